@@ -117,6 +117,20 @@
 #include <sys/stat.h>
 #include <sys/shm.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
+#include <array>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <string>
 #include <vector>
 
@@ -138,7 +152,12 @@ CppON *CppON::factory( CppON &jt )
             rtn = new CODouble( (CODouble &) jt );
             break;
         case STRING_CPPON_OBJ_TYPE:
-            rtn = new COString( (COString &) jt );
+            if( jt.lazy )
+            {
+                rtn = new COFileString( (COFileString &) jt );                                  // Shares the file instead of reading it
+            } else {
+                rtn = new COString( (COString &) jt );
+            }
             break;
         case NULL_CPPON_OBJ_TYPE:
             rtn = new CONull;
@@ -164,6 +183,8 @@ CppON::CppON( CppONType type )
     siz = 0;
     data = NULL;
     precision = -1;
+    refs = 0;
+    lazy = raw = false;
 }
 
 // cppcheck-suppress constParameter
@@ -172,6 +193,8 @@ CppON::CppON( CppON *jt )
     siz                 = jt->siz;
     data                = NULL;
     precision           = jt->precision;
+    refs                = 0;
+    lazy = raw          = false;
     switch ( typ = jt->typ )
     {
         case INTEGER_CPPON_OBJ_TYPE:
@@ -205,6 +228,8 @@ CppON::CppON( CppON &jt )
     siz                 = jt.siz;
     data                = NULL;
     precision           = jt.precision;
+    refs                = 0;
+    lazy = raw          = false;
     switch ( typ = jt.typ )
     {
         case INTEGER_CPPON_OBJ_TYPE:
@@ -273,7 +298,7 @@ void CppON::deleteData()
                     // cppcheck-suppress postfixOperator
                     for( it = m->begin(); m->end() != it; it++ )
                     {
-                        delete( it->second);
+                        release( it->second );
                     }
                     m->clear();
                     delete ( m );
@@ -284,7 +309,7 @@ void CppON::deleteData()
                     vector <CppON *> *v = ( vector<CppON *> * ) data;
                     for(unsigned int i = 0; v->size() > i; i++ )
                     {
-                        delete( v->at( i ) );
+                        release( v->at( i ) );
                     }
                     delete ( v );
                 }
@@ -406,30 +431,39 @@ CppON *CppON::guessDataType( const char *str )
 
 string *CppON::toNetString( const char *str, char styp )
 {
-    int  len            = strlen( str );
-    char buf[ len + 16 ];
+    string *rtn = new string();
 
-    snprintf( buf, len+16, "%d:%s%c", len, str, styp );
-    return new string( buf );
+    appendNetString( *rtn, str, strlen( str ), styp );
+    return rtn;
 };
 
+void CppON::appendNetString( std::string &out, const char *str, size_t len, char styp )
+{
+    char buf[ 24 ];
+    int  n = snprintf( buf, sizeof( buf ), "%zu:", len );
+
+    out.append( buf, n );
+    out.append( str, len );
+    out.push_back( styp );
+}
+
 const char *CppON::c_str()
 {
     string indent = "";
 
+    if( data && INTEGER_CPPON_OBJ_TYPE == typ )
+    {
+        // cppcheck-suppress cstyleCast
+        return ( (COInteger *) this )->c_str();                                             // Numbers build their text in str themselves, and a
+    } else if( data && DOUBLE_CPPON_OBJ_TYPE == typ ) {                                     // lazy one keeps its source text there
+        // cppcheck-suppress cstyleCast
+        return ( (CODouble *) this )->c_str();
+    }
     str = "";
     if( data )
     {
         switch( typ )
         {
-            case INTEGER_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                str = ( (COInteger *) this )->c_str();
-                break;
-            case DOUBLE_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                str = ( (CODouble *) this )->c_str();
-                break;
             case STRING_CPPON_OBJ_TYPE:
                 // cppcheck-suppress cstyleCast
                 str = ( (COString *) this )->c_str();
@@ -593,20 +627,479 @@ static __inline void DumpWhiteSpace( const char *(&str) ) { char ch; while( 0 !=
 static __inline void DumpWhiteSpace( char &ch, const char **str ) { while( 0 != (ch = **str ) &&( ' ' == ch || '\t' == ch || '\n' == ch || 'r' == ch ) ) { (*str)++; } }
 static __inline void DumpWhiteSpace( char &ch, const char *(&str) ) { while( 0 != (ch = *str ) &&( ' ' == ch || '\t' == ch || '\n' == ch || 'r' == ch ) ) { str++; } }
 
+/*
+ * Return a pointer to the first quote, back slash, NUL or non ASCII byte at or after p.  Everything before it can be
+ * copied out of a JSON string as is.  The SSE2 version only uses aligned loads so it never reads across a page
+ * boundary past the terminating NUL, which is also why it is excluded from address sanitizing.
+ */
+#if defined(__SSE2__)
+__attribute__((no_sanitize_address))
+#endif
+static __inline const char *skipPlain( const char *p )
+{
+#if defined(__SSE2__)
+    const __m128i   quote   = _mm_set1_epi8( '"' );
+    const __m128i   bslash  = _mm_set1_epi8( '\\' );
+    const __m128i   zero    = _mm_setzero_si128();
+    unsigned        off     = (unsigned) ( (uintptr_t) p & 15 );
+    const __m128i   *a      = (const __m128i *) ( p - off );
+    __m128i         v       = _mm_load_si128( a );
+    unsigned        mask    = (unsigned) ( _mm_movemask_epi8( _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, quote ), _mm_cmpeq_epi8( v, bslash ) ),
+                                                                            _mm_cmpeq_epi8( v, zero ) ) ) | _mm_movemask_epi8( v ) ) >> off;
+    if( mask )
+    {
+        return p + __builtin_ctz( mask );
+    }
+    for( ;; )
+    {
+        v = _mm_load_si128( ++a );
+        mask = (unsigned) ( _mm_movemask_epi8( _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, quote ), _mm_cmpeq_epi8( v, bslash ) ),
+                                                             _mm_cmpeq_epi8( v, zero ) ) ) | _mm_movemask_epi8( v ) );
+        if( mask )
+        {
+            return (const char *) a + __builtin_ctz( mask );
+        }
+    }
+#else
+    unsigned char c;
+
+    while( 0 != ( c = (unsigned char) *p ) && '"' != c && '\\' != c && !( c & 0x80 ) ) { p++; }
+    return p;
+#endif
+}
+
+/*
+ * Length of the UTF-8 sequence starting with the non ASCII byte at p, or 0 if it is not valid UTF-8.  Stray
+ * continuation bytes, overlong forms, UTF-16 surrogates and values above U+10FFFF are all rejected.
+ */
+static __inline size_t utf8SeqLen( const unsigned char *p )
+{
+    unsigned char   c   = p[ 0 ];
+    unsigned char   lo  = 0x80;
+    unsigned char   hi  = 0xBF;
+    size_t          n;
+
+    if( 0xC2 <= c && 0xDF >= c )
+    {
+        n = 2;
+    } else if( 0xE0 == c ) {
+        n = 3;
+        lo = 0xA0;
+    } else if( 0xED == c ) {
+        n = 3;
+        hi = 0x9F;
+    } else if( 0xE1 <= c && 0xEF >= c ) {
+        n = 3;
+    } else if( 0xF0 == c ) {
+        n = 4;
+        lo = 0x90;
+    } else if( 0xF4 == c ) {
+        n = 4;
+        hi = 0x8F;
+    } else if( 0xF1 <= c && 0xF3 >= c ) {
+        n = 4;
+    } else {
+        return 0;
+    }
+    if( lo > p[ 1 ] || hi < p[ 1 ] )
+    {
+        return 0;
+    }
+    for( size_t i = 2; n > i; i++ )
+    {
+        if( 0x80 != ( p[ i ] & 0xC0 ) )
+        {
+            return 0;
+        }
+    }
+    return n;
+}
+
+static __inline void appendUtf8( std::string &out, uint32_t cp )
+{
+    if( 0x80 > cp )
+    {
+        out.push_back( (char) cp );
+    } else if( 0x800 > cp ) {
+        out.push_back( (char) ( 0xC0 | ( cp >> 6 ) ) );
+        out.push_back( (char) ( 0x80 | ( cp & 0x3F ) ) );
+    } else if( 0x10000 > cp ) {
+        out.push_back( (char) ( 0xE0 | ( cp >> 12 ) ) );
+        out.push_back( (char) ( 0x80 | ( ( cp >> 6 ) & 0x3F ) ) );
+        out.push_back( (char) ( 0x80 | ( cp & 0x3F ) ) );
+    } else {
+        out.push_back( (char) ( 0xF0 | ( cp >> 18 ) ) );
+        out.push_back( (char) ( 0x80 | ( ( cp >> 12 ) & 0x3F ) ) );
+        out.push_back( (char) ( 0x80 | ( ( cp >> 6 ) & 0x3F ) ) );
+        out.push_back( (char) ( 0x80 | ( cp & 0x3F ) ) );
+    }
+}
+
+static __inline int hex4( const char *p )
+{
+    int     rtn     = 0;
+
+    for( int i = 0; 4 > i; i++ )
+    {
+        char    c   = p[ i ];
+        int     d;
+
+        if( '0' <= c && '9' >= c )
+        {
+            d = c - '0';
+        } else if( 'a' <= c && 'f' >= c ) {
+            d = c - 'a' + 10;
+        } else if( 'A' <= c && 'F' >= c ) {
+            d = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        rtn = ( rtn << 4 ) | d;
+    }
+    return rtn;
+}
+
+/*
+ * Resource limits of the parse running on this thread (see CppONParseOptions).  It is only set while
+ * parseJson() runs with options, so the parser pays a single pointer test per object when there are no limits.
+ */
+struct CppONParseBudget
+{
+    CppONParseOptions   *opts;
+    const char          *base;                                                              // Start of the input, for error offsets
+    const char          *end;                                                               // Its end, what a length prefix may reach
+    const std::shared_ptr<COFileRegion> *region;                                            // parseJsonFile()'s mapping when strings may stay in it
+    size_t              bytes;
+    size_t              nodes;
+    unsigned            depth;
+};
+
+static thread_local CppONParseBudget *parseBudget = NULL;
+
+/*
+ * A regular file mmap'd read only by parseJsonFile() for CppONParseOptions::fileStrings, followed by at least one
+ * zero byte so the parser sees a NUL terminated string.  It is kept open for copy_file_range() and sendfile() and
+ * goes away with the last COFileString in it.
+ */
+struct COFileRegion
+{
+    int                 fd;
+    char                *map;
+    size_t              len;                                                                // Of the file
+    size_t              mapLen;                                                             // Of the mapping, which is longer
+                        COFileRegion() : fd( -1 ), map( NULL ), len( 0 ), mapLen( 0 ) {}
+                        ~COFileRegion() { if( map ) munmap( map, mapLen ); if( 0 <= fd ) close( fd ); }
+};
+
+#define PARSE_NODE_BYTES    ( sizeof( COMap ) )
+#define SERIALIZER_CHECK_EVENTS 64                                                          // Nodes written between clock reads in COSerializer::step()
+#define RECLAIM_SLICE_NODES     4096                                                        // Nodes the background reclaimer frees between checks
+#define UNIX_ZERO_COPY_MIN      256                                                         // Strings this long are sent from where they are
+#define FILE_COPY_MIN           4096                                                        // Runs of a COFileString this long are copied file to file
+#define UNIX_MAX_SEGMENTS       1024                                                        // IOV_MAX on Linux
+#define UNIX_PACKET_BATCH       64                                                          // Packets per sendmmsg()
+#define STORE_COMMIT_BYTES      ( 4 << 20 )                                                 // A COStore queue this big is committed by put()
+#define STORE_COMPACT_MIN       ( 1 << 20 )                                                 // Dead log bytes before background compaction
+#define STORE_MIN_SLOTS         1024                                                        // Smallest COStore index
+#define STORE_COPY_BYTES        ( 1 << 20 )                                                 // Buffer compact() copies records through
+#define JOURNAL_MIN_CHECKPOINT  ( 64 << 10 )                                                // Smallest journal COJournal checkpoints
+#define RELOAD_EVENT_BYTES      ( 64 << 10 )                                                // inotify events read at a time
+#define BATCH_MIN_PER_THREAD    64                                                          // Smallest run of a batch given its own thread
+
+/*
+ * Record why the parse is being abandoned.  Only the first (innermost) error is kept.
+ */
+static bool budgetFail( CppONParseErrorCode code, const char *at, const char *msg )
+{
+    CppONParseError     &err    = parseBudget->opts->error;
+
+    if( CPPON_PARSE_OK == err.code )
+    {
+        err.code = code;
+        err.offset = ( at && at >= parseBudget->base ) ? at - parseBudget->base : 0;
+        err.message = msg;
+    }
+    return false;
+}
+
+static __inline bool budgetFailed() { return parseBudget && CPPON_PARSE_OK != parseBudget->opts->error.code; }
+
+/*
+ * Account for a new object about to be parsed at "at".  depth counts the objects being parsed.
+ */
+static __inline bool budgetEnter( const char *at )
+{
+    CppONParseOptions   *o  = parseBudget->opts;
+
+    if( CPPON_PARSE_OK != o->error.code )
+    {
+        return false;
+    } else if( o->maxNodes && o->maxNodes <= parseBudget->nodes ) {
+        return budgetFail( CPPON_PARSE_TOO_MANY_NODES, at, "Too many objects" );
+    } else if( o->maxBytes && o->maxBytes < parseBudget->bytes + PARSE_NODE_BYTES ) {
+        return budgetFail( CPPON_PARSE_TOO_MANY_BYTES, at, "Memory limit exceeded" );
+    }
+    parseBudget->depth++;
+    parseBudget->nodes++;
+    parseBudget->bytes += PARSE_NODE_BYTES;
+    return true;
+}
+
+/*
+ * Called once the object being entered is known to be a Map or Array.
+ */
+static __inline bool budgetNest( const char *at )
+{
+    if( parseBudget->opts->maxDepth && parseBudget->opts->maxDepth < parseBudget->depth )
+    {
+        return budgetFail( CPPON_PARSE_TOO_DEEP, at, "Nesting too deep" );
+    }
+    return true;
+}
+
+static __inline void budgetLeave( const char *at, const CppON *rtn )
+{
+    parseBudget->depth--;
+    if( ! rtn && CPPON_PARSE_OK == parseBudget->opts->error.code )
+    {
+        budgetFail( CPPON_PARSE_SYNTAX, at, "Syntax error" );
+    }
+}
+
+/*
+ * Check that a string (or key) of "len" bytes can still be added.  Called before the bytes are copied.
+ */
+static __inline bool budgetString( const char *at, size_t len )
+{
+    CppONParseOptions   *o  = parseBudget->opts;
+
+    if( o->maxStringLength && o->maxStringLength < len )
+    {
+        return budgetFail( CPPON_PARSE_STRING_TOO_LONG, at, "String too long" );
+    } else if( o->maxBytes && o->maxBytes < parseBudget->bytes + len ) {
+        return budgetFail( CPPON_PARSE_TOO_MANY_BYTES, at, "Memory limit exceeded" );
+    }
+    return true;
+}
+
+static __inline bool budgetElement( const char *at, size_t count, size_t bytes )
+{
+    CppONParseOptions   *o  = parseBudget->opts;
+
+    parseBudget->bytes += bytes;
+    if( o->maxContainerSize && o->maxContainerSize < count )
+    {
+        return budgetFail( CPPON_PARSE_CONTAINER_TOO_LARGE, at, "Container too large" );
+    } else if( o->maxBytes && o->maxBytes < parseBudget->bytes ) {
+        return budgetFail( CPPON_PARSE_TOO_MANY_BYTES, at, "Memory limit exceeded" );
+    }
+    return true;
+}
+
+/*
+ * Length of the JSON number at p or 0 if there isn't a well formed one.  "dbl" is set if it has a fraction or exponent.
+ */
+static __inline size_t jsonNumberLength( const char *p, bool &dbl )
+{
+    const char  *s  = p;
+
+    dbl = false;
+    if( '-' == *p )
+    {
+        p++;
+    }
+    if( '0' > *p || '9' < *p )
+    {
+        return 0;
+    }
+    while( '0' <= *p && '9' >= *p ) { p++; }
+    if( '.' == *p )
+    {
+        dbl = true;
+        if( '0' > *++p || '9' < *p )
+        {
+            return 0;
+        }
+        while( '0' <= *p && '9' >= *p ) { p++; }
+    }
+    if( 'e' == *p || 'E' == *p )
+    {
+        dbl = true;
+        if( '+' == *++p || '-' == *p )
+        {
+            p++;
+        }
+        if( '0' > *p || '9' < *p )
+        {
+            return 0;
+        }
+        while( '0' <= *p && '9' >= *p ) { p++; }
+    }
+    return ( 'x' == *p || 'X' == *p ) ? 0 : p - s;
+}
+
+/*
+ * The length of a string value starting at p (just past the quote) whose bytes are its value as they are, or 0 if
+ * it has an escape (or is not terminated) and must be decoded.
+ */
+static size_t fileStringLength( const char *p )
+{
+    const char  *q  = p;
+
+    for( ;; )
+    {
+        size_t  n;
+
+        q = skipPlain( q );
+        if( '"' == *q )
+        {
+            return q - p;
+        } else if( !( *q & 0x80 ) || !( n = utf8SeqLen( (const unsigned char *) q ) ) ) {
+            return 0;
+        }
+        q += n;
+    }
+}
+
+/*
+ * Decode the body of a JSON string.  On entry p points just past the opening quote, on success it is left just past
+ * the closing quote and "out" holds the decoded UTF-8.  Runs of plain characters are appended in bulk, escapes
+ * (including \uXXXX and surrogate pairs) are decoded and raw non ASCII bytes must be valid UTF-8.  An unknown escape
+ * keeps the character after the back slash as it always has.  \u0000 is rejected, as string values are used as C
+ * strings.
+ */
+static bool decodeJsonString( const char *&p, std::string &out )
+{
+    out.clear();
+    for( ;; )
+    {
+        const char      *q  = skipPlain( p );
+        unsigned char   c   = (unsigned char) *q;
+        size_t          n;
+
+        if( parseBudget && ! budgetString( p, out.size() + ( q - p ) ) )                    // Checked before copying
+        {
+            return false;
+        }
+        out.append( p, q - p );
+        p = q;
+        if( '"' == c )
+        {
+            p++;
+            return true;
+        } else if( ! c ) {
+            fprintf( stderr, "%s[%d]: Unterminated string\n", __FILE__, __LINE__ );
+            return false;
+        } else if( c & 0x80 ) {
+            if( !( n = utf8SeqLen( (const unsigned char *) p ) ) )
+            {
+                fprintf( stderr, "%s[%d]: Invalid UTF-8 byte 0x%.2X in string\n", __FILE__, __LINE__, (unsigned) c );
+                return false;
+            }
+            out.append( p, n );
+            p += n;
+            continue;
+        }
+        c = (unsigned char) p[ 1 ];
+        p += 2;
+        switch( c )
+        {
+            case 'b':
+                out.push_back( '\b' );
+                break;
+            case 'f':
+                out.push_back( '\f' );
+                break;
+            case 'n':
+                out.push_back( '\n' );
+                break;
+            case 'r':
+                out.push_back( '\r' );
+                break;
+            case 't':
+                out.push_back( '\t' );
+                break;
+            case 'u':
+                {
+                    int     cp  = hex4( p );
+
+                    if( 0 > cp )
+                    {
+                        fprintf( stderr, "%s[%d]: Invalid \\u escape in string\n", __FILE__, __LINE__ );
+                        return false;
+                    } else if( ! cp ) {
+                        fprintf( stderr, "%s[%d]: \\u0000 in string\n", __FILE__, __LINE__ );    // Values are NUL terminated
+                        return false;
+                    }
+                    p += 4;
+                    if( 0xD800 <= cp && 0xDBFF >= cp )
+                    {
+                        int     lo  = ( '\\' == p[ 0 ] && 'u' == p[ 1 ] ) ? hex4( &p[ 2 ] ) : -1;
+
+                        if( 0xDC00 > lo || 0xDFFF < lo )
+                        {
+                            fprintf( stderr, "%s[%d]: Unpaired surrogate in string\n", __FILE__, __LINE__ );
+                            return false;
+                        }
+                        p += 6;
+                        cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( lo - 0xDC00 );
+                    } else if( 0xDC00 <= cp && 0xDFFF >= cp ) {
+                        fprintf( stderr, "%s[%d]: Unpaired surrogate in string\n", __FILE__, __LINE__ );
+                        return false;
+                    }
+                    appendUtf8( out, (uint32_t) cp );
+                }
+                break;
+            case '\0':
+                fprintf( stderr, "%s[%d]: Unterminated string\n", __FILE__, __LINE__ );
+                return false;
+            default:                                                                        // '"', '\\', '/' and anything unknown
+                if( c & 0x80 )
+                {
+                    p--;                                                                    // Validate it with the next pass
+                } else {
+                    out.push_back( (char) c );
+                }
+                break;
+        }
+    }
+}
+
 CppON *CppON::GetTNetstring( const char **str )
 {
     CppON           *base   = NULL;
-    uint32_t        len     = (uint32_t) strtol( *str, (char **) str, 10 );
+    const char      *at     = *str;
+    size_t          len;
     char            ch;
     char            typ     = '\0';
 
+    if( parseBudget && ! budgetEnter( at ) )
+    {
+        return NULL;
+    }
+    len = (size_t) strtoull( *str, (char **) str, 10 );
     while( 0 != (ch = *(*str)++) && ( ' ' == ch || '\t' == ch || '\r' == ch || '\n' == ch ) );
+    if( ':' == ch && parseBudget && (size_t)( parseBudget->end - *str ) <= len )           // Checked before the type byte is read
+    {
+        budgetFail( CPPON_PARSE_SYNTAX, at, "Length runs past the end of the input" );
+        ch = '\0';
+    } else if( ':' == ch && parseBudget ) {
+        typ = (*str)[ len ];
+        if( ( ',' == typ && ! budgetString( at, len ) ) || ( ( '}' == typ || ']' == typ ) && ! budgetNest( at ) ) )
+        {
+            ch = '\0';                                                         // Over a limit, don't even look at it
+        }
+    }
     if( ':' == ch )
     {
         switch ( typ = (*str)[ len ] )
         {
             case ',':                                                        // string
                 {
+                    if( parseBudget )
+                    {
+                        parseBudget->bytes += len;
+                    }
                     std::string s( *str, len );
                     base = new COString( s );
                 }
@@ -622,7 +1115,7 @@ CppON *CppON::GetTNetstring( const char **str )
                 {
                     base = new COBoolean( true );
                 } else if(  0 == strncasecmp( *str, "false", 5 ) ) {
-                    base = new COBoolean( true );
+                    base = new COBoolean( false );
                 }
                 break;
             case '~':                                                        // NULL
@@ -631,9 +1124,9 @@ CppON *CppON::GetTNetstring( const char **str )
             case '}':                                                        // Map
                 {
                     base = new COMap();
-                    std::string s( *str, len );
-                    const char    *cptr = s.c_str();
-                    while( *cptr )
+                    const char    *cptr = *str;
+                    const char    *cend = *str + len;                  // Parse in place, the type character ends the data
+                    while( cptr < cend )
                     {
                         DumpWhiteSpace( ch, cptr );
                         for( unsigned i = 0; 0 != (ch = cptr[ i ] ) && ('0' <= ch && '9' >= ch); i++);
@@ -646,7 +1139,7 @@ CppON *CppON::GetTNetstring( const char **str )
                             name = (COString *)  GetTNetstring( &cptr );
                         }
                         DumpWhiteSpace( ch, cptr );
-                        if( *cptr  && CppON::isString( name ) )
+                        if( cptr < cend && CppON::isString( name ) )
                         {
                             for( unsigned i = 0; 0 != (ch = cptr[ i ] ) && ('0' <= ch && '9' >= ch); i++);
                             if( ':' != ch )
@@ -658,8 +1151,19 @@ CppON *CppON::GetTNetstring( const char **str )
                             if( CppON::isObj( val ) )
                             {
                                 ((COMap *) base )->append( name->c_str(), val );
+                                if( parseBudget && ! budgetElement( cptr, base->size(), name->size() + 4 * sizeof( void * ) ) )
+                                {
+                                    delete name;
+                                    delete base;
+                                    base = NULL;
+                                    break;
+                                }
                                 delete name;
                             } else {
+                                if( val )
+                                {
+                                    delete val;
+                                }
                                 delete name;
                                 delete base;
                                 base = NULL;
@@ -681,19 +1185,27 @@ CppON *CppON::GetTNetstring( const char **str )
             case ']':                                                        // Array
                 {
                     base = new COArray();
-                    std::string s( *str, len );
-                    const char    *cptr = s.c_str();
-                    while( *cptr )
+                    const char    *cptr = *str;
+                    const char    *cend = *str + len;
+                    while( cptr < cend )
                     {
                         DumpWhiteSpace( ch, cptr );
                         for( unsigned i = 0; 0 != (ch = cptr[ i ] ) && ('0' <= ch && '9' >= ch); i++);
-                        if( ':' != ch )
+                        CppON   *obj    = ( ':' != ch ) ? GetObj( &cptr ) : GetTNetstring( &cptr );
+                        if( ! obj )                                                 // Never put a NULL into the array
                         {
-                            ( ( COArray *) base )->append( GetObj( &cptr ) );
-                        } else {
-                            ( ( COArray *) base )->append( GetTNetstring( &cptr ) );
+                            delete base;
+                            base = NULL;
+                            break;
+                        }
+                        ( ( COArray *) base )->append( obj );
+                        if( parseBudget && ! budgetElement( cptr, base->size(), sizeof( CppON * ) ) )
+                        {
+                            delete base;
+                            base = NULL;
+                            break;
                         }
-                        if( 0 != *cptr )
+                        if( cptr < cend )
                         {
                             DumpWhiteSpace( ch, cptr );
                             if( ',' == ch )
@@ -714,6 +1226,10 @@ CppON *CppON::GetTNetstring( const char **str )
         }
         *str += (len + 1);
     }
+    if( parseBudget )
+    {
+        budgetLeave( at, base );
+    }
     return base;
 }
 
@@ -723,6 +1239,17 @@ CppON *CppON::GetObj( const char **str )
     CppON       *base   = NULL;
     const char  *nc     = *str;
     char        ch      = *nc++;
+    size_t      numLen  = 0;
+    size_t      fileLen = 0;
+    bool        dbl     = false;
+
+    if( parseBudget && ! budgetEnter( *str ) )
+    {
+        return NULL;
+    } else if( parseBudget && ( '{' == ch || '[' == ch ) && ! budgetNest( *str ) ) {
+        budgetLeave( *str, NULL );
+        return NULL;
+    }
 
     if( '{' == ch )
     {
@@ -736,12 +1263,9 @@ CppON *CppON::GetObj( const char **str )
             while( 0 != (ch = *nc++ ) && '"' != ch );
             if( ch )
             {
-                int n = 0;
-                while( 0 != ( ch = nc[ n ] ) && '"' != ch ) { n++; };
-                if( ch )
+                string name;
+                if( decodeJsonString( nc, name ) )
                 {
-                    string name( nc, n++ );
-                    nc += n;
                     DumpWhiteSpace( ch, nc );
                     if( ':' == ch )
                     {
@@ -758,10 +1282,13 @@ CppON *CppON::GetObj( const char **str )
                         }
                         if( obj )
                         {
-                            mp->append( name.c_str(), obj );
+                            mp->append( name, obj );
                             DumpWhiteSpace( ch, nc );
                             // Character should be a comma or a '}';
-                            if( ',' == ch )
+                            if( parseBudget && ! budgetElement( nc, mp->size(), name.size() + 4 * sizeof( void * ) ) )
+                            {
+                                fail = true;
+                            } else if( ',' == ch )
                             {
                                 nc++;
                             } else if( ch && '}' != ch ) {
@@ -822,6 +1349,10 @@ CppON *CppON::GetObj( const char **str )
                     fail = true;
                 }
                 arr->append( obj );
+                if( parseBudget && ! budgetElement( nc, arr->size(), sizeof( CppON * ) ) )
+                {
+                    fail = true;
+                }
             } else {
                 fail = true;
             }
@@ -835,21 +1366,29 @@ CppON *CppON::GetObj( const char **str )
         }
         *str = &nc[ 1 ];
         DumpWhiteSpace( ch, str );
+    } else if( '"' == ch && parseBudget && parseBudget->region && ( fileLen = fileStringLength( nc ) ) >= parseBudget->opts->fileStrings ) {
+        if( parseBudget->opts->maxStringLength && parseBudget->opts->maxStringLength < fileLen )  // Costs no heap so only the length is checked
+        {
+            budgetFail( CPPON_PARSE_STRING_TOO_LONG, nc, "String too long" );
+        } else {
+            base = new COFileString( *parseBudget->region, nc - ( *parseBudget->region )->map, fileLen );
+            nc += fileLen + 1;
+        }
+        *str = nc;
+        DumpWhiteSpace( ch, str );
     } else if( '"' == ch ) {
-        int n = 0;
-        std::vector<char> acum;
-        while( '"' != ( ch = nc[ n ] ) && 0 != ch )
+        std::string s;
+        if( decodeJsonString( nc, s ) )
         {
-            if( 0x5C == ch )
+            COString    *cs = new COString( "" );
+            cs->value()->swap( s );                                                         // Keeps any embedded NULs
+            base = cs;
+            if( parseBudget )
             {
-                ch = nc[ ++n ];
+                parseBudget->bytes += cs->value()->size();
             }
-            acum.push_back( ch );
-            n++;
-        };
-        std::string s( acum.begin(), acum.end() );
-        base = new COString( s.c_str() );
-        *str = &nc[ ++n ];
+        }
+        *str = nc;
         DumpWhiteSpace( ch, str );
     } else if( ( 't' == ch || 'T' == ch ) && 0 == strncasecmp( nc, "rue", 3 ) && ( ! (ch == *(nc + 3)) || ',' == ch || ' ' == ch || '\t' == ch || '\n' == ch || '\r' == ch ) ) {
         *str += 4;
@@ -859,6 +1398,18 @@ CppON *CppON::GetObj( const char **str )
         *str += 5;
         base = new COBoolean( false );
         DumpWhiteSpace( ch, str );
+    } else if( parseBudget && parseBudget->opts->lazyNumbers && 0 < ( numLen = jsonNumberLength( *str, dbl ) ) ) {
+        if( dbl )
+        {
+            base = new CODouble( 0.0 );
+        } else {
+            base = new COInteger( (uint64_t) 0 );
+        }
+        base->str.assign( *str, numLen );                                                  // Converted on first use (see parseRaw())
+        base->lazy = base->raw = true;
+        parseBudget->bytes += numLen;
+        *str += numLen;
+        DumpWhiteSpace( ch, str );
     } else if( ( '0' <= ch && '9' >= ch ) || '-' == ch || '+' == ch ) {
         char c;
         const char *dot = NULL;
@@ -888,9 +1439,13 @@ CppON *CppON::GetObj( const char **str )
             base = new CODouble( d );
         }
         DumpWhiteSpace( ch, str );
-    } else {
+    } else if( ! budgetFailed() ) {
         fprintf( stderr, "\n%c%s is not an object\n", ch, nc );
     }
+    if( parseBudget )
+    {
+        budgetLeave( nc, base );
+    }
     return base;
 }
 
@@ -910,64 +1465,316 @@ CppON *CppON::parseJson( const char *str )
     return NULL;
 }
 
-// cppcheck-suppress unusedFunction
-CppON *CppON::parseJsonFile( const char *path )
+CppON *CppON::parseJson( const char *str, CppONParseOptions &opts )
 {
-    char        *buf;
-    char        *bSave;
-    FILE        *fp     = fopen( path, "r" );
-    int         sz      = 1024;
-    int         rd      = 0;
-    int         c;
-    CppON       *rtn    = NULL;
+    return parseJson( str, str + strlen( str ), NULL, opts );
+}
 
-    if( !fp )
-    {
-        char estr[ 1024 ];
-        snprintf( estr, 1023, "fopen Failed to open JSON FILE \"%s\"", path );
-        perror( estr );
-        return rtn;
+/*
+ * Parse the len bytes at str, which may hold NULs inside TNetStrings.  TNetString lengths are kept within len, but
+ * JSON text is read up to a NUL, so one must follow it: normally str[ len ], at the latest the end of the data.
+ */
+CppON *CppON::parseJson( const char *str, size_t len, CppONParseOptions &opts )
+{
+    return parseJson( str, str + len, NULL, opts );
+}
+
+/*
+ * The parse behind the other two.  end is the end of the input, what a TNetString length may reach; region is
+ * parseJsonFile()'s mapping when string values may be left in it.
+ */
+CppON *CppON::parseJson( const char *str, const char *end, const std::shared_ptr<COFileRegion> *region, CppONParseOptions &opts )
+{
+    CppONParseBudget    budget;
+    CppONParseBudget    *saved  = parseBudget;
+    CppON               *rtn;
+
+    opts.error = CppONParseError();
+    budget.opts = &opts;
+    budget.base = str;
+    budget.end = end;
+    budget.bytes = budget.nodes = 0;
+    budget.depth = 0;
+    budget.region = region;
+    parseBudget = &budget;
+    rtn = parseJson( str );
+    parseBudget = saved;
+    if( rtn && CPPON_PARSE_OK != opts.error.code )                                          // A failure deep down that was tolerated
+    {
+        delete rtn;
+        rtn = NULL;
+    } else if( ! rtn && CPPON_PARSE_OK == opts.error.code ) {
+        opts.error.code = CPPON_PARSE_SYNTAX;
+        opts.error.message = "No object found";
     }
-    if( !( buf = (char *) malloc( sz ) ) )
+    if( rtn && opts.schema )
+    {
+        std::vector<COSchemaError>  errors;
+
+        if( ! opts.schema->validate( rtn, &errors, 1 ) )
+        {
+            opts.error.code = CPPON_PARSE_SCHEMA;
+            opts.error.message = ( errors.size() ) ? ( ( errors[ 0 ].path.length() ) ? errors[ 0 ].path + ": " : "" ) + errors[ 0 ].message : "Schema failed";
+            delete rtn;
+            rtn = NULL;
+        }
+    }
+
+    if( rtn && opts.dedupe )
+    {
+        opts.dedupeStats = rtn->dedupe();
+    }
+    return rtn;
+}
+
+/*
+ * Parse a contiguous run of a batch.  Every message is copied into the same scratch buffer to NUL terminate it, so
+ * a worker allocates only for the trees it builds.  The first failure is kept in first/firstError and what dedupe
+ * freed is added to stats.
+ */
+static size_t parseBatchRange( const std::vector<CppONSpan> &spans, std::vector<CppON *> &results, size_t from, size_t to,
+                               CppONParseOptions opts, size_t &first, CppONParseError &firstError, CppONDedupeStats &stats )
+{
+    std::string     scratch;
+    size_t          ok = 0;
+
+    for( size_t i = from; to > i; i++ )
+    {
+        scratch.assign( ( spans[ i ].data ) ? spans[ i ].data : "", ( spans[ i ].data ) ? spans[ i ].len : 0 );
+        if( ( results[ i ] = CppON::parseJson( scratch.c_str(), scratch.size(), opts ) ) )  // A TNetString may hold NULs
+        {
+            ok++;
+            stats.subtrees += opts.dedupeStats.subtrees;
+            stats.nodes += opts.dedupeStats.nodes;
+            stats.bytes += opts.dedupeStats.bytes;
+        } else if( ( size_t ) -1 == first ) {
+            first = i;
+            firstError = opts.error;
+        }
+    }
+    return ok;
+}
+
+/*
+ * Parse many independent JSON or TNetString messages in one call.  results[ i ] is the tree for spans[ i ] or
+ * NULL if it failed; opts.error describes the first message that failed.  The limits in opts apply to each
+ * message on its own.  With threads > 1 (0 means one per CPU) the batch is split in contiguous runs over worker
+ * threads, each with its own scratch buffer.  With opts.dedupe each message is deduped on its own, so results
+ * never share nodes and may be handed to, changed and deleted on different threads; opts.dedupeStats is the total.
+ * Returns the number of messages parsed.
+ */
+size_t CppON::parseBatch( const std::vector<CppONSpan> &spans, std::vector<CppON *> &results, CppONParseOptions &opts, unsigned threads )
+{
+    size_t                      n           = spans.size();
+    size_t                      ok          = 0;
+    size_t                      first       = ( size_t ) -1;
+    CppONParseError             firstError;
+
+    results.assign( n, NULL );
+    opts.error = CppONParseError();
+    opts.dedupeStats = CppONDedupeStats();
+    if( ! threads )
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    if( threads > n / BATCH_MIN_PER_THREAD )                                                // Not worth a thread for a few small messages
+    {
+        threads = ( unsigned ) ( n / BATCH_MIN_PER_THREAD );
+    }
+    if( 1 >= threads )
+    {
+        ok = parseBatchRange( spans, results, 0, n, opts, first, firstError, opts.dedupeStats );
+    } else {
+        std::vector<std::thread>        workers;
+        std::vector<size_t>             counts( threads, 0 );
+        std::vector<size_t>             firsts( threads, ( size_t ) -1 );
+        std::vector<CppONParseError>    errors( threads );
+        std::vector<CppONDedupeStats>   stats( threads );
+        size_t                          chunk = ( n + threads - 1 ) / threads;
+
+        workers.reserve( threads );
+        for( unsigned t = 0; threads > t; t++ )
+        {
+            size_t from = t * chunk;
+            size_t to = ( n < from + chunk ) ? n : from + chunk;
+
+            workers.emplace_back( [ &, t, from, to ]() { counts[ t ] = parseBatchRange( spans, results, from, to, opts, firsts[ t ], errors[ t ], stats[ t ] ); } );
+        }
+        for( unsigned t = 0; threads > t; t++ )
+        {
+            workers[ t ].join();
+        }
+        for( unsigned t = 0; threads > t; t++ )                                             // Workers copy opts as they start
+        {
+            ok += counts[ t ];
+            opts.dedupeStats.subtrees += stats[ t ].subtrees;
+            opts.dedupeStats.nodes += stats[ t ].nodes;
+            opts.dedupeStats.bytes += stats[ t ].bytes;
+            if( ( size_t ) -1 == first && ( size_t ) -1 != firsts[ t ] )                    // Runs are in order so the first one wins
+            {
+                first = firsts[ t ];
+                firstError = errors[ t ];
+            }
+        }
+    }
+    if( ( size_t ) -1 != first )
+    {
+        opts.error = firstError;
+    }
+    return ok;
+}
+
+// cppcheck-suppress unusedFunction
+CppON *CppON::parseJsonFile( const char *path )
+{
+    CppONParseOptions   opts;
+
+    return parseJsonFile( path, opts );
+}
+
+/*
+ * Read all of an open file into one malloc'ed, NUL terminated buffer.  A regular file is sized with fstat() and read
+ * with as few read() calls as the kernel allows; anything else (a pipe, a tty) grows the buffer by doubling.  A full
+ * buffer is grown only when a read into a small spare buffer returns more, so a file read to its end is never doubled.
+ */
+static char *readWholeFile( FILE *fp, size_t *len )
+{
+    struct stat st;
+    int         fd      = fileno( fp );
+    size_t      cap     = 64 * 1024;
+    size_t      rd      = 0;
+    char        *buf;
+
+    if( ! fstat( fd, &st ) && S_ISREG( st.st_mode ) && 0 < st.st_size )
+    {
+        cap = (size_t) st.st_size + 1;
+    }
+    if( !( buf = (char *) malloc( cap ) ) )
     {
-        fclose( fp );
         perror( "malloc Memory allocation error" );
-        return rtn;
+        return NULL;
     }
-    while( EOF != ( c = fgetc( fp ) ) )
+    for( ;; )
     {
-        buf[ rd++ ] = ( char ) c;
-        if( rd == sz )
+        char    spare[ 4096 ];
+        char    *to     = ( rd + 1 < cap ) ? buf + rd : spare;                             // A full buffer is only grown if
+        ssize_t n       = read( fd, to, ( spare == to ) ? sizeof( spare ) : cap - rd - 1 ); // there turns out to be more
+
+        if( 0 == n )
         {
-            if( !( buf = (char *) realloc( (void *) (bSave = buf ), sz += 512 ) ) )
+            break;
+        } else if( 0 > n ) {
+            if( EINTR == errno )
+            {
+                continue;
+            }
+            perror( "read" );
+            free( buf );
+            return NULL;
+        } else if( spare == to ) {
+            char    *nBuf = (char *) realloc( buf, cap = cap * 2 + (size_t) n );
+
+            if( ! nBuf )
             {
-                snprintf( bSave, 1023, "realloc Failed to allocate %d bytes of memory", sz );
-                perror( bSave );
-                free( bSave );
-                return rtn;
+                fprintf( stderr, "%s[%d]: Failed to allocate %zu bytes of memory\n", __FILE__, __LINE__, cap );
+                free( buf );
+                return NULL;
             }
+            buf = nBuf;
+            memcpy( buf + rd, spare, (size_t) n );
         }
+        rd += (size_t) n;
     }
     buf[ rd ] = '\0';
+    if( len )
+    {
+        *len = rd;
+    }
+    return buf;
+}
+
+/*
+ * Map a regular file for CppONParseOptions::fileStrings.  The file is mapped over an anonymous mapping a page
+ * longer than it, so even a file that fills its last page is followed by a zero byte.  NULL if it is not a regular
+ * file or can not be mapped, and the caller reads it as usual.
+ */
+static std::shared_ptr<COFileRegion> mapFileRegion( const char *path )
+{
+    std::shared_ptr<COFileRegion>   r       = std::make_shared<COFileRegion>();
+    size_t                          page    = (size_t) sysconf( _SC_PAGESIZE );
+    struct stat                     st;
+    void                            *m;
+
+    if( 0 > ( r->fd = open( path, O_RDONLY | O_CLOEXEC ) ) || fstat( r->fd, &st ) || ! S_ISREG( st.st_mode ) || 0 >= st.st_size )
+    {
+        return NULL;
+    }
+    r->len = (size_t) st.st_size;
+    r->mapLen = ( r->len / page + 1 ) * page;
+    if( MAP_FAILED == ( m = mmap( NULL, r->mapLen, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) ) )
+    {
+        perror( "mmap" );
+        return NULL;
+    }
+    r->map = (char *) m;
+    if( MAP_FAILED == mmap( r->map, r->len, PROT_READ, MAP_PRIVATE | MAP_FIXED, r->fd, 0 ) )
+    {
+        perror( "mmap" );
+        return NULL;
+    }
+    return r;
+}
+
+CppON *CppON::parseJsonFile( const char *path, CppONParseOptions &opts )
+{
+    char        *buf;
+    FILE        *fp;
+    size_t      len;
+    CppON       *rtn    = NULL;
+
+    if( opts.fileStrings )
+    {
+        std::shared_ptr<COFileRegion>   region = mapFileRegion( path );
+
+        if( region )
+        {
+            return parseJson( region->map, region->map + region->len, &region, opts );      // The strings left in it hold the mapping
+        }
+    }
+    if( !( fp = fopen( path, "r" ) ) )
+    {
+        char estr[ 1024 ];
+        snprintf( estr, 1023, "fopen Failed to open JSON FILE \"%s\"", path );
+        perror( estr );
+        return rtn;
+    }
+    buf = readWholeFile( fp, &len );
     fclose( fp );
-    rtn = parseJson( buf );
-    free(buf );
+    if( buf )
+    {
+        rtn = parseJson( buf, len, opts );
+        free(buf );
+    }
     return ( rtn );
 }
 
+/*
+ * Read a single object from a stream one character at a time so nothing past it is consumed.
+ * Use COStreamReader to read a long stream of concatenated documents.
+ */
 CppON *CppON::readObj( FILE *fp )
 {
     CppON       *rtn    = NULL;
     int         otype   = -1;
     int         stype   = -1;
-    unsigned    rd      = 0;
+    size_t      rd      = 0;
     int         c;
     unsigned    levels  = 0;
     bool        done    = false;
 
     if( fp )
     {
-        unsigned    sz = 1024;
+        size_t      sz = 1024;
         char        *buf,*bSave;
 
         if( !( buf = (char *) malloc( sz ) ) )
@@ -999,7 +1806,7 @@ CppON *CppON::readObj( FILE *fp )
                     buf[ rd++ ] = ( char ) c;
                     if( rd == sz )
                     {
-                        if( !( buf = (char *) realloc( (void *) (bSave = buf ), sz += 512 ) ) )
+                        if( !( buf = (char *) realloc( (void *) (bSave = buf ), sz *= 2 ) ) )
                         {
                             perror( bSave );
                             free( bSave );
@@ -1040,7 +1847,7 @@ CppON *CppON::readObj( FILE *fp )
                                     } else if( '[' == c ) {
                                         levels = 4;
                                         stype = 2;
-                                    } else if ( ('0' <= c && c <= 9 ) || '-' == c || '+' == c ) {
+                                    } else if ( ('0' <= c && c <= '9' ) || '-' == c || '+' == c ) {
                                         levels = 4;
                                         stype = 3;
                                     } else if( 't' == c || 'T' == c    ) {                                // true?
@@ -1211,1446 +2018,1285 @@ CppON  *CppON::diff( CppON &newObj, const char *name )
     }
     return NULL;
 }
-#if HAS_XML
 
 /*
- * Routine to trim white space off the beginning and end of the content of a text node
+ * Drop one owner of a node.  Nodes that have been shared by dedupe() just lose a reference, all others are deleted.
+ * Containers call this for their children instead of using delete directly.
  */
+void CppON::release( CppON *obj )
+{
+    if( obj )
+    {
+        if( obj->refs )
+        {
+            obj->refs--;
+        } else {
+            delete obj;
+        }
+    }
+}
 
-static char *trimTag( xmlNodePtr con )
+/*
+ * Deferred destruction.  deleteAsync() only queues a tree.  reclaim() takes the queued trees apart one node at a
+ * time - children are moved to a work stack and the emptied container is deleted - so it can stop after any
+ * number of nodes and carry on in the next call.  Nodes shared through dedupe() are released, not freed, as
+ * release() does.  Either call reclaim() from a loop that has time to spare, or let backgroundReclaim( true ) run
+ * it on its own thread.  Shared node counts are not atomic, so a tree freed on the background thread must not
+ * share nodes with trees the rest of the program still uses.
+ */
+static std::mutex               reclaimQueueLock;                                           // Guards reclaimQueue and the thread state
+static std::mutex               reclaimWorkLock;                                            // One reclaim() at a time
+static std::condition_variable  reclaimWake;
+static std::vector<CppON *>     reclaimQueue;                                               // Trees handed over by deleteAsync()
+static std::vector<CppON *>     reclaimWork;                                                // Nodes of trees being taken apart
+static std::thread              reclaimThread;
+static bool                     reclaimRunning  = false;
+
+void CppON::deleteAsync( CppON *obj )
 {
-    char  *rtn = NULL;
-    if( con )
+    if( obj )
     {
-        if( !( xmlStrcmp( con->name, (const xmlChar *) "text" ) )  && con->content )        // Make sure it is a text node with content
+        if( obj->refs )
         {
-            char   *oPtr;
-            char   *inPtr = (char *)con->content;
-            char   *ePtr;
-            char   ch;
+            obj->refs--;
+        } else {
+            std::lock_guard<std::mutex> lock( reclaimQueueLock );
 
-            rtn  = new char[ strlen( (const char *) con->content ) + 1 ];                   // Create a string that is at least the same size
-            oPtr = ePtr = rtn;                                                              //  as the original string
+            reclaimQueue.push_back( obj );
+            if( reclaimRunning )
+            {
+                reclaimWake.notify_one();
+            }
+        }
+    }
+}
 
-            while( ' ' == ( ch = *inPtr++ ) || '\n' == ch || '\t' == ch  );                 // Skip over Leading white space
+size_t CppON::reclaimPending()
+{
+    std::lock_guard<std::mutex> lock( reclaimQueueLock );
 
-            if( ch )                                                                        // If string had at least one non-white space character it is good
+    return reclaimQueue.size();
+}
+
+size_t CppON::reclaim( size_t maxNodes )
+{
+    std::lock_guard<std::mutex> work( reclaimWorkLock );
+    size_t                      freed = 0;
+
+    while( ! maxNodes || maxNodes > freed )
+    {
+        CppON *n;
+
+        if( reclaimWork.empty() )
+        {
+            std::lock_guard<std::mutex> lock( reclaimQueueLock );
+
+            if( reclaimQueue.empty() )
             {
-                do                                                                          // Copy all characters until end of string
+                break;
+            }
+            reclaimWork.swap( reclaimQueue );
+        }
+        n = reclaimWork.back();
+        reclaimWork.pop_back();
+        if( n->data && MAP_CPPON_OBJ_TYPE == n->typ )
+        {
+            map <string, CppON*> *m = ( map <string, CppON *> * ) n->data;
+
+            for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; ++it )
+            {
+                if( it->second && it->second->refs )
                 {
-                    *oPtr++ = ch;
-                    if( ' ' != ch && '\t' != ch && '\n' != ch )                             // Remember place of last non-white space, + 1
-                    {
-                        ePtr = oPtr;
-                    }
-                } while( ( ch = *inPtr++ ) );                                               // Keep going until null is found
+                    it->second->refs--;
+                } else if( it->second ) {
+                    reclaimWork.push_back( it->second );
+                }
+            }
+            m->clear();
+        } else if( n->data && ARRAY_CPPON_OBJ_TYPE == n->typ ) {
+            vector<CppON *> *v = ( vector<CppON *> * ) n->data;
 
-                *ePtr = '\0';                                                               // Put a null at place saved of space after last non white space
-            } else {
-                delete[] rtn;                                                               // empty string so delete it, and return NULL.
-                rtn = NULL;
+            for( size_t i = 0; v->size() > i; i++ )                                         // Slots before the head are NULL
+            {
+                CppON *c = ( *v )[ i ];
+
+                if( c && c->refs )
+                {
+                    c->refs--;
+                } else if( c ) {
+                    reclaimWork.push_back( c );
+                }
             }
+            v->clear();
         }
+        delete n;
+        freed++;
     }
-    return rtn;
+    return freed;
 }
 
 /*
- * Simple static routine to just check if the cursor has any non-text children.
+ * Body of the background reclaimer: sleep until deleteAsync() queues something, then free it in slices so
+ * backgroundReclaim( false ) does not wait for a whole tree.
  */
-
-static bool hasChildren( xmlNodePtr cur )
+static void reclaimLoop()
 {
-    bool rtn = false;
-    while( cur )
+    std::unique_lock<std::mutex> lock( reclaimQueueLock );
+
+    while( reclaimRunning )
     {
-        if( 1 == cur->type )
+        if( reclaimQueue.empty() )
         {
-            rtn = true;
+            reclaimWake.wait( lock );
+        } else {
+            lock.unlock();
+            while( CppON::reclaim( RECLAIM_SLICE_NODES ) ) {}
+            lock.lock();
         }
-        cur = cur->next;
     }
-    return rtn;
+}
+
+void CppON::backgroundReclaim( bool on )
+{
+    std::unique_lock<std::mutex> lock( reclaimQueueLock );
+
+    if( on && ! reclaimRunning )
+    {
+        reclaimRunning = true;
+        reclaimThread = std::thread( reclaimLoop );
+    } else if( ! on && reclaimRunning ) {
+        reclaimRunning = false;
+        reclaimWake.notify_one();
+        lock.unlock();
+        reclaimThread.join();
+    }
 }
 
 /*
- * Iterative routine to parse XML nodes.
- * A node may be a simple node of type string, integer, double, boolean or null
- * A map that contains children
- * An array that contains children
- * attributes are considered children and will have a '-' prepended to the name.
- * Nodes that have attributes or other children along with text will have the text added as a node named "#text"
- * This routing will call itself to resolve all of its children do do the simple node level
+ * Stops the background reclaimer when the program exits so the std::thread is never destroyed while joinable.
  */
+static struct ReclaimStopper
+{
+    ~ReclaimStopper() { CppON::backgroundReclaim( false ); }
+} reclaimStopper;
 
-static int parseNode( xmlNodePtr cur, CppON *parent, std:: string indent )
+/*
+ * Convert the source text of a lazy number (see CppONParseOptions::lazyNumbers) into its value.  The text stays
+ * in str and is still used for output until the value is changed.  A lazy string is a COFileString, read in here.
+ */
+void CppON::parseRaw()
 {
-    xmlNodePtr             childCur;
-    xmlNodePtr            cur2;
-    xmlNodePtr            cur3;
-    CppON                *root = NULL;
-    CppON                *childObj = NULL;
-    _xmlAttr            *attr = NULL;
-    int                    rtn = 0;
-    char                *value;
-    static std::string    preStr = "";
+    if( STRING_CPPON_OBJ_TYPE == typ )
+    {
+        // cppcheck-suppress cstyleCast
+        ( (COFileString *) this )->load();                                                  // Only a COFileString is lazy
+        return;
+    }
+    lazy = false;
+    if( data && INTEGER_CPPON_OBJ_TYPE == typ && sizeof( int64_t ) == siz )
+    {
+        *( (int64_t *) data ) = strtoll( str.c_str(), NULL, 10 );
+    } else if( data && DOUBLE_CPPON_OBJ_TYPE == typ ) {
+        *( (double *) data ) = strtod( str.c_str(), NULL );
+    }
+}
 
-    indent += "  ";
-    if( !cur )
+/*
+ * Structural comparison used by dedupe().  Unlike operator== this requires maps to have the same keys in the
+ * same order and integers to be stored in the same size so that two identical trees serialize the same way.
+ */
+bool CppON::identical( CppON *obj )
+{
+    if( this == obj )
     {
-        return 0;
+        return true;
     }
-    if( 1 == cur->type )                                                                // Don't parse non-nodes
+    if( STRING_CPPON_OBJ_TYPE == typ && obj && STRING_CPPON_OBJ_TYPE == obj->typ && ( lazy || obj->lazy ) )
     {
-        bool children = hasChildren( cur->xmlChildrenNode );
-        if( ( attr = cur->properties ) || children )                                      // If it has properties it must be at least a map
-        {
-            if( parent->isMap() )
-            {
-                // cppcheck-suppress cstyleCast
-                ((COMap *)parent )->append( (const char * ) cur->name, root = new COMap() );
-            } else if( parent->isArray() ) {
-                // cppcheck-suppress cstyleCast
-                ((COArray *)parent )->append( root = new COMap() );
-            }
-            parent = root;
+        // cppcheck-suppress cstyleCast
+        size_t      len = ( (COString *) this )->size();
+        // cppcheck-suppress cstyleCast
+        const char  *a  = ( lazy ) ? ( (COFileString *) this )->bytes() : ( ( data ) ? ( (std::string *) data )->data() : "" );
+        // cppcheck-suppress cstyleCast
+        const char  *b  = ( obj->lazy ) ? ( (COFileString *) obj )->bytes() : ( ( obj->data ) ? ( (std::string *) obj->data )->data() : "" );
 
-            /*
-             * do attributes
-             */
-            for( ; attr; attr = attr->next )
-            {
-                std::string name = "-";                                                            // Attributes are children with the '-' prepended to their name
-                name += (const char *) attr->name;
-                childObj = CppON::guessDataType( (const char *) attr->children->content );  // decide data type from content
-                if( parent->isMap() )                                                          // different routines to add node to array or map
-                {
-                    // cppcheck-suppress cstyleCast
-                    ( ( COMap *) parent)->append( name, childObj );
-                } else if( parent->isArray() ) {
-                    // cppcheck-suppress cstyleCast
-                    ( ( COArray *) parent)->append( childObj );
-                }
-            }
-            if( ( childCur = cur->xmlChildrenNode ) )
+        // cppcheck-suppress cstyleCast
+        return ( len == ( (COString *) obj )->size() && ( a == b || ! memcmp( a, b, len ) ) );     // Compared where they are
+    }
+    if( ! obj || typ != obj->typ || ( NULL == data ) != ( NULL == obj->data ) )
+    {
+        return false;
+    }
+    if( ! data )
+    {
+        return true;
+    }
+    switch( typ )
+    {
+        case INTEGER_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            return ( siz == obj->siz && ((COInteger *) this)->longValue() == ((COInteger *) obj)->longValue() );
+        case DOUBLE_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            return ( precision == obj->precision && ((CODouble *) this)->doubleValue() == ((CODouble *) obj)->doubleValue() );
+        case STRING_CPPON_OBJ_TYPE:
+            return ( *( (std::string *) data ) == *( (std::string *) obj->data ) );
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            return ( ((COBoolean *) this)->value() == ((COBoolean *) obj)->value() );
+        case NULL_CPPON_OBJ_TYPE:
+            return true;
+        case MAP_CPPON_OBJ_TYPE:
             {
-                for( cur2 = childCur; cur2; cur2 = cur2->next )                                // Process all children
+                map<string, CppON *>    *m  = (map<string, CppON *> *) data;
+                map<string, CppON *>    *o  = (map<string, CppON *> *) obj->data;
+
+                if( m->size() != o->size() || order != obj->order )
                 {
-                    if( 1 == cur2->type )
+                    return false;
+                }
+                for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; ++it )
+                {
+                    map<string, CppON *>::iterator ot = o->find( it->first );
+                    if( o->end() == ot || ! it->second->identical( ot->second ) )
                     {
-                        bool         arrayMember = false;
-                        std::string  tagName = (const char *)cur2->name;
-                        for( cur3 = cur2->next; cur3; cur3 = cur3->next )                          // See if they are part of an array
-                        {
-                            if( !xmlStrcmp( (const xmlChar *)tagName.c_str(), cur3->name ) )
-                            {
-                                arrayMember = true;                                                    //    if the same name appears it must be an array
-                            }
-                        }
-                        if( arrayMember )                                                          // Process all array children together
-                        {
-                            if( parent->isMap() )
-                            {
-                                // cppcheck-suppress cstyleCast
-                                ( ( COMap *) parent)->append( tagName, childObj = new COArray() );
-                            } else if( parent->isArray() ) {
-                                // cppcheck-suppress cstyleCast
-                                ( ( COArray *) parent)->append( childObj = new COArray() );
-                            }
-                            preStr = "\n  ";
-                            preStr += indent;
-                            parseNode( cur2, childObj, indent + "  " );
-                            for( cur3 = cur2->next; cur3; )                                          // See if they are part of an array
-                            {
-                                xmlNodePtr cur4 = cur3;
-                                cur3 = cur3->next;                                                    // Get next pointer in case we delete this one
-                                if( !xmlStrcmp( (const xmlChar *)tagName.c_str(), cur4->name ) )
-                                {
-                                    parseNode( cur4, childObj, indent + "  " );
-                                    xmlUnlinkNode( cur4 );
-                                    xmlFreeNode( cur4 );
-                                }
-                            }
-                        } else {
-                            preStr = "";
-                            parseNode( cur2, parent, indent );
-                        }
-                    } else if( ( value = trimTag( cur->xmlChildrenNode ) ) ) {                  // Node has attribute and content
-                        // cppcheck-suppress cstyleCast
-                        ( ( COMap *) parent)->append( "#text", childObj = new COString( value ) );
-                        delete[] value;
+                        return false;
                     }
                 }
             }
-        } else if( ( value = trimTag( cur->xmlChildrenNode ) ) ) {
-            childObj = CppON::guessDataType( value );
-            delete[] value;
-            if( parent->isMap() )
-            {
-                // cppcheck-suppress cstyleCast
-                ( ( COMap *) parent)->append( (const char *)cur->name, childObj  );
-            } else if( parent->isArray() ) {
-                // cppcheck-suppress cstyleCast
-                ( ( COArray *) parent)->append( childObj );
-            }
-        }
-    } else {
-        if( (value = trimTag( cur ) ) )
-        {
-            childObj = CppON::guessDataType( value );
-            delete[] value;
-            if( parent->isMap() )
+            return true;
+        case ARRAY_CPPON_OBJ_TYPE:
             {
                 // cppcheck-suppress cstyleCast
-                ( ( COMap *) parent)->append( indent, childObj );
-            } else if( parent->isArray() ) {
+                COArray     *a  = (COArray *) this;
                 // cppcheck-suppress cstyleCast
-                ( ( COArray *) parent)->append( childObj );
+                COArray     *b  = (COArray *) obj;
+
+                if( a->size() != b->size() )
+                {
+                    return false;
+                }
+                for( size_t i = 0; a->size() > i; i++ )
+                {
+                    if( ! a->at( i )->identical( b->at( i ) ) )
+                    {
+                        return false;
+                    }
+                }
             }
-        }
+            return true;
+        default:
+            break;
     }
-    return rtn;
+    return false;
 }
 
-// cppcheck-suppress unusedFunction
-CppON *CppON::parseXML( const char *str )
+/*
+ * Approximate the heap used by a tree.  This counts the objects, their data and the container bookkeeping
+ * but not the allocator's own overhead.  If "nodes" is given the number of nodes in the tree is added to it.
+ */
+size_t CppON::memSize( size_t *nodes )
 {
-    CppON         *rtn = NULL;
-    xmlDocPtr       doc;
-    xmlNodePtr       cur;
+    size_t      rtn     = 0;
 
-    if( ! str )
+    if( nodes )
     {
-        fprintf( stderr, "Attempt to convert an empty string to a data Object\n");
-    } else if( !( doc = ( '.' == *str || '/' == *str) ? xmlParseFile( str ) : xmlParseDoc( (const xmlChar *)str ) ) ) {
-        fprintf( stderr, "Empty Document!\n" );
-        xmlFreeDoc( doc );
-    } else if( !(cur = xmlDocGetRootElement( doc ) ) ) {
-        fprintf( stderr, "Failed to get root node!\n" );
-        xmlFreeDoc( doc );
-    } else {
-        rtn = new COMap( );                                      // Create the new Map object to return
-        parseNode( cur, rtn, std::string( "" ) );
-        xmlFreeDoc( doc );
+        (*nodes)++;
     }
-    return rtn;
-}
-#endif
-
-// cppcheck-suppress unusedFunction
-CppON *CppON::parseTSV(const char *str )
-{
-    COArray     *rtn    = NULL;
-
-    if( ! str || ! str[ 0 ] )
+    switch( typ )
     {
-        fprintf( stderr, "Attempt to convert an empty string to a data Object\n");
-    }  else {
-        FILE *fd;
-        if( ! ( fd = fopen( str, "r" ) ) )
-        {
-            fprintf( stderr, "Failed to open file %s: %d - %s\n",str, errno, strerror( errno ) );
-        } else {
-            int           ch = 0;
-            std::string   s;
-            COArray       *line= new COArray();
-            rtn = new COArray();
-            while( EOF != ( ch = fgetc( fd ) ) )
+        case INTEGER_CPPON_OBJ_TYPE:
+            rtn = sizeof( COInteger ) + ( ( data ) ? siz : 0 );
+            break;
+        case DOUBLE_CPPON_OBJ_TYPE:
+            rtn = sizeof( CODouble ) + ( ( data ) ? sizeof( double ) : 0 );
+            break;
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            rtn = sizeof( COBoolean ) + ( ( data ) ? sizeof( bool ) : 0 );
+            break;
+        case NULL_CPPON_OBJ_TYPE:
+            rtn = sizeof( CONull );
+            break;
+        case STRING_CPPON_OBJ_TYPE:
+            rtn = sizeof( COString );
+            if( data )
             {
-                if( '\n' == ch )
+                std::string *sp = (std::string *) data;
+                rtn += sizeof( std::string ) + ( ( sizeof( std::string ) <= sp->capacity() ) ? sp->capacity() + 1 : 0 );
+            }
+            break;
+        case MAP_CPPON_OBJ_TYPE:
+            rtn = sizeof( COMap );
+            if( data )
+            {
+                map<string, CppON *>    *m  = (map<string, CppON *> *) data;
+
+                rtn += sizeof( *m ) + order.capacity() * sizeof( std::string );
+                for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; ++it )
                 {
-                    line->append( new COString( s ) );
-                    s.clear();
-                    rtn->append( line );
-                    line = new COArray();
-                } else if( '\t' == ch ) {
-                    line->append( new COString( s ) );
-                    s.clear();
-                } else if( 31 <= ch && 127 > ch ) {
-                    s += ch;
+                    size_t  klen = ( sizeof( std::string ) <= it->first.capacity() ) ? it->first.capacity() + 1 : 0;
+                    rtn += 4 * sizeof( void * ) + sizeof( *it ) + 2 * klen;                                      // tree node + key in map and order
+                    rtn += it->second->memSize( nodes );
                 }
             }
-            delete( line );
-            fclose( fd );
-        }
+            break;
+        case ARRAY_CPPON_OBJ_TYPE:
+            rtn = sizeof( COArray );
+            if( data )
+            {
+                // cppcheck-suppress cstyleCast
+                COArray     *a  = (COArray *) this;
+
+                rtn += sizeof( vector<CppON *> ) + ( (vector<CppON *> *) data )->capacity() * sizeof( CppON * );
+                for( size_t i = 0; a->size() > i; i++ )
+                {
+                    rtn += a->at( i )->memSize( nodes );
+                }
+            }
+            break;
+        default:
+            break;
     }
     return rtn;
 }
 
-// cppcheck-suppress unusedFunction
-CppON *CppON::parseCSV(const char *str )
+/*
+ * The part of a tree's memSize() that deleting it would not free: nodes shared through dedupe() are only released,
+ * so they and everything below them stay.  Their nodes are added to "nodes".
+ */
+static size_t sharedSize( CppON *obj, size_t *nodes )
 {
-    COArray     *rtn    = NULL;
+    size_t  rtn = 0;
 
-    if( ! str || ! str[ 0 ] )
+    if( obj->isShared() )
     {
-        fprintf( stderr, "Attempt to convert an empty string to a data Object\n");
-    }  else {
-        FILE *fd;
-        if( ! ( fd = fopen( str, "r" ) ) )
-        {
-            fprintf( stderr, "Failed to open file %s: %d - %s\n",str, errno, strerror( errno ) );
-        } else {
-            int           ch = 0;
-            std::string   s;
-            COArray       *line= new COArray();
+        return obj->memSize( nodes );
+    } else if( CppON::isMap( obj ) ) {
+        // cppcheck-suppress cstyleCast
+        std::map<std::string, CppON *> *m = ( (COMap *) obj )->value();
 
-            rtn = new COArray();
+        for( std::map<std::string, CppON *>::iterator it = m->begin(); m->end() != it; ++it )
+        {
+            rtn += sharedSize( it->second, nodes );
+        }
+    } else if( CppON::isArray( obj ) ) {
+        // cppcheck-suppress cstyleCast
+        COArray *a = (COArray *) obj;
 
-            while( EOF != ( ch = fgetc( fd ) ) )
-            {
-                if( '\n' == ch )
-                {
-                    line->append( new COString( s ) );
-                    s.clear();
-                    rtn->append( line );
-                    line = new COArray();
-                } else if( ',' == ch ) {
-                    line->append( new COString( s ) );
-                    s.clear();
-                } else if( 31 <= ch && 127 > ch ) {
-                    s += ch;
-                }
-            }
-            delete( line );
-            fclose( fd );
+        for( size_t i = 0; a->size() > i; i++ )
+        {
+            rtn += sharedSize( a->at( i ), nodes );
         }
     }
     return rtn;
 }
 
+#define FNV_OFFSET_BASIS    0xCBF29CE484222325ULL
+#define FNV_PRIME           0x00000100000001B3ULL
+
+static __inline uint64_t fnvHash( uint64_t h, const void *buf, size_t len )
+{
+    const unsigned char *p = (const unsigned char *) buf;
+
+    while( len-- )
+    {
+        h ^= *p++;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static __inline uint64_t hashMix( uint64_t h, uint64_t v ) { return h ^ ( v + 0x9E3779B97F4A7C15ULL + ( h << 6 ) + ( h >> 2 ) ); }
+
 /*
- * This routine parses a "TNetString" into a CppON object
+ * Compute the structural hash of a tree bottom up.  If a table is given, every Map or Array child is looked up in
+ * it once its own children have been processed.  A child identical to one already in the table is replaced by a
+ * reference to the one in the table, otherwise it is added to it.  Because children are made canonical before
+ * their parents are compared, the identical() check of two parents stops at the first shared child pointer.
  */
-CppON *CppON::parse( const char *str, char **rstr )
+uint64_t CppON::hashTree( std::unordered_multimap< uint64_t, CppON *> *table, CppONDedupeStats *stats )
 {
-    CppON       *rtn    = NULL;
+    uint64_t    h       = fnvHash( FNV_OFFSET_BASIS, &typ, sizeof( typ ) );
 
-    if( str && *str )
+    if( lazy && STRING_CPPON_OBJ_TYPE == typ )
     {
-        COMap      *mp;
-        COArray      *ar;
-        char       *ptr, *ptr1;
-        int     len = strtol( str, &ptr, 10 );
-
-        ptr++;    // Point at next character
-        if( rstr )
-        {
-            *rstr = &ptr[ len + 1 ];
-        }
-        switch ( ptr[ len ] )
-        {
-            case ',':
-                {
-                    char buf[ len + 1 ];
-                    strncpy( buf, ptr, len );
-                    buf[ len ]='\0';
-                    rtn = new COString( string( buf ) );
-                }
-                break;
-            case '#':
-                {
-                    uint64_t ia = strtoll( ptr, NULL, 10);
-                    rtn = new COInteger( ia );
-                }
-                break;
-            case '^':
-                {
-                    double id = strtod( ptr, NULL );
-                    rtn = new CODouble( id );
-                }
-                break;
-            case '!':
-                {
-                    char buf[ len + 1 ];
-                    strncpy( buf, ptr, len );
-                    buf[ len ]= '\0';
-                    rtn = new COBoolean( ( 0 == strcasecmp( "true", buf ) ) || ( 0 == strcasecmp( "t", buf ) ) );
-                }
-                break;
-            case '~':
-                rtn = new CONull();
-                break;
-            case '}':
+        // cppcheck-suppress cstyleCast
+        return fnvHash( h, ( (COFileString *) this )->bytes(), siz );                       // Hashed in the file, as a string in memory would be
+    }
+    if( ! data )
+    {
+        return h;
+    }
+    switch( typ )
+    {
+        case INTEGER_CPPON_OBJ_TYPE:
+            {
+                // cppcheck-suppress cstyleCast
+                int64_t v = ((COInteger *) this)->longValue();
+                h = fnvHash( fnvHash( h, &siz, sizeof( siz ) ), &v, sizeof( v ) );
+            }
+            break;
+        case DOUBLE_CPPON_OBJ_TYPE:
+            {
+                // cppcheck-suppress cstyleCast
+                double v = ((CODouble *) this)->doubleValue();
+                h = fnvHash( fnvHash( h, &precision, sizeof( precision ) ), &v, sizeof( v ) );
+            }
+            break;
+        case STRING_CPPON_OBJ_TYPE:
+            h = fnvHash( h, ( (std::string *) data )->data(), ( (std::string *) data )->length() );
+            break;
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            {
+                // cppcheck-suppress cstyleCast
+                bool v = ((COBoolean *) this)->value();
+                h = fnvHash( h, &v, sizeof( v ) );
+            }
+            break;
+        case MAP_CPPON_OBJ_TYPE:
+        case ARRAY_CPPON_OBJ_TYPE:
+            {
+                map<string, CppON *>    *m      = ( MAP_CPPON_OBJ_TYPE == typ ) ? (map<string, CppON *> *) data : NULL;
+                // cppcheck-suppress cstyleCast
+                COArray                 *a      = ( ARRAY_CPPON_OBJ_TYPE == typ ) ? (COArray *) this : NULL;
+                size_t                  count   = ( m ) ? order.size() : (size_t) a->size();
+
+                for( size_t idx = 0; count > idx; idx++ )
                 {
-                    char buf[ len + 1 ];
-                    strncpy( buf, ptr, len );
-                    buf[ len ]='\0';
-                    ptr = buf;
-                    rtn = mp = new COMap();
-                    while( CppON *mykey = CppON::parse( ptr, &ptr1 ) )
+                    map<string, CppON *>::iterator  it;
+                    CppON                           **slot;
+
+                    if( m )
                     {
-                        if( STRING_CPPON_OBJ_TYPE != mykey->type() )
+                        it = m->find( order[ idx ] );
+                        h = fnvHash( h, it->first.data(), it->first.length() + 1 );
+                        slot = &it->second;
+                    } else {
+                        slot = &( ( *a->value() )[ idx ] );
+                    }
+                    CppON       *child  = *slot;
+                    uint64_t    ch      = child->hashTree( table, stats );
+
+                    if( table && ( MAP_CPPON_OBJ_TYPE == child->typ || ARRAY_CPPON_OBJ_TYPE == child->typ ) )
+                    {
+                        CppON   *canon = NULL;
+                        std::pair< std::unordered_multimap< uint64_t, CppON *>::iterator, std::unordered_multimap< uint64_t, CppON *>::iterator > range = table->equal_range( ch );
+
+                        for( std::unordered_multimap< uint64_t, CppON *>::iterator ti = range.first; range.second != ti; ++ti )
                         {
-                            if( mykey )                // Should never happen but this will satisfy the stupid analyzer.
+                            if( ti->second->identical( child ) )
                             {
-                                delete mykey;
+                                canon = ti->second;
+                                break;
                             }
-                            delete mp;
-                            return NULL;
                         }
-                        if( CppON *myval = CppON::parse( ptr1, &ptr ) )
+                        if( ! canon )
                         {
-                            // cppcheck-suppress cstyleCast
-                            mp->append( ((COString *)mykey)->c_str(), myval );
-                            delete( mykey );
+                            table->insert( std::pair< uint64_t, CppON * >( ch, child ) );
+                        } else if( canon != child ) {
+                            if( stats && ! child->refs )
+                            {
+                                size_t  kept    = 0;
+
+                                stats->subtrees++;
+                                stats->bytes += child->memSize( &stats->nodes );
+                                stats->bytes -= sharedSize( child, &kept );                 // Children already deduped stay
+                                stats->nodes -= kept;
+                            }
+                            canon->refs++;
+                            release( child );
+                            *slot = canon;
                         }
                     }
+                    h = hashMix( h, ch );
                 }
-                break;
-            case ']':
-                {
-                    char buf[ len + 1];
-                    strncpy( buf, ptr, len );
-                    buf[ len ]='\0';
-                    ptr = buf;
-                    rtn = ar = new COArray();
-                    while( CppON *myval = CppON::parse( ptr, &ptr1 ) )
-                    {
-                        ar->append( myval );
-                        ptr = ptr1;
-                    }
-                }
-                break;
-            default:
-                fprintf( stderr, "\t\tCppON:parse:unknown type %c\n", ptr[ len ] );
-                //fprintf( stderr, "\t\t'%s'\n", str );
-                break;
-        }
+            }
+            break;
+        default:
+            break;
     }
-    return rtn;
+    return h;
 }
 
 /*
- * Little comparison function that returns 0 if two byte arrays are equal, 1 otherwise
+ * Hash-cons a tree.  Every Map or Array that is structurally identical to one found earlier in the walk is
+ * replaced by a reference to the first one, so large documents that repeat the same blocks keep only one copy.
+ * The returned statistics tell how many subtrees, nodes and (approximately) bytes were freed.
+ * See the notes in the header about shared nodes being read only.
  */
-static __inline int argCmp( const unsigned char *arg, int argSize, const unsigned char *val, int valSize )
+CppONDedupeStats CppON::dedupe()
 {
-    if( argSize != valSize )
-    {
-        return 1;
-    }
-    while( argSize-- )
+    CppONDedupeStats                                stats;
+    std::unordered_multimap< uint64_t, CppON *>     table;
+
+    if( MAP_CPPON_OBJ_TYPE == typ || ARRAY_CPPON_OBJ_TYPE == typ )
     {
-        if( arg[ argSize ] != val[ argSize ] )
-        {
-            return 1;
-        }
+        hashTree( &table, &stats );
     }
-    return 0;
+    return stats;
 }
 
+#if HAS_XML
+
 /*
- * Search a TNetString for a char string tag equal to an argument.
- *     arg - The null terminated character string you are looking for. (Yes it must be an ASCII C string)
- *     str - Pointer to the size part of the TNetString.  It must be terminated with a ':' per the spec
- *     next - Optional pointer used to return a pointer to the byte count of the next object in the string
- *     cnt - An optional pointer returning the size of the string.
+ * Routine to trim white space off the beginning and end of the content of a text node
  */
 
-unsigned char *CppON::findTNetStringArg( const char *arg, int argSize, const char *str, const char **next, int *cnt )
+static char *trimTag( xmlNodePtr con )
 {
-    unsigned char   *rtn    = NULL;
-    unsigned char   *_cPtr;
-
-    if( str && *str && arg && *arg )
+    char  *rtn = NULL;
+    if( con )
     {
-        if( '}' == *str || ']' == *str )
-        {
-            str++;
-        }
-        int _dSz = strtol( str, (char **)&_cPtr, 10 );
-        if( _cPtr && ':' == *_cPtr++  )
+        if( !( xmlStrcmp( con->name, (const xmlChar *) "text" ) )  && con->content )        // Make sure it is a text node with content
         {
-            unsigned char   _uc;
-            if( '}' == ( _uc =  _cPtr[ _dSz ] ) )                        // object is hash map so check every one
+            char   *oPtr;
+            char   *inPtr = (char *)con->content;
+            char   *ePtr;
+            char   ch;
+
+            rtn  = new char[ strlen( (const char *) con->content ) + 1 ];                   // Create a string that is at least the same size
+            oPtr = ePtr = rtn;                                                              //  as the original string
+
+            while( ' ' == ( ch = *inPtr++ ) || '\n' == ch || '\t' == ch  );                 // Skip over Leading white space
+
+            if( ch )                                                                        // If string had at least one non-white space character it is good
             {
-                char   *_cTmp = (char *)_cPtr;
-                int    _dTmp;
-                for( int sz = _dSz; 0 < sz; )
-                {
-                    if( ( rtn = CppON::findTNetStringArg( arg, argSize,  _cTmp, (const char **)&_cTmp, &_dTmp ) ) )
-                    {
-                        _dSz = _dTmp;
-                        break;
-                    }
-                    if( 0 < (sz = _dSz - ( ( _cTmp - (char *)_cPtr ) +_dTmp + 1) ) && ',' == _cTmp[ -1 ] )
-                    {
-                        char  *_cTmp2;
-                        _dTmp = strtol( _cTmp, &_cTmp2, 10 );
-                        if( ',' == _cTmp2[ _dTmp + 1 ] )
-                        {
-                            _cTmp = _cTmp2 + _dTmp + 2;
-                        }
-                    }
-                }
-            } else if( ']' == _uc ) {                                // object is an array so check them
-                char   *_cTmp = (char *)_cPtr;
-                int    _dTmp;
-                for( int sz = _dSz; 0 < sz; )
-                {
-                    if( ( rtn = CppON::findTNetStringArg( arg, argSize,  _cTmp, (const char **)&_cTmp, &_dTmp ) ) )
-                    {
-                        _dSz = _dTmp;
-                        break;
-                    }
-                    sz = _dSz - ( ( _cTmp - (char *)_cPtr ) +_dTmp + 1 );
-                }
-            } else if( ',' == _uc && !argCmp( (unsigned char *) arg, argSize, _cPtr, _dSz ) ) {        // String, right length, equal
-                                                                                                    //     Found tag now return next
-                _cPtr += _dSz + 1;                                                                    // Point to size of next tag
-                if( *_cPtr )                                                                        // If not EOS
+                do                                                                          // Copy all characters until end of string
                 {
-                    _dSz = strtol( (char *)_cPtr, (char **)&_cPtr, 10 );                            // Get the size
-                    if( ':' == *_cPtr++ )                                                            // Next char of a valid tag is ":"
+                    *oPtr++ = ch;
+                    if( ' ' != ch && '\t' != ch && '\n' != ch )                             // Remember place of last non-white space, + 1
                     {
-                        rtn = _cPtr;
+                        ePtr = oPtr;
                     }
-                }
+                } while( ( ch = *inPtr++ ) );                                               // Keep going until null is found
+
+                *ePtr = '\0';                                                               // Put a null at place saved of space after last non white space
+            } else {
+                delete[] rtn;                                                               // empty string so delete it, and return NULL.
+                rtn = NULL;
             }
         }
-        if( cnt )
-        {
-            *cnt = _dSz;
-        }
-        if( next && _cPtr )
-        {
-            *next = (char * )_cPtr + _dSz + 1;
-        }
-    } else {
-        fprintf( stderr, "Error\n");
-        if( arg )
-        {
-            fprintf( stderr,"arg = %s\n", arg );
-        } else {
-            fprintf( stderr, "arg == NULL\n" );
-        }
-        if( str )
-        {
-            fprintf( stderr, "str = %s\n", str );
-        } else {
-            fprintf( stderr, "str == NULL\n" );
-        }
-        if( cnt )
-        {
-            *cnt = 0;
-        }
-        if( next )
-        {
-            *next = NULL;
-        }
     }
     return rtn;
 }
 
-long long CppON::toLongInt(void)
-{
-    long long   rtn     = 0;
+/*
+ * Simple static routine to just check if the cursor has any non-text children.
+ */
 
-    switch (typ)
+static bool hasChildren( xmlNodePtr cur )
+{
+    bool rtn = false;
+    while( cur )
     {
-        case INTEGER_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = ((COInteger *)this)->longValue();
-            break;
-        case DOUBLE_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = (long long) ((CODouble *)this)->doubleValue();
-            break;
-        case STRING_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = strtol( ( ( COString *)this)->c_str(), NULL, 0 );
-            break;
-        case BOOLEAN_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = ( ((COBoolean *) this)->value() ) ? 1LL : 0LL;
-            break;
-        default:
-            break;
+        if( 1 == cur->type )
+        {
+            rtn = true;
+        }
+        cur = cur->next;
     }
     return rtn;
 }
 
-int  CppON::toInt(void)
-{
-    int         rtn     = 0;
-
-    switch (typ)
-    {
-        case INTEGER_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = ((COInteger *)this)->intValue();
-            break;
-        case DOUBLE_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = (int) ((CODouble *)this)->doubleValue();
-            break;
-        case STRING_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = strtol( ( ( COString *)this)->c_str(), NULL, 0 );
-            break;
-        case BOOLEAN_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = ( ((COBoolean *) this)->value() ) ? 1 : 0;
-            break;
-        default:
-            break;
-    }
-    return rtn;
-}
-bool CppON::toBoolean( void )
-{
-    bool        rtn     = false;
+/*
+ * Iterative routine to parse XML nodes.
+ * A node may be a simple node of type string, integer, double, boolean or null
+ * A map that contains children
+ * An array that contains children
+ * attributes are considered children and will have a '-' prepended to the name.
+ * Nodes that have attributes or other children along with text will have the text added as a node named "#text"
+ * This routing will call itself to resolve all of its children do do the simple node level
+ */
 
-    switch( typ )
-    {
-        case BOOLEAN_CPPON_OBJ_TYPE:
-            rtn = ((COBoolean*) this)->value();
-            break;
-        case DOUBLE_CPPON_OBJ_TYPE:
-            rtn = ( 0.0 != ((CODouble *) this)->doubleValue() );
-            break;
-        case INTEGER_CPPON_OBJ_TYPE:
-            rtn = ( 0 != ((COInteger *) this)->intValue() );
-            break;
-        case STRING_CPPON_OBJ_TYPE:
-            rtn = ( 0 == strcasecmp( ( (COString *) this )->c_str(), "True" ) );
-            break;
-        default:
-            break;
-    }
-    return rtn;
-}
-double CppON::toDouble( void )
+static int parseNode( xmlNodePtr cur, CppON *parent, std:: string indent )
 {
-    double      rtn     = UD_DOUBLE;
+    xmlNodePtr             childCur;
+    xmlNodePtr            cur2;
+    xmlNodePtr            cur3;
+    CppON                *root = NULL;
+    CppON                *childObj = NULL;
+    _xmlAttr            *attr = NULL;
+    int                    rtn = 0;
+    char                *value;
+    static std::string    preStr = "";
 
-    switch (typ)
+    indent += "  ";
+    if( !cur )
     {
-        case DOUBLE_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = ((CODouble *)this)->doubleValue();
-            break;
-        case INTEGER_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = (double)((COInteger *)this)->intValue();
-            break;
-        case STRING_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = strtod( ( ( COString *)this)->c_str(), NULL );
-            break;
-        case BOOLEAN_CPPON_OBJ_TYPE:
-            // cppcheck-suppress cstyleCast
-            rtn = ( ((COBoolean *) this)->value() ) ? 1.0 : 0.0;
-            break;
-        default:
-            break;
+        return 0;
     }
-    return rtn;
-}
-
-CppON *CppON::operator = ( CppON &val )
-{
-    typ = val.typ;
-    switch( val.typ )
+    if( 1 == cur->type )                                                                // Don't parse non-nodes
     {
-        case INTEGER_CPPON_OBJ_TYPE:
-            deleteData();
-            switch( siz = val.size() )
+        bool children = hasChildren( cur->xmlChildrenNode );
+        if( ( attr = cur->properties ) || children )                                      // If it has properties it must be at least a map
+        {
+            if( parent->isMap() )
             {
-                case sizeof( char ):
-                    data = new ( char );
-                    *((char*) data) = ((COInteger *) &val )->charValue();
-                    break;
-                case sizeof( short ):
-                    data = new ( short );
-                    *((short*) data) = ((COInteger*) &val )->shortValue();
-                    break;
-                case sizeof( int ):
-                    data = new ( int );
-                    *((int*) data) = ((COInteger*) &val )->intValue();
-                    break;
-                default:
-                    data = new ( long long );
-                    *((long long*) data) = ((COInteger*) &val )->longValue();
-                    break;
+                // cppcheck-suppress cstyleCast
+                ((COMap *)parent )->append( (const char * ) cur->name, root = new COMap() );
+            } else if( parent->isArray() ) {
+                // cppcheck-suppress cstyleCast
+                ((COArray *)parent )->append( root = new COMap() );
             }
-            break;
-        case DOUBLE_CPPON_OBJ_TYPE:
-            if( data )
+            parent = root;
+
+            /*
+             * do attributes
+             */
+            for( ; attr; attr = attr->next )
             {
-                if( 0 < this->precision  && 16 >= this->precision )
+                std::string name = "-";                                                            // Attributes are children with the '-' prepended to their name
+                name += (const char *) attr->name;
+                childObj = CppON::guessDataType( (const char *) attr->children->content );  // decide data type from content
+                if( parent->isMap() )                                                          // different routines to add node to array or map
                 {
-                    double t;
-                    double pow_10 = 1;
-                    double n = *((double*) (*this).data);
-                    double d = ((CODouble *) &val )->doubleValue();
-                    if( this->precision )
-                    {
-                        pow_10 = pow( 10.0, this->precision);
-                        n *= pow_10;
-                        d *= pow_10;
-                    }
-                    t = n - d;
-                    if( 0.75 < t || -0.75 > t )
-                    {
-                        *((double*) (*this).data) = round( d )/ pow_10;
-                    }
-                } else {
-                    *((double *) data) = ((CODouble *) &val )->doubleValue();
+                    // cppcheck-suppress cstyleCast
+                    ( ( COMap *) parent)->append( name, childObj );
+                } else if( parent->isArray() ) {
+                    // cppcheck-suppress cstyleCast
+                    ( ( COArray *) parent)->append( childObj );
                 }
-            } else {
-                data = new double;
-                *((double *) data) = ((CODouble *) &val )->doubleValue();
             }
-            break;
-        case STRING_CPPON_OBJ_TYPE:
-            deleteData();
-            data = ( val.data ) ? new std::string( ( ( std::string *) val.data )->c_str() ): NULL;
-            break;
-        case NULL_CPPON_OBJ_TYPE:
-            siz = val.siz;
-            break;
-        case BOOLEAN_CPPON_OBJ_TYPE:
-            data = new(char);
-            *( ( char *) data) = ((COBoolean *) &val )->value();
-            siz = 1;
-            break;
-        case MAP_CPPON_OBJ_TYPE:
+            if( ( childCur = cur->xmlChildrenNode ) )
             {
-                deleteData();
-                siz = val.size();
-                data = new map<string, CppON*>();
-                map<string, CppON*> *th = (map<string, CppON*> *) data;
-                COMap  *m = (COMap *) &val;
-                // cppcheck-suppress postfixOperator
-                for( std::vector<std::string>::iterator itr = m->order.begin(); m->order.end() != itr; itr++ )
+                for( cur2 = childCur; cur2; cur2 = cur2->next )                                // Process all children
                 {
-                    CppON *obj = m->findCaseElement( itr->c_str() );
-                    if( obj )
+                    if( 1 == cur2->type )
                     {
-                        order.push_back( string( *itr ) );
-                        switch( obj->typ )
+                        bool         arrayMember = false;
+                        std::string  tagName = (const char *)cur2->name;
+                        for( cur3 = cur2->next; cur3; cur3 = cur3->next )                          // See if they are part of an array
                         {
-                            case INTEGER_CPPON_OBJ_TYPE:
+                            if( !xmlStrcmp( (const xmlChar *)tagName.c_str(), cur3->name ) )
+                            {
+                                arrayMember = true;                                                    //    if the same name appears it must be an array
+                            }
+                        }
+                        if( arrayMember )                                                          // Process all array children together
+                        {
+                            if( parent->isMap() )
+                            {
                                 // cppcheck-suppress cstyleCast
-                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COInteger( *((COInteger *)obj ) ) ) );
-                                break;
-                            case DOUBLE_CPPON_OBJ_TYPE:
+                                ( ( COMap *) parent)->append( tagName, childObj = new COArray() );
+                            } else if( parent->isArray() ) {
+                                // cppcheck-suppress cstyleCast
+                                ( ( COArray *) parent)->append( childObj = new COArray() );
+                            }
+                            preStr = "\n  ";
+                            preStr += indent;
+                            parseNode( cur2, childObj, indent + "  " );
+                            for( cur3 = cur2->next; cur3; )                                          // See if they are part of an array
+                            {
+                                xmlNodePtr cur4 = cur3;
+                                cur3 = cur3->next;                                                    // Get next pointer in case we delete this one
+                                if( !xmlStrcmp( (const xmlChar *)tagName.c_str(), cur4->name ) )
                                 {
-                                    // cppcheck-suppress cstyleCast
-                                    char p = ( (CODouble *)obj )->Precision();
-                                    CODouble *d;
-                                    // cppcheck-suppress cstyleCast
-                                    th->insert( th->end(), pair< string, CppON* >( itr->c_str(), d = new CODouble( *( (CODouble *)obj ) ) ) );
-                                    if( 0 <= p )
-                                    {
-                                        d->Precision( p );
-                                    }
+                                    parseNode( cur4, childObj, indent + "  " );
+                                    xmlUnlinkNode( cur4 );
+                                    xmlFreeNode( cur4 );
                                 }
-                                break;
-                            case STRING_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COString( *( (COString *)obj ) ) ) );
-                                break;
-                            case NULL_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new CONull( *( (CONull *)obj ) ) ) );
-                                break;
-                            case BOOLEAN_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COBoolean( *( (COBoolean *)obj ) ) ) );
-                                break;
-                            case MAP_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COMap( *( (COMap *)obj ) ) ) );
-                                break;
-                            case ARRAY_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COArray( *( (COArray *)obj ) ) ) );
-                                break;
-                            default:
-                                break;
-                        }
+                            }
+                        } else {
+                            preStr = "";
+                            parseNode( cur2, parent, indent );
+                        }
+                    } else if( ( value = trimTag( cur->xmlChildrenNode ) ) ) {                  // Node has attribute and content
+                        // cppcheck-suppress cstyleCast
+                        ( ( COMap *) parent)->append( "#text", childObj = new COString( value ) );
+                        delete[] value;
                     }
                 }
             }
-            break;
-        case ARRAY_CPPON_OBJ_TYPE:
+        } else if( ( value = trimTag( cur->xmlChildrenNode ) ) ) {
+            childObj = CppON::guessDataType( value );
+            delete[] value;
+            if( parent->isMap() )
             {
-                deleteData();
-                siz = val.size();
-                data = new vector<CppON *>();
-                for( int i = 0; siz > i; i++ )
-                {
-                    CppON *jt = ((COArray &) val ).at( i );
-                    switch( jt->type() )
-                    {
-                        case INTEGER_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            ((COArray*)this)->append( new COInteger( *((COInteger *)jt ) ) );
-                            break;
-                        case DOUBLE_CPPON_OBJ_TYPE:
-                            {
-                                // cppcheck-suppress cstyleCast
-                                char p = ( (CODouble *)jt )->Precision();
-                                CODouble *d;
-                                // cppcheck-suppress cstyleCast
-                                ((COArray*)this)->append( d = new CODouble( *( (CODouble *)jt ) ) );
-                                if( 0 <= p )
-                                {
-                                    d->Precision( p );
-                                }
-                            }
-                            break;
-                        case STRING_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            ((COArray*)this)->append( new COString( *( (COString *)jt ) ) );
-                            break;
-                        case NULL_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            ((COArray*)this)->append( new CONull( *( (CONull *)jt ) ) );
-                            break;
-                        case BOOLEAN_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            ((COArray*)this)->append( new COBoolean( *( (COBoolean *)jt ) ) );
-                            break;
-                        case MAP_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            ((COArray*)this)->append( new COMap( *( (COMap *)jt ) ) );
-                            break;
-                        case ARRAY_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            ((COArray*)this)->append( new COArray( *( (COArray *)jt ) ) );
-                            break;
-                        default:
-                            break;
-                    }
-                }
+                // cppcheck-suppress cstyleCast
+                ( ( COMap *) parent)->append( (const char *)cur->name, childObj  );
+            } else if( parent->isArray() ) {
+                // cppcheck-suppress cstyleCast
+                ( ( COArray *) parent)->append( childObj );
             }
-            break;
-        default:
-            break;
+        }
+    } else {
+        if( (value = trimTag( cur ) ) )
+        {
+            childObj = CppON::guessDataType( value );
+            delete[] value;
+            if( parent->isMap() )
+            {
+                // cppcheck-suppress cstyleCast
+                ( ( COMap *) parent)->append( indent, childObj );
+            } else if( parent->isArray() ) {
+                // cppcheck-suppress cstyleCast
+                ( ( COArray *) parent)->append( childObj );
+            }
+        }
     }
-
-    return this;
+    return rtn;
 }
 
-/****************************************************************************************/
-/*                                                                                      */
-/*                                         COBoolean                                    */
-/*                                                                                      */
-/****************************************************************************************/
-
-string *COBoolean::toNetString()
+// cppcheck-suppress unusedFunction
+CppON *CppON::parseXML( const char *str )
 {
-    if( !data )
+    CppON         *rtn = NULL;
+    xmlDocPtr       doc;
+    xmlNodePtr       cur;
+
+    if( ! str )
     {
-        return NULL;
+        fprintf( stderr, "Attempt to convert an empty string to a data Object\n");
+    } else if( !( doc = ( '.' == *str || '/' == *str) ? xmlParseFile( str ) : xmlParseDoc( (const xmlChar *)str ) ) ) {
+        fprintf( stderr, "Empty Document!\n" );
+        xmlFreeDoc( doc );
+    } else if( !(cur = xmlDocGetRootElement( doc ) ) ) {
+        fprintf( stderr, "Failed to get root node!\n" );
+        xmlFreeDoc( doc );
+    } else {
+        rtn = new COMap( );                                      // Create the new Map object to return
+        parseNode( cur, rtn, std::string( "" ) );
+        xmlFreeDoc( doc );
     }
-    const char *val = *( (char *) data )  ? "true" : "false";
-    return CppON::toNetString( val, '!' );
+    return rtn;
 }
+#endif
 
-string *COBoolean::toJsonString()
+// cppcheck-suppress unusedFunction
+CppON *CppON::parseTSV(const char *str )
 {
-    return new string( ((value())? "true" : "false") );
-}
+    COArray     *rtn    = NULL;
 
-void COBoolean::dump( FILE *fp )
-{
-    fprintf( fp, "%s", (data) ? ( ( *(char *)data ) ? "true":"false") : "NULL" );
-}
-void COBoolean::cdump( FILE *fp )
-{
-    fprintf( fp, "%s", (data) ? ( ( *(char *)data ) ? "true":"false") : "false" );
-}
-const char  *COBoolean::c_str()
-{
-    str = ( data && *( (char *) data ))? "true" : "false";
-    return str.c_str();
+    if( ! str || ! str[ 0 ] )
+    {
+        fprintf( stderr, "Attempt to convert an empty string to a data Object\n");
+    }  else {
+        FILE *fd;
+        if( ! ( fd = fopen( str, "r" ) ) )
+        {
+            fprintf( stderr, "Failed to open file %s: %d - %s\n",str, errno, strerror( errno ) );
+        } else {
+            int           ch = 0;
+            std::string   s;
+            COArray       *line= new COArray();
+            rtn = new COArray();
+            while( EOF != ( ch = fgetc( fd ) ) )
+            {
+                if( '\n' == ch )
+                {
+                    line->append( new COString( s ) );
+                    s.clear();
+                    rtn->append( line );
+                    line = new COArray();
+                } else if( '\t' == ch ) {
+                    line->append( new COString( s ) );
+                    s.clear();
+                } else if( 31 <= ch && 127 > ch ) {
+                    s += ch;
+                }
+            }
+            delete( line );
+            fclose( fd );
+        }
+    }
+    return rtn;
 }
 
-/****************************************************************************************/
-/*                                                                                      */
-/*                                    COMap                                             */
-/*                                                                                      */
-/****************************************************************************************/
-
-COMap::COMap( COMap *mt ) : CppON(  MAP_CPPON_OBJ_TYPE )
+// cppcheck-suppress unusedFunction
+CppON *CppON::parseCSV(const char *str )
 {
-    data = new map<string, CppON*>();
-    std::map< std::string, CppON * >  &dm = *( ( map<string, CppON*> * ) data );
+    COArray     *rtn    = NULL;
 
-    // cppcheck-suppress postfixOperator
-    for( std::vector<std::string>::iterator itr = mt->order.begin(); mt->order.end() != itr; itr++ )
+    if( ! str || ! str[ 0 ] )
     {
-        CppON *obj = mt->findCaseElement( itr->c_str() );
-        order.push_back( string( *itr ) );
-        switch( obj->type() )
+        fprintf( stderr, "Attempt to convert an empty string to a data Object\n");
+    }  else {
+        FILE *fd;
+        if( ! ( fd = fopen( str, "r" ) ) )
         {
-            case INTEGER_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COInteger( *((COInteger *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case DOUBLE_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new CODouble( *( (CODouble *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case STRING_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COString( *( (COString *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case NULL_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new CONull( *( (CONull *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case BOOLEAN_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COBoolean( *( (COBoolean *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case MAP_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COMap( *( (COMap *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case ARRAY_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COArray( *( (COArray *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            default:
-                break;
+            fprintf( stderr, "Failed to open file %s: %d - %s\n",str, errno, strerror( errno ) );
+        } else {
+            int           ch = 0;
+            std::string   s;
+            COArray       *line= new COArray();
+
+            rtn = new COArray();
+
+            while( EOF != ( ch = fgetc( fd ) ) )
+            {
+                if( '\n' == ch )
+                {
+                    line->append( new COString( s ) );
+                    s.clear();
+                    rtn->append( line );
+                    line = new COArray();
+                } else if( ',' == ch ) {
+                    line->append( new COString( s ) );
+                    s.clear();
+                } else if( 31 <= ch && 127 > ch ) {
+                    s += ch;
+                }
+            }
+            delete( line );
+            fclose( fd );
         }
     }
+    return rtn;
 }
 
-COMap::COMap( COMap & mt ) : CppON(  MAP_CPPON_OBJ_TYPE )
+/*
+ * This routine parses a "TNetString" into a CppON object
+ */
+CppON *CppON::parse( const char *str, char **rstr )
 {
-    data = new map<string, CppON*>();
-    std::map< std::string, CppON * >  &dm = *( ( map<string, CppON*> * ) data );
+    CppON       *rtn    = NULL;
 
-    // cppcheck-suppress postfixOperator
-    for( std::vector<std::string>::iterator itr = mt.order.begin(); mt.order.end() != itr; itr++ )
+    if( str && *str )
     {
-        CppON *obj = mt.findCaseElement( itr->c_str() );
-        order.push_back( string( *itr ) );
-        switch( obj->type() )
+        COMap      *mp;
+        COArray      *ar;
+        char       *ptr, *ptr1;
+        size_t     len = (size_t) strtoull( str, &ptr, 10 );
+
+        ptr++;    // Point at next character
+        if( rstr )
         {
-            case INTEGER_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COInteger( *((COInteger *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case DOUBLE_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new CODouble( *( (CODouble *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case STRING_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COString( *( (COString *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case NULL_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new CONull( *( (CONull *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case BOOLEAN_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COBoolean( *( (COBoolean *)obj ) );
-                // cppcheck-suppress cstyleCast
-                break;
-            case MAP_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COMap( *( (COMap *)obj ) );
-                // cppcheck-suppress cstyleCast
+            *rstr = &ptr[ len + 1 ];
+        }
+        switch ( ptr[ len ] )
+        {
+            case ',':
+                rtn = new COString( string( ptr, strnlen( ptr, len ) ) );
                 break;
-            case ARRAY_CPPON_OBJ_TYPE:
-                dm[ *itr ] = new COArray( *( (COArray *)obj ) );
-                // cppcheck-suppress cstyleCast
+            case '#':
+                {
+                    uint64_t ia = strtoll( ptr, NULL, 10);
+                    rtn = new COInteger( ia );
+                }
                 break;
-            default:
+            case '^':
+                {
+                    double id = strtod( ptr, NULL );
+                    rtn = new CODouble( id );
+                }
                 break;
-        }
-    }
-};
-
-/*
- * Does not check for null string
- */
-void COMap::doParse( const char *str )
-{
-    DumpWhiteSpace( str );
-    const char    *sav = str;
-    unsigned     i;
-    if( '{' == *str )
-    {
-        char         name[ 256 ];
-        char        ch;
-        CppON        *obj = NULL;
-        ++str;
-        DumpWhiteSpace( ch, str );
-        while( *str )
-        {
-            sav = str;
-            if( '"' == *str++ )
-            {
-                for( i = 0; i < 255 && 0 != ( ch = *str++ ) && '"' != ch; i++ )
+            case '!':
                 {
-                    name[ i ] = ch;
+                    string buf( ptr, strnlen( ptr, len ) );
+
+                    rtn = new COBoolean( ( 0 == strcasecmp( "true", buf.c_str() ) ) || ( 0 == strcasecmp( "t", buf.c_str() ) ) );
                 }
-                name[ i ] = '\0';
-                if( '"' == ch )
+                break;
+            case '~':
+                rtn = new CONull();
+                break;
+            case '}':
                 {
-                    DumpWhiteSpace( ch, str );
-                    sav = str;
-                    if( ':' == ch )
+                    string buf( ptr, strnlen( ptr, len ) );
+
+                    ptr = &buf[ 0 ];
+                    rtn = mp = new COMap();
+                    while( CppON *mykey = CppON::parse( ptr, &ptr1 ) )
                     {
-                        ++str;
-                        DumpWhiteSpace( ch, str );
-                        sav = str;
-                        while( 0 != (ch = *str ) && ( ' ' == ch || '\t' == ch || '\n' == ch || '\r' == ch ) ) { ++str; }
-                        if( '0' <= ch && '9' >= ch )
-                        {
-                            obj = GetTNetstring( &str );
-                        } else if( ch ) {
-                            obj =  GetObj( &str );
-                        }
-                        if( obj )
+                        if( STRING_CPPON_OBJ_TYPE != mykey->type() )
                         {
-                            append( name, obj );
-                            obj = NULL;
-                            DumpWhiteSpace( ch, str );
-                            if( ch )
+                            if( mykey )                // Should never happen but this will satisfy the stupid analyzer.
                             {
-                                if( ',' == *str )
-                                {
-                                    str++;
-                                    DumpWhiteSpace( ch, str );
-                                } else if( '}' == *str ) {
-                                    break;
-                                } else {
-                                    fprintf( stderr, "%s[%d]: Unexpected character: '%c'\n", __FILE__,__LINE__, *str );
-                                    break;
-                                }
+                                delete mykey;
                             }
-                        } else {
-                            std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
-                            fprintf( stderr, "%s[%d]: Failed to get object: '%s'\n", __FILE__,__LINE__, s.c_str() );
+                            delete mp;
+                            return NULL;
+                        }
+                        if( CppON *myval = CppON::parse( ptr1, &ptr ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            mp->append( ((COString *)mykey)->c_str(), myval );
+                            delete( mykey );
                         }
-                    } else {
-                        std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
-                        fprintf( stderr, "%s[%d]: Unexpected character: '%s'\n", __FILE__,__LINE__, sav );
-                        break;
                     }
-                } else {
-                    std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
-                    fprintf( stderr, "%s[%d]: Unexpected character: '%s'\n", __FILE__,__LINE__, sav );
-                    break;
                 }
-            } else {
-                std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
-                fprintf( stderr, "%s[%d]: Unexpected character: '%s'\n", __FILE__,__LINE__, sav );
                 break;
-            }
+            case ']':
+                {
+                    string buf( ptr, strnlen( ptr, len ) );
+
+                    ptr = &buf[ 0 ];
+                    rtn = ar = new COArray();
+                    while( CppON *myval = CppON::parse( ptr, &ptr1 ) )
+                    {
+                        ar->append( myval );
+                        ptr = ptr1;
+                    }
+                }
+                break;
+            default:
+                fprintf( stderr, "\t\tCppON:parse:unknown type %c\n", ptr[ len ] );
+                //fprintf( stderr, "\t\t'%s'\n", str );
+                break;
         }
-    } else {
-        std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
-        fprintf( stderr, "%s[%d]: Parse ERROR: Expected '{' got '%s'\n", __FILE__, __LINE__, sav );
     }
+    return rtn;
 }
 
-void COMap::parseData( const char *str )
+/*
+ * Little comparison function that returns 0 if two byte arrays are equal, 1 otherwise
+ */
+static __inline int argCmp( const unsigned char *arg, int argSize, const unsigned char *val, int valSize )
 {
-    if( str )
+    if( argSize != valSize )
     {
-        doParse( str );
+        return 1;
+    }
+    while( argSize-- )
+    {
+        if( arg[ argSize ] != val[ argSize ] )
+        {
+            return 1;
+        }
     }
+    return 0;
 }
 
-COMap::COMap( const char *path, const char *file ): CppON( MAP_CPPON_OBJ_TYPE )
+/*
+ * Search a TNetString for a char string tag equal to an argument.
+ *     arg - The null terminated character string you are looking for. (Yes it must be an ASCII C string)
+ *     str - Pointer to the size part of the TNetString.  It must be terminated with a ':' per the spec
+ *     next - Optional pointer used to return a pointer to the byte count of the next object in the string
+ *     cnt - An optional pointer returning the size of the string.
+ */
+
+unsigned char *CppON::findTNetStringArg( const char *arg, int argSize, const char *str, const char **next, int *cnt )
 {
-    data = new map<string, CppON*>();
-    struct stat     _stat;
-    std::string p( path );
-    FILE    *fp;
+    unsigned char   *rtn    = NULL;
+    unsigned char   *_cPtr;
 
-    if( '/' != p.back() )
-    {
-        p += '/';
-    }
-    p.append( file );
-    if( ! stat( p.c_str(), &_stat ) && ! ( _stat.st_mode & DIRECTORY_BIT ) && (fp = fopen( p.c_str(), "r" ) ) )
+    if( str && *str && arg && *arg )
     {
-        int     sz = 1024;
-        char    *buf,*bSave;
-        int     rd = 0;
-        int     c;
-
-        if( !( buf = (char *) malloc( sz ) ) )
+        if( '}' == *str || ']' == *str )
         {
-            fclose( fp );
-            fprintf( stderr, "%s[%.4u]: Failed to allocate memory",__FILE__, __LINE__ );
+            str++;
         }
-        while( EOF != ( c = fgetc( fp ) ) )
+        int _dSz = strtol( str, (char **)&_cPtr, 10 );
+        if( _cPtr && ':' == *_cPtr++  )
         {
-            buf[ rd++ ] = ( char ) c;
-            if( rd == sz )
+            unsigned char   _uc;
+            if( '}' == ( _uc =  _cPtr[ _dSz ] ) )                        // object is hash map so check every one
             {
-                if( !( buf = (char *) realloc( (void *) (bSave = buf ), sz += 512 ) ) )
+                char   *_cTmp = (char *)_cPtr;
+                int    _dTmp;
+                for( int sz = _dSz; 0 < sz; )
+                {
+                    if( ( rtn = CppON::findTNetStringArg( arg, argSize,  _cTmp, (const char **)&_cTmp, &_dTmp ) ) )
+                    {
+                        _dSz = _dTmp;
+                        break;
+                    }
+                    if( 0 < (sz = _dSz - ( ( _cTmp - (char *)_cPtr ) +_dTmp + 1) ) && ',' == _cTmp[ -1 ] )
+                    {
+                        char  *_cTmp2;
+                        _dTmp = strtol( _cTmp, &_cTmp2, 10 );
+                        if( ',' == _cTmp2[ _dTmp + 1 ] )
+                        {
+                            _cTmp = _cTmp2 + _dTmp + 2;
+                        }
+                    }
+                }
+            } else if( ']' == _uc ) {                                // object is an array so check them
+                char   *_cTmp = (char *)_cPtr;
+                int    _dTmp;
+                for( int sz = _dSz; 0 < sz; )
+                {
+                    if( ( rtn = CppON::findTNetStringArg( arg, argSize,  _cTmp, (const char **)&_cTmp, &_dTmp ) ) )
+                    {
+                        _dSz = _dTmp;
+                        break;
+                    }
+                    sz = _dSz - ( ( _cTmp - (char *)_cPtr ) +_dTmp + 1 );
+                }
+            } else if( ',' == _uc && !argCmp( (unsigned char *) arg, argSize, _cPtr, _dSz ) ) {        // String, right length, equal
+                                                                                                    //     Found tag now return next
+                _cPtr += _dSz + 1;                                                                    // Point to size of next tag
+                if( *_cPtr )                                                                        // If not EOS
                 {
-                    fprintf( stderr, "%s[%.4u]: Failed to reallocate memory: %d bytes!",__FILE__, __LINE__, sz );
-                    free( bSave );
+                    _dSz = strtol( (char *)_cPtr, (char **)&_cPtr, 10 );                            // Get the size
+                    if( ':' == *_cPtr++ )                                                            // Next char of a valid tag is ":"
+                    {
+                        rtn = _cPtr;
+                    }
                 }
             }
         }
-        buf[ rd ] = '\0';
-        fclose( fp );
-        parseData( buf );
-        free(buf );
-    } else {
-        fprintf( stderr, "%s[%.4u]: Failed to open JSON FILE \"%s\"",__FILE__, __LINE__, p.c_str() );
+        if( cnt )
+        {
+            *cnt = _dSz;
+        }
+        if( next && _cPtr )
+        {
+            *next = (char * )_cPtr + _dSz + 1;
+        }
+    } else {
+        fprintf( stderr, "Error\n");
+        if( arg )
+        {
+            fprintf( stderr,"arg = %s\n", arg );
+        } else {
+            fprintf( stderr, "arg == NULL\n" );
+        }
+        if( str )
+        {
+            fprintf( stderr, "str = %s\n", str );
+        } else {
+            fprintf( stderr, "str == NULL\n" );
+        }
+        if( cnt )
+        {
+            *cnt = 0;
+        }
+        if( next )
+        {
+            *next = NULL;
+        }
     }
+    return rtn;
 }
 
-COMap::COMap( const char *str ): CppON(  MAP_CPPON_OBJ_TYPE )
+long long CppON::toLongInt(void)
 {
-    data = new map<string, CppON*>();
-    parseData( str );
-}
+    long long   rtn     = 0;
 
-COMap *COMap::operator=( const char *str )
-{
-    if( data )
+    switch (typ)
     {
-        (( map <string, CppON *> * ) data)->clear();
-    } else {
-        data = new map<string, CppON*>();
+        case INTEGER_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = ((COInteger *)this)->longValue();
+            break;
+        case DOUBLE_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = (long long) ((CODouble *)this)->doubleValue();
+            break;
+        case STRING_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = strtol( ( ( COString *)this)->c_str(), NULL, 0 );
+            break;
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = ( ((COBoolean *) this)->value() ) ? 1LL : 0LL;
+            break;
+        default:
+            break;
     }
-    order.clear();
-    doParse( str );
-    return this;
+    return rtn;
 }
 
-// cppcheck-suppress unusedFunction
-void COMap::replaceObj( string s, CppON *obj )
+int  CppON::toInt(void)
 {
-    map <string, CppON *> *m = ( map <string, CppON*> *) data;
-    map <string, CppON *>::iterator it;
-    if( m->end( ) != (it = m->find( s ) ) )
+    int         rtn     = 0;
+
+    switch (typ)
     {
-        delete it->second;
-        it->second = obj;
+        case INTEGER_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = ((COInteger *)this)->intValue();
+            break;
+        case DOUBLE_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = (int) ((CODouble *)this)->doubleValue();
+            break;
+        case STRING_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = strtol( ( ( COString *)this)->c_str(), NULL, 0 );
+            break;
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = ( ((COBoolean *) this)->value() ) ? 1 : 0;
+            break;
+        default:
+            break;
     }
+    return rtn;
 }
-
-// cppcheck-suppress unusedFunction
-void COMap::removeVal( string s )
+bool CppON::toBoolean( void )
 {
-    map <string, CppON *> *m = ( map <string, CppON*> *) data;
-    map <string, CppON *>::iterator it;
+    bool        rtn     = false;
 
-    if( m->end( ) != (it = m->find( s ) ) )
+    switch( typ )
     {
-        m->erase( it );
-        for( std::vector<std::string>::iterator iter = order.begin(); order.end() != iter; ++iter )
-        {
-            if( ! iter->compare( s ) )
-            {
-                order.erase( iter );
-                break;
-            }
-        }
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            rtn = ((COBoolean*) this)->value();
+            break;
+        case DOUBLE_CPPON_OBJ_TYPE:
+            rtn = ( 0.0 != ((CODouble *) this)->doubleValue() );
+            break;
+        case INTEGER_CPPON_OBJ_TYPE:
+            rtn = ( 0 != ((COInteger *) this)->intValue() );
+            break;
+        case STRING_CPPON_OBJ_TYPE:
+            rtn = ( 0 == strcasecmp( ( (COString *) this )->c_str(), "True" ) );
+            break;
+        default:
+            break;
     }
+    return rtn;
 }
-
-void COMap::clear( )
+double CppON::toDouble( void )
 {
-    map <string, CppON*> *m = ( map <string, CppON *> * ) data;
-    map<string, CppON *>::iterator it;
+    double      rtn     = UD_DOUBLE;
 
-    // cppcheck-suppress postfixOperator
-    for( it = m->begin(); m->end() != it; it++ )
+    switch (typ)
     {
-        delete( it->second);
+        case DOUBLE_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = ((CODouble *)this)->doubleValue();
+            break;
+        case INTEGER_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = (double)((COInteger *)this)->intValue();
+            break;
+        case STRING_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = strtod( ( ( COString *)this)->c_str(), NULL );
+            break;
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            rtn = ( ((COBoolean *) this)->value() ) ? 1.0 : 0.0;
+            break;
+        default:
+            break;
     }
-    m->clear();
-    order.clear();
+    return rtn;
 }
 
-void COMap::merge( COMap *targetObj, const char *name )
+CppON *CppON::operator = ( CppON &val )
 {
-    if( ! data )
-    {
-        data = new std::map<std::string, CppON*>();                                                 // data object you are merging too.
-    }
-    map<string, CppON *> *s = (map<string, CppON *> *) targetObj->data;                             // s is the data object of the map you are merging
-
-    for( map< string, CppON *>::iterator ti = s->begin(); s->end() != ti; ++ti )                    // foreach object in map you are merging
+    materialize();
+    lazy = raw = false;
+    typ = val.typ;
+    switch( val.typ )
     {
-        const string                    *targetStr = &(ti->first);                                  // get Object name
-        CppONType                        _eType = (ti->second)->type();                             // get type of object
-        CppON                            *myObj = NULL;                                             // Place to save an object that is found.
-        map<string, CppON *>::iterator  it;                                                         // Used to search destination
-        map<string, CppON *> *m = (map<string, CppON *> *) data;                                    // Search the destination for any objects with the same name.
-
-        // cppcheck-suppress postfixOperator
-        for( it = m->begin(); m->end() != it; it++ )
-        {
-            if( ! strcmp(  (it->first).c_str(), targetStr->c_str() ) )                              // Find the object
+        case INTEGER_CPPON_OBJ_TYPE:
+            deleteData();
+            switch( siz = val.size() )
             {
-                myObj = it->second;                                                                 // OK we have it already. set "myObj" to it and quit looking
-                break;
+                case sizeof( char ):
+                    data = new ( char );
+                    *((char*) data) = ((COInteger *) &val )->charValue();
+                    break;
+                case sizeof( short ):
+                    data = new ( short );
+                    *((short*) data) = ((COInteger*) &val )->shortValue();
+                    break;
+                case sizeof( int ):
+                    data = new ( int );
+                    *((int*) data) = ((COInteger*) &val )->intValue();
+                    break;
+                default:
+                    data = new ( long long );
+                    *((long long*) data) = ((COInteger*) &val )->longValue();
+                    break;
             }
-        }
-        if( myObj )                                                                                 // We found it so we need to merge the reasult
-        {
-            switch( _eType )                                                                        // The merge is handled differently depending on type of object it is
+            if( val.raw )
             {
-                case INTEGER_CPPON_OBJ_TYPE:                                                        // If it is an integer
-                    if( INTEGER_CPPON_OBJ_TYPE == myObj->type())                                    //    If the old object is the same type then we
-                    {
-                        // cppcheck-suppress cstyleCast
-                        *((COInteger *) myObj) = (long long)(COInteger *)(ti->second )->toLongInt();// set it to the new one
-                    } else {                                                                        //    If not
-                        m->erase( it );                                                             //      Delete it and add the new object
-                        delete myObj;
-                        // cppcheck-suppress cstyleCast
-                        append( targetStr->c_str(), new COInteger( (uint64_t)(COInteger *)( ti->second )->toLongInt( ) ) );
-                    }
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:                                                         //  If it is a double (like an integer )
-                    if( DOUBLE_CPPON_OBJ_TYPE == myObj->type())                                     //      If the old object is also a double
+                str = val.str;
+                raw = true;
+            }
+            break;
+        case DOUBLE_CPPON_OBJ_TYPE:
+            if( data )
+            {
+                if( 0 < this->precision  && 16 >= this->precision )
+                {
+                    double t;
+                    double pow_10 = 1;
+                    double n = *((double*) (*this).data);
+                    double d = ((CODouble *) &val )->doubleValue();
+                    if( this->precision )
                     {
-                        // cppcheck-suppress cstyleCast
-                        ((CODouble *) myObj)->set( ((CODouble *)(ti->second ) )->toDouble());       // set it to the new value
-                    } else {                                                                        //      else if it of a different type than delete the old and replace
-                        m->erase( it );
-                        delete myObj;
-                        // cppcheck-suppress cstyleCast
-                        append( targetStr->c_str(), new CODouble( (double)((CODouble *)( ti->second ))->toLongInt( ) ) );
+                        pow_10 = pow( 10.0, this->precision);
+                        n *= pow_10;
+                        d *= pow_10;
                     }
-                    break;
-                case STRING_CPPON_OBJ_TYPE:                                                        // Strings are treated like integers and doubles
-                    if( STRING_CPPON_OBJ_TYPE == myObj->type())
+                    t = n - d;
+                    if( 0.75 < t || -0.75 > t )
                     {
-                        // cppcheck-suppress cstyleCast
-                        *((COString *) myObj) = ((COString *)(ti->second ) )->c_str();
-                    } else {
-                        m->erase( it );
-                        delete myObj;
-                        // cppcheck-suppress cstyleCast
-                        append( targetStr->c_str(), new COString( ((COString *)( ti->second ))->c_str() ) );
+                        *((double*) (*this).data) = round( d )/ pow_10;
                     }
-                    break;
-                case NULL_CPPON_OBJ_TYPE:                                                          //  In the case of null, it doesn't have a value
-                    if( NULL_CPPON_OBJ_TYPE != myObj->type())                                      //  But if the old one exist and it isn't null,
-                    {
-                        m->erase( it );                                                            //    delete it and set it to null
-                        delete myObj;
-                        append( targetStr->c_str(), new CONull() );
-                    }
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:                                                       // booleans are treated like integers, doubles and strings
-                    if( BOOLEAN_CPPON_OBJ_TYPE == myObj->type())
-                    {
-                        // cppcheck-suppress cstyleCast
-                        *((COBoolean *) myObj) = *((COBoolean *)(ti->second ));
-                    } else {
-                        m->erase( it );
-                        delete myObj;
-                        // cppcheck-suppress cstyleCast
-                        append( targetStr->c_str(), new COBoolean( ((COBoolean *)( ti->second ))->value() ) );
-                    }
-                    break;
-                case  MAP_CPPON_OBJ_TYPE:
-                    {
-                        // cppcheck-suppress cstyleCast
-                        COMap     *pt = ( COMap *) ti->second;
-                        if( MAP_CPPON_OBJ_TYPE == myObj->type())                                   //    IF the old one is also a map then
-                        {
-                            // cppcheck-suppress cstyleCast
-                            ((COMap *)it->second )->merge( pt , name );                            //      merge the two
-                        } else {                                                                   //    else
-                            m->erase( it );                                                        //      delete the old one and merge the new one.
-                            delete myObj;
-                            append( targetStr->c_str(), new COMap( *pt ) );
-                        }
-                    }
-                    break;
-                case  ARRAY_CPPON_OBJ_TYPE:
-                    {
-                        // cppcheck-suppress cstyleCast
-                        COArray   *arrTarget = (COArray *) ti->second;
-                        for( int k = 0; arrTarget->size() > k; k++ )
-                        {
-                            COString  *str;
-                            COString  *namePtr;
-                            COMap     *tMap;
-                            // cppcheck-suppress cstyleCast
-                            if( CppON::isMap( tMap = (COMap *)arrTarget->at( k ) ) && CppON::isString( namePtr = (COString *) (tMap->findElement( name ) ) ) )
-                            {
-                                // cppcheck-suppress cstyleCast
-                                COArray   *arr = (COArray *) it->second;
-                                int       i;
-                                for( i = 0; arr->size() > i; i++ )
-                                {
-                                    COMap     *uMap;
-                                    // cppcheck-suppress cstyleCast
-                                    if( CppON::isMap( uMap = (COMap *)arr->at( i ) ) && CppON::isString( str = (COString *) (uMap->findElement( name ) ) ) && !strcmp( str->c_str(), namePtr->c_str() ) )
-                                    {
-                                        uMap->merge( tMap, name );
-                                        break;
-                                    }
-                                }
-                                if( arr->size() <= i )
-                                {
-                                    arr->append( new COMap( *tMap ));
-                                }
-                                // cppcheck-suppress cstyleCast
-                            } else if( CppON::isString( str = (COString *)arrTarget->at( k ) ) ) {
-                                // cppcheck-suppress cstyleCast
-                                COArray   *arr = (COArray *) myObj;
-                                int       k1;
-                                for( k1 = 0; arr->size() > k1; k1++ )                              // Check if a string exists in target object that is the same
-                                {
-                                    // cppcheck-suppress cstyleCast
-                                    COString  *kStr = (COString *) arr->at( k1 );
-                                    if( CppON::isString( kStr ) )
-                                    {
-                                        if( ! strcmp( str->c_str(), kStr->c_str() ) )
-                                        {
-                                            break;
-                                        }
-                                    }
-                                }
-                                if( arr->size() == k1 )
-                                {
-                                    arr->append( new COString( *str ) );
-                                }
-                            }
-                        }
-                    }
-                    break;
-                default:
-                    break;
+                } else {
+                    *((double *) data) = ((CODouble *) &val )->doubleValue();
+                }
+            } else {
+                data = new double;
+                *((double *) data) = ((CODouble *) &val )->doubleValue();
             }
-        } else {                                                                                   // It doesn't have this so just add it.
-            // cppcheck-suppress cstyleCast
-            append( *targetStr, CppON::factory( *(( CppON *)ti->second )) );
-        }
-    }
-}
-
-void COMap::upDate( COMap *target, const char *name )
-{
-    if( data )
-    {
-        map<string, CppON *> *s = (map<string, CppON *> *) target->data;
-
-        for( map< string, CppON *>::iterator ti = s->begin(); s->end() != ti; ++ti )
-        {
-            bool                                 found = false;
-            map<string, CppON *>::iterator       it;
-            const string                         *targetStr = &(ti->first);
-            CppONType                              _eType = (ti->second)->type();
-
-            map<string, CppON *> *m = (map<string, CppON *> *) data;
-            // cppcheck-suppress postfixOperator
-            for( it = m->begin(); m->end() != it; it++ )
+            if( val.raw && *((double *) data) == ((CODouble *) &val )->doubleValue() )
             {
-                if( ! strcmp(  (it->first).c_str(), targetStr->c_str() ) )
+                str = val.str;
+                raw = true;
+            }
+            break;
+        case STRING_CPPON_OBJ_TYPE:
+            deleteData();
+            data = ( val.data ) ? new std::string( ( ( std::string *) val.data )->c_str() ): NULL;
+            break;
+        case NULL_CPPON_OBJ_TYPE:
+            siz = val.siz;
+            break;
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            data = new(char);
+            *( ( char *) data) = ((COBoolean *) &val )->value();
+            siz = 1;
+            break;
+        case MAP_CPPON_OBJ_TYPE:
+            {
+                deleteData();
+                siz = val.size();
+                data = new map<string, CppON*>();
+                map<string, CppON*> *th = (map<string, CppON*> *) data;
+                COMap  *m = (COMap *) &val;
+                // cppcheck-suppress postfixOperator
+                for( std::vector<std::string>::iterator itr = m->order.begin(); m->order.end() != itr; itr++ )
                 {
-                    found = true;
-                    if( (it->second)->type() == _eType )                                           // If they are the same data type then just update it
+                    CppON *obj = m->findCaseElement( itr->c_str() );
+                    if( obj )
                     {
-                        switch( _eType )
+                        order.push_back( string( *itr ) );
+                        switch( obj->typ )
                         {
                             case INTEGER_CPPON_OBJ_TYPE:
                                 // cppcheck-suppress cstyleCast
-                                *((COInteger *)it->second ) =  ( (COInteger *)ti->second )->intValue();
+                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COInteger( *((COInteger *)obj ) ) ) );
                                 break;
                             case DOUBLE_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                *((CODouble *)it->second ) =  ( (CODouble *)ti->second )->doubleValue();
-                                break;
-                            case STRING_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                *((COString *)it->second ) = ( (COString *)ti->second )->c_str() ;
-                                break;
-                            case BOOLEAN_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                *((COBoolean *)it->second ) = ( (COBoolean *)ti->second )->value();
-                                break;
-                            case  MAP_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                ((COMap *)it->second )->upDate( ( (COMap *) ti->second ), name );
-                                break;
-                            case  ARRAY_CPPON_OBJ_TYPE:
                                 {
                                     // cppcheck-suppress cstyleCast
-                                    COArray   *arrTarget = (COArray *) ti->second;
-                                    for( int k = 0; arrTarget->size() > k; k++ )
+                                    char p = ( (CODouble *)obj )->Precision();
+                                    CODouble *d;
+                                    // cppcheck-suppress cstyleCast
+                                    th->insert( th->end(), pair< string, CppON* >( itr->c_str(), d = new CODouble( *( (CODouble *)obj ) ) ) );
+                                    if( 0 <= p )
                                     {
-                                        COString *namePtr;
-                                        COMap *tMap;
-                                        // cppcheck-suppress cstyleCast
-                                        if( CppON::isMap( tMap = (COMap *)arrTarget->at( k ) ) && CppON::isString( namePtr = (COString *) (tMap->findElement( name ) ) ) )
-                                        {
-                                            // cppcheck-suppress cstyleCast
-                                            COArray     *arr = (COArray *) it->second;
-                                            for( int i = 0; arr->size() > i; i++ )
-                                            {
-                                                COString *str;
-                                                COMap     *uMap;
-                                                // cppcheck-suppress cstyleCast
-                                                if( CppON::isMap( uMap = (COMap *)arr->at( i ) ) && CppON::isString( str = (COString *) (uMap->findElement( name ) ) ) && !strcmp( str->c_str(), namePtr->c_str() ) )
-                                                {
-                                                    COMap *newMap = new COMap( *tMap );
-                                                    if( ! arr->replace( i, newMap ) )
-                                                    {
-                                                        delete newMap;
-                                                    }
-                                                    delete uMap;
-                                                    break;
-                                                }
-                                            }
-                                        }
+                                        d->Precision( p );
                                     }
                                 }
                                 break;
-                            case NULL_CPPON_OBJ_TYPE:
-                                fprintf( stderr, "COMap:update - Null 1st being ignored\n");
-                                break;
-                            default:
-                                break;
-                        }
-                    } else {
-                        delete ( it->second );                                                                          // replace the data type with the new one.
-                        switch( _eType )
-                        {
-                            case INTEGER_CPPON_OBJ_TYPE:
-                                // cppcheck-suppress cstyleCast
-                                it->second =  new COInteger( ( (COInteger *)ti->second )->intValue() );
-                                break;
-                            case DOUBLE_CPPON_OBJ_TYPE:
+                            case STRING_CPPON_OBJ_TYPE:
                                 // cppcheck-suppress cstyleCast
-                                it->second =  new CODouble( ( (CODouble *)ti->second )->doubleValue() );
+                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COString( *( (COString *)obj ) ) ) );
                                 break;
-                            case STRING_CPPON_OBJ_TYPE:
+                            case NULL_CPPON_OBJ_TYPE:
                                 // cppcheck-suppress cstyleCast
-                                it->second = new COString( ( (COString *)ti->second )->c_str() );
+                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new CONull( *( (CONull *)obj ) ) ) );
                                 break;
                             case BOOLEAN_CPPON_OBJ_TYPE:
                                 // cppcheck-suppress cstyleCast
-                                it->second = new COBoolean( ( (COBoolean *)ti->second )->value() );
+                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COBoolean( *( (COBoolean *)obj ) ) ) );
                                 break;
-                            case  MAP_CPPON_OBJ_TYPE:
+                            case MAP_CPPON_OBJ_TYPE:
                                 // cppcheck-suppress cstyleCast
-                                it->second  = new COMap( * ( (COMap *)ti->second ) );
+                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COMap( *( (COMap *)obj ) ) ) );
                                 break;
-                            case  ARRAY_CPPON_OBJ_TYPE:
+                            case ARRAY_CPPON_OBJ_TYPE:
                                 // cppcheck-suppress cstyleCast
-                                it->second  = new COArray( * ( (COArray *)ti->second ) );
-                                break;
-                            case NULL_CPPON_OBJ_TYPE:
-                                it->second = new CONull();
-                                fprintf( stderr, "%s[%d]: COMap:update - Null being ignored\n",__FILE__,__LINE__);
-                                target->dump();
+                                th->insert( th->end(), pair< string, CppON* >( itr->c_str(), new COArray( *( (COArray *)obj ) ) ) );
                                 break;
                             default:
                                 break;
@@ -2658,3125 +3304,8191 @@ void COMap::upDate( COMap *target, const char *name )
                     }
                 }
             }
-            if( ! found )
+            break;
+        case ARRAY_CPPON_OBJ_TYPE:
             {
-                switch ( _eType )
+                deleteData();
+                siz = val.size();
+                data = new vector<CppON *>();
+                for( size_t i = 0; siz > i; i++ )
                 {
-                    case INTEGER_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        this->append( ti->first, new COInteger( *((COInteger *) ti->second) ) );
-                        break;
-                    case DOUBLE_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        this->append( ti->first, new CODouble( *((CODouble *) ti->second) ) );
-                        break;
-                    case STRING_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        this->append( ti->first, new COString( *((COString *) ti->second) ) );
-                        break;
-                    case BOOLEAN_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        this->append( ti->first, new COBoolean( *((COBoolean *) ti->second) ) );
-                        break;
-                    case NULL_CPPON_OBJ_TYPE:
-                        this->append( ti->first, new CONull() );
-                        break;
-                    case  MAP_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        this->append( ti->first, new COMap( *((COMap *) ti->second) ) );
-                        break;
-                    case  ARRAY_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        this->append( ti->first, new COArray( *((COArray *) ti->second) ) );
-                        break;
-                    default:
-                        break;
+                    CppON *jt = ((COArray &) val ).at( i );
+                    switch( jt->type() )
+                    {
+                        case INTEGER_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            ((COArray*)this)->append( new COInteger( *((COInteger *)jt ) ) );
+                            break;
+                        case DOUBLE_CPPON_OBJ_TYPE:
+                            {
+                                // cppcheck-suppress cstyleCast
+                                char p = ( (CODouble *)jt )->Precision();
+                                CODouble *d;
+                                // cppcheck-suppress cstyleCast
+                                ((COArray*)this)->append( d = new CODouble( *( (CODouble *)jt ) ) );
+                                if( 0 <= p )
+                                {
+                                    d->Precision( p );
+                                }
+                            }
+                            break;
+                        case STRING_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            ((COArray*)this)->append( new COString( *( (COString *)jt ) ) );
+                            break;
+                        case NULL_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            ((COArray*)this)->append( new CONull( *( (CONull *)jt ) ) );
+                            break;
+                        case BOOLEAN_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            ((COArray*)this)->append( new COBoolean( *( (COBoolean *)jt ) ) );
+                            break;
+                        case MAP_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            ((COArray*)this)->append( new COMap( *( (COMap *)jt ) ) );
+                            break;
+                        case ARRAY_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            ((COArray*)this)->append( new COArray( *( (COArray *)jt ) ) );
+                            break;
+                        default:
+                            break;
+                    }
                 }
             }
-        }
+            break;
+        default:
+            break;
     }
+
+    return this;
 }
 
-CppON *COMap::findEqual( const char * name, CppON &search )
+/****************************************************************************************/
+/*                                                                                      */
+/*                                      CppONIterator                                   */
+/*                                                                                      */
+/****************************************************************************************/
+
+void CppONIterator::reset( CppON *rt )
 {
-    CppON     *rtn = NULL;
-    CppONType    _eType = search.type();
+    stack.clear();
+    curPath.clear();
+    root = rt;
+    cur = NULL;
+    curKey = NULL;
+    curIndex = 0;
+    curDepth = 0;
+    isLeaving = false;
+    descend = true;
+    started = false;
+}
 
-    if( data )
+bool CppONIterator::next()
+{
+    CppON               *child = NULL;
+    const std::string   *childKey = NULL;
+    size_t              idx = 0;
+
+    if( ! started )
     {
-        map<string, CppON *>::iterator it;
-        map<string, CppON *> *m = (map<string, CppON *> *) data;
-        // cppcheck-suppress postfixOperator
-        for( it = m->begin(); !rtn && m->end() != it; it++ )
+        started = true;
+        if( ! root )
         {
-            if( ! strcmp(  (it->first).c_str(), name ) && (it->second)->type() == _eType )
+            return false;
+        }
+        child = root;
+    } else {
+        if( stack.empty() )
+        {
+            return false;
+        }
+        Frame &f = stack.back();
+
+        if( ! descend && ! isLeaving && cur == f.node )
+        {
+            f.next = ( size_t ) -1;
+        }
+        descend = true;
+        if( MAP_CPPON_OBJ_TYPE == f.node->type() )
+        {
+            // cppcheck-suppress cstyleCast
+            COMap                           *mp = (COMap *) f.node;
+            std::map<std::string, CppON *>  *m = mp->value();
+            std::vector<std::string>        *keys = mp->getKeys();
+
+            while( ! child && m && keys->size() > f.next )
             {
-                switch( _eType )
+                std::map<std::string, CppON *>::iterator it = m->find( ( *keys )[ f.next ] );
+
+                idx = f.next++;
+                if( m->end() != it && it->second )
                 {
-                    case INTEGER_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( ((COInteger &) search).intValue() == ((COInteger *)it->second )->intValue() )
-                        {
-                            rtn = (it->second);
-                        }
-                        break;
-                    case DOUBLE_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( ((CODouble &) search).doubleValue() == ((CODouble *)it->second )->doubleValue() )
-                        {
-                            rtn = (it->second);
-                        }
-                        break;
-                    case STRING_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( !strcmp( ( ( COString &) search).c_str(), ((COString *)it->second )->c_str() ) )
-                        {
-                            rtn = ( it->second );
-                        }
-                        break;
-                    case BOOLEAN_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( ((COBoolean &) search).value() == ((COBoolean *)it->second )->value() )
-                        {
-                            rtn = (it->second);
-                        }
-                        break;
-                    case NULL_CPPON_OBJ_TYPE:
-                        rtn = (it->second );
-                        break;
-                    default:
-                        break;
+                    child = it->second;
+                    childKey = &it->first;
                 }
             }
-            if( ! rtn )
+        } else {
+            // cppcheck-suppress cstyleCast
+            COArray                         *ar = (COArray *) f.node;
+            size_t                          n = ar->size();
+
+            while( ! child && n > f.next )
             {
-                if( MAP_CPPON_OBJ_TYPE == (it->second)->type() )
-                {
-                    // cppcheck-suppress cstyleCast
-                    rtn = ( ( COMap *) it->second )->findEqual( name, search );
-                } else if( ARRAY_CPPON_OBJ_TYPE == (it->second)->type() ) {
-                    //            rtn = ( ( COArray *) it->second )->findEqual( name, search );
-                }
+                idx = f.next++;
+                child = ar->at( idx );
+            }
+        }
+        if( ! child )
+        {
+            cur = f.node;
+            curKey = f.key;
+            curIndex = f.index;
+            curDepth = stack.size() - 1;
+            if( trackPath )
+            {
+                curPath.resize( f.pathLen );
+            }
+            isLeaving = true;
+            stack.pop_back();
+            return true;
+        }
+        if( trackPath )
+        {
+            curPath.resize( f.pathLen );
+            if( 1 < stack.size() )
+            {
+                curPath.push_back( '/' );
+            }
+            if( childKey )
+            {
+                curPath.append( *childKey );
+            } else {
+                char    buf[ 24 ];
+                int     n = snprintf( buf, sizeof( buf ), "%zu", idx );
+
+                curPath.append( buf, n );
             }
         }
     }
-    return rtn;
+    cur = child;
+    curKey = childKey;
+    curIndex = idx;
+    curDepth = stack.size();
+    isLeaving = false;
+    if( MAP_CPPON_OBJ_TYPE == child->type() || ARRAY_CPPON_OBJ_TYPE == child->type() )
+    {
+        if( stack.capacity() == stack.size() )
+        {
+            stack.reserve( ( stack.size() ) ? stack.size() * 2 : 16 );
+        }
+        stack.push_back( Frame{ child, childKey, idx, 0, curPath.size() } );
+    }
+    return true;
 }
 
-
 /*
- * Splits a path based on the forward slash ('/') into a val string and a remainder part
- * basically on retruning everything before the slash is in the "val" string and the remainder points to everything after the slash
- *
+ * What appendJson() writes in place of a character, or NULL for one written as it is.
  */
-
-static void splitPath( const char *str, std::string &val, const char **remainder )
+static __inline const char *jsonEscape( char ch )
 {
-    if( str && remainder )
-    {
-        for( *remainder = str; *(*remainder) && '/' != *(*remainder) ; (*remainder)++ );
-        val = std::string( str, ( *remainder - str ) );
-        if( '/' == *(*remainder) )
-        {
-            (*remainder)++;
-        }
+    switch( ch )
+    {
+        case '"':
+            return "%22";
+        case '{':
+            return "%7B";
+        case '}':
+            return "%7D";
+        case '<':
+            return "%3C";
+        case '>':
+            return "%3E";
+        case '\\':
+            return "%5C";
+        case '\'':
+            return "%60";
+        case '^':
+            return "%5E";
+        case '&':
+            return "%26";
+        case '\r':
+            return "%0D";
+        case '\n':
+        case '\a':
+            return "%0A";
+        case '\t':
+            return " ";
+        default:
+            return NULL;
     }
 }
+
 /*
- * This and its companion "findCaseElement" if the typical way to find object in a map.
- *
- * Normally we are looking for an element directly in a structure but if we are need to go further
- * and retrieve an object in a Map thats in the Map we can deleminate the levels with a forward slash.
- * Likewise if we are looking for an element in an array  then we can delimit that with a colon.  So
- *  config/axisEncoders:2/resolution would search the structure to get the "config" map which it would search
- *  to get the axisEncoders array and retrieve the third element returning the resolution object of it.
- *  {
- *    config: {
- *      axisEncoders: [
- *        {
- *        },
- *        {
- *        },
- *        {
- *          name: \"Gurely\",
- *          resolution:0.01
- *        }
- *      ]
- *    }
- *  }
- *
+ * The iterator and the NET length stack a writer uses.  There is one per thread and it keeps its capacity, so once a
+ * tree of a given shape has been written, writing it again only touches the output string.
  */
+struct CppONWriterScratch
+{
+    CppONIterator                                   it;
+    std::vector<size_t>                             marks;
+                                                    CppONWriterScratch() : it( NULL, false ) {}
+};
 
-CppON *COMap::findElement( const char *str )
+static thread_local CppONWriterScratch writerScratch;
+
+/*
+ * Bytes of a COFileString that writeCompactJson( fd )/writeNetString( fd ) copy from its file instead of writing
+ * them from the output string: they go in front of out[ at ].
+ */
+struct COWriteHole
 {
-    CppON *rtn = NULL;
-    if( data && str )
-    {
-        int        arrayIndex = -1;
+    size_t                                          at;
+    COFileString                                    *str;
+    size_t                                          off;                                            // Within the string
+    size_t                                          len;
+};
 
-        /*
-         * Split the path with s = to anything before a forward slash ('/') and str pointing to first character after it.
-         */
-        std::string s;
-        splitPath( str, s, &str );                                                // split the string based on a slash
+/*
+ * Writes a tree as compact JSON, indented JSON or a TNetString by walking it with a CppONIterator, appending
+ * every node straight into one output string.  The scalars are written through their own (non-virtual)
+ * appendJson()/appendNetString(), so there is no temporary string per node.
+ */
+class CppONWriter
+{
+public:
+    enum Style { COMPACT, PRETTY, NET };
+
+                                                    CppONWriter( CppON *root, Style s, std::string &o, const std::string &ind ) : it( writerScratch.it ), out( &o ), indent( ind ), marks( writerScratch.marks ), holes( NULL ), style( s ), first( true ) { it.reset( root ); marks.clear(); }
+                                                    CppONWriter( CppONIterator &i, std::vector<size_t> &m, Style s, const std::string &ind ) : it( i ), out( NULL ), indent( ind ), marks( m ), holes( NULL ), style( s ), first( true ) {}
+            void                                    leaveHoles( std::vector<COWriteHole> *h ) { holes = h; }   // Leave COFileStrings in their files
+            void                                    run() { while( it.next() ) { emit(); } }
+            bool                                    emitNext( std::string &o ) { out = &o; if( ! it.next() ) { return false; } emit(); return true; }     // One event, false at the end
+private:
+            void                                    pad( unsigned depth ) { out->append( indent ); out->append( 2 * depth, ' ' ); }
+            void                                    emit();
+            void                                    emitScalar( CppON *n );
+            void                                    emitFileString( COFileString *fs );
+            void                                    span( COFileString *fs, size_t off, size_t len );
+
+            CppONIterator                           &it;
+            std::string                             *out;
+            std::string                             indent;                                         // Indent of the root in PRETTY
+            std::vector<size_t>                     &marks;                                         // NET: where each open container's body starts
+            std::vector<COWriteHole>                *holes;                                         // Where COFileStrings go, NULL to copy them into out
+            Style                                   style;
+            bool                                    first;                                          // Nothing written in the current container yet
+};
 
-        /*
-         * Now look to see if there is an index after the original part denoted by a colon (':')
-         */
-        size_t idx = s.find( ':' );
-        std::string more;
-        if( std::string::npos != idx )                                            // colon is found
-        {
-            char *r;
-            arrayIndex = strtol( &s.c_str()[ idx + 1 ], &r, 10 );                // Read the index as a base 10 number following the colon
-            more = r;                                                            // more will contain any text after the number
-            s = s.substr( 0, idx );                                                // s only contains the text up to the colon
-        }
+void CppONWriter::emit()
+{
+    CppON       *n = it.node();
+    unsigned    depth = it.depth();
+    bool        container = ( MAP_CPPON_OBJ_TYPE == n->type() || ARRAY_CPPON_OBJ_TYPE == n->type() );
+    char        open = ( MAP_CPPON_OBJ_TYPE == n->type() ) ? '{' : '[';
 
-        /*
-         * OK search the map for an item with a name matching the text in 's'
-         */
-#if 1
-        std::map<std::string,CppON*>::iterator it = ((std::map< std::string, CppON*> *) data)->find( s );
-        if( ((std::map< std::string, CppON*> *) data)->end() != it )
-        {
-            rtn = it->second;
-        }
-#else
-        map<string, CppON *> *m = (map<string, CppON *> *) data;
-        // cppcheck-suppress postfixOperator
-        for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; it++ )
+    if( it.leaving() )
+    {
+        char close = ( MAP_CPPON_OBJ_TYPE == n->type() ) ? '}' : ']';
+
+        switch( style )
         {
-            if( ! strcmp(  (it->first).c_str(), s.c_str() ) )                    // if found set "rtn" to the object and quit looking
+            case PRETTY:
+                out->push_back( '\n' );
+                pad( depth );
+                out->push_back( close );
+                break;
+            case NET:
             {
-                rtn = it->second;
+                size_t  pos = marks.back();
+                size_t  h   = ( holes ) ? holes->size() : 0;
+                size_t  gap = 0;
+                char    buf[ 24 ];
+                int     len;
+
+                while( h && ( *holes )[ h - 1 ].at >= pos )                                 // Bytes of the body that are left in files
+                {
+                    gap += ( *holes )[ --h ].len;
+                }
+                len = snprintf( buf, sizeof( buf ), "%zu:", out->size() - pos + gap );
+                marks.pop_back();
+                out->insert( pos, buf, len );
+                for( ; holes && holes->size() > h; h++ )
+                {
+                    ( *holes )[ h ].at += len;
+                }
+                out->push_back( close );
                 break;
             }
+            default:
+                out->push_back( close );
+                break;
         }
-#endif
-        if( rtn && CppON::isMap( rtn ) && *str )                                // But wait! if the object found is a map and there is a remainder from the
-        {                                                                         // original split then call ourselves with the new string to find the object
-            // cppcheck-suppress cstyleCast
-            rtn = ( (COMap *) rtn )->findElement( str );
-        } else if( rtn && CppON::isArray( rtn ) && 0 <= arrayIndex ) {            // Or maybe the returned object was an array and we have an index
-            while( CppON::isArray( rtn ) && 0 <= arrayIndex )
-            {
-                // cppcheck-suppress cstyleCast
-                rtn = ( (COArray*) rtn)->at( arrayIndex );
-                if( CppON::isMap( rtn ) && *str )
+        first = false;
+        return;
+    }
+    if( depth )
+    {
+        const std::string *key = it.key();
+
+        switch( style )
+        {
+            case PRETTY:
+                if( ! first )
                 {
-                    // cppcheck-suppress cstyleCast
-                    rtn = ( (COMap *) rtn)->findElement( str );
-                    break;
-                } else if( ! CppON::isArray( rtn ) || more[ 0 ] != ':' ) {
-                    break;
-                } else {
-                    char *r;
-                    s = more.substr( 1 );
-                    arrayIndex = strtol( s.c_str(), &r, 10 );
-                    more = r;
+                    out->append( ",\n" );
                 }
-            }
+                pad( depth );
+                if( key )
+                {
+                    out->push_back( '"' );
+                    out->append( *key );
+                    out->append( "\": " );
+                    if( container )
+                    {
+                        out->push_back( '\n' );
+                        pad( depth );
+                    }
+                } else if( container ) {
+                    pad( depth );
+                }
+                break;
+            case NET:
+                if( key )
+                {
+                    CppON::appendNetString( *out, key->data(), key->length(), ',' );
+                }
+                break;
+            default:
+                if( ! first )
+                {
+                    out->push_back( ',' );
+                }
+                if( key )
+                {
+                    out->push_back( '"' );
+                    out->append( *key );
+                    out->append( "\":" );
+                }
+                break;
         }
+    } else if( container && PRETTY == style ) {
+        pad( 0 );
+    }
+    first = false;
+    if( ! container )
+    {
+        emitScalar( n );
+        return;
+    }
+    first = true;
+    switch( style )
+    {
+        case PRETTY:
+            out->push_back( open );
+            out->push_back( '\n' );
+            break;
+        case NET:
+            marks.push_back( out->size() );
+            break;
+        default:
+            out->push_back( open );
+            break;
     }
-    return rtn;
 }
-// cppcheck-suppress unusedFunction
-CppON *COMap::findNoSplit( const char *str )
+
+void CppONWriter::emitScalar( CppON *n )
 {
-    CppON *rtn = NULL;
+    bool net = ( NET == style );
 
-    if( data && str )
+    switch( n->type() )
     {
-        /*
-         * OK search the map for an item with a name matching the text in 's'
-         */
-        map<string, CppON *> *m = (map<string, CppON *> *) data;
-        // cppcheck-suppress postfixOperator
-        for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; it++ )
-        {
-            if( ! strcmp( (it->first).c_str(), str ) )         // if found set "rtn" to the object and quit looking
+        case INTEGER_CPPON_OBJ_TYPE:
+            if( net )
             {
-                rtn = it->second;
-                break;
+                // cppcheck-suppress cstyleCast
+                ( (COInteger *) n )->appendNetString( *out );
+            } else {
+                // cppcheck-suppress cstyleCast
+                ( (COInteger *) n )->appendJson( *out );
             }
-        }
+            break;
+        case DOUBLE_CPPON_OBJ_TYPE:
+            if( net )
+            {
+                // cppcheck-suppress cstyleCast
+                ( (CODouble *) n )->appendNetString( *out );
+            } else {
+                // cppcheck-suppress cstyleCast
+                ( (CODouble *) n )->appendJson( *out );
+            }
+            break;
+        case STRING_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            if( holes && ( (COString *) n )->inFile() )
+            {
+                // cppcheck-suppress cstyleCast
+                emitFileString( (COFileString *) n );
+            } else if( net ) {
+                // cppcheck-suppress cstyleCast
+                ( (COString *) n )->appendNetString( *out );
+            } else {
+                // cppcheck-suppress cstyleCast
+                ( (COString *) n )->appendJson( *out );
+            }
+            break;
+        case BOOLEAN_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            if( ( (COBoolean *) n )->value() )
+            {
+                out->append( ( net ) ? "4:true!" : "true" );
+            } else {
+                out->append( ( net ) ? "5:false!" : "false" );
+            }
+            break;
+        default:
+            out->append( ( net ) ? "0:~" : "null" );
+            break;
     }
-    return rtn;
 }
-CppON *COMap::findCaseElement( const char *str )
+
+/*
+ * Leave a COFileString as holes to be copied from its file.  In JSON the characters appendJson() changes are
+ * written into out and only the runs between them of FILE_COPY_MIN bytes or more are left as holes.
+ */
+void CppONWriter::emitFileString( COFileString *fs )
 {
-    CppON *rtn = NULL;
+    const char  *p      = fs->bytes();
+    size_t      len     = fs->size();
 
-    if( data  && str )
+    if( NET == style )
     {
-        /*
-         * Split the path with s = to anything before a forward slash ('/') and str pointing to first character after it.
-         */
+        char    buf[ 24 ];
 
-        int         arrayIndex = -1;
-        std::string s;
+        out->append( buf, snprintf( buf, sizeof( buf ), "%zu:", len ) );
+        span( fs, 0, len );
+        out->push_back( ',' );
+    } else {
+        size_t  from    = 0;
 
-        splitPath( str, s, &str );
-        /*
-         * Now look to see if there is an index after the original part denoted by a colon (':')
-         */
-        size_t idx = s.find( ':' );
-        std::string more;
-        if( std::string::npos != idx )                              // colon is found
+        out->push_back( '"' );
+        for( size_t i = 0; len > i; i++ )
         {
-            char *r;
-            arrayIndex = strtol( &s.c_str()[ idx + 1 ], &r, 10 );     // Read the index as a base 10 number following the colon
-            more = r;                                                 // more will contain any text after the number
-            s = s.substr( 0, idx );                                   // s only contains the text up to the colon
-        }
+            const char  *e  = jsonEscape( p[ i ] );
 
-        map<string, CppON *> *m = (map<string, CppON *> *) data;
-        // cppcheck-suppress postfixOperator
-        for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; it++ )
-        {
-            if( ! strcasecmp(  (it->first).c_str(), s.c_str() ) )
-            {
-                rtn = it->second;
-                break;
-            }
-        }
-        if( rtn && CppON::isMap( rtn ) && *str )
-        {
-            // cppcheck-suppress cstyleCast
-            rtn = ( (COMap *) rtn )->findCaseElement( str );
-        } else if(CppON::isArray( rtn ) && 0 <= arrayIndex ) {    // Or maybe the returned object was an array and we have an index
-            while( CppON::isArray( rtn ) && 0 <= arrayIndex )
+            if( e )
             {
-                // cppcheck-suppress cstyleCast
-                rtn = ( (COArray*) rtn)->at( arrayIndex );
-                if( CppON::isMap( rtn ) && *str )
-                {
-                    // cppcheck-suppress cstyleCast
-                    rtn = ( (COMap *) rtn)->findElement( str );
-                    break;
-                } else if( ! CppON::isArray( rtn ) || more[ 0 ] != ':' ) {
-                    break;
-                } else {
-                    char *r;
-                    s = more.substr( 1 );
-                    arrayIndex = strtol( s.c_str(), &r, 10 );
-                    more = r;
-                }
+                span( fs, from, i - from );
+                out->append( e );
+                from = i + 1;
             }
         }
+        span( fs, from, len - from );
+        out->push_back( '"' );
     }
-    return rtn;
 }
-std::string *COMap::toCompactJsonString( )
+
+void CppONWriter::span( COFileString *fs, size_t off, size_t len )
 {
-    std::string *rtn = new string( "{" );
-    if( data )
+    if( FILE_COPY_MIN <= len )
     {
-        map<string, CppON *>::iterator    it;
-        map<string, CppON *>            *m = (map<string, CppON *> *) data;
-        CppON                            *n;
-        std::string                        *sptr;
-        bool                            first = true;
+        holes->push_back( COWriteHole{ out->size(), fs, off, len } );
+    } else {
+        out->append( fs->bytes() + off, len );
+    }
+}
 
-        for( size_t idx = 0; order.size() > idx; ++idx )
+/*
+ * Copy len bytes at off of the file src to fd: copy_file_range() when fd is a file it can copy to, else sendfile(),
+ * else write() from the mapping at mem.  Only errors that say the method does not apply move on to the next one.
+ */
+static bool copyFromFile( int fd, int src, const char *mem, off_t off, size_t len )
+{
+    int     m       = 0;
+    size_t  done    = 0;
+
+    while( done < len )
+    {
+        ssize_t n;
+
+        if( 0 == m )
         {
-            it = m->find( order.at( idx ) );
-            if( first )
-            {
-                first = false;
-            } else {
-                rtn->append( "," );
-            }
-            *rtn += '\"';
-            rtn->append( ( ( string ) it->first ).c_str() );
-            rtn->append( "\":" );
-            // cppcheck-suppress cstyleCast
-            n = (CppON *) it->second;
-            sptr = NULL;
-            switch ( n->type() )
-            {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COInteger *) n )->toJsonString();
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (CODouble *) n )->toJsonString();
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COString *) n )->toJsonString();
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COBoolean *) n )->toJsonString();
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = (( CONull *) n )->toJsonString();
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COMap *) n )->toCompactJsonString( );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COArray *) n )->toCompactJsonString( );
-                    break;
-                default:
-                    break;
-            }
-            if( sptr )
-            {
-                *rtn += *sptr;
-                delete sptr;
-            }
+            n = copy_file_range( src, &off, fd, NULL, len - done, 0 );
+        } else if( 1 == m ) {
+            n = sendfile( fd, src, &off, len - done );
+        } else {
+            n = write( fd, mem + done, len - done );
+        }
+        if( 0 < n )
+        {
+            done += (size_t) n;
+        } else if( 0 == n ) {
+            fprintf( stderr, "%s[%d]: Source file is shorter than expected\n", __FILE__, __LINE__ );
+            return false;
+        } else if( EINTR == errno ) {
+            continue;
+        } else if( 2 > m && ( EINVAL == errno || EXDEV == errno || ENOSYS == errno || EOPNOTSUPP == errno || ( 0 == m && EBADF == errno ) ) ) {
+            m++;
+        } else {
+            perror( ( 0 == m ) ? "copy_file_range" : ( 1 == m ) ? "sendfile" : "write" );
+            return false;
         }
     }
-    *rtn += '}';
-    return rtn;
+    return true;
 }
 
-std::string *COMap::toJsonString( std::string &indent )
+void CppON::writeCompactJson( std::string &out )
 {
-    std::string *rtn = new string( indent.c_str() );
-    rtn->append( "{\n" );
-    if( data )
+    out.clear();
+    if( data || raw || lazy || NULL_CPPON_OBJ_TYPE == typ )
     {
-        map<string, CppON *>::iterator    it;
-        map<string, CppON *>            *m = (map<string, CppON *> *) data;
-        CppON                            *n;
-        std::string                        *sptr;
-        bool                            first = true;
-        std::string                        newIndent = indent;
+        CppONWriter w( this, CppONWriter::COMPACT, out, "" );
+
+        w.run();
+    }
+}
+
+void CppON::writeNetString( std::string &out )
+{
+    out.clear();
+    if( data || raw || lazy || NULL_CPPON_OBJ_TYPE == typ )
+    {
+        CppONWriter w( this, CppONWriter::NET, out, "" );
+
+        w.run();
+    }
+}
 
-        newIndent.append( "  " );
-        for( std::vector< std::string >::iterator ito = order.begin(); order.end() != ito; ito++ )
+static bool writeFully( int fd, const char *buf, size_t len )
+{
+    while( len )
+    {
+        ssize_t n = write( fd, buf, len );
+
+        if( 0 < n )
         {
-            it = m->find( *ito );
-            if( first )
-            {
-                first = false;
-            } else {
-                rtn->append( ",\n" );
-            }
-            rtn->append( newIndent.c_str() );
-            *rtn += '\"';
-            rtn->append( ( ( string ) it->first ).c_str() );
-            rtn->append( "\": " );
-            // cppcheck-suppress cstyleCast
-            n = (CppON *) it->second;
-            sptr = NULL;
-            switch ( n->type() )
-            {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COInteger *) n )->toJsonString();
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (CODouble *) n )->toJsonString();
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COString *) n )->toJsonString();
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COBoolean *) n )->toJsonString();
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = (( CONull *) n )->toJsonString();
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    rtn->append( "\n" );
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COMap *) n )->toJsonString( newIndent );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    rtn->append( "\n" );
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COArray *) n )->toJsonString( newIndent );
-                    break;
-                default:
-                    break;
-            }
-            if( sptr )
-            {
-                *rtn += *sptr;
-                delete sptr;
-            }
+            buf += n;
+            len -= (size_t) n;
+        } else if( 0 > n && EINTR != errno ) {
+            perror( "write" );
+            return false;
         }
     }
-    *rtn += '\n';
-    rtn->append( indent.c_str() );
-    *rtn += '}';
-    return rtn;
+    return true;
 }
 
-string *COMap::toNetString()
+/*
+ * Write a tree to fd.  Everything but the COFileStrings is built in memory as usual; those are copied from their
+ * files into the gaps (see copyFromFile()), so the memory used does not depend on how large they are.
+ */
+static ssize_t writeToFd( CppON *root, CppONWriter::Style style, int fd )
 {
-    if( data && MAP_CPPON_OBJ_TYPE == typ )
+    std::string                 out;
+    std::vector<COWriteHole>    holes;
+    size_t                      at      = 0;
+    size_t                      total   = 0;
+    CppONWriter                 w( root, style, out, "" );
+
+    w.leaveHoles( &holes );
+    w.run();
+    for( size_t h = 0; holes.size() > h; h++ )
     {
-        std::string rt;
-        std::map<std::string, CppON *>::iterator it;
-        std::map<std::string, CppON *> *m = (map<string, CppON *> *) data;
+        COWriteHole &x  = holes[ h ];
 
-        for( size_t idx = 0; order.size() > idx; ++idx )
+        if( ! writeFully( fd, out.data() + at, x.at - at ) ||
+            ! copyFromFile( fd, x.str->fileDescriptor(), x.str->bytes() + x.off, (off_t)( x.str->fileOffset() + x.off ), x.len ) )
         {
-            std::string *sptr;
-            it = m->find( order.at( idx ) );
-            rt += *( sptr = CppON::toNetString( ( ( string ) it->first).c_str(), ',' ) );
-            delete ( sptr );
-            // cppcheck-suppress cstyleCast
-            CppON *n = (CppON *) it->second;
-            sptr = NULL;
-            switch ( n->type() )
-            {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COInteger *) n )->COInteger::toNetString();
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (CODouble *) n )->CODouble::toNetString();
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COString *) n )->COString::toNetString();
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COBoolean *) n )->COBoolean::toNetString();
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = (( CONull *) n )->CONull:: toNetString();
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COMap *) n )->COMap::toNetString();
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COArray *) n )->COArray::toNetString();
-                    break;
-                default:
-                    fprintf( stderr, "Map::toNetString: Unknown CppONType\n");
-                    break;
-            }
-            if( sptr )
-            {
-                rt+= *sptr;
-                delete sptr;
-            }
+            return -1;
         }
-        return CppON::toNetString( rt.c_str(), '}' );
+        total += x.len;
+        at = x.at;
     }
-    return NULL;
+    if( ! writeFully( fd, out.data() + at, out.size() - at ) )
+    {
+        return -1;
+    }
+    return (ssize_t)( total + out.size() );
 }
 
-const char  *COMap::c_str( std::string &idnt )
+ssize_t CppON::writeCompactJson( int fd )
 {
-    str = "{";
-    if( data )
-    {
-        map<string, CppON *>::iterator    it;
-        map<string, CppON *>            *m = (map<string, CppON *> *) data;
-        const char                        *comma = "\n";
-        std::string                        indent = idnt;
+    return ( data || raw || lazy || NULL_CPPON_OBJ_TYPE == typ ) ? writeToFd( this, CppONWriter::COMPACT, fd ) : 0;
+}
 
-        for( size_t idx = 0; order.size() > idx; ++idx )
-        {
-            it = m->find( order.at( idx ) );
-            str.append( comma );
-            comma = ",\n";
-            str.append( indent );
-            str += '"';
-            str += it->first;
-            str.append( "\": " );
-            // cppcheck-suppress cstyleCast
-            CppON *n = (CppON *) it->second;
-            switch ( n->type() )
-            {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( (COInteger *) n )->c_str();
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( (CODouble *) n )->c_str();
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    str += '"';
-                    // cppcheck-suppress cstyleCast
-                    str += ( ( COString *) n )->c_str();
-                    str += '"';
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( ( COBoolean *) n )->c_str();
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( ( CONull *) n )->c_str();
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( (COMap *) n )->c_str( indent );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( (COArray *) n )->c_str( indent );
-                    break;
-                default:
-                    break;
-            }
-        }
-        str += '\n';
-    }
-    str += '}';
-    return str.c_str();
+ssize_t CppON::writeNetString( int fd )
+{
+    return ( data || raw || lazy || NULL_CPPON_OBJ_TYPE == typ ) ? writeToFd( this, CppONWriter::NET, fd ) : 0;
 }
 
+/****************************************************************************************/
+/*                                                                                      */
+/*                                      COSerializer                                    */
+/*                                                                                      */
+/****************************************************************************************/
 
-void COMap::dump( string &indent, FILE *fp )
+COSerializer::COSerializer( CppON *root, Style style, const std::string &indent, bool snapshot ) : it( NULL, false )
 {
-    if( data )
-    {
-        map<string, CppON *>::iterator   it;
-        map<string, CppON *>            *m = (map<string, CppON *> *) data;
-        bool                              first = true;
-        string                            newIndent = indent;
+    owned = ( snapshot && root ) ? CppON::factory( root ) : NULL;
+    it.reset( ( owned ) ? owned : root );
+    writer = new CppONWriter( it, marks, ( PRETTY == style ) ? CppONWriter::PRETTY : CppONWriter::COMPACT, indent );
+    pendingPos = 0;
+    total = 0;
+    finished = ! root;
+}
 
-        newIndent.append( "\t" );
-        fprintf( fp, "%s{",indent.c_str() );
-        for( size_t idx = 0; order.size() > idx; ++idx )
-        {
-            it = m->find( order.at( idx ) );
-            if( first )
-            {
-                fprintf( fp, "\n%s\"%s\": ", newIndent.c_str(), ( ( string ) it->first).c_str() );
-                first = false;
-            } else {
-                fprintf( fp, ",\n%s\"%s\": ", newIndent.c_str(), ( ( string ) it->first).c_str() );
-            }
-            // cppcheck-suppress cstyleCast
-            CppON *n = (CppON *) it->second;
-            switch ( n->type() )
-            {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (COInteger *) n )->dump( fp );
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (CODouble *) n )->dump( fp );
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( ( COString *) n )->dump( fp );
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( ( COBoolean *) n )->dump( fp );
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( ( CONull *) n )->dump( fp );
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    fprintf( fp, "\n");
-                    // cppcheck-suppress cstyleCast
-                    ( (COMap *) n )->dump( newIndent, fp );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    fprintf( fp, "\n");
-                    // cppcheck-suppress cstyleCast
-                    ( (COArray *) n )->dump( newIndent, fp  );
-                    break;
-                default:
-                    break;
-            }
-        }
-        fprintf( fp, "\n%s}",indent.c_str() );
-    } else {
-        fprintf( fp, "NULL");
+COSerializer::~COSerializer()
+{
+    delete writer;
+    if( owned )
+    {
+        delete owned;
     }
 }
 
-void COMap::cdump( FILE *fp )
+/*
+ * Append the next part of the text to out.  Stops after maxBytes bytes or, checked every SERIALIZER_CHECK_EVENTS
+ * nodes, after maxMicros microseconds, whichever comes first (0 means no limit).  A node that does not fit in
+ * the byte budget is split; the rest of it is written first on the next call.
+ * Returns true once all of the text has been written.
+ */
+bool COSerializer::step( std::string &out, size_t maxBytes, unsigned maxMicros )
 {
-    if( data )
-    {
-        map<string, CppON *>::iterator   it;
-        map<string, CppON *>            *m = (map<string, CppON *> *) data;
-        bool                              first = true;
+    struct timespec     start;
+    size_t              budget  = ( maxBytes ) ? maxBytes : ( size_t ) -1;
+    unsigned            events  = 0;
 
-        fprintf( fp, "{" );
-        for( size_t idx = 0; order.size() > idx; ++idx )
+    if( maxMicros )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &start );
+    }
+    while( budget )
+    {
+        if( pendingPos < pending.size() )
         {
-            it = m->find( order.at( idx ) );
-            if( first )
+            size_t n = pending.size() - pendingPos;
+
+            if( n > budget )
             {
-                fprintf( fp, "\\\"%s\\\": ", ( ( string ) it->first).c_str() );
-                first = false;
-            } else {
-                fprintf( fp, ",\\\"%s\\\": ", ( ( string ) it->first).c_str() );
+                n = budget;
             }
-            // cppcheck-suppress cstyleCast
-            CppON *n = (CppON *) it->second;
-            switch ( n->type() )
+            out.append( pending, pendingPos, n );
+            pendingPos += n;
+            budget -= n;
+            total += n;
+        } else if( finished ) {
+            break;
+        } else {
+            pending.clear();
+            pendingPos = 0;
+            if( ! writer->emitNext( pending ) )
             {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (COInteger *) n )->cdump( fp );
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (CODouble *) n )->cdump( fp );
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( ( COString *) n )->cdump( fp );
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( ( COBoolean *) n )->cdump( fp );
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( ( CONull *) n )->cdump( fp );
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    fprintf( fp, "\"\n\"");
-                    // cppcheck-suppress cstyleCast
-                    ( (COMap *) n )->cdump( fp );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    fprintf( fp, "\"\n\"");
-                    // cppcheck-suppress cstyleCast
-                    ( (COArray *) n )->cdump( fp  );
-                    break;
-                default:
-                    break;
+                finished = true;
+            } else if( maxMicros && !( ++events % SERIALIZER_CHECK_EVENTS ) ) {
+                struct timespec now;
+
+                clock_gettime( CLOCK_MONOTONIC, &now );
+                if( ( now.tv_sec - start.tv_sec ) * 1000000 + ( now.tv_nsec - start.tv_nsec ) / 1000 >= (long) maxMicros )
+                {
+                    budget = 0;
+                }
             }
         }
-        fprintf( fp, "}" );
-    } else {
-        fprintf( fp, "{}");
     }
+    return done();
 }
 
-/*
- * Given a path, write a file to disk
- */
+/****************************************************************************************/
+/*                                                                                      */
+/*                                      CppONRealTime                                   */
+/*                                                                                      */
+/****************************************************************************************/
 
-int  COMap::toFile( const char *path )
+static thread_local unsigned    rtDepth     = 0;
+static thread_local size_t      rtAllocs    = 0;
+static bool                     rtAbort     = false;
+
+void CppONRealTime::enter()
 {
-    FILE    *fp = NULL;
-    int     rtn = 0;
-    /*
-     * Make sure we were passed something as a path and if so attempt to open it for writing
-     */
-    if( path && *path && (fp = fopen( path, "w" ) ) )
+    rtDepth++;
+}
+
+void CppONRealTime::leave()
+{
+    if( rtDepth )
     {
-        dump( fp );
-        fclose( fp );
-    } else {
-        rtn = -1;
+        rtDepth--;
     }
-    return rtn;
 }
 
-/*
- * Certain types take priority over others and so they are "promoted" to the higher priority.  They are ordered:
- *  1) Map or Array
- *  2) boolean
- *  3) double
- *  4) Integer
- *  5) String
- *  6) NULL;
- *
- *  The odd guy is the NULL. The NUll replaces everyone but everyone replaces the NULL
- */
+size_t CppONRealTime::allocations()
+{
+    return rtAllocs;
+}
 
-static void appendTag( string name, CppON *obj, COMap *rtn, CppON *n )
+void CppONRealTime::resetAllocations()
 {
-    if( obj->type() == MAP_CPPON_OBJ_TYPE )
+    rtAllocs = 0;
+}
+
+void CppONRealTime::abortOnAllocation( bool a )
+{
+    rtAbort = a;
+}
+
+#if CPPON_RT_CHECK
+void *operator new( size_t n )
+{
+    void    *p;
+
+    if( rtDepth )
     {
-        // cppcheck-suppress cstyleCast
-        rtn->append( name, new COMap( *((COMap *) obj) ) );
-    } else if( obj->type() == ARRAY_CPPON_OBJ_TYPE ) {
-        // cppcheck-suppress cstyleCast
-        rtn->append( name, new COArray( *((COArray *) obj) ) );
-    } else {
-        switch ( n->type() )
+        rtAllocs++;
+        if( rtAbort )
         {
-            case BOOLEAN_CPPON_OBJ_TYPE:                                            // If original type was a boolean then promote everything to boolean except null;
-                {
-                    // cppcheck-suppress cstyleCast
-                    bool v = ((COBoolean *) n )->value();
-                    bool r;
+            rtDepth = 0;
+            fprintf( stderr, "%s[%d]: %zu byte allocation in a real-time section\n", __FILE__, __LINE__, n );
+            abort();
+        }
+    }
+    if( !( p = malloc( ( n ) ? n : 1 ) ) )
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
 
-                    switch( obj->type() )
-                    {
-                        case BOOLEAN_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            if( v != ( r = ((COBoolean *) obj )->value() ) )
-                            {
-                                rtn->append( name, new COBoolean( r ) );
-                            }
-                            break;
-                        case INTEGER_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            if( v != ( r = ( ( (COInteger *) obj)->intValue() != 0 ) ) )
-                            {
-                                rtn->append( name, new COBoolean( r ) );
-                            }
-                            break;
-                        case DOUBLE_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            if( v != ( r = ( ( ( CODouble *) obj)->toInt() != 0 ) ) )
-                            {
-                                rtn->append( name, new COBoolean( r ) );
-                            }
-                            break;
-                        case STRING_CPPON_OBJ_TYPE:
-                            {
-                                // cppcheck-suppress cstyleCast
-                                const char *cPtr = ((COString *) obj)->c_str();
-                                if( v != ( r = ( 0 != ( !strcasecmp( cPtr, "true") ) ? 1 : ( (!strcasecmp( cPtr, "false" ) ) ? 0 : strtol( cPtr, NULL, 10 ) ) ) ) )
-                                {
-                                    rtn->append( name, new COBoolean( r ) );
-                                }
-                            }
-                            break;
-                        case NULL_CPPON_OBJ_TYPE:
-                            rtn->append( name, new CONull( ) );
-                            break;
-                        default:
-                            break;
-                    }
-                }
+void operator delete( void *p ) noexcept
+{
+    free( p );
+}
+
+void operator delete( void *p, size_t ) noexcept
+{
+    free( p );
+}
+#endif
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                         COBoolean                                    */
+/*                                                                                      */
+/****************************************************************************************/
+
+string *COBoolean::toNetString()
+{
+    if( !data )
+    {
+        return NULL;
+    }
+    const char *val = *( (char *) data )  ? "true" : "false";
+    return CppON::toNetString( val, '!' );
+}
+
+string *COBoolean::toJsonString()
+{
+    return new string( ((value())? "true" : "false") );
+}
+
+void COBoolean::dump( FILE *fp )
+{
+    fprintf( fp, "%s", (data) ? ( ( *(char *)data ) ? "true":"false") : "NULL" );
+}
+void COBoolean::cdump( FILE *fp )
+{
+    fprintf( fp, "%s", (data) ? ( ( *(char *)data ) ? "true":"false") : "false" );
+}
+const char  *COBoolean::c_str()
+{
+    str = ( data && *( (char *) data ))? "true" : "false";
+    return str.c_str();
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                    COMap                                             */
+/*                                                                                      */
+/****************************************************************************************/
+
+COMap::COMap( COMap *mt ) : CppON(  MAP_CPPON_OBJ_TYPE )
+{
+    data = new map<string, CppON*>();
+    std::map< std::string, CppON * >  &dm = *( ( map<string, CppON*> * ) data );
+
+    // cppcheck-suppress postfixOperator
+    for( std::vector<std::string>::iterator itr = mt->order.begin(); mt->order.end() != itr; itr++ )
+    {
+        CppON *obj = mt->findCaseElement( itr->c_str() );
+        order.push_back( string( *itr ) );
+        switch( obj->type() )
+        {
+            case INTEGER_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new COInteger( *((COInteger *)obj ) );
+                // cppcheck-suppress cstyleCast
                 break;
             case DOUBLE_CPPON_OBJ_TYPE:
-                {
-                    // cppcheck-suppress cstyleCast
-                    double v = ((CODouble *) n )->doubleValue();
-                    double r;
-
-                    switch( obj->type() )
-                    {
-                        case DOUBLE_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            if( v != ((CODouble *) obj)->doubleValue() )
-                            {
-                                // cppcheck-suppress cstyleCast
-                                rtn->append( name, new CODouble( *((CODouble *) obj) ) );
-                            }
-                            break;
-                        case INTEGER_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            if( v != ( r = (double)( ( COInteger * ) obj )->longValue() ) )
-                            {
-                                rtn->append( name, new CODouble( r ) );
-                            }
-                            break;
-                        case STRING_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            if( v != ( r = strtod( ((COString *) obj)->c_str(), NULL ) ) )
-                            {
-                                rtn->append( name, new CODouble( r ) );
-                            }
-                            break;
-                        case BOOLEAN_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( name, new COBoolean( *((COBoolean *) obj) ) );
-                            break;
-                        case NULL_CPPON_OBJ_TYPE:
-                            rtn->append( name, new CONull( ) );
-                            break;
-                        default:
-                            break;
-                    }
-                }
+                dm[ *itr ] = new CODouble( *( (CODouble *)obj ) );
+                // cppcheck-suppress cstyleCast
                 break;
-            case INTEGER_CPPON_OBJ_TYPE:
-                {
-                    // cppcheck-suppress cstyleCast
-                    uint64_t v = ((COInteger *) n)->toLongInt();
-                    uint64_t r;
-                    switch( obj->type() )
-                    {
-                        case INTEGER_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            if( v != (uint64_t)((COInteger *) obj)->toLongInt() )
-                            {
-                                // cppcheck-suppress cstyleCast
-                                rtn->append( name, new COInteger( *((COInteger *) obj) ) );
-                            }
-                            break;
-                        case STRING_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            if( v != ( r = strtol( ((COString *) obj)->c_str(), NULL, 0 ) ) )
-                            {
-                                rtn->append( name, new COInteger( r ) );
-                            }
-                            break;
-                        case DOUBLE_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( name, new CODouble( *((CODouble *) obj) ) );
-                            break;
-                        case BOOLEAN_CPPON_OBJ_TYPE:
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( name, new COBoolean( *((COBoolean *) obj) ) );
-                            break;
-                        case NULL_CPPON_OBJ_TYPE:
-                            rtn->append( name, new CONull( ) );
-                            break;
-                        default:
-                            break;
-                    }
-                }
+            case STRING_CPPON_OBJ_TYPE:
+                dm[ *itr ] = factory( obj );
+                // cppcheck-suppress cstyleCast
+                break;
+            case NULL_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new CONull( *( (CONull *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            case BOOLEAN_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new COBoolean( *( (COBoolean *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            case MAP_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new COMap( *( (COMap *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            case ARRAY_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new COArray( *( (COArray *)obj ) );
+                // cppcheck-suppress cstyleCast
                 break;
             default:
-                switch( obj->type() )
-                {
-                    case INTEGER_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( *((COInteger *) n ) != *((COInteger *) obj ) )
-                        {
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( name, new COInteger( *((COInteger *) obj) ) );
-                        }
-                        break;
-                    case DOUBLE_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( *((CODouble *) n ) != *((CODouble *) obj ) )
-                        {
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( name, new CODouble( *((CODouble *) obj) ) );
-                        }
-                        break;
-                    case BOOLEAN_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( *((COBoolean *) n ) != *((COBoolean *) obj ) )
-                        {
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( name, new COBoolean( *((COBoolean *) obj) ) );
-                        }
-                        break;
-                    case NULL_CPPON_OBJ_TYPE:
-                        if( n->type() != NULL_CPPON_OBJ_TYPE )
+                break;
+        }
+    }
+}
+
+COMap::COMap( COMap & mt ) : CppON(  MAP_CPPON_OBJ_TYPE )
+{
+    data = new map<string, CppON*>();
+    std::map< std::string, CppON * >  &dm = *( ( map<string, CppON*> * ) data );
+
+    // cppcheck-suppress postfixOperator
+    for( std::vector<std::string>::iterator itr = mt.order.begin(); mt.order.end() != itr; itr++ )
+    {
+        CppON *obj = mt.findCaseElement( itr->c_str() );
+        order.push_back( string( *itr ) );
+        switch( obj->type() )
+        {
+            case INTEGER_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new COInteger( *((COInteger *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            case DOUBLE_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new CODouble( *( (CODouble *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            case STRING_CPPON_OBJ_TYPE:
+                dm[ *itr ] = factory( obj );
+                // cppcheck-suppress cstyleCast
+                break;
+            case NULL_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new CONull( *( (CONull *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            case BOOLEAN_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new COBoolean( *( (COBoolean *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            case MAP_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new COMap( *( (COMap *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            case ARRAY_CPPON_OBJ_TYPE:
+                dm[ *itr ] = new COArray( *( (COArray *)obj ) );
+                // cppcheck-suppress cstyleCast
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+/*
+ * Does not check for null string
+ */
+void COMap::doParse( const char *str )
+{
+    DumpWhiteSpace( str );
+    const char    *sav = str;
+    unsigned     i;
+    if( '{' == *str )
+    {
+        char         name[ 256 ];
+        char        ch;
+        CppON        *obj = NULL;
+        ++str;
+        DumpWhiteSpace( ch, str );
+        while( *str )
+        {
+            sav = str;
+            if( '"' == *str++ )
+            {
+                for( i = 0; i < 255 && 0 != ( ch = *str++ ) && '"' != ch; i++ )
+                {
+                    name[ i ] = ch;
+                }
+                name[ i ] = '\0';
+                if( '"' == ch )
+                {
+                    DumpWhiteSpace( ch, str );
+                    sav = str;
+                    if( ':' == ch )
+                    {
+                        ++str;
+                        DumpWhiteSpace( ch, str );
+                        sav = str;
+                        while( 0 != (ch = *str ) && ( ' ' == ch || '\t' == ch || '\n' == ch || '\r' == ch ) ) { ++str; }
+                        if( '0' <= ch && '9' >= ch )
                         {
-                            rtn->append( name, new CONull( ) );
+                            obj = GetTNetstring( &str );
+                        } else if( ch ) {
+                            obj =  GetObj( &str );
                         }
-                        break;
-                    case STRING_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( *((COString *) n ) != *((COString *) obj ) )
+                        if( obj )
                         {
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( name, new COString( *((COString *) obj) ) );
+                            append( name, obj );
+                            obj = NULL;
+                            DumpWhiteSpace( ch, str );
+                            if( ch )
+                            {
+                                if( ',' == *str )
+                                {
+                                    str++;
+                                    DumpWhiteSpace( ch, str );
+                                } else if( '}' == *str ) {
+                                    break;
+                                } else {
+                                    fprintf( stderr, "%s[%d]: Unexpected character: '%c'\n", __FILE__,__LINE__, *str );
+                                    break;
+                                }
+                            }
+                        } else {
+                            std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
+                            fprintf( stderr, "%s[%d]: Failed to get object: '%s'\n", __FILE__,__LINE__, s.c_str() );
                         }
+                    } else {
+                        std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
+                        fprintf( stderr, "%s[%d]: Unexpected character: '%s'\n", __FILE__,__LINE__, sav );
                         break;
-                    case MAP_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( name, new COMap( *((COMap *) obj) ) );
-                        break;
-                    case ARRAY_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( name, new COArray( *((COArray *) obj) ) );
-                        break;
-                    default:
-                        break;
+                    }
+                } else {
+                    std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
+                    fprintf( stderr, "%s[%d]: Unexpected character: '%s'\n", __FILE__,__LINE__, sav );
+                    break;
                 }
+            } else {
+                std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
+                fprintf( stderr, "%s[%d]: Unexpected character: '%s'\n", __FILE__,__LINE__, sav );
+                break;
+            }
+        }
+    } else {
+        std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
+        fprintf( stderr, "%s[%d]: Parse ERROR: Expected '{' got '%s'\n", __FILE__, __LINE__, sav );
+    }
+}
+
+void COMap::parseData( const char *str )
+{
+    if( str )
+    {
+        doParse( str );
+    }
+}
+
+COMap::COMap( const char *path, const char *file ): CppON( MAP_CPPON_OBJ_TYPE )
+{
+    data = new map<string, CppON*>();
+    struct stat     _stat;
+    std::string p( path );
+    FILE    *fp;
+
+    if( '/' != p.back() )
+    {
+        p += '/';
+    }
+    p.append( file );
+    if( ! stat( p.c_str(), &_stat ) && ! ( _stat.st_mode & DIRECTORY_BIT ) && (fp = fopen( p.c_str(), "r" ) ) )
+    {
+        char    *buf = readWholeFile( fp, NULL );
+
+        fclose( fp );
+        if( buf )
+        {
+            parseData( buf );
+            free(buf );
+        }
+    } else {
+        fprintf( stderr, "%s[%.4u]: Failed to open JSON FILE \"%s\"",__FILE__, __LINE__, p.c_str() );
+    }
+}
+
+COMap::COMap( const char *str ): CppON(  MAP_CPPON_OBJ_TYPE )
+{
+    data = new map<string, CppON*>();
+    parseData( str );
+}
+
+COMap *COMap::operator=( const char *str )
+{
+    if( data )
+    {
+        (( map <string, CppON *> * ) data)->clear();
+    } else {
+        data = new map<string, CppON*>();
+    }
+    order.clear();
+    doParse( str );
+    return this;
+}
+
+// cppcheck-suppress unusedFunction
+void COMap::replaceObj( string s, CppON *obj )
+{
+    map <string, CppON *> *m = ( map <string, CppON*> *) data;
+    map <string, CppON *>::iterator it;
+    if( m->end( ) != (it = m->find( s ) ) )
+    {
+        release( it->second );
+        it->second = obj;
+    }
+}
+
+// cppcheck-suppress unusedFunction
+void COMap::removeVal( string s )
+{
+    map <string, CppON *> *m = ( map <string, CppON*> *) data;
+    map <string, CppON *>::iterator it;
+
+    if( m->end( ) != (it = m->find( s ) ) )
+    {
+        m->erase( it );
+        for( std::vector<std::string>::iterator iter = order.begin(); order.end() != iter; ++iter )
+        {
+            if( ! iter->compare( s ) )
+            {
+                order.erase( iter );
                 break;
+            }
         }
     }
 }
 
-COMap  *COMap::diff( COMap &newObj, const char *name )
+void COMap::clear( )
+{
+    map <string, CppON*> *m = ( map <string, CppON *> * ) data;
+    map<string, CppON *>::iterator it;
+
+    // cppcheck-suppress postfixOperator
+    for( it = m->begin(); m->end() != it; it++ )
+    {
+        release( it->second );
+    }
+    m->clear();
+    order.clear();
+}
+
+void COMap::merge( COMap *targetObj, const char *name )
+{
+    if( ! data )
+    {
+        data = new std::map<std::string, CppON*>();                                                 // data object you are merging too.
+    }
+    map<string, CppON *> *s = (map<string, CppON *> *) targetObj->data;                             // s is the data object of the map you are merging
+
+    for( map< string, CppON *>::iterator ti = s->begin(); s->end() != ti; ++ti )                    // foreach object in map you are merging
+    {
+        const string                    *targetStr = &(ti->first);                                  // get Object name
+        CppONType                        _eType = (ti->second)->type();                             // get type of object
+        CppON                            *myObj = NULL;                                             // Place to save an object that is found.
+        map<string, CppON *>::iterator  it;                                                         // Used to search destination
+        map<string, CppON *> *m = (map<string, CppON *> *) data;                                    // Search the destination for any objects with the same name.
+
+        // cppcheck-suppress postfixOperator
+        for( it = m->begin(); m->end() != it; it++ )
+        {
+            if( ! strcmp(  (it->first).c_str(), targetStr->c_str() ) )                              // Find the object
+            {
+                myObj = it->second;                                                                 // OK we have it already. set "myObj" to it and quit looking
+                break;
+            }
+        }
+        if( myObj )                                                                                 // We found it so we need to merge the reasult
+        {
+            switch( _eType )                                                                        // The merge is handled differently depending on type of object it is
+            {
+                case INTEGER_CPPON_OBJ_TYPE:                                                        // If it is an integer
+                    if( INTEGER_CPPON_OBJ_TYPE == myObj->type())                                    //    If the old object is the same type then we
+                    {
+                        // cppcheck-suppress cstyleCast
+                        *((COInteger *) myObj) = (long long)(COInteger *)(ti->second )->toLongInt();// set it to the new one
+                    } else {                                                                        //    If not
+                        m->erase( it );                                                             //      Delete it and add the new object
+                        release( myObj );
+                        // cppcheck-suppress cstyleCast
+                        append( targetStr->c_str(), new COInteger( (uint64_t)(COInteger *)( ti->second )->toLongInt( ) ) );
+                    }
+                    break;
+                case DOUBLE_CPPON_OBJ_TYPE:                                                         //  If it is a double (like an integer )
+                    if( DOUBLE_CPPON_OBJ_TYPE == myObj->type())                                     //      If the old object is also a double
+                    {
+                        // cppcheck-suppress cstyleCast
+                        ((CODouble *) myObj)->set( ((CODouble *)(ti->second ) )->toDouble());       // set it to the new value
+                    } else {                                                                        //      else if it of a different type than delete the old and replace
+                        m->erase( it );
+                        release( myObj );
+                        // cppcheck-suppress cstyleCast
+                        append( targetStr->c_str(), new CODouble( (double)((CODouble *)( ti->second ))->toLongInt( ) ) );
+                    }
+                    break;
+                case STRING_CPPON_OBJ_TYPE:                                                        // Strings are treated like integers and doubles
+                    if( STRING_CPPON_OBJ_TYPE == myObj->type())
+                    {
+                        // cppcheck-suppress cstyleCast
+                        *((COString *) myObj) = ((COString *)(ti->second ) )->c_str();
+                    } else {
+                        m->erase( it );
+                        release( myObj );
+                        // cppcheck-suppress cstyleCast
+                        append( targetStr->c_str(), new COString( ((COString *)( ti->second ))->c_str() ) );
+                    }
+                    break;
+                case NULL_CPPON_OBJ_TYPE:                                                          //  In the case of null, it doesn't have a value
+                    if( NULL_CPPON_OBJ_TYPE != myObj->type())                                      //  But if the old one exist and it isn't null,
+                    {
+                        m->erase( it );                                                            //    delete it and set it to null
+                        release( myObj );
+                        append( targetStr->c_str(), new CONull() );
+                    }
+                    break;
+                case BOOLEAN_CPPON_OBJ_TYPE:                                                       // booleans are treated like integers, doubles and strings
+                    if( BOOLEAN_CPPON_OBJ_TYPE == myObj->type())
+                    {
+                        // cppcheck-suppress cstyleCast
+                        *((COBoolean *) myObj) = *((COBoolean *)(ti->second ));
+                    } else {
+                        m->erase( it );
+                        release( myObj );
+                        // cppcheck-suppress cstyleCast
+                        append( targetStr->c_str(), new COBoolean( ((COBoolean *)( ti->second ))->value() ) );
+                    }
+                    break;
+                case  MAP_CPPON_OBJ_TYPE:
+                    {
+                        // cppcheck-suppress cstyleCast
+                        COMap     *pt = ( COMap *) ti->second;
+                        if( MAP_CPPON_OBJ_TYPE == myObj->type())                                   //    IF the old one is also a map then
+                        {
+                            // cppcheck-suppress cstyleCast
+                            ((COMap *)it->second )->merge( pt , name );                            //      merge the two
+                        } else {                                                                   //    else
+                            m->erase( it );                                                        //      delete the old one and merge the new one.
+                            release( myObj );
+                            append( targetStr->c_str(), new COMap( *pt ) );
+                        }
+                    }
+                    break;
+                case  ARRAY_CPPON_OBJ_TYPE:
+                    {
+                        // cppcheck-suppress cstyleCast
+                        COArray   *arrTarget = (COArray *) ti->second;
+                        for( size_t k = 0; arrTarget->size() > k; k++ )
+                        {
+                            COString  *str;
+                            COString  *namePtr;
+                            COMap     *tMap;
+                            // cppcheck-suppress cstyleCast
+                            if( CppON::isMap( tMap = (COMap *)arrTarget->at( k ) ) && CppON::isString( namePtr = (COString *) (tMap->findElement( name ) ) ) )
+                            {
+                                // cppcheck-suppress cstyleCast
+                                COArray   *arr = (COArray *) it->second;
+                                size_t    i;
+                                for( i = 0; arr->size() > i; i++ )
+                                {
+                                    COMap     *uMap;
+                                    // cppcheck-suppress cstyleCast
+                                    if( CppON::isMap( uMap = (COMap *)arr->at( i ) ) && CppON::isString( str = (COString *) (uMap->findElement( name ) ) ) && !strcmp( str->c_str(), namePtr->c_str() ) )
+                                    {
+                                        uMap->merge( tMap, name );
+                                        break;
+                                    }
+                                }
+                                if( arr->size() <= i )
+                                {
+                                    arr->append( new COMap( *tMap ));
+                                }
+                                // cppcheck-suppress cstyleCast
+                            } else if( CppON::isString( str = (COString *)arrTarget->at( k ) ) ) {
+                                // cppcheck-suppress cstyleCast
+                                COArray   *arr = (COArray *) myObj;
+                                size_t    k1;
+                                for( k1 = 0; arr->size() > k1; k1++ )                              // Check if a string exists in target object that is the same
+                                {
+                                    // cppcheck-suppress cstyleCast
+                                    COString  *kStr = (COString *) arr->at( k1 );
+                                    if( CppON::isString( kStr ) )
+                                    {
+                                        if( ! strcmp( str->c_str(), kStr->c_str() ) )
+                                        {
+                                            break;
+                                        }
+                                    }
+                                }
+                                if( arr->size() == k1 )
+                                {
+                                    arr->append( new COString( *str ) );
+                                }
+                            }
+                        }
+                    }
+                    break;
+                default:
+                    break;
+            }
+        } else {                                                                                   // It doesn't have this so just add it.
+            // cppcheck-suppress cstyleCast
+            append( *targetStr, CppON::factory( *(( CppON *)ti->second )) );
+        }
+    }
+}
+
+void COMap::upDate( COMap *target, const char *name )
+{
+    if( data )
+    {
+        map<string, CppON *> *s = (map<string, CppON *> *) target->data;
+
+        for( map< string, CppON *>::iterator ti = s->begin(); s->end() != ti; ++ti )
+        {
+            bool                                 found = false;
+            map<string, CppON *>::iterator       it;
+            const string                         *targetStr = &(ti->first);
+            CppONType                              _eType = (ti->second)->type();
+
+            map<string, CppON *> *m = (map<string, CppON *> *) data;
+            // cppcheck-suppress postfixOperator
+            for( it = m->begin(); m->end() != it; it++ )
+            {
+                if( ! strcmp(  (it->first).c_str(), targetStr->c_str() ) )
+                {
+                    found = true;
+                    if( (it->second)->type() == _eType )                                           // If they are the same data type then just update it
+                    {
+                        switch( _eType )
+                        {
+                            case INTEGER_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                *((COInteger *)it->second ) =  ( (COInteger *)ti->second )->intValue();
+                                break;
+                            case DOUBLE_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                *((CODouble *)it->second ) =  ( (CODouble *)ti->second )->doubleValue();
+                                break;
+                            case STRING_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                *((COString *)it->second ) = ( (COString *)ti->second )->c_str() ;
+                                break;
+                            case BOOLEAN_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                *((COBoolean *)it->second ) = ( (COBoolean *)ti->second )->value();
+                                break;
+                            case  MAP_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                ((COMap *)it->second )->upDate( ( (COMap *) ti->second ), name );
+                                break;
+                            case  ARRAY_CPPON_OBJ_TYPE:
+                                {
+                                    // cppcheck-suppress cstyleCast
+                                    COArray   *arrTarget = (COArray *) ti->second;
+                                    for( size_t k = 0; arrTarget->size() > k; k++ )
+                                    {
+                                        COString *namePtr;
+                                        COMap *tMap;
+                                        // cppcheck-suppress cstyleCast
+                                        if( CppON::isMap( tMap = (COMap *)arrTarget->at( k ) ) && CppON::isString( namePtr = (COString *) (tMap->findElement( name ) ) ) )
+                                        {
+                                            // cppcheck-suppress cstyleCast
+                                            COArray     *arr = (COArray *) it->second;
+                                            for( size_t i = 0; arr->size() > i; i++ )
+                                            {
+                                                COString *str;
+                                                COMap     *uMap;
+                                                // cppcheck-suppress cstyleCast
+                                                if( CppON::isMap( uMap = (COMap *)arr->at( i ) ) && CppON::isString( str = (COString *) (uMap->findElement( name ) ) ) && !strcmp( str->c_str(), namePtr->c_str() ) )
+                                                {
+                                                    COMap *newMap = new COMap( *tMap );
+                                                    if( ! arr->replace( i, newMap ) )                   // replace() releases uMap
+                                                    {
+                                                        delete newMap;
+                                                    }
+                                                    break;
+                                                }
+                                            }
+                                        }
+                                    }
+                                }
+                                break;
+                            case NULL_CPPON_OBJ_TYPE:
+                                fprintf( stderr, "COMap:update - Null 1st being ignored\n");
+                                break;
+                            default:
+                                break;
+                        }
+                    } else {
+                        release( it->second );                                                                          // replace the data type with the new one.
+                        switch( _eType )
+                        {
+                            case INTEGER_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                it->second =  new COInteger( ( (COInteger *)ti->second )->intValue() );
+                                break;
+                            case DOUBLE_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                it->second =  new CODouble( ( (CODouble *)ti->second )->doubleValue() );
+                                break;
+                            case STRING_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                it->second = new COString( ( (COString *)ti->second )->c_str() );
+                                break;
+                            case BOOLEAN_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                it->second = new COBoolean( ( (COBoolean *)ti->second )->value() );
+                                break;
+                            case  MAP_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                it->second  = new COMap( * ( (COMap *)ti->second ) );
+                                break;
+                            case  ARRAY_CPPON_OBJ_TYPE:
+                                // cppcheck-suppress cstyleCast
+                                it->second  = new COArray( * ( (COArray *)ti->second ) );
+                                break;
+                            case NULL_CPPON_OBJ_TYPE:
+                                it->second = new CONull();
+                                fprintf( stderr, "%s[%d]: COMap:update - Null being ignored\n",__FILE__,__LINE__);
+                                target->dump();
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                }
+            }
+            if( ! found )
+            {
+                switch ( _eType )
+                {
+                    case INTEGER_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        this->append( ti->first, new COInteger( *((COInteger *) ti->second) ) );
+                        break;
+                    case DOUBLE_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        this->append( ti->first, new CODouble( *((CODouble *) ti->second) ) );
+                        break;
+                    case STRING_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        this->append( ti->first, new COString( *((COString *) ti->second) ) );
+                        break;
+                    case BOOLEAN_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        this->append( ti->first, new COBoolean( *((COBoolean *) ti->second) ) );
+                        break;
+                    case NULL_CPPON_OBJ_TYPE:
+                        this->append( ti->first, new CONull() );
+                        break;
+                    case  MAP_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        this->append( ti->first, new COMap( *((COMap *) ti->second) ) );
+                        break;
+                    case  ARRAY_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        this->append( ti->first, new COArray( *((COArray *) ti->second) ) );
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Set or remove a key of a Map exactly as given; append() would split a key with a '/' in it into a path.
+ */
+static void mapSetKey( COMap *m, const std::string &key, CppON *obj )
+{
+    std::map<std::string, CppON *>::iterator it = m->value()->find( key );
+
+    if( m->value()->end() != it )
+    {
+        CppON::release( it->second );
+        it->second = obj;
+    } else {
+        m->value()->insert( std::pair<std::string, CppON *>( key, obj ) );
+        m->getKeys()->push_back( key );
+    }
+}
+
+static void mapRemoveKey( COMap *m, const std::string &key )
+{
+    std::map<std::string, CppON *>::iterator    it = m->value()->find( key );
+    std::vector<std::string>::iterator          k;
+
+    if( m->value()->end() != it )
+    {
+        CppON::release( it->second );
+        m->value()->erase( it );
+        if( m->getKeys()->end() != ( k = std::find( m->getKeys()->begin(), m->getKeys()->end(), key ) ) )
+        {
+            m->getKeys()->erase( k );
+        }
+    }
+}
+
+/*
+ * Nodes of a partial result of mergeAll() whose value was started over (a type change or a plain value) somewhere
+ * within the documents merged into it.  Such a node replaces what it is merged into instead of being merged.  Before
+ * two partials are merged the right one's set is added to the left one's, as those are the nodes that get checked.
+ */
+typedef std::unordered_set<CppON *> COMergeResets;
+
+static void mergeMoveMap( COMap *into, COMap *from, const char *keyField, COMergeResets &resets );
+
+/*
+ * Merge the elements of a later Array into an earlier one the way merge() does: Maps with the same keyField value
+ * are merged, other keyed Maps and strings not already there are added and everything else is ignored.
+ */
+static void mergeMoveArray( COArray *into, COArray *from, const char *keyField, COMergeResets &resets )
+{
+    std::unordered_map<std::string, COMap *>    keyed;
+    std::unordered_set<std::string>             strs;
+    std::vector<CppON *>                        *v      = from->value();
+    size_t                                      n       = into->size();
+
+    for( size_t i = 0; n > i; i++ )
+    {
+        CppON *e = into->at( i );
+        CppON *k;
+
+        if( keyField && CppON::isMap( e ) && CppON::isString( k = ( (COMap *) e )->findElement( keyField ) ) )
+        {
+            // cppcheck-suppress cstyleCast
+            keyed.emplace( *( (COString *) k )->value(), (COMap *) e );                     // The first one is the one merged into
+        } else if( CppON::isString( e ) ) {
+            // cppcheck-suppress cstyleCast
+            strs.insert( *( (COString *) e )->value() );
+        }
+    }
+    for( size_t i = 0; v->size() > i; i++ )
+    {
+        CppON                                               *e  = ( *v )[ i ];
+        CppON                                               *k;
+        std::unordered_map<std::string, COMap *>::iterator  it;
+
+        if( keyField && CppON::isMap( e ) && CppON::isString( k = ( (COMap *) e )->findElement( keyField ) ) )
+        {
+            // cppcheck-suppress cstyleCast
+            const std::string &key = *( (COString *) k )->value();
+
+            if( keyed.end() != ( it = keyed.find( key ) ) )
+            {
+                // cppcheck-suppress cstyleCast
+                mergeMoveMap( it->second, (COMap *) e, keyField, resets );
+            } else {
+                // cppcheck-suppress cstyleCast
+                keyed.emplace( key, (COMap *) e );
+                into->append( e );
+                ( *v )[ i ] = NULL;
+            }
+        } else if( CppON::isString( e ) ) {
+            // cppcheck-suppress cstyleCast
+            if( strs.insert( *( (COString *) e )->value() ).second )
+            {
+                into->append( e );
+                ( *v )[ i ] = NULL;
+            }
+        }
+    }
+}
+
+/*
+ * Merge a later partial result into an earlier one, moving nodes out of "from" rather than copying them.  What
+ * "into" loses is swapped into "from", which the caller frees once the whole reduction is done.
+ */
+static void mergeMoveMap( COMap *into, COMap *from, const char *keyField, COMergeResets &resets )
+{
+    std::map<std::string, CppON *>  *a  = into->value();
+    std::map<std::string, CppON *>  *b  = from->value();
+
+    for( std::map<std::string, CppON *>::iterator ib = b->begin(); b->end() != ib; ++ib )
+    {
+        std::map<std::string, CppON *>::iterator    ia  = a->find( ib->first );
+        CppON                                       *y  = ib->second;
+
+        if( ! y )
+        {
+            continue;
+        } else if( a->end() == ia ) {
+            mapSetKey( into, ib->first, y );
+            ib->second = NULL;
+        } else if( ! ia->second || ia->second->type() != y->type() || resets.count( y ) ) {
+            if( ! resets.count( y ) )
+            {
+                resets.insert( y );                                                         // The merged run changes type here
+            }
+            std::swap( ia->second, ib->second );
+        } else if( MAP_CPPON_OBJ_TYPE == y->type() ) {
+            // cppcheck-suppress cstyleCast
+            mergeMoveMap( (COMap *) ia->second, (COMap *) y, keyField, resets );
+        } else if( ARRAY_CPPON_OBJ_TYPE == y->type() ) {
+            // cppcheck-suppress cstyleCast
+            mergeMoveArray( (COArray *) ia->second, (COArray *) y, keyField, resets );
+        } else {
+            std::swap( ia->second, ib->second );                                            // The later value wins
+        }
+    }
+}
+
+/*
+ * Merge many documents into one, as if each were merge()d in turn into an empty Map, but as a tree reduction:
+ * neighbours are merged in pairs, the pairs of each round in parallel on up to "threads" threads (0 for one per
+ * core), and then the results of that round in pairs, and so on.  Subtrees are moved from one document into the
+ * other instead of being copied and the pairing does not depend on timing, so the result (key order included) is
+ * the same on every run.  A partial result remembers where a value was started over so merging it in replaces what
+ * came before instead of merging with it, as it would have done one document at a time.
+ *
+ * The documents are consumed: the result is the first of them and the others are freed.  docs is left empty.
+ */
+COMap *COMap::mergeAll( std::vector<COMap *> &docs, const char *keyField, unsigned threads )
+{
+    std::vector<COMap *>        cur;
+    std::vector<COMergeResets>  resets;
+    std::vector<COMap *>        garbage;
+    COMap                       *rtn;
+
+    for( size_t i = 0; docs.size() > i; i++ )
+    {
+        if( docs[ i ] )
+        {
+            cur.push_back( docs[ i ] );
+        }
+    }
+    docs.clear();
+    if( ! threads )
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    if( ! threads )
+    {
+        threads = 1;                                                                        // The count is not known
+    }
+    resets.resize( cur.size() );
+    while( 1 < cur.size() )
+    {
+        size_t                      pairs   = cur.size() / 2;
+        size_t                      n       = ( threads < pairs ) ? threads : pairs;
+        std::vector<std::thread>    pool;
+        auto                        work    = [ & ]( size_t first )
+        {
+            for( size_t p = first; pairs > p; p += n )
+            {
+                resets[ 2 * p ].insert( resets[ 2 * p + 1 ].begin(), resets[ 2 * p + 1 ].end() );  // The right side's marks decide
+                mergeMoveMap( cur[ 2 * p ], cur[ 2 * p + 1 ], keyField, resets[ 2 * p ] );         // what it replaces
+            }
+        };
+
+        for( size_t t = 1; n > t; t++ )
+        {
+            pool.push_back( std::thread( work, t ) );
+        }
+        work( 0 );
+        for( size_t t = 0; pool.size() > t; t++ )
+        {
+            pool[ t ].join();
+        }
+        for( size_t p = 0; pairs > p; p++ )
+        {
+            garbage.push_back( cur[ 2 * p + 1 ] );
+            cur[ p ] = cur[ 2 * p ];
+            resets[ p ].swap( resets[ 2 * p ] );
+        }
+        if( cur.size() & 1 )
+        {
+            cur[ pairs ] = cur.back();
+            resets[ pairs ].swap( resets[ cur.size() - 1 ] );
+            pairs++;
+        }
+        cur.resize( pairs );
+        resets.resize( pairs );
+    }
+    rtn = ( cur.size() ) ? cur[ 0 ] : new COMap();
+    for( size_t i = 0; garbage.size() > i; i++ )                                            // Freed only now so no address in resets is reused
+    {
+        delete garbage[ i ];
+    }
+    return rtn;
+}
+
+CppON *COMap::findEqual( const char * name, CppON &search )
+{
+    CppON     *rtn = NULL;
+    CppONType    _eType = search.type();
+
+    if( data )
+    {
+        map<string, CppON *>::iterator it;
+        map<string, CppON *> *m = (map<string, CppON *> *) data;
+        // cppcheck-suppress postfixOperator
+        for( it = m->begin(); !rtn && m->end() != it; it++ )
+        {
+            if( ! strcmp(  (it->first).c_str(), name ) && (it->second)->type() == _eType )
+            {
+                switch( _eType )
+                {
+                    case INTEGER_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( ((COInteger &) search).intValue() == ((COInteger *)it->second )->intValue() )
+                        {
+                            rtn = (it->second);
+                        }
+                        break;
+                    case DOUBLE_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( ((CODouble &) search).doubleValue() == ((CODouble *)it->second )->doubleValue() )
+                        {
+                            rtn = (it->second);
+                        }
+                        break;
+                    case STRING_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( !strcmp( ( ( COString &) search).c_str(), ((COString *)it->second )->c_str() ) )
+                        {
+                            rtn = ( it->second );
+                        }
+                        break;
+                    case BOOLEAN_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( ((COBoolean &) search).value() == ((COBoolean *)it->second )->value() )
+                        {
+                            rtn = (it->second);
+                        }
+                        break;
+                    case NULL_CPPON_OBJ_TYPE:
+                        rtn = (it->second );
+                        break;
+                    default:
+                        break;
+                }
+            }
+            if( ! rtn )
+            {
+                if( MAP_CPPON_OBJ_TYPE == (it->second)->type() )
+                {
+                    // cppcheck-suppress cstyleCast
+                    rtn = ( ( COMap *) it->second )->findEqual( name, search );
+                } else if( ARRAY_CPPON_OBJ_TYPE == (it->second)->type() ) {
+                    //            rtn = ( ( COArray *) it->second )->findEqual( name, search );
+                }
+            }
+        }
+    }
+    return rtn;
+}
+
+
+/*
+ * Splits a path based on the forward slash ('/') into a val string and a remainder part
+ * basically on retruning everything before the slash is in the "val" string and the remainder points to everything after the slash
+ *
+ */
+
+static void splitPath( const char *str, std::string &val, const char **remainder )
+{
+    if( str && remainder )
+    {
+        for( *remainder = str; *(*remainder) && '/' != *(*remainder) ; (*remainder)++ );
+        val = std::string( str, ( *remainder - str ) );
+        if( '/' == *(*remainder) )
+        {
+            (*remainder)++;
+        }
+    }
+}
+/*
+ * This and its companion "findCaseElement" if the typical way to find object in a map.
+ *
+ * Normally we are looking for an element directly in a structure but if we are need to go further
+ * and retrieve an object in a Map thats in the Map we can deleminate the levels with a forward slash.
+ * Likewise if we are looking for an element in an array  then we can delimit that with a colon.  So
+ *  config/axisEncoders:2/resolution would search the structure to get the "config" map which it would search
+ *  to get the axisEncoders array and retrieve the third element returning the resolution object of it.
+ *  {
+ *    config: {
+ *      axisEncoders: [
+ *        {
+ *        },
+ *        {
+ *        },
+ *        {
+ *          name: \"Gurely\",
+ *          resolution:0.01
+ *        }
+ *      ]
+ *    }
+ *  }
+ *
+ */
+
+CppON *COMap::findElement( const char *str )
+{
+    CppON *rtn = NULL;
+    if( data && str )
+    {
+        int        arrayIndex = -1;
+
+        /*
+         * Split the path with s = to anything before a forward slash ('/') and str pointing to first character after it.
+         */
+        std::string s;
+        splitPath( str, s, &str );                                                // split the string based on a slash
+
+        /*
+         * Now look to see if there is an index after the original part denoted by a colon (':')
+         */
+        size_t idx = s.find( ':' );
+        std::string more;
+        if( std::string::npos != idx )                                            // colon is found
+        {
+            char *r;
+            arrayIndex = strtol( &s.c_str()[ idx + 1 ], &r, 10 );                // Read the index as a base 10 number following the colon
+            more = r;                                                            // more will contain any text after the number
+            s = s.substr( 0, idx );                                                // s only contains the text up to the colon
+        }
+
+        /*
+         * OK search the map for an item with a name matching the text in 's'
+         */
+#if 1
+        std::map<std::string,CppON*>::iterator it = ((std::map< std::string, CppON*> *) data)->find( s );
+        if( ((std::map< std::string, CppON*> *) data)->end() != it )
+        {
+            rtn = it->second;
+        }
+#else
+        map<string, CppON *> *m = (map<string, CppON *> *) data;
+        // cppcheck-suppress postfixOperator
+        for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; it++ )
+        {
+            if( ! strcmp(  (it->first).c_str(), s.c_str() ) )                    // if found set "rtn" to the object and quit looking
+            {
+                rtn = it->second;
+                break;
+            }
+        }
+#endif
+        if( rtn && CppON::isMap( rtn ) && *str )                                // But wait! if the object found is a map and there is a remainder from the
+        {                                                                         // original split then call ourselves with the new string to find the object
+            // cppcheck-suppress cstyleCast
+            rtn = ( (COMap *) rtn )->findElement( str );
+        } else if( rtn && CppON::isArray( rtn ) && 0 <= arrayIndex ) {            // Or maybe the returned object was an array and we have an index
+            while( CppON::isArray( rtn ) && 0 <= arrayIndex )
+            {
+                // cppcheck-suppress cstyleCast
+                rtn = ( (COArray*) rtn)->at( arrayIndex );
+                if( CppON::isMap( rtn ) && *str )
+                {
+                    // cppcheck-suppress cstyleCast
+                    rtn = ( (COMap *) rtn)->findElement( str );
+                    break;
+                } else if( ! CppON::isArray( rtn ) || more[ 0 ] != ':' ) {
+                    break;
+                } else {
+                    char *r;
+                    s = more.substr( 1 );
+                    arrayIndex = strtol( s.c_str(), &r, 10 );
+                    more = r;
+                }
+            }
+        }
+    }
+    return rtn;
+}
+// cppcheck-suppress unusedFunction
+CppON *COMap::findNoSplit( const char *str )
+{
+    CppON *rtn = NULL;
+
+    if( data && str )
+    {
+        /*
+         * OK search the map for an item with a name matching the text in 's'
+         */
+        map<string, CppON *> *m = (map<string, CppON *> *) data;
+        // cppcheck-suppress postfixOperator
+        for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; it++ )
+        {
+            if( ! strcmp( (it->first).c_str(), str ) )         // if found set "rtn" to the object and quit looking
+            {
+                rtn = it->second;
+                break;
+            }
+        }
+    }
+    return rtn;
+}
+CppON *COMap::findCaseElement( const char *str )
+{
+    CppON *rtn = NULL;
+
+    if( data  && str )
+    {
+        /*
+         * Split the path with s = to anything before a forward slash ('/') and str pointing to first character after it.
+         */
+
+        int         arrayIndex = -1;
+        std::string s;
+
+        splitPath( str, s, &str );
+        /*
+         * Now look to see if there is an index after the original part denoted by a colon (':')
+         */
+        size_t idx = s.find( ':' );
+        std::string more;
+        if( std::string::npos != idx )                              // colon is found
+        {
+            char *r;
+            arrayIndex = strtol( &s.c_str()[ idx + 1 ], &r, 10 );     // Read the index as a base 10 number following the colon
+            more = r;                                                 // more will contain any text after the number
+            s = s.substr( 0, idx );                                   // s only contains the text up to the colon
+        }
+
+        map<string, CppON *> *m = (map<string, CppON *> *) data;
+        // cppcheck-suppress postfixOperator
+        for( map<string, CppON *>::iterator it = m->begin(); m->end() != it; it++ )
+        {
+            if( ! strcasecmp(  (it->first).c_str(), s.c_str() ) )
+            {
+                rtn = it->second;
+                break;
+            }
+        }
+        if( rtn && CppON::isMap( rtn ) && *str )
+        {
+            // cppcheck-suppress cstyleCast
+            rtn = ( (COMap *) rtn )->findCaseElement( str );
+        } else if(CppON::isArray( rtn ) && 0 <= arrayIndex ) {    // Or maybe the returned object was an array and we have an index
+            while( CppON::isArray( rtn ) && 0 <= arrayIndex )
+            {
+                // cppcheck-suppress cstyleCast
+                rtn = ( (COArray*) rtn)->at( arrayIndex );
+                if( CppON::isMap( rtn ) && *str )
+                {
+                    // cppcheck-suppress cstyleCast
+                    rtn = ( (COMap *) rtn)->findElement( str );
+                    break;
+                } else if( ! CppON::isArray( rtn ) || more[ 0 ] != ':' ) {
+                    break;
+                } else {
+                    char *r;
+                    s = more.substr( 1 );
+                    arrayIndex = strtol( s.c_str(), &r, 10 );
+                    more = r;
+                }
+            }
+        }
+    }
+    return rtn;
+}
+std::string *COMap::toCompactJsonString( )
+{
+    std::string *rtn = new string();
+    CppONWriter w( this, CppONWriter::COMPACT, *rtn, "" );
+
+    w.run();
+    return rtn;
+}
+
+std::string *COMap::toJsonString( std::string &indent )
+{
+    std::string *rtn = new string();
+    CppONWriter w( this, CppONWriter::PRETTY, *rtn, indent );
+
+    w.run();
+    return rtn;
+}
+
+string *COMap::toNetString()
+{
+    if( data && MAP_CPPON_OBJ_TYPE == typ )
+    {
+        std::string *rtn = new string();
+        CppONWriter w( this, CppONWriter::NET, *rtn, "" );
+
+        w.run();
+        return rtn;
+    }
+    return NULL;
+}
+
+const char  *COMap::c_str( std::string &idnt )
+{
+    str = "{";
+    if( data )
+    {
+        map<string, CppON *>::iterator    it;
+        map<string, CppON *>            *m = (map<string, CppON *> *) data;
+        const char                        *comma = "\n";
+        std::string                        indent = idnt;
+
+        for( size_t idx = 0; order.size() > idx; ++idx )
+        {
+            it = m->find( order.at( idx ) );
+            str.append( comma );
+            comma = ",\n";
+            str.append( indent );
+            str += '"';
+            str += it->first;
+            str.append( "\": " );
+            // cppcheck-suppress cstyleCast
+            CppON *n = (CppON *) it->second;
+            switch ( n->type() )
+            {
+                case INTEGER_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( (COInteger *) n )->c_str();
+                    break;
+                case DOUBLE_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( (CODouble *) n )->c_str();
+                    break;
+                case STRING_CPPON_OBJ_TYPE:
+                    str += '"';
+                    // cppcheck-suppress cstyleCast
+                    str += ( ( COString *) n )->c_str();
+                    str += '"';
+                    break;
+                case BOOLEAN_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( ( COBoolean *) n )->c_str();
+                    break;
+                case NULL_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( ( CONull *) n )->c_str();
+                    break;
+                case MAP_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( (COMap *) n )->c_str( indent );
+                    break;
+                case ARRAY_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( (COArray *) n )->c_str( indent );
+                    break;
+                default:
+                    break;
+            }
+        }
+        str += '\n';
+    }
+    str += '}';
+    return str.c_str();
+}
+
+
+void COMap::dump( string &indent, FILE *fp )
+{
+    if( data )
+    {
+        map<string, CppON *>::iterator   it;
+        map<string, CppON *>            *m = (map<string, CppON *> *) data;
+        bool                              first = true;
+        string                            newIndent = indent;
+
+        newIndent.append( "\t" );
+        fprintf( fp, "%s{",indent.c_str() );
+        for( size_t idx = 0; order.size() > idx; ++idx )
+        {
+            it = m->find( order.at( idx ) );
+            if( first )
+            {
+                fprintf( fp, "\n%s\"%s\": ", newIndent.c_str(), ( ( string ) it->first).c_str() );
+                first = false;
+            } else {
+                fprintf( fp, ",\n%s\"%s\": ", newIndent.c_str(), ( ( string ) it->first).c_str() );
+            }
+            // cppcheck-suppress cstyleCast
+            CppON *n = (CppON *) it->second;
+            switch ( n->type() )
+            {
+                case INTEGER_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (COInteger *) n )->dump( fp );
+                    break;
+                case DOUBLE_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (CODouble *) n )->dump( fp );
+                    break;
+                case STRING_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( ( COString *) n )->dump( fp );
+                    break;
+                case BOOLEAN_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( ( COBoolean *) n )->dump( fp );
+                    break;
+                case NULL_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( ( CONull *) n )->dump( fp );
+                    break;
+                case MAP_CPPON_OBJ_TYPE:
+                    fprintf( fp, "\n");
+                    // cppcheck-suppress cstyleCast
+                    ( (COMap *) n )->dump( newIndent, fp );
+                    break;
+                case ARRAY_CPPON_OBJ_TYPE:
+                    fprintf( fp, "\n");
+                    // cppcheck-suppress cstyleCast
+                    ( (COArray *) n )->dump( newIndent, fp  );
+                    break;
+                default:
+                    break;
+            }
+        }
+        fprintf( fp, "\n%s}",indent.c_str() );
+    } else {
+        fprintf( fp, "NULL");
+    }
+}
+
+void COMap::cdump( FILE *fp )
+{
+    if( data )
+    {
+        map<string, CppON *>::iterator   it;
+        map<string, CppON *>            *m = (map<string, CppON *> *) data;
+        bool                              first = true;
+
+        fprintf( fp, "{" );
+        for( size_t idx = 0; order.size() > idx; ++idx )
+        {
+            it = m->find( order.at( idx ) );
+            if( first )
+            {
+                fprintf( fp, "\\\"%s\\\": ", ( ( string ) it->first).c_str() );
+                first = false;
+            } else {
+                fprintf( fp, ",\\\"%s\\\": ", ( ( string ) it->first).c_str() );
+            }
+            // cppcheck-suppress cstyleCast
+            CppON *n = (CppON *) it->second;
+            switch ( n->type() )
+            {
+                case INTEGER_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (COInteger *) n )->cdump( fp );
+                    break;
+                case DOUBLE_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (CODouble *) n )->cdump( fp );
+                    break;
+                case STRING_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( ( COString *) n )->cdump( fp );
+                    break;
+                case BOOLEAN_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( ( COBoolean *) n )->cdump( fp );
+                    break;
+                case NULL_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( ( CONull *) n )->cdump( fp );
+                    break;
+                case MAP_CPPON_OBJ_TYPE:
+                    fprintf( fp, "\"\n\"");
+                    // cppcheck-suppress cstyleCast
+                    ( (COMap *) n )->cdump( fp );
+                    break;
+                case ARRAY_CPPON_OBJ_TYPE:
+                    fprintf( fp, "\"\n\"");
+                    // cppcheck-suppress cstyleCast
+                    ( (COArray *) n )->cdump( fp  );
+                    break;
+                default:
+                    break;
+            }
+        }
+        fprintf( fp, "}" );
+    } else {
+        fprintf( fp, "{}");
+    }
+}
+
+/*
+ * Given a path, write a file to disk
+ */
+
+int  COMap::toFile( const char *path )
+{
+    FILE    *fp = NULL;
+    int     rtn = 0;
+    /*
+     * Make sure we were passed something as a path and if so attempt to open it for writing
+     */
+    if( path && *path && (fp = fopen( path, "w" ) ) )
+    {
+        dump( fp );
+        fclose( fp );
+    } else {
+        rtn = -1;
+    }
+    return rtn;
+}
+
+/*
+ * Certain types take priority over others and so they are "promoted" to the higher priority.  They are ordered:
+ *  1) Map or Array
+ *  2) boolean
+ *  3) double
+ *  4) Integer
+ *  5) String
+ *  6) NULL;
+ *
+ *  The odd guy is the NULL. The NUll replaces everyone but everyone replaces the NULL
+ */
+
+static void appendTag( string name, CppON *obj, COMap *rtn, CppON *n )
+{
+    if( obj->type() == MAP_CPPON_OBJ_TYPE )
+    {
+        // cppcheck-suppress cstyleCast
+        rtn->append( name, new COMap( *((COMap *) obj) ) );
+    } else if( obj->type() == ARRAY_CPPON_OBJ_TYPE ) {
+        // cppcheck-suppress cstyleCast
+        rtn->append( name, new COArray( *((COArray *) obj) ) );
+    } else {
+        switch ( n->type() )
+        {
+            case BOOLEAN_CPPON_OBJ_TYPE:                                            // If original type was a boolean then promote everything to boolean except null;
+                {
+                    // cppcheck-suppress cstyleCast
+                    bool v = ((COBoolean *) n )->value();
+                    bool r;
+
+                    switch( obj->type() )
+                    {
+                        case BOOLEAN_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            if( v != ( r = ((COBoolean *) obj )->value() ) )
+                            {
+                                rtn->append( name, new COBoolean( r ) );
+                            }
+                            break;
+                        case INTEGER_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            if( v != ( r = ( ( (COInteger *) obj)->intValue() != 0 ) ) )
+                            {
+                                rtn->append( name, new COBoolean( r ) );
+                            }
+                            break;
+                        case DOUBLE_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            if( v != ( r = ( ( ( CODouble *) obj)->toInt() != 0 ) ) )
+                            {
+                                rtn->append( name, new COBoolean( r ) );
+                            }
+                            break;
+                        case STRING_CPPON_OBJ_TYPE:
+                            {
+                                // cppcheck-suppress cstyleCast
+                                const char *cPtr = ((COString *) obj)->c_str();
+                                if( v != ( r = ( 0 != ( !strcasecmp( cPtr, "true") ) ? 1 : ( (!strcasecmp( cPtr, "false" ) ) ? 0 : strtol( cPtr, NULL, 10 ) ) ) ) )
+                                {
+                                    rtn->append( name, new COBoolean( r ) );
+                                }
+                            }
+                            break;
+                        case NULL_CPPON_OBJ_TYPE:
+                            rtn->append( name, new CONull( ) );
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                break;
+            case DOUBLE_CPPON_OBJ_TYPE:
+                {
+                    // cppcheck-suppress cstyleCast
+                    double v = ((CODouble *) n )->doubleValue();
+                    double r;
+
+                    switch( obj->type() )
+                    {
+                        case DOUBLE_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            if( v != ((CODouble *) obj)->doubleValue() )
+                            {
+                                // cppcheck-suppress cstyleCast
+                                rtn->append( name, new CODouble( *((CODouble *) obj) ) );
+                            }
+                            break;
+                        case INTEGER_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            if( v != ( r = (double)( ( COInteger * ) obj )->longValue() ) )
+                            {
+                                rtn->append( name, new CODouble( r ) );
+                            }
+                            break;
+                        case STRING_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            if( v != ( r = strtod( ((COString *) obj)->c_str(), NULL ) ) )
+                            {
+                                rtn->append( name, new CODouble( r ) );
+                            }
+                            break;
+                        case BOOLEAN_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( name, new COBoolean( *((COBoolean *) obj) ) );
+                            break;
+                        case NULL_CPPON_OBJ_TYPE:
+                            rtn->append( name, new CONull( ) );
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                break;
+            case INTEGER_CPPON_OBJ_TYPE:
+                {
+                    // cppcheck-suppress cstyleCast
+                    uint64_t v = ((COInteger *) n)->toLongInt();
+                    uint64_t r;
+                    switch( obj->type() )
+                    {
+                        case INTEGER_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            if( v != (uint64_t)((COInteger *) obj)->toLongInt() )
+                            {
+                                // cppcheck-suppress cstyleCast
+                                rtn->append( name, new COInteger( *((COInteger *) obj) ) );
+                            }
+                            break;
+                        case STRING_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            if( v != ( r = strtol( ((COString *) obj)->c_str(), NULL, 0 ) ) )
+                            {
+                                rtn->append( name, new COInteger( r ) );
+                            }
+                            break;
+                        case DOUBLE_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( name, new CODouble( *((CODouble *) obj) ) );
+                            break;
+                        case BOOLEAN_CPPON_OBJ_TYPE:
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( name, new COBoolean( *((COBoolean *) obj) ) );
+                            break;
+                        case NULL_CPPON_OBJ_TYPE:
+                            rtn->append( name, new CONull( ) );
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                break;
+            default:
+                switch( obj->type() )
+                {
+                    case INTEGER_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( *((COInteger *) n ) != *((COInteger *) obj ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( name, new COInteger( *((COInteger *) obj) ) );
+                        }
+                        break;
+                    case DOUBLE_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( *((CODouble *) n ) != *((CODouble *) obj ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( name, new CODouble( *((CODouble *) obj) ) );
+                        }
+                        break;
+                    case BOOLEAN_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( *((COBoolean *) n ) != *((COBoolean *) obj ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( name, new COBoolean( *((COBoolean *) obj) ) );
+                        }
+                        break;
+                    case NULL_CPPON_OBJ_TYPE:
+                        if( n->type() != NULL_CPPON_OBJ_TYPE )
+                        {
+                            rtn->append( name, new CONull( ) );
+                        }
+                        break;
+                    case STRING_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( *((COString *) n ) != *((COString *) obj ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( name, new COString( *((COString *) obj) ) );
+                        }
+                        break;
+                    case MAP_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( name, new COMap( *((COMap *) obj) ) );
+                        break;
+                    case ARRAY_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( name, new COArray( *((COArray *) obj) ) );
+                        break;
+                    default:
+                        break;
+                }
+                break;
+        }
+    }
+}
+
+COMap  *COMap::diff( COMap &newObj, const char *name )
+{
+    COMap                            *rtn    = new COMap();
+    CppON                            *n;
+    map<string, CppON *>::iterator    it;
+    map<string, CppON *>            *m        = (map<string, CppON *> *) data;
+
+    // cppcheck-suppress postfixOperator
+    for( it = m->begin(); m->end() != it; it++ )
+    {
+        CppON                *obj;
+
+        if( ( obj = newObj.findElement( (string *)&(it->first) ) ) )
+        {
+            // cppcheck-suppress cstyleCast
+            if( ( n = (CppON *) it->second ) )
+            {
+                COMap                *nv;
+                COArray                *na;
+
+                switch ( n->type() )
+                {
+                    case INTEGER_CPPON_OBJ_TYPE:
+                        appendTag( it->first, obj, rtn, n );
+                        break;
+                    case DOUBLE_CPPON_OBJ_TYPE:
+                        appendTag( it->first, obj, rtn, n );
+                        break;
+                    case STRING_CPPON_OBJ_TYPE:
+                        appendTag( it->first, obj, rtn, n );
+                        break;
+                    case BOOLEAN_CPPON_OBJ_TYPE:
+                        appendTag( it->first, obj, rtn, n );
+                        break;
+                    case NULL_CPPON_OBJ_TYPE:
+                        appendTag( it->first, obj, rtn, n );
+                        break;
+                    case MAP_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( (nv = ((COMap *) n )->diff( *((COMap *) obj ), name ) ) )
+                        {
+                            rtn->append( it->first, nv );
+                        }
+                        break;
+                    case ARRAY_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( (na = ( (COArray *) n )->diff( *( ( COArray *) obj ), name ) ) )
+                        {
+                            rtn->append( it->first, na );
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+    m = (map<string, CppON *> *) newObj.getData();
+    // cppcheck-suppress postfixOperator
+    for( it = m->begin(); m->end() != it; it++ )
+    {
+        if(!( this->findElement( (string *)&(it->first) ) ) )
+        {
+            // cppcheck-suppress cstyleCast
+            if( ( n = (CppON *) it->second ) )
+            {
+                switch ( n->type() )
+                {
+                    case INTEGER_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( it->first, new COInteger( *((COInteger *) it->second ) ) );
+                        break;
+                    case DOUBLE_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( it->first, new CODouble( *((CODouble *) it->second ) ) );
+                        break;
+                    case STRING_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( it->first, new COString( *((COString *) it->second ) ) );
+                        break;
+                    case BOOLEAN_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( it->first, new COBoolean( *((COBoolean *) it->second ) ) );
+                        break;
+                    case NULL_CPPON_OBJ_TYPE:
+                        fprintf( stderr, "COMap:diff - NULL type found, appended a NULL to %s\n", it->first.c_str() );
+                        rtn->append( it->first, new CONull( ) );
+                        break;
+                    case MAP_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( it->first, new COMap( *(( COMap *) it->second ) ) );
+                        break;
+                    case ARRAY_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( it->first, new COArray( *(( COArray *) it->second ) ) );
+                        break;
+                    default:
+                        break;
+                }
+            } else {
+                fprintf( stderr, "appended a NULL to %s\n", it->first.c_str() );
+                rtn->append( it->first, new CONull( ) );
+            }
+        }
+    }
+    if( ! rtn->size() )
+    {
+        delete rtn;
+        rtn = NULL;
+    }
+    return rtn;
+}
+
+/*
+ * Add an element to the map
+ * But first check to see if the key is a path,
+ * If not then
+ *    just add it.
+ * else
+ *    check to see if it references an existing object in the map
+ *    if not then
+ *       append a map by that name
+ *
+ *    check to see if the object is a map
+ *    if so then
+ *       append the object to it with the remainder of the key
+ *    if not is it an array?
+ *       if so then we will append it without the key
+ *    otherwise
+ *       we can't do anything because we can't append an object to something that isn't a map or and array
+ *
+ *
+ */
+
+int COMap::append( std::string key, CppON *n )
+{
+    size_t pos = key.find( '/' );
+    int rtn = 0;
+
+    if( string::npos == pos )
+    {
+        std::map <std::string, CppON *> *m = ( std::map <std::string, CppON*> *) data;
+        std::map <std::string, CppON *>::iterator it = m->find( key );                                    // If there is already an object by this name delete it and and the new one.
+        if( m->end() != it )
+        {
+            release( it->second );
+            m->erase( it );
+            std::vector< std::string>::iterator its = std::find( order.begin(), order.end(), key );
+            if( order.end() != its )
+            {
+                order.erase( its );
+            }
+        }
+        m->insert( m->end(), std::pair < std::string, CppON* >( key, n ) );
+        order.push_back(std::string( key ) );
+    } else {
+        string s = key.substr( 0, pos );
+        key = key.substr( pos + 1 );
+        COMap *mp = (COMap *) findElement( s );
+        if(! mp )
+        {
+            append( s, mp = new COMap() );
+        }
+        if( CppON::isMap( mp ) )
+        {
+            rtn = mp->append( key, n );
+        } else if( CppON::isArray( mp ) ) {
+            ((COArray *)mp )->append( n );
+        } else {
+            rtn = -1;
+        }
+    }
+    return rtn;
+};
+
+// cppcheck-suppress unusedFunction
+std::vector<CppON *> *COMap::getValues()
+{
+    std::vector<CppON *> *rtn = new std::vector<CppON *>;
+
+    // cppcheck-suppress postfixOperator
+    for(std::map< std::string, CppON *>::iterator it = (( std::map<std::string, CppON *> *) data )->begin();(( std::map<std::string, CppON *> *) data )->end() != it; it++)
+    {
+        rtn->push_back( it->second );
+    }
+    return rtn;
+};
+
+// cppcheck-suppress unusedFunction
+CppON *COMap::extract( const char *name )
+{
+    CppON *rtn = NULL;
+    std::map< std::string, CppON *>::iterator it = (( std::map<std::string, CppON *> *) data )->find( name );
+
+    if( it != ((std::map< std::string, CppON *> *) data )->end() )
+    {
+        rtn = it->second;
+        for( std::vector<std::string>::iterator iter = order.begin(); order.end() != iter; ++iter )
+        {
+            if( ! iter->compare( it->first ) )
+            {
+                order.erase( iter );
+                break;
+            }
+        }
+        (( std::map<std::string, CppON *> *) data )->erase( it );
+    }
+    return rtn;
+}
+
+COMap *COMap::operator=( COMap &val )
+{
+    map< string, CppON*> *ptr;
+
+    if( data )
+    {
+        map <string, CppON*> *m = ( map <string, CppON *> * ) data;
+        map<string, CppON *>::iterator it;
+
+        // cppcheck-suppress postfixOperator
+        for( it = m->begin(); m->end() != it; it++ )
+        {
+            release( it->second );
+        }
+        m->clear();
+    } else {
+        data = new map<string, CppON*>();
+    }
+    order.clear();
+    siz = val.size();
+    map<string, CppON*> *th = (map<string, CppON*> *) data;
+
+    if( ( ptr = val.value() ) )
+    {
+        // cppcheck-suppress postfixOperator
+        for( std::map< string, CppON* >::iterator it = ptr->begin(); it != ptr->end(); it++ )
+        {
+            switch( it->second->type() )
+            {
+                case INTEGER_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    th->insert( th->end(), pair< string, CppON* >( it->first, new COInteger( *((COInteger *)it->second ) ) ) );
+                    order.push_back( string( it->first ) );
+                    break;
+                case DOUBLE_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    th->insert( th->end(), pair< string, CppON* >( it->first, new CODouble( *( (CODouble *)it->second ) ) ) );
+                    order.push_back( string( it->first ) );
+                    break;
+                case STRING_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    th->insert( th->end(), pair< string, CppON* >( it->first, new COString( *( (COString *)it->second ) ) ) );
+                    order.push_back( string( it->first ) );
+                    break;
+                case NULL_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    th->insert( th->end(), pair< string, CppON* >( it->first, new CONull( *( (CONull *)it->second ) ) ) );
+                    order.push_back( string( it->first ) );
+                    break;
+                case BOOLEAN_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    th->insert( th->end(), pair< string, CppON* >( it->first, new COBoolean( *( (COBoolean *)it->second ) ) ) );
+                    order.push_back( string( it->first ) );
+                    break;
+                case MAP_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    th->insert( th->end(), pair< string, CppON* >( it->first, new COMap( *( (COMap *)it->second ) ) ) );
+                    order.push_back( string( it->first ) );
+                    break;
+                case ARRAY_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    th->insert( th->end(), pair< string, CppON* >( it->first, new COArray( *( (COArray *)it->second ) ) ) );
+                    order.push_back( string( it->first ) );
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return this;
+}
+
+bool COMap::operator == ( COMap &val )
+{
+    map<string, CppON*> *th = (map<string, CppON*> *) data;
+
+    // cppcheck-suppress postfixOperator
+    for( std::map< string, CppON* >::iterator itr = th->begin(); itr != th->end(); itr++ )
+    {
+        CppON               *t;
+
+        if( !(t = val.findElement( itr->first.c_str() ) ) )
+        {
+            return false;
+        }
+        if( !isObj( t ) || !isObj( itr->second ) )
+        {
+            return false;
+        }
+        if( t->type() != (itr->second)->type() )
+        {
+            return false;
+        }
+        if( *t != *itr->second )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/****************************************************************************************/
+/*                                                                                        */
+/*                                        COArray                                            */
+/*                                                                                        */
+/****************************************************************************************/
+
+COArray::COArray( COArray *at ) : CppON( ARRAY_CPPON_OBJ_TYPE )
+{
+    head = 0;
+    siz = at->size();
+    data = new vector<CppON *>();
+    for( size_t i = 0; at->size() > i; i++ )
+    {
+        CppON *jt = at->at( i );
+        switch( jt->type() )
+        {
+            case INTEGER_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COInteger( *((COInteger *)jt ) ) );
+                break;
+            case DOUBLE_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new CODouble( *( (CODouble *)jt ) ) );
+                break;
+            case STRING_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( factory( jt ) );
+                break;
+            case NULL_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new CONull( *( (CONull *)jt ) ) );
+                break;
+            case BOOLEAN_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COBoolean( *( (COBoolean *)jt ) ) );
+                break;
+            case MAP_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COMap( *( (COMap *)jt ) ) );
+                break;
+            case ARRAY_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COArray( *( (COArray *)jt ) ) );
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+COArray::COArray( COArray & at ) : CppON( ARRAY_CPPON_OBJ_TYPE )
+{
+    head = 0;
+    siz = at.size();
+    data = new vector<CppON *>();
+    for( size_t i = 0; at.size() > i; i++ )
+    {
+        CppON *jt = at.at( i );
+        switch( jt->type() )
+        {
+            case INTEGER_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COInteger( *((COInteger *)jt ) ) );
+                break;
+            case DOUBLE_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new CODouble( *( (CODouble *)jt ) ) );
+                break;
+            case STRING_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( factory( jt ) );
+                break;
+            case NULL_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new CONull( *( (CONull *)jt ) ) );
+                break;
+            case BOOLEAN_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COBoolean( *( (COBoolean *)jt ) ) );
+                break;
+            case MAP_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COMap( *( (COMap *)jt ) ) );
+                break;
+            case ARRAY_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COArray( *( (COArray *)jt ) ) );
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void COArray::parseData( const char *str )
+{
+    if( str )
+    {
+        DumpWhiteSpace( str );
+        const char    *sav = str;
+        unsigned     i;
+        if( '[' == *str )
+        {
+            char        ch;
+            CppON        *obj = NULL;
+            ++str;
+            DumpWhiteSpace( ch, str );
+            while( ch )
+            {
+                sav = str;
+                while( 0 != (ch = *str ) && ( ' ' == ch || '\t' == ch || '\n' == ch || '\r' == ch ) ) { ++str; }
+                if( '0' <= ch && '9' >= ch )
+                {
+                    obj = GetTNetstring( &str );
+                } else if( ch ) {
+                    obj =  GetObj( &str );
+                }
+                if( obj )
+                {
+                    append( obj );
+                    obj = NULL;
+                    DumpWhiteSpace( ch, str );
+                    if( ch )
+                    {
+                        if( ',' == *str )
+                        {
+                            str++;
+                            DumpWhiteSpace( ch, str );
+                        } else if( ']' == ch ) {
+                            break;
+                        } else {
+                            fprintf( stderr, "%s[%d]: Unexpected character: '%c'\n", __FILE__,__LINE__, *str );
+                            break;
+                        }
+                    }
+                } else {
+                    std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
+                    fprintf( stderr, "%s[%d]: Failed to get object: '%s'\n", __FILE__,__LINE__, s.c_str() );
+                }
+            }
+        } else {
+            std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
+            fprintf( stderr, "%s[%d]: Parse ERROR: Expected '[' got '%s'\n", __FILE__, __LINE__, sav );
+        }
+    }
+}
+
+COArray::COArray( const char *path, const char *file ): CppON( ARRAY_CPPON_OBJ_TYPE )
+{
+    struct stat     _stat;
+    std::string p( path );
+    FILE    *fp;
+
+    head = 0;
+    data = new vector<CppON *>();
+    siz = 0;
+    if( '/' != p.back() )
+    {
+        p += '/';
+    }
+    p.append( file );
+
+    if( ! stat( p.c_str(), &_stat ) && ! ( _stat.st_mode & DIRECTORY_BIT ) && (fp = fopen( p.c_str(), "r" ) ) )
+    {
+        char    *buf = readWholeFile( fp, NULL );
+
+        fclose( fp );
+        if( buf )
+        {
+            parseData( buf );
+            free(buf );
+        }
+    } else {
+        fprintf( stderr, "%s[%.4u]: Failed to open JSON FILE \"%s\"",__FILE__, __LINE__, p.c_str() );
+    }
+}
+
+COArray::COArray( const char *str ): CppON( ARRAY_CPPON_OBJ_TYPE )
+{
+    head = 0;
+    data = new vector<CppON *>();
+    siz = 0;
+
+    parseData( str );
+}
+
+void COArray::clear( )
+{
+    vector <CppON *> *v = ( vector<CppON *> * ) data;
+
+    for(unsigned int i = 0; v->size() > i; i++ )
+    {
+        release( v->at( i ) );
+    }
+    v->clear();
+    head = 0;
+}
+
+CppON *COArray::remove( size_t idx )
+{
+    vector< CppON *>  *v = ( vector<CppON *> *) data;
+    CppON *rtn = NULL;
+
+    if( 0 == idx )
+    {
+        rtn = pop_front();
+    } else if( v->size() - head > idx ) {
+        rtn = v->at( head + idx );
+        v->erase( v->begin() + head + idx );
+    }
+    return rtn;
+}
+
+CppON *COArray::pop_front()
+{
+    vector< CppON *>  *v = ( vector<CppON *> *) data;
+    CppON *rtn = NULL;
+
+    if( v && v->size() > head )
+    {
+        rtn = (*v)[ head ];
+        (*v)[ head++ ] = NULL;
+        if( v->size() == head )
+        {
+            v->clear();
+            head = 0;
+        } else if( 64 <= head && v->size() <= 2 * head ) {
+            compact();
+        }
+    }
+    return rtn;
+}
+
+void COArray::push_front( CppON *n )
+{
+    vector< CppON *>  *v = ( vector<CppON *> *) data;
+
+    if( head )
+    {
+        (*v)[ --head ] = n;
+    } else {
+        v->insert( v->begin(), n );
+    }
+}
+
+/*
+ * Drop the slots in front of the head left behind by pop_front().
+ */
+void COArray::compact()
+{
+    if( head )
+    {
+        vector< CppON *>  *v = ( vector<CppON *> *) data;
+
+        v->erase( v->begin(), v->begin() + head );
+        head = 0;
+    }
+}
+
+string *COArray::toCompactJsonString( )
+{
+    std::string *rtn = new string();
+    CppONWriter w( this, CppONWriter::COMPACT, *rtn, "" );
+
+    w.run();
+    return rtn;
+}
+
+string *COArray::toJsonString( std::string &indent )
+{
+    std::string *rtn = new string();
+    CppONWriter w( this, CppONWriter::PRETTY, *rtn, indent );
+
+    w.run();
+    return rtn;
+}
+
+string *COArray::toNetString()
+{
+    if( data )
+    {
+        std::string *rtn = new string();
+        CppONWriter w( this, CppONWriter::NET, *rtn, "" );
+
+        w.run();
+        return rtn;
+    }
+
+    return NULL;
+}
+
+const char  *COArray::c_str( std::string &idnt )
+{
+    str = "[";
+    if( data )
+    {
+        vector <CppON *> *v = ( vector <CppON *> * )    data;
+        unsigned                                        i;
+        const char                                        *comma = "\n";
+        std::string                                        indent = idnt;
+
+        for( i = head; v->size() > i; i++ )
+        {
+            CppON *n = v->at( i );
+
+            str.append( comma );
+            comma = ",\n";
+            str.append( indent );
+            switch ( n->type() )
+            {
+                case INTEGER_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( (COInteger *) n )->c_str();
+                    break;
+                case DOUBLE_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( (CODouble *) n )->c_str();
+                    break;
+                case STRING_CPPON_OBJ_TYPE:
+                    str += '"';
+                    // cppcheck-suppress cstyleCast
+                    str += ( ( COString *) n )->c_str();
+                    str += '"';
+                    break;
+                case BOOLEAN_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( ( COBoolean *) n )->c_str();
+                    break;
+                case NULL_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( ( CONull *) n )->c_str();
+                    break;
+                case MAP_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( (COMap *) n )->c_str( indent );
+                    break;
+                case ARRAY_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    str += ( (COArray *) n )->c_str( indent );
+                    break;
+                default:
+                    break;
+            }
+        }
+        str += '\n';
+    }
+    str += ']';
+    return str.c_str();
+}
+
+void COArray::dump( string &indent, FILE *fp )
+{
+    if( data )
+    {
+        vector <CppON *> *v = ( vector <CppON *> * )    data;
+        unsigned                                        i;
+        string                                            newIndent    = indent;
+        bool                                            first        = true;
+
+        newIndent += "\t";
+        fprintf( fp, "%s[",indent.c_str() );
+        for( i = head; v->size() > i; i++ )
+        {
+            CppON *n = v->at( i );
+            if( first )
+            {
+                fprintf( fp,"\n%s", newIndent.c_str() );
+                first = false;
+            } else {
+                fprintf( fp, ",\n%s", newIndent.c_str() );
+            }
+            switch ( n->type() )
+            {
+                case INTEGER_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (COInteger *) n )->dump( fp );
+                    break;
+                case DOUBLE_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (CODouble *) n )->dump( fp );
+                    break;
+                case STRING_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (COString *) n )->dump( fp );
+                    break;
+                case BOOLEAN_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( ( COBoolean *) n )->dump( fp );
+                    break;
+                case MAP_CPPON_OBJ_TYPE:
+                    fprintf( fp, "\n");
+                    // cppcheck-suppress cstyleCast
+                    ( (COMap *) n )->dump( newIndent, fp );
+                    break;
+                case ARRAY_CPPON_OBJ_TYPE:
+                    fprintf( fp, "\n");
+                    // cppcheck-suppress cstyleCast
+                    ( (COArray *) n )->dump( newIndent, fp );
+                    break;
+                case NULL_CPPON_OBJ_TYPE:
+                    fprintf( stderr, "COArray: dump -> Dropping NULL\n" );
+                    break;
+                default:
+                    break;
+            }
+        }
+        fprintf( fp, "\n%s]",indent.c_str() );
+    } else {
+        fprintf( fp, "NULL" );
+    }
+}
+void COArray::cdump( FILE *fp )
+{
+    if( data )
+    {
+        vector <CppON *> *v = ( vector <CppON *> * )    data;
+        unsigned                                        i;
+        bool                                            first = true;
+
+        fprintf( fp, "[");
+        for( i = head; v->size() > i; i++ )
+        {
+            CppON *n = v->at( i );
+            if( first )
+            {
+                first = false;
+            } else {
+                fprintf( fp, "," );
+            }
+            switch ( n->type() )
+            {
+                case INTEGER_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (COInteger *) n )->cdump( fp );
+                    break;
+                case DOUBLE_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (CODouble *) n )->cdump( fp );
+                    break;
+                case STRING_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( (COString *) n )->cdump( fp );
+                    break;
+                case BOOLEAN_CPPON_OBJ_TYPE:
+                    // cppcheck-suppress cstyleCast
+                    ( ( COBoolean *) n )->cdump( fp );
+                    break;
+                case MAP_CPPON_OBJ_TYPE:
+                    fprintf( fp, "\"\n\"");
+                    // cppcheck-suppress cstyleCast
+                    ( (COMap *) n )->cdump( fp );
+                    break;
+                case ARRAY_CPPON_OBJ_TYPE:
+                    fprintf( fp, "\"\n\"");
+                    // cppcheck-suppress cstyleCast
+                    ( (COArray *) n )->cdump( fp );
+                    break;
+                case NULL_CPPON_OBJ_TYPE:
+                    fprintf( stderr, "COArray: cdump -> Dropping NULL\n" );
+                    break;
+                default:
+                    break;
+            }
+        }
+        fprintf( fp, "]" );
+    } else {
+        fprintf( fp, "[]" );
+    }
+}
+
+COArray  *COArray::diff( COArray &newObj, const char *name )
+{
+    COArray                            *rtn    = new COArray();
+    COMap                            *nv;
+    COString                        *vS;
+    COArray                            *na;
+    vector< CppON *>::iterator        it;
+    vector< CppON *>::iterator        nt;
+    vector< CppON *>                *v        = ( vector <CppON *> * ) data;
+    vector< CppON *>                *u        = ( vector <CppON *> * ) newObj.data;
+
+    it = v->begin() + head;
+    // cppcheck-suppress postfixOperator
+    for( nt = u->begin() + newObj.head; u->end() != nt; nt++ )
+    {
+        CppON                        *n;
+        CppON                        *obj    = NULL;
+        COString                    *uS;
+
+        // cppcheck-suppress cstyleCast
+        if( CppON::isMap( obj = (CppON *) *nt ) && name && CppON::isString( uS = (COString *)( ( COMap * ) obj)->findElement( name ) ) )   // If array of maps look for name
+        {
+            // cppcheck-suppress postfixOperator
+            for( it = v->begin() + head; v->end() != it; it++ )
+            {
+                // cppcheck-suppress cstyleCast
+                if( CppON::isMap( n = (CppON *) *it ) && CppON::isString( vS = (COString *) ( ( COMap * ) n )->findElement( name ) ) && !strcmp( uS->c_str(), vS->c_str( ) ) )
+                {
+                    // cppcheck-suppress cstyleCast
+                    if( (nv = ((COMap *) n )->diff( *((COMap *) obj ), name ) ) )
+                    {
+                        delete( nv );      // send whole map
+                        // cppcheck-suppress cstyleCast
+                        rtn->append( new COMap( *( ( COMap * ) obj ) ) );
+                        break;
+                    }
+                }
+            }
+        } else if( it != v->end() ) {
+            obj    = ( CppON * ) *nt;
+            n = ( CppON * ) *it;
+            if( obj->type() == n->type() )
+            {
+                switch ( obj->type() )
+                {
+                    case INTEGER_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( *((COInteger *) n ) != *((COInteger *) obj ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( new COInteger( *((COInteger *) obj) ) );
+                        }
+                        break;
+                    case DOUBLE_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( *((CODouble *) n ) != *((CODouble *) obj ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( new CODouble( *((CODouble *) obj) ) );
+                        }
+                        break;
+                    case STRING_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( *((COString *) n ) != *((COString *) obj ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( new COString( *((COString *) obj) ) );
+                        }
+                        break;
+                    case BOOLEAN_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( *((COBoolean *) n ) != *((COBoolean *) obj ) )
+                        {
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( new COBoolean( *((COBoolean *) obj) ) );
+                        }
+                        break;
+                    case NULL_CPPON_OBJ_TYPE:
+                        fprintf( stderr, "COArray: diff - Dropping NULL\n" );
+                        break;
+                    case MAP_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( (nv = ((COMap *) n )->diff( *((COMap *) obj ) ) ) )
+                        {
+                            delete (nv);                                                  // send whole map
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( new COMap(  *((COMap *) obj ) ) );
+                        }
+                        break;
+                    case ARRAY_CPPON_OBJ_TYPE:
+                        // cppcheck-suppress cstyleCast
+                        if( (na = ( (COArray *) n )->diff( *( ( COArray *) obj ) ) ) )
+                        {
+                            delete (na);                                                  // send whole map
+                            // cppcheck-suppress cstyleCast
+                            rtn->append( new COArray(  *((COArray *) obj ) ) );
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+            // cppcheck-suppress postfixOperator
+            it++;
+        }
+    }
+    if(!rtn->size() )
+    {
+        delete rtn;
+        rtn = NULL;
+    }
+    return rtn;
+}
+
+/*
+ * The state of one diffEdits(): the two element ranges, their hashes and the runs found so far, each
+ * { old index, elements deleted, new index, elements inserted }.
+ */
+struct COArrayEditor
+{
+    CppON                                   **a;
+    CppON                                   **b;
+    std::vector<uint64_t>                   ha;
+    std::vector<uint64_t>                   hb;
+    std::vector<long>                       vf;
+    std::vector<long>                       vb;
+    std::vector< std::array<size_t, 4> >    runs;
+
+    bool    same( size_t i, size_t j ) { return ha[ i ] == hb[ j ] && a[ i ]->identical( b[ j ] ); }
+    void    run( size_t x, size_t del, size_t y, size_t ins );
+    void    split( size_t a0, size_t a1, size_t b0, size_t b1 );
+};
+
+void COArrayEditor::run( size_t x, size_t del, size_t y, size_t ins )
+{
+    if( runs.size() && runs.back()[ 0 ] + runs.back()[ 1 ] == x && runs.back()[ 2 ] + runs.back()[ 3 ] == y )
+    {
+        runs.back()[ 1 ] += del;                                                                    // Adjacent to the last one, extend it
+        runs.back()[ 3 ] += ins;
+    } else {
+        runs.push_back( { x, del, y, ins } );
+    }
+}
+
+/*
+ * Myers' linear space O(ND) diff of a[ a0, a1 ) against b[ b0, b1 ): find the middle snake of the shortest edit
+ * script by running it from both ends at once, then do each side of it the same way.  The runs come out in order.
+ */
+void COArrayEditor::split( size_t a0, size_t a1, size_t b0, size_t b1 )
+{
+    while( a0 < a1 && b0 < b1 && same( a0, b0 ) )
+    {
+        a0++;
+        b0++;
+    }
+    while( a0 < a1 && b0 < b1 && same( a1 - 1, b1 - 1 ) )
+    {
+        a1--;
+        b1--;
+    }
+    if( a0 == a1 || b0 == b1 )
+    {
+        if( a0 != a1 || b0 != b1 )
+        {
+            run( a0, a1 - a0, b0, b1 - b0 );
+        }
+        return;
+    }
+
+    long    n       = (long)( a1 - a0 );
+    long    m       = (long)( b1 - b0 );
+    long    delta   = n - m;
+    long    maxD    = ( n + m + 1 ) / 2;
+    long    off     = maxD;
+    bool    odd     = ( delta & 1 );
+    long    k1lo    = 0;
+    long    k1hi    = 0;
+    long    k2lo    = 0;
+    long    k2hi    = 0;
+
+    vf.assign( 2 * maxD + 2, -1 );
+    vb.assign( 2 * maxD + 2, -1 );
+    vf[ off + 1 ] = 0;
+    vb[ off + 1 ] = 0;
+    for( long d = 0; maxD > d; d++ )
+    {
+        for( long k = -d + k1lo; d - k1hi >= k; k += 2 )                                            // Forward from the start
+        {
+            long x = ( -d == k || ( d != k && vf[ off + k - 1 ] < vf[ off + k + 1 ] ) ) ? vf[ off + k + 1 ] : vf[ off + k - 1 ] + 1;
+            long y = x - k;
+
+            while( n > x && m > y && same( a0 + x, b0 + y ) )
+            {
+                x++;
+                y++;
+            }
+            vf[ off + k ] = x;
+            if( n < x )
+            {
+                k1hi += 2;
+            } else if( m < y ) {
+                k1lo += 2;
+            } else if( odd && 0 <= off + delta - k && (long) vb.size() > off + delta - k && -1 != vb[ off + delta - k ] ) {
+                if( x >= n - vb[ off + delta - k ] && ( x || y ) && ( n != x || m != y ) )
+                {
+                    split( a0, a0 + x, b0, b0 + y );
+                    split( a0 + x, a1, b0 + y, b1 );
+                    return;
+                }
+            }
+        }
+        for( long k = -d + k2lo; d - k2hi >= k; k += 2 )                                            // Backward from the end
+        {
+            long x = ( -d == k || ( d != k && vb[ off + k - 1 ] < vb[ off + k + 1 ] ) ) ? vb[ off + k + 1 ] : vb[ off + k - 1 ] + 1;
+            long y = x - k;
+
+            while( n > x && m > y && same( a1 - x - 1, b1 - y - 1 ) )
+            {
+                x++;
+                y++;
+            }
+            vb[ off + k ] = x;
+            if( n < x )
+            {
+                k2hi += 2;
+            } else if( m < y ) {
+                k2lo += 2;
+            } else if( ! odd && 0 <= off + delta - k && (long) vf.size() > off + delta - k && -1 != vf[ off + delta - k ] ) {
+                long fx = vf[ off + delta - k ];
+                long fy = fx - ( delta - k );
+
+                if( fx >= n - x && ( fx || fy ) && ( n != fx || m != fy ) )
+                {
+                    split( a0, a0 + fx, b0, b0 + fy );
+                    split( a0 + fx, a1, b0 + fy, b1 );
+                    return;
+                }
+            }
+        }
+    }
+    run( a0, a1 - a0, b0, b1 - b0 );                                                                // Nothing in common
+}
+
+/*
+ * Compare this Array with newObj and return the shortest edit script that turns it into newObj, or NULL if they are
+ * identical().  Elements are compared by their structural hash first so only likely matches are compared in full,
+ * and the common head and tail are skipped before anything is hashed, so the work grows with the number of edits
+ * rather than the length of the Arrays.  The script is an Array of runs in ascending order, each
+ * [ index, count, [ elements ] ]: remove count elements at index (counted in this Array) and put the elements there.
+ * A run that only removes leaves the elements out.  Unlike diff() nothing is matched by name: a changed element is
+ * replaced.
+ */
+COArray *COArray::diffEdits( COArray &newObj )
+{
+    COArrayEditor   ed;
+    size_t          n       = size();
+    size_t          m       = newObj.size();
+    size_t          lo      = 0;
+    COArray         *rtn;
+
+    ed.a = ( n ) ? &( *(vector<CppON *> *) data )[ head ] : NULL;
+    ed.b = ( m ) ? &( *(vector<CppON *> *) newObj.data )[ newObj.head ] : NULL;
+    while( lo < n && lo < m && ed.a[ lo ]->identical( ed.b[ lo ] ) )
+    {
+        lo++;
+    }
+    while( lo < n && lo < m && ed.a[ n - 1 ]->identical( ed.b[ m - 1 ] ) )
+    {
+        n--;
+        m--;
+    }
+    if( lo == n && lo == m )
+    {
+        return NULL;
+    }
+    ed.ha.resize( n );
+    ed.hb.resize( m );
+    for( size_t i = lo; n > i; i++ )
+    {
+        ed.ha[ i ] = ed.a[ i ]->hash();
+    }
+    for( size_t i = lo; m > i; i++ )
+    {
+        ed.hb[ i ] = ed.b[ i ]->hash();
+    }
+    ed.split( lo, n, lo, m );
+
+    rtn = new COArray();
+    for( size_t r = 0; ed.runs.size() > r; r++ )
+    {
+        COArray     *op = new COArray();
+
+        op->append( new COInteger( (uint64_t) ed.runs[ r ][ 0 ] ) );
+        op->append( new COInteger( (uint64_t) ed.runs[ r ][ 1 ] ) );
+        if( ed.runs[ r ][ 3 ] )
+        {
+            COArray *ins = new COArray();
+
+            for( size_t i = 0; ed.runs[ r ][ 3 ] > i; i++ )
+            {
+                ins->append( factory( ed.b[ ed.runs[ r ][ 2 ] + i ] ) );
+            }
+            op->append( ins );
+        }
+        rtn->append( op );
+    }
+    return rtn;
+}
+
+/*
+ * Apply an edit script from diffEdits() in one pass over the Array.  Removed elements are released and the
+ * inserted ones copied, so the script can be applied more than once.  A script that is not well formed, or does not
+ * fit this Array, is rejected with -1 before anything is changed.
+ */
+int COArray::applyEdits( COArray &edits )
+{
+    vector<CppON *>     *v      = (vector<CppON *> *) data;
+    size_t              n       = size();
+    size_t              at      = 0;
+    vector<CppON *>     out;
+
+    for( size_t r = 0; edits.size() > r; r++ )
+    {
+        // cppcheck-suppress cstyleCast
+        COArray *op = (COArray *) edits.at( r );
+        CppON   *idx;
+        CppON   *cnt;
+        CppON   *ins;
+
+        if( ! isArray( op ) || 2 > op->size() || 3 < op->size() || ! isInteger( idx = op->at( 0 ) ) || ! isInteger( cnt = op->at( 1 ) ) ||
+            ( ( ins = op->at( 2 ) ) && ! isArray( ins ) ) || 0 > idx->toLongInt() || 0 > cnt->toLongInt() ||
+            at > (size_t) idx->toLongInt() || n < (size_t) idx->toLongInt() + (size_t) cnt->toLongInt() )
+        {
+            fprintf( stderr, "%s[%d]: Bad edit %lu\n", __FILE__, __LINE__, (unsigned long) r );
+            return -1;
+        }
+        at = (size_t) ( idx->toLongInt() + cnt->toLongInt() );
+    }
+    out.reserve( n );
+    at = 0;
+    for( size_t r = 0; edits.size() > r; r++ )
+    {
+        // cppcheck-suppress cstyleCast
+        COArray *op     = (COArray *) edits.at( r );
+        size_t  idx     = (size_t) op->at( 0 )->toLongInt();
+        size_t  end     = idx + (size_t) op->at( 1 )->toLongInt();
+        // cppcheck-suppress cstyleCast
+        COArray *ins    = (COArray *) op->at( 2 );
+
+        for( ; idx > at; at++ )
+        {
+            out.push_back( ( *v )[ head + at ] );
+        }
+        for( ; end > at; at++ )
+        {
+            release( ( *v )[ head + at ] );
+        }
+        for( size_t i = 0; ins && ins->size() > i; i++ )
+        {
+            out.push_back( factory( ins->at( i ) ) );
+        }
+    }
+    for( ; n > at; at++ )
+    {
+        out.push_back( ( *v )[ head + at ] );
+    }
+    v->swap( out );
+    head = 0;
+    return 0;
+}
+
+COArray *COArray::operator=( COArray &val )
+{
+    if( data )
+    {
+        vector <CppON *> *v = ( vector<CppON *> * ) data;
+
+        for(unsigned int i = 0; v->size() > i; i++ )
+        {
+            release( v->at( i ) );
+        }
+        v->clear();
+    } else {
+        data = new vector<CppON *>();
+    }
+    head = 0;
+    siz = val.size();
+
+    for( size_t i = 0; val.size() > i; i++ )
+    {
+        CppON *jt = val.at( i );
+
+        switch( jt->type() )
+        {
+            case INTEGER_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COInteger( *((COInteger *)jt ) ) );
+                break;
+            case DOUBLE_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new CODouble( *( (CODouble *)jt ) ) );
+                break;
+            case STRING_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( factory( jt ) );
+                break;
+            case NULL_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new CONull( *( (CONull *)jt ) ) );
+                break;
+            case BOOLEAN_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COBoolean( *( (COBoolean *)jt ) ) );
+                break;
+            case MAP_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COMap( *( (COMap *)jt ) ) );
+                break;
+            case ARRAY_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                append( new COArray( *( (COArray *)jt ) ) );
+                break;
+            default:
+                break;
+        }
+    }
+    return this;
+}
+
+bool COArray::operator == ( COArray &val )
+{
+    // cppcheck-suppress cstyleCast
+    if( val.size() != ((COArray*)this)->size() )
+    {
+        return false;
+    }
+    for( size_t i = 0; val.size() > i; i++ )
+    {
+        // cppcheck-suppress cstyleCast
+        if( ! ( *val.at( i ) == *((COArray*)this)->at( i ) ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                 COString                                             */
+/*                                                                                      */
+/****************************************************************************************/
+
+COString::COString( COString *st ) : CppON( STRING_CPPON_OBJ_TYPE )
+{
+    if( st->lazy )
+    {
+        // cppcheck-suppress cstyleCast
+        data = new std::string( ( (COFileString *) st )->bytes(), st->siz );                // Copied out of the file, st stays there
+    } else {
+        data = ( st->data ) ? new std::string( ( ( std::string *) st->data )->c_str() ): NULL;
+    }
+}
+
+COString::COString( COString &st ) : COString( &st )
+{
+}
+
+COString::COString( std::string st ) : CppON( STRING_CPPON_OBJ_TYPE )
+{
+    std::string rst;
+
+    for( unsigned int i = 0; st.length() > i; i++ )
+    {
+        char ch = st[ i ];
+        switch( ch )
+        {
+            case '"':
+                rst.append( "%22" );
+                break;
+            case '%':
+                rst.append( "%25" );
+                break;
+            case '\0':
+                rst.append( "%00" );
+                break;
+            default:
+                rst.push_back( ch );
+                break;
+        }
+    }
+    data = new std::string( rst.c_str() );
+}
+
+COString::COString( std::string st, bool base64 ) : CppON( STRING_CPPON_OBJ_TYPE )
+{
+    if( ! base64 )
+    {
+        std::string rst;
+
+        for( unsigned int i = 0; st.length() > i; i++ )
+        {
+            char ch = st[ i ];
+            switch( ch )
+            {
+                case '"':
+                    rst.append( "%22" );
+                    break;
+                case '%':
+                    rst.append( "%25" );
+                    break;
+                case '\0':
+                    rst.append( "%00" );
+                    break;
+                default:
+                    rst.push_back( ch );
+                    break;
+            }
+        }
+        data = new std::string( rst.c_str() );
+    } else {
+        size_t          len;
+        std::string     *s = new std::string( st.length() + 3, '\0' );
+
+        if( base64Decode( st.c_str(), st.length(), len, &( *s )[ 0 ] ) )
+        {
+            s->resize( len );
+            data = s;
+        } else {
+            delete s;
+            data = NULL;
+        }
+    }
+};
+
+COString::COString( const char *st, bool base64) : CppON( STRING_CPPON_OBJ_TYPE )
+{
+    if( ! base64 )
+    {
+        data = new std::string( st );
+    } else {
+        size_t          len;
+        size_t          sz = strlen( st );
+        std::string     *s = new std::string( sz + 3, '\0' );
+
+        if( base64Decode( st, sz, len, &( *s )[ 0 ] ) )
+        {
+            s->resize( len );
+            data = s;
+        } else {
+            delete s;
+            data = NULL;
+        }
+    }
+}
+
+COString::COString( uint64_t val, bool hex ) : CppON( STRING_CPPON_OBJ_TYPE )
+{
+    char buf[ 32 ];
+
+#if SIXTY_FOUR_BIT
+    if( hex )
+    {
+        snprintf( buf, 31, "0x%.16lX", val );
+    } else {
+        snprintf( buf, 31, "%lu", val );
+    }
+#else
+    if( hex )
+    {
+        snprintf( buf, 31, "0x%.16llX", val );
+    } else {
+        snprintf( buf, 31, "%llu", val );
+    }
+#endif
+    data = new std::string( buf );
+}
+COString::COString( uint32_t val, bool hex ) : CppON( STRING_CPPON_OBJ_TYPE )
+{
+    char buf[ 24 ];
+
+    if( hex )
+    {
+        snprintf( buf, 23, "0x%.8X", val );
+    } else {
+        snprintf( buf, 23, "%u", val );
+    }
+    data = new std::string( buf );
+}
+COString *COString::operator = ( uint64_t val )
+{
+    char buf[ 32 ];
+
+    materialize();
+#if SIXTY_FOUR_BIT
+    if( data && '0' == ((std::string *) data)->at( 0 )  )
+    {
+        snprintf( buf, 31, "0x%.16lX", val );
+    } else {
+        snprintf( buf, 31, "%lu", val );
+    }
+#else
+    if( data && '0' == ((std::string *) data)->at( 0 )  )
+    {
+        snprintf( buf, 31, "0x%.16llX", val );
+    } else {
+        snprintf( buf, 31, "%llu", val );
+    }
+#endif
+    if( data )
+    {
+        *( ( std::string *) data) = buf;
+    } else {
+        data = new std::string( buf );
+    }
+    return this;
+}
+COString *COString::operator = ( uint32_t val )
+{
+    char buf[ 24 ];
+
+    materialize();
+    if( data && '0' == ((std::string *) data)->at( 0 ) )
+    {
+        snprintf( buf, 23, "0x%.16X", val );
+    } else {
+        snprintf( buf, 23, "%u", val );
+    }
+    if( data )
+    {
+        *( ( std::string *) data) = buf;
+    } else {
+        data = new std::string( buf );
+    }
+    return this;
+}
+COString *COString::operator = ( int val )
+{
+    char buf[ 24 ];
+
+    snprintf( buf, 23, "%d", val );
+
+    if( data )
+    {
+        *( ( std::string *) data) = buf;
+    } else {
+        data = new std::string( buf );
+    }
+    return this;
+}
+// cppcheck-suppress unusedFunction
+std::string *COString::toString()
+{
+    char            *cPtr = (char *) data;
+    char            ch;
+    std::string        *rtn = new string();
+
+    while( 0 != (ch = *cPtr++ ) )
+    {
+        if( '%' == ch )
+        {
+            ch = ( ( *cPtr++ - '0' ) << 4 );
+            ch += (*cPtr++ - '0' );
+        }
+        rtn->push_back( ch );
+    }
+    rtn->push_back( '\0' );
+    return rtn;
+};
+
+string *COString::toNetString()
+{
+    if( ! data && ! lazy )
+    {
+        return NULL;
+    }
+    string *rtn = new string();
+
+    appendNetString( *rtn );
+    return rtn;
+}
+
+void COString::appendNetString( std::string &out )
+{
+    std::string *s = (std::string *) data;
+
+    if( lazy )
+    {
+        // cppcheck-suppress cstyleCast
+        CppON::appendNetString( out, ( (COFileString *) this )->bytes(), siz, ',' );
+        return;
+    }
+    CppON::appendNetString( out, ( s ) ? s->data() : "", ( s ) ? s->length() : 0, ',' );
+}
+
+static unsigned char dtab[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x0A, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3E, 0x80, 0x80, 0x80, 0x3F,
+                                0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x80, 0x80, 0x80, 0x00, 0x80, 0x80,
+                                0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                                0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+                                0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+
+static unsigned char etable[] ={0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,0x50,
+                                0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x61,0x62,0x63,0x64,0x65,0x66,
+                                0x67,0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,0x70,0x71,0x72,0x73,0x74,0x75,0x76,
+                                0x77,0x78,0x79,0x7A,0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x2B,0x2F};
+
+/*
+ * Decode Base64 encoded strings
+ * Some files insert newlines in the strings to brake them up.  Allow those
+ */
+char *COString::base64Decode( const char *tmp, size_t sz, size_t &len, char    *out )
+{
+    int             i;
+    int             ch;
+    unsigned char    a[ 4 ],b[ 4 ];
+
+    len = 0;
+    if( ! tmp || 1 > sz )
+    {
+        return NULL;
+    }
+    if( ! out )
+    {
+        out = new char[ sz + 3 ];
+    }
+    while( *tmp != 0 )
+    {
+        if( 0x0A == *tmp )
+        {
+            tmp++;
+        } else {
+            for( i = 0; 4 > i ;  )
+            {
+                ch = *tmp++;
+                if( ch == 0 || 0x80 == dtab[ ch ] )          // Got an illegal character so die.
+                {
+                    fprintf( stderr, "Character = 0x%.2X => dtab: 0x%.2X\n", ch, dtab[ ch ] );
+                    return NULL;
+                } else if( 0x0A != ch ) {
+                    a[ i ] = (unsigned char) ch;
+                    b[ i++ ] = (unsigned char) dtab[ ch ];
+                }
+            }
+            out[ len++ ] = ( b[ 0 ] << 2 ) | ( b[ 1 ] >> 4 );
+            if(a[ 2 ] != '=')
+            {
+                out[ len++ ] = ( b[ 1 ] << 4 ) | ( b[ 2 ] >> 2 );
+                if(a[ 3 ] != '=')
+                {
+                    out[ len++ ] = ( b[ 2 ] << 6 ) | b[ 3 ];
+                }
+            }
+        }
+    }
+    out[ len ] = 0;
+    return out;
+}
+
+std::string *COString::toBase64JsonString( const char *cPtr, size_t len )
+{
+    std::string     *rtn = new std::string();
+    unsigned char   ig[ 3 ];
+
+    rtn->reserve( ( ( len + 2 ) / 3 ) * 4 );
+    for( size_t i = 0; len > i; i += 3 )
+    {
+        size_t n = ( 3 < len - i ) ? 3 : len - i;
+
+        ig[ 0 ] = (unsigned char) cPtr[ i ];
+        ig[ 1 ] = ( 1 < n ) ? (unsigned char) cPtr[ i + 1 ] : 0;
+        ig[ 2 ] = ( 2 < n ) ? (unsigned char) cPtr[ i + 2 ] : 0;
+        rtn->push_back( etable[ ig[ 0 ] >> 2 ] );
+        rtn->push_back( etable[ ( ( ig[ 0 ] & 3) << 4 ) | ig[ 1 ] >> 4 ] );
+        rtn->push_back( ( 1 < n ) ? etable[ ( ( ig[ 1 ] &0x0f ) << 2 ) | ( ig[ 2 ] >> 6 ) ] : '=' );   // Pad with '=' when the input ran out
+        rtn->push_back( ( 2 < n ) ? etable[ ig[ 2 ] & 0x3f ] : '=' );
+    }
+    return rtn;
+}
+
+string *COString::toJsonString()
+{
+    if( ! data )
+    {
+        return NULL;
+    }
+    string *rtn = new string();
+
+    appendJson( *rtn );
+    return rtn;
+}
+
+static void appendJsonChars( std::string &out, const char *cPtr, size_t len )
+{
+    for( size_t i = 0; len > i; i++ )
+    {
+        const char  *e  = jsonEscape( cPtr[ i ] );
+
+        if( e )
+        {
+            out.append( e );
+        } else {
+            out.push_back( cPtr[ i ] );
+        }
+    }
+}
+
+void COString::appendJson( std::string &out )
+{
+    out.push_back( '"' );
+    if( lazy )
+    {
+        // cppcheck-suppress cstyleCast
+        appendJsonChars( out, ( (COFileString *) this )->bytes(), siz );                    // Straight from the file
+    } else if( data ) {
+        appendJsonChars( out, ( ( std::string *) data)->data(), ( ( std::string *) data)->length() );
+    }
+    out.push_back( '"');
+}
+
+void COString::dump( FILE *fp)
+{
+    materialize();
+    fprintf( fp, "\"%s\"", ( data ) ? ((std::string *) data)->c_str() : "\"\"" );
+}
+void COString::cdump( FILE *fp )
+{
+    materialize();
+    fprintf( fp, "\\\"%s\\\"", ( data ) ? ((std::string *) data)->c_str() : "\"\"" );
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                      COFileString                                    */
+/*                                                                                      */
+/****************************************************************************************/
+
+COFileString::COFileString( const std::shared_ptr<COFileRegion> &r, size_t off, size_t len ) : COString( STRING_CPPON_OBJ_TYPE ), region( r ), offset( off )
+{
+    siz = len;
+    lazy = true;
+}
+
+COFileString::COFileString( COFileString &fs ) : COString( STRING_CPPON_OBJ_TYPE ), region( fs.region ), offset( fs.offset )
+{
+    if( fs.lazy )
+    {
+        siz = fs.siz;
+        lazy = true;
+    } else {
+        data = ( fs.data ) ? new std::string( *(std::string *) fs.data ) : NULL;
+        region.reset();
+    }
+}
+
+const char *COFileString::bytes()
+{
+    return ( lazy ) ? region->map + offset : NULL;
+}
+
+int COFileString::fileDescriptor()
+{
+    return ( lazy ) ? region->fd : -1;
+}
+
+/*
+ * Read the value into memory.  From here on it is an ordinary COString; the mapping is let go of and is unmapped
+ * when no other string refers to it.
+ */
+void COFileString::load()
+{
+    if( lazy )
+    {
+        data = new std::string( region->map + offset, siz );
+        siz = 0;
+        lazy = false;
+        region.reset();
+    }
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                        CODouble                                      */
+/*                                                                                      */
+/****************************************************************************************/
+
+CODouble::CODouble( CODouble *dt ) : CppON( DOUBLE_CPPON_OBJ_TYPE )
+{
+    if( ! data )
+    {
+        data = new ( double );
+    }
+    *((double *) data) = dt->doubleValue();
+    precision = dt->Precision();
+    if( dt->raw )
+    {
+        str = dt->str;
+        raw = true;
+    }
+}
+
+CODouble::CODouble( CODouble &dt ) : CppON( DOUBLE_CPPON_OBJ_TYPE )
+{
+    if( ! data )
+    {
+        data = new ( double );
+    }
+    *((double *) data) = dt.doubleValue();
+    precision = dt.Precision();
+    if( dt.raw )
+    {
+        str = dt.str;
+        raw = true;
+    }
+}
+
+string *CODouble::toNetString()
+{
+    string *rtn = new string();
+
+    appendNetString( *rtn );
+    return rtn;
+};
+
+void CODouble::appendNetString( std::string &out )
+{
+    char buf[ 48 ];
+    buf[ 47 ] = buf[ 0 ] = '\0';
+    if( raw )
+    {
+        CppON::appendNetString( out, str.data(), str.length(), '^' );
+        return;
+    } else if( data ) {
+    snprintf( buf, 47, "%.10lf", *(( double *) data ));
+    }
+    CppON::appendNetString( out, buf, strlen( buf ), '^' );
+}
+
+string *CODouble::toJsonString()
+{
+    string *rtn = new string();
+
+    appendJson( *rtn );
+    return rtn;
+}
+
+void CODouble::appendJson( std::string &out )
+{
+    char buf[ 128 ];
+    buf[127] = buf[ 0 ] = '\0';
+    if( raw )
+    {
+        out.append( str );
+        return;
+    } else if( data )
+    {
+        if( 0 > precision || 16 < precision )
+        {
+            snprintf( buf, 127, "%.10lf", *(double *)data );
+        } else {
+            char prebuf[ 8 ];
+            prebuf[ 7 ] = buf[ 23 ] = '\0';
+            snprintf( prebuf, 7, "%c.%dlf", '%', (int)precision );
+            snprintf( buf, 23, prebuf, *(double *) data );
+        }
+    }
+    out.append( buf );
+}
+
+const char *CODouble::c_str()
+{
+    char buf[ 32 ];
+    buf[ 31 ] = '\0';
+    if( raw )
+    {
+        return str.c_str();
+    } else if( data )
+    {
+        if( 0 > precision || 16 < precision )
+        {
+            snprintf( buf, 31, "%.10lf", *(double *) data );
+        } else{
+            char prebuf[ 8 ];
+            prebuf[ 7 ] = buf[ 23 ] = '\0';
+            snprintf( prebuf, 7, "%c.%dlf", '%', (int)precision );
+            snprintf( buf, 23, prebuf, *(double *) data );
+        }
+    } else {
+        strcpy( buf, "NULL" );
+    }
+    str = buf;
+    return str.c_str();
+}
+
+void CODouble::dump( FILE *fp)
+{
+    if( raw )
+    {
+        fprintf( fp, "%s", str.c_str() );
+    } else if( data )
+    {
+        fprintf( fp, "%.10lf", *(double *) data );
+    } else {
+        fprintf( fp, "NULL" );
+    }
+}
+
+void CODouble::cdump( FILE *fp )
+{
+    if( raw )
+    {
+        fprintf( fp, "%s", str.c_str() );
+    } else if( data )
+    {
+        fprintf( fp, "%.16lf", *(double *) data );
+    } else {
+        fprintf( fp, "0.0" );
+    }
+}
+
+double CODouble::operator = (const double& val)
+{
+    materialize();
+    lazy = raw = false;
+    if( !data )
+    {
+        data = new double;
+        *((double*) (*this).data) = val;
+    } else {
+        if( 0 > precision  || 16 < precision )
+        {
+            *((double*) (*this).data) = val;
+        } else {
+            double pow_10 = pow( 10.0, precision);
+            double n = pow_10 * *((double*) (*this).data);
+            double d = pow_10 * val;
+            double t = n - d;
+            if( 0.75 < t || -0.75 > t )
+            {
+                *((double*) (*this).data) = round( d )/ pow_10;
+            }
+        }
+    }
+    return *((double*) (*this).data);
+}
+
+CODouble *CODouble::operator = ( CODouble &val)
+{
+    materialize();
+    lazy = raw = false;
+    if( ! data )
+    {
+        data = new double;
+        precision = val.precision;
+        *((double*)data ) = val.doubleValue();
+    } else {
+        if( 0 <= precision && 16 >= precision )
+        {
+            double pow_10 = pow( 10.0, precision);
+            double n = pow_10 * *((double*) (*this).data);
+            double d = pow_10 * val.doubleValue();
+            double t = n - d;
+
+            if( 0.75 < t || -0.75 > t )
+            {
+                *((double*)data ) = round( d )/ pow_10;
+            }
+        } else {
+            *((double*)data ) = val.doubleValue();
+        }
+    }
+    return this;
+};
+
+/****************************************************************************************/
+/*                                                                                        */
+/*                                        COInteger                                        */
+/*                                                                                        */
+/****************************************************************************************/
+
+string *COInteger::toJsonString()
+{
+    string *rtn = new string();
+
+    appendJson( *rtn );
+    return rtn;
+}
+
+void COInteger::appendJson( std::string &out )
+{
+    char buf[ 32 ];
+
+    buf[ 31 ] = buf[ 0 ] = '\0';
+    if( raw )
+    {
+        out.append( str );
+        return;
+    } else if( data )
+    {
+        switch ( siz )
+        {
+            case sizeof( char ):
+                snprintf( buf, 31,"%c", *( char *) data );
+                break;
+            case sizeof( short ):
+                snprintf( buf, 31, "%d", ( int ) *(( short *) data ));
+                break;
+            case sizeof( int ):
+                snprintf( buf, 31, "%d", *(( int *) data ));
+                break;
+            case sizeof( long long):
+#if SIXTY_FOUR_BIT
+                snprintf( buf, 31, "%ld", *(( uint64_t *) data ));
+#else
+                snprintf( buf, 31, "%lld", *(( uint64_t *) data ));
+#endif
+                break;
+        }
+    }
+    out.append( buf );
+}
+
+COInteger::COInteger( COInteger *it ) : CppON( INTEGER_CPPON_OBJ_TYPE )
+{
+    switch( siz = it->size() )
+    {
+        case sizeof( char ):
+            data = new ( char );
+            *((char*) data) = it->charValue();
+            break;
+        case sizeof( short ):
+            data = new ( short );
+            *((short*) data) = it->shortValue();
+            break;
+        case sizeof( int ):
+            data = new ( int );
+            *((int*) data) = it->intValue();
+            break;
+        default:
+            data = new ( long long );
+            *((long long*) data) = it->longValue();
+            break;
+    }
+    if( it->raw )
+    {
+        str = it->str;
+        raw = true;
+    }
+}
+
+COInteger::COInteger( COInteger &it ) : CppON( INTEGER_CPPON_OBJ_TYPE )
+{
+    switch( siz = it.size() )
+    {
+        case sizeof( char ):
+            data = new ( char );
+            *((char*) data) = it.charValue();
+            break;
+        case sizeof( short ):
+            data = new ( short );
+            *((short*) data) = it.shortValue();
+            break;
+        case sizeof( int ):
+            data = new ( int );
+            *((int*) data) = it.intValue();
+            break;
+        default:
+            data = new ( long long );
+            *((long long*) data) = it.longValue();
+            break;
+    }
+    if( it.raw )
+    {
+        str = it.str;
+        raw = true;
+    }
+}
+
+int64_t COInteger::longValue()
+{
+    int64_t rtn = 0;
+
+    materialize();
+    if( data )
+    {
+        switch ( siz )
+        {
+            case sizeof( int8_t ):
+                rtn = (int64_t ) *( (int8_t *) data );
+                break;
+            case sizeof( int16_t ):
+                rtn = (int64_t) *( ( int16_t *) data );
+                break;
+            case sizeof( int32_t ):
+                rtn = (int64_t) *( (int32_t *) data );
+                break;
+            case sizeof( int64_t ):
+                rtn = *( (int64_t *) data );
+                break;
+        }
+    }
+    return rtn;
+}
+
+string *COInteger::toNetString()
+{
+    string *rtn = new string();
+
+    appendNetString( *rtn );
+    return rtn;
+}
+
+void COInteger::appendNetString( std::string &out )
+{
+    if( raw )
+    {
+        CppON::appendNetString( out, str.data(), str.length(), '#' );
+    } else {
+        std::string txt;
+
+        appendJson( txt );
+        CppON::appendNetString( out, txt.data(), txt.length(), '#' );
+    }
+}
+
+const char *COInteger::c_str()
+{
+    char buf[ 32 ];
+
+    buf[ 31 ] = '\0';
+    if( raw )
+    {
+        return str.c_str();
+    } else if( data )
+    {
+        switch ( siz )
+        {
+            case sizeof( char ):
+                snprintf( buf, 31, "%c", *(char *) data );
+                break;
+            case sizeof( short ):
+                snprintf( buf, 31, "%d", ( int ) *(short *) data );
+                break;
+            case sizeof( int ):
+                snprintf( buf, 31, "%d", *(int *) data );
+                break;
+            default:
+#if SIXTY_FOUR_BIT
+                snprintf( buf, 31, "%ld", *(uint64_t *) data );
+#else
+                snprintf( buf, 31, "%lld", *(uint64_t *) data );
+#endif
+                break;
+        }
+    }
+    str = buf;
+    return str.c_str();
+}
+
+void COInteger::dump( FILE *fp)
+{
+    if( raw )
+    {
+        fprintf( fp, "%s", str.c_str() );
+    } else if( data )
+    {
+        switch ( siz )
+        {
+            case sizeof( char ):
+                fprintf( fp, "%c", *(char *) data );
+                break;
+            case sizeof( short ):
+                fprintf( fp, "%d", ( int ) *(short *) data );
+                break;
+            case sizeof( int ):
+                fprintf( fp, "%d", *(int *) data );
+                break;
+            default:
+#if SIXTY_FOUR_BIT
+                fprintf( fp, "%ld", *(uint64_t *) data );
+#else
+                fprintf( fp, "%lld", *(uint64_t *) data );
+#endif
+                break;
+        }
+    } else {
+        fprintf( fp, "NULL" );
+    }
+}
+
+void COInteger::cdump( FILE *fp )
+{
+    if( raw )
+    {
+        fprintf( fp, "%s", str.c_str() );
+    } else if( data )
+    {
+        switch ( siz )
+        {
+            case sizeof( char ):
+                fprintf( fp, "%c", *(char *) data );
+                break;
+            case sizeof( short ):
+                fprintf( fp, "%d", ( int ) *(short *) data );
+                break;
+            case sizeof( int ):
+                fprintf( fp, "%d", *(int *) data );
+                break;
+            default:
+#if SIXTY_FOUR_BIT
+                fprintf( fp, "%ld", *(uint64_t *) data );
+#else
+                fprintf( fp, "%lld", *(uint64_t *) data );
+#endif
+                break;
+        }
+    } else {
+        fprintf( fp, "0" );
+    }
+}
+
+
+uint64_t COInteger::doOperation( unsigned sz, uint64_t val, CppONOperator op )
+{
+    int64_t rtn = 0;
+
+    materialize();
+    raw = false;
+
+    switch( siz )
+    {
+        case 1:
+            switch( op )
+            {
+                case CPPON_ADD:
+                    if( unSigned )
+                    {
+                        *((uint8_t*) data ) += (uint8_t) val;
+                        rtn = (int64_t) *((uint8_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int8_t*) data ) + (int64_t) val;
+                        rtn = (-128>rtn )?-128:((127<rtn)?127:rtn);
+                        *((uint8_t *) data) = (uint8_t) rtn;
+                    }
+                    break;
+                case CPPON_SUBTRACT:
+                    if( unSigned )
+                    {
+                        *((uint8_t*) data ) -= (uint8_t) val;
+                        rtn = (int64_t) *((uint8_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int8_t*) data ) - (int64_t) val;
+                        rtn = (-128>rtn )?-128:((127<rtn)?127:rtn);
+                        *((uint8_t *) data) = (uint8_t) rtn;
+                    }
+                    break;
+                case CPPON_MULTIPLY:
+                    if( unSigned )
+                    {
+                        *((uint8_t*) data ) *= (uint8_t) val;
+                        rtn = (int64_t) *((uint8_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int8_t*) data ) * (int64_t) val;
+                        rtn = (-128>rtn )?-128:((127<rtn)?127:rtn);
+                        *((uint8_t *) data) = (uint8_t) rtn;
+                    }
+                    break;
+                case CPPON_DIVIDE:
+                    if( unSigned )
+                    {
+                        *((uint8_t*) data ) /= (uint8_t) val;
+                        rtn = (int64_t) *((uint8_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int8_t*) data ) / (int64_t) val;
+                        rtn = (-128>rtn )?-128:((127<rtn)?127:rtn);
+                        *((uint8_t *) data) = (uint8_t) rtn;
+                    }
+                    break;
+            }
+            break;
+        case 2:
+            switch( op )
+            {
+                case CPPON_ADD:
+                    if( unSigned )
+                    {
+                        *((uint16_t*) data ) += (uint16_t) val;
+                        rtn = (int64_t) *((uint16_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int16_t*) data ) + (int64_t) val;
+                        rtn = (-32768>rtn )?-32768:((32767<rtn)?32767:rtn);
+                        *((uint16_t *) data) = (uint16_t) rtn;
+                    }
+                    break;
+                case CPPON_SUBTRACT:
+                    if( unSigned )
+                    {
+                        *((uint16_t*) data ) -= (uint16_t) val;
+                        rtn = (int64_t) *((uint16_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int16_t*) data ) - (int64_t) val;
+                        rtn = (-32768>rtn )?-32768:((32767<rtn)?32767:rtn);
+                        *((uint16_t *) data) = (uint16_t) rtn;
+                    }
+                    break;
+                case CPPON_MULTIPLY:
+                    if( unSigned )
+                    {
+                        *((uint16_t*) data ) *= (uint16_t) val;
+                        rtn = (int64_t) *((uint16_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int16_t*) data ) * (int64_t) val;
+                        rtn = (-32768>rtn )?-32768:((32767<rtn)?32767:rtn);
+                        *((uint16_t *) data) = (uint16_t) rtn;
+                    }
+                    break;
+                case CPPON_DIVIDE:
+                    if( unSigned )
+                    {
+                        *((uint16_t*) data ) /= (uint16_t) val;
+                        rtn = (int64_t) *((uint16_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int16_t*) data ) / (int64_t) val;
+                        rtn = (-32768>rtn )?-32768:((32767<rtn)?32767:rtn);
+                        *((uint16_t *) data) = (uint16_t) rtn;
+                    }
+                    break;
+            }
+            break;
+        case 4:
+            switch( op )
+            {
+                case CPPON_ADD:
+                    if( unSigned )
+                    {
+                        *((uint32_t*) data ) += (uint32_t) val;
+                        rtn = (int64_t) *((uint32_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int32_t*) data ) + (int64_t) val;
+                        rtn = (-2147483648>rtn )?-2147483648:((0x7FFFFFFF<rtn)?0x7FFFFFFF:rtn);
+                        *((uint32_t *) data) = (uint32_t) rtn;
+                    }
+                    break;
+                case CPPON_SUBTRACT:
+                    if( unSigned )
+                    {
+                        *((uint32_t*) data ) -= (uint32_t) val;
+                        rtn = (int64_t) *((uint32_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int32_t*) data ) - (int64_t) val;
+                        rtn = (-2147483648>rtn )?-2147483648:((0x7FFFFFFF<rtn)?0x7FFFFFFF:rtn);
+                        *((uint32_t *) data) = (uint32_t) rtn;
+                    }
+                    break;
+                case CPPON_MULTIPLY:
+                    if( unSigned )
+                    {
+                        *((uint32_t*) data ) *= (uint32_t) val;
+                        rtn = (int64_t) *((uint32_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int32_t*) data ) * (int64_t) val;
+                        rtn = (-2147483648>rtn )?-2147483648:((0x7FFFFFFF<rtn)?0x7FFFFFFF:rtn);
+                        *((uint32_t *) data) = (uint32_t) rtn;
+                    }
+                    break;
+                case CPPON_DIVIDE:
+                    if( unSigned )
+                    {
+                        *((uint32_t*) data ) /= (uint32_t) val;
+                        rtn = (int64_t) *((uint32_t *) data );
+                    } else {
+                        rtn = (int64_t)*((int32_t*) data ) / (int64_t) val;
+                        rtn = (-2147483648>rtn )?-2147483648:((0x7FFFFFFF<rtn)?0x7FFFFFFF:rtn);
+                        *((uint32_t *) data) = (uint32_t) rtn;
+                    }
+                    break;
+            }
+            break;
+        case 8:
+            switch( op )
+            {
+                case CPPON_ADD:
+                    if( unSigned )
+                    {
+                        *((uint64_t *) data ) += (uint64_t) val;
+                        rtn = *((uint64_t *) data );
+                    } else {
+                        *((int64_t *) data ) += (int64_t) val;
+                        rtn = *((int64_t *) data );
+                    }
+                    break;
+                case CPPON_SUBTRACT:
+                    if( unSigned )
+                    {
+                        *((uint64_t*) data ) -= (uint64_t) val;
+                        rtn = *((uint64_t*) data );
+                    } else {
+                        *((int64_t*) data ) -= (int64_t) val;
+                        rtn = *((int64_t*) data );
+                    }
+                    break;
+                case CPPON_MULTIPLY:
+                    if( unSigned )
+                    {
+                        *((uint64_t*) data ) *= (uint64_t) val;
+                        rtn = *((uint64_t*) data );
+                    } else {
+                        *((int64_t*) data ) *= (int64_t) val;
+                        rtn = *((int64_t*) data );
+                    }
+                    break;
+                case CPPON_DIVIDE:
+                    if( unSigned )
+                    {
+                        *((uint64_t*) data ) /= (uint64_t) val;
+                        rtn = *((uint64_t*) data );
+                    } else {
+                        *((int64_t*) data ) /= (int64_t) val;
+                        rtn = (int64_t) *((int64_t*) data );
+                    }
+                    break;
+            }
+            break;
+    }
+    switch( sz )
+    {
+        case 1:
+            if( unSigned )
+            {
+                rtn = ( (uint64_t) rtn > 256 ) ? 256 : rtn;
+            } else {
+                rtn = ( rtn > 127 ) ? 127 : ( ( rtn < -128 ) ? -128 : rtn );
+            }
+            break;
+        case 2:
+            if( unSigned )
+            {
+                rtn = ( (uint64_t) rtn > 0xFFFF ) ? 0xFFFF : rtn;
+            } else {
+                rtn = ( rtn > 0x7FFF ) ? 0x7FFF : ( ( rtn < -0x8000 ) ? -0x8000 : rtn );
+            }
+            break;
+        case 4:
+            if( unSigned )
+            {
+                rtn = ( (uint64_t) rtn > 0xFFFFFFFF ) ? 0xFFFFFFFF : rtn;
+            } else {
+                rtn = ( rtn > 0x7FFFFFFF ) ? 0x7FFFFFFF : ( ( rtn < -80000000 ) ? -0x80000000 : rtn );
+            }
+            break;
+        default:
+            break;
+    }
+    return rtn;
+}
+
+
+bool COInteger::operator == ( COInteger &newObj ) {
+    materialize();
+    newObj.materialize();
+    /*
+     * If the sizes are equal then just compare them
+     */
+    if( siz == newObj.siz )
+    {
+        return (
+                ( siz == sizeof( long long) ) ? *( (long long *) newObj.data ) == *( (long long *)data ) :
+                ( siz == sizeof( int ) )      ? *( (int *)       newObj.data ) == *( (int *)      data ) :
+                ( siz == sizeof( short ) )    ? *( (short *)     newObj.data ) == *( (short *)    data ) :
+                *( (char * )     newObj.data ) == *( (char *)     data ) );
+        /*
+         * Else convert them both to "long long" and compare them.
+         */
+    } else {
+        return     ( (siz == sizeof( long long ) ) ?                 *( (long long *)         data ) :
+                ( (siz == sizeof( int       ) ) ? ( long long )      *( (int *)               data ) :
+                ( (siz == sizeof( short     ) ) ? ( long long )      *( (short *)             data ) :
+                ( long long ) *( (char *)              data ) ) ) ) ==
+                ( (newObj.siz == sizeof( long long ) ) ?               *( (long long *)  newObj.data ) :
+                ( (newObj.siz == sizeof( int       ) ) ? ( long long ) *( (int *)        newObj.data ) :
+                ( (newObj.siz == sizeof( short     ) ) ? ( long long ) *( (short *)      newObj.data ) :
+                ( long long ) *( (char *)       newObj.data ) ) ) );
+    }
+}
+
+COInteger *COInteger::operator=(COInteger &val )
+{
+    lazy = raw = false;
+    if( siz != val.siz )
+    {
+        switch(siz)
+        {
+            case sizeof(int): delete (int*)data; break;
+            case sizeof(long long): delete (long long*)data; break;
+            case sizeof(short): delete (short*)data; break;
+            case sizeof(char): delete (char*)data; break;
+        }
+        switch(siz=val.siz)
+        {
+            case sizeof(int): data=new int;break;
+            case sizeof(long long): data=new (long long); break;
+            case sizeof(short): data=new(short); break;
+            case sizeof(char): data=new(char); break;
+        }
+    }
+    switch(siz)
+    {
+        case sizeof(int): *((int*)data )=val.intValue(); break;
+        case sizeof(long long): *((long long*)data )=val.longValue(); break;
+        case sizeof(short): *((short*)data )=val.shortValue(); break;
+        case sizeof(char): *((char*)data )=val.charValue(); break;
+    }
+    if( val.raw )
+    {
+        str = val.str;
+        raw = true;
+    }
+    return this;
+}
+
+/****************************************************************************************/
+/*                                                                                        */
+/*                                        CONull                                            */
+/*                                                                                        */
+/****************************************************************************************/
+
+void CONull::dump( FILE *fp)
+{
+    fprintf( fp, "NULL" );
+}
+void CONull::cdump( FILE *fp )
+{
+    fprintf( fp, "null" );
+}
+string *CONull::toJsonString()
+{
+    return new string("null");
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                    COConcurrentMap                                   */
+/*                                                                                      */
+/****************************************************************************************/
+
+COConcurrentMap::~COConcurrentMap()
+{
+    for( size_t i = 0; COCMAP_SHARDS > i; i++ )
+    {
+        for( std::unordered_map<std::string, Entry>::iterator it = shards[ i ].map.begin(); shards[ i ].map.end() != it; ++it )
+        {
+            CppON::release( it->second.obj );
+        }
+    }
+}
+
+int COConcurrentMap::append( const std::string &key, CppON *n )
+{
+    Shard       &s      = shard( key );
+    CppON       *old    = NULL;
+
+    {
+        std::lock_guard<std::mutex>                         lock( s.lock );
+        std::unordered_map<std::string, Entry>::iterator    it = s.map.find( key );
+
+        if( s.map.end() != it )
+        {
+            old = it->second.obj;
+            s.map.erase( it );                                                              // Like COMap, a replaced key moves to the end
+        } else {
+            count.fetch_add( 1, std::memory_order_relaxed );
+        }
+        s.map.emplace( key, Entry{ n, seq.fetch_add( 1, std::memory_order_relaxed ) } );
+    }
+    CppON::release( old );                                                                  // Outside the lock
+    return 0;
+}
+
+int64_t COConcurrentMap::add( const std::string &key, int64_t delta )
+{
+    Shard                                               &s = shard( key );
+    std::lock_guard<std::mutex>                         lock( s.lock );
+    std::unordered_map<std::string, Entry>::iterator    it = s.map.find( key );
+
+    if( s.map.end() == it )
+    {
+        count.fetch_add( 1, std::memory_order_relaxed );
+        s.map.emplace( key, Entry{ new COInteger( delta ), seq.fetch_add( 1, std::memory_order_relaxed ) } );
+        return delta;
+    }
+    CppON *n = it->second.obj;
+
+    switch( n->type() )
+    {
+        case INTEGER_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            return ( (COInteger *) n )->operator += ( delta );
+        case DOUBLE_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            return ( int64_t ) ( ( (CODouble *) n )->operator += ( delta ) );
+        default:
+            fprintf( stderr, "%s[%d]: \"%s\" is not a number\n", __FILE__, __LINE__, key.c_str() );
+            return 0;
+    }
+}
+
+double COConcurrentMap::add( const std::string &key, double delta )
+{
+    Shard                                               &s = shard( key );
+    std::lock_guard<std::mutex>                         lock( s.lock );
+    std::unordered_map<std::string, Entry>::iterator    it = s.map.find( key );
+
+    if( s.map.end() == it )
+    {
+        count.fetch_add( 1, std::memory_order_relaxed );
+        s.map.emplace( key, Entry{ new CODouble( delta ), seq.fetch_add( 1, std::memory_order_relaxed ) } );
+        return delta;
+    }
+    CppON *n = it->second.obj;
+
+    switch( n->type() )
+    {
+        case INTEGER_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            return ( double ) ( (COInteger *) n )->operator += ( ( int64_t ) delta );
+        case DOUBLE_CPPON_OBJ_TYPE:
+            // cppcheck-suppress cstyleCast
+            return ( (CODouble *) n )->operator += ( delta );
+        default:
+            fprintf( stderr, "%s[%d]: \"%s\" is not a number\n", __FILE__, __LINE__, key.c_str() );
+            return 0.0;
+    }
+}
+
+CppON *COConcurrentMap::findElement( const std::string &key )
+{
+    Shard                                               &s = shard( key );
+    std::lock_guard<std::mutex>                         lock( s.lock );
+    std::unordered_map<std::string, Entry>::iterator    it = s.map.find( key );
+
+    return ( s.map.end() != it ) ? it->second.obj : NULL;
+}
+
+CppON *COConcurrentMap::findCopy( const std::string &key )
+{
+    Shard                                               &s = shard( key );
+    std::lock_guard<std::mutex>                         lock( s.lock );
+    std::unordered_map<std::string, Entry>::iterator    it = s.map.find( key );
+
+    return ( s.map.end() != it ) ? CppON::factory( it->second.obj ) : NULL;
+}
+
+void COConcurrentMap::removeVal( const std::string &key )
+{
+    Shard       &s      = shard( key );
+    CppON       *old    = NULL;
+
+    {
+        std::lock_guard<std::mutex>                         lock( s.lock );
+        std::unordered_map<std::string, Entry>::iterator    it = s.map.find( key );
+
+        if( s.map.end() != it )
+        {
+            old = it->second.obj;
+            s.map.erase( it );
+            count.fetch_sub( 1, std::memory_order_relaxed );
+        }
+    }
+    CppON::release( old );
+}
+
+/*
+ * Copy every value while holding all of the shard locks, so no write lands half way through, then put the
+ * copies in a COMap in the order the keys were added once the locks are dropped.
+ */
+COMap *COConcurrentMap::snapshot()
+{
+    std::vector< std::pair< uint64_t, std::pair< std::string, CppON * > > >  items;
+    COMap                                                                   *rtn = new COMap();
+
+    items.reserve( size() );
+    for( size_t i = 0; COCMAP_SHARDS > i; i++ )
+    {
+        shards[ i ].lock.lock();
+    }
+    for( size_t i = 0; COCMAP_SHARDS > i; i++ )
+    {
+        for( std::unordered_map<std::string, Entry>::iterator it = shards[ i ].map.begin(); shards[ i ].map.end() != it; ++it )
+        {
+            items.push_back( std::make_pair( it->second.seq, std::make_pair( it->first, CppON::factory( it->second.obj ) ) ) );
+        }
+    }
+    for( size_t i = COCMAP_SHARDS; 0 < i; i-- )
+    {
+        shards[ i - 1 ].lock.unlock();
+    }
+    std::sort( items.begin(), items.end(), []( const std::pair< uint64_t, std::pair< std::string, CppON * > > &a,
+                                               const std::pair< uint64_t, std::pair< std::string, CppON * > > &b ) { return a.first < b.first; } );
+    for( size_t i = 0; items.size() > i; i++ )                                              // Not append(), which would split "a/b"
+    {
+        rtn->value()->insert( items[ i ].second );
+        rtn->getKeys()->push_back( items[ i ].second.first );
+    }
+    return rtn;
+}
+
+std::string *COConcurrentMap::toCompactJsonString()
+{
+    COMap           *snap = snapshot();
+    std::string     *rtn = snap->toCompactJsonString();
+
+    delete snap;
+    return rtn;
+}
+
+std::string *COConcurrentMap::toJsonString()
+{
+    COMap           *snap = snapshot();
+    std::string     *rtn = snap->toJsonString();
+
+    delete snap;
+    return rtn;
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                       COChannel                                      */
+/*                                                                                      */
+/****************************************************************************************/
+
+COChannel::COChannel( size_t cap ) : head( 0 ), tail( 0 ), isClosed( false ), popWaiters( 0 ), pushWaiters( 0 )
+{
+    size_t  n = 2;
+
+    while( n < cap )
+    {
+        n <<= 1;
+    }
+    mask = n - 1;
+    cells = new Cell[ n ];
+    for( size_t i = 0; n > i; i++ )
+    {
+        cells[ i ].seq.store( i, std::memory_order_relaxed );
+        cells[ i ].obj = NULL;
+    }
+    sem_init( &notEmpty, 0, 0 );
+    sem_init( &notFull, 0, 0 );
+}
+
+COChannel::~COChannel()
 {
-    COMap                            *rtn    = new COMap();
-    CppON                            *n;
-    map<string, CppON *>::iterator    it;
-    map<string, CppON *>            *m        = (map<string, CppON *> *) data;
+    while( CppON *obj = tryPop() )
+    {
+        CppON::release( obj );
+    }
+    sem_destroy( &notEmpty );
+    sem_destroy( &notFull );
+    delete[] cells;
+}
 
-    // cppcheck-suppress postfixOperator
-    for( it = m->begin(); m->end() != it; it++ )
+size_t COChannel::size()
+{
+    size_t h = head.load( std::memory_order_relaxed );
+    size_t t = tail.load( std::memory_order_relaxed );
+
+    return ( h > t ) ? h - t : 0;
+}
+
+bool COChannel::tryPush( CppON *obj )
+{
+    size_t  pos = head.load( std::memory_order_relaxed );
+    Cell    *cell;
+
+    if( isClosed.load( std::memory_order_relaxed ) )
     {
-        CppON                *obj;
+        return false;
+    }
+    for( ;; )
+    {
+        cell = &cells[ pos & mask ];
+        intptr_t dif = (intptr_t) cell->seq.load( std::memory_order_acquire ) - (intptr_t) pos;
 
-        if( ( obj = newObj.findElement( (string *)&(it->first) ) ) )
+        if( 0 == dif )
         {
-            // cppcheck-suppress cstyleCast
-            if( ( n = (CppON *) it->second ) )
+            if( head.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
             {
-                COMap                *nv;
-                COArray                *na;
-
-                switch ( n->type() )
-                {
-                    case INTEGER_CPPON_OBJ_TYPE:
-                        appendTag( it->first, obj, rtn, n );
-                        break;
-                    case DOUBLE_CPPON_OBJ_TYPE:
-                        appendTag( it->first, obj, rtn, n );
-                        break;
-                    case STRING_CPPON_OBJ_TYPE:
-                        appendTag( it->first, obj, rtn, n );
-                        break;
-                    case BOOLEAN_CPPON_OBJ_TYPE:
-                        appendTag( it->first, obj, rtn, n );
-                        break;
-                    case NULL_CPPON_OBJ_TYPE:
-                        appendTag( it->first, obj, rtn, n );
-                        break;
-                    case MAP_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( (nv = ((COMap *) n )->diff( *((COMap *) obj ), name ) ) )
-                        {
-                            rtn->append( it->first, nv );
-                        }
-                        break;
-                    case ARRAY_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( (na = ( (COArray *) n )->diff( *( ( COArray *) obj ), name ) ) )
-                        {
-                            rtn->append( it->first, na );
-                        }
-                        break;
-                    default:
-                        break;
-                }
+                break;
             }
+        } else if( 0 > dif ) {
+            return false;                                                                   // Full
+        } else {
+            pos = head.load( std::memory_order_relaxed );
         }
     }
-    m = (map<string, CppON *> *) newObj.getData();
-    // cppcheck-suppress postfixOperator
-    for( it = m->begin(); m->end() != it; it++ )
+    cell->obj = obj;
+    cell->seq.store( pos + 1, std::memory_order_release );
+    wake( &notEmpty, popWaiters );
+    return true;
+}
+
+CppON *COChannel::tryPop()
+{
+    size_t  pos = tail.load( std::memory_order_relaxed );
+    Cell    *cell;
+    CppON   *obj;
+
+    for( ;; )
     {
-        if(!( this->findElement( (string *)&(it->first) ) ) )
+        cell = &cells[ pos & mask ];
+        intptr_t dif = (intptr_t) cell->seq.load( std::memory_order_acquire ) - (intptr_t) ( pos + 1 );
+
+        if( 0 == dif )
         {
-            // cppcheck-suppress cstyleCast
-            if( ( n = (CppON *) it->second ) )
+            if( tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
             {
-                switch ( n->type() )
-                {
-                    case INTEGER_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( it->first, new COInteger( *((COInteger *) it->second ) ) );
-                        break;
-                    case DOUBLE_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( it->first, new CODouble( *((CODouble *) it->second ) ) );
-                        break;
-                    case STRING_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( it->first, new COString( *((COString *) it->second ) ) );
-                        break;
-                    case BOOLEAN_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( it->first, new COBoolean( *((COBoolean *) it->second ) ) );
-                        break;
-                    case NULL_CPPON_OBJ_TYPE:
-                        fprintf( stderr, "COMap:diff - NULL type found, appended a NULL to %s\n", it->first.c_str() );
-                        rtn->append( it->first, new CONull( ) );
-                        break;
-                    case MAP_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( it->first, new COMap( *(( COMap *) it->second ) ) );
-                        break;
-                    case ARRAY_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( it->first, new COArray( *(( COArray *) it->second ) ) );
-                        break;
-                    default:
-                        break;
-                }
-            } else {
-                fprintf( stderr, "appended a NULL to %s\n", it->first.c_str() );
-                rtn->append( it->first, new CONull( ) );
+                break;
             }
+        } else if( 0 > dif ) {
+            return NULL;                                                                    // Empty
+        } else {
+            pos = tail.load( std::memory_order_relaxed );
         }
     }
-    if( ! rtn->size() )
+    obj = cell->obj;
+    cell->seq.store( pos + mask + 1, std::memory_order_release );
+    wake( &notFull, pushWaiters );
+    return obj;
+}
+
+size_t COChannel::tryPushBatch( CppON **objs, size_t n )
+{
+    size_t i = 0;
+
+    while( n > i && tryPush( objs[ i ] ) )
     {
-        delete rtn;
-        rtn = NULL;
+        i++;
+    }
+    return i;
+}
+
+size_t COChannel::tryPopBatch( CppON **objs, size_t max )
+{
+    size_t i = 0;
+
+    while( max > i && ( objs[ i ] = tryPop() ) )
+    {
+        i++;
+    }
+    return i;
+}
+
+/*
+ * Post the semaphore only if a thread has said it is waiting on it.  Paired with wait(), where the waiter
+ * announces itself before looking at the ring once more, so a wake up can't fall between the two.
+ */
+void COChannel::wake( sem_t *sem, std::atomic<int> &waiters )
+{
+    if( 0 < waiters.load( std::memory_order_seq_cst ) )
+    {
+        sem_post( sem );
+    }
+}
+
+/*
+ * Sleep until wake() or close(), or until timeoutMs runs out.  Returns false on a time out.  The caller tries
+ * the ring again either way; forPush says which end it wants.
+ */
+bool COChannel::wait( sem_t *sem, std::atomic<int> &waiters, int timeoutMs, bool forPush )
+{
+    bool    rtn = true;
+
+    waiters.fetch_add( 1, std::memory_order_seq_cst );
+    if( isClosed.load() || ( ( forPush ) ? size() <= mask : 0 < size() ) )
+    {
+        waiters.fetch_sub( 1, std::memory_order_seq_cst );
+        return true;
+    }
+    if( 0 > timeoutMs )
+    {
+        while( sem_wait( sem ) && EINTR == errno ) {}
+    } else {
+        struct timespec ts;
+
+        clock_gettime( CLOCK_REALTIME, &ts );
+        ts.tv_sec += timeoutMs / 1000;
+        ts.tv_nsec += ( timeoutMs % 1000 ) * 1000000L;
+        if( 1000000000L <= ts.tv_nsec )
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        while( ( rtn = ! sem_timedwait( sem, &ts ) ) == false && EINTR == errno ) {}
     }
+    waiters.fetch_sub( 1, std::memory_order_seq_cst );
     return rtn;
 }
 
+bool COChannel::push( CppON *obj, int timeoutMs )
+{
+    while( ! tryPush( obj ) )
+    {
+        if( isClosed.load() || ! timeoutMs || ! wait( &notFull, pushWaiters, timeoutMs, true ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+CppON *COChannel::pop( int timeoutMs )
+{
+    CppON *obj;
+
+    while( !( obj = tryPop() ) )
+    {
+        if( isClosed.load() || ! timeoutMs || ! wait( &notEmpty, popWaiters, timeoutMs, false ) )
+        {
+            return tryPop();                                                                // Something may have come in at the last moment
+        }
+    }
+    return obj;
+}
+
+size_t COChannel::pushBatch( CppON **objs, size_t n, int timeoutMs )
+{
+    size_t done = tryPushBatch( objs, n );
+
+    while( n > done && push( objs[ done ], timeoutMs ) )
+    {
+        done++;
+        done += tryPushBatch( objs + done, n - done );
+    }
+    return done;
+}
+
+size_t COChannel::popBatch( CppON **objs, size_t max, int timeoutMs )
+{
+    if( ! max || !( objs[ 0 ] = pop( timeoutMs ) ) )
+    {
+        return 0;
+    }
+    return 1 + tryPopBatch( objs + 1, max - 1 );
+}
+
+void COChannel::close()
+{
+    isClosed.store( true );
+    for( int i = popWaiters.load(); 0 < i; i-- )
+    {
+        sem_post( &notEmpty );
+    }
+    for( int i = pushWaiters.load(); 0 < i; i-- )
+    {
+        sem_post( &notFull );
+    }
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                      COStreamReader                                  */
+/*                                                                                      */
+/****************************************************************************************/
+
+#define STREAM_BLOCK_SIZE   65536
+
+/*
+ * Return the offset of the first character in p[0..n) that the boundary scanner has to look at, or n if there is none.
+ * Inside a string that is a quote or a back slash, outside one a quote or one of the brackets.  The brackets are
+ * matched with a single compare each by folding '[' (0x5B) onto '{' (0x7B) and ']' (0x5D) onto '}' (0x7D).
+ */
+static __inline size_t nextStructural( const char *p, size_t n, bool inString )
+{
+    size_t      i       = 0;
+
+#if defined(__SSE2__)
+    const __m128i   quote   = _mm_set1_epi8( '"' );
+    const __m128i   second  = _mm_set1_epi8( ( inString ) ? '\\' : '{' );
+    const __m128i   third   = _mm_set1_epi8( ( inString ) ? '\\' : '}' );
+    const __m128i   fold    = _mm_set1_epi8( ( inString ) ? 0 : 0x20 );
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        __m128i     v       = _mm_loadu_si128( (const __m128i *) ( p + i ) );
+        __m128i     f       = _mm_or_si128( v, fold );
+        int         mask    = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( v, quote ),
+                                                 _mm_or_si128( _mm_cmpeq_epi8( f, second ), _mm_cmpeq_epi8( f, third ) ) ) );
+        if( mask )
+        {
+            return i + __builtin_ctz( mask );
+        }
+    }
+#endif
+    if( inString )
+    {
+        for( ; i < n && '"' != p[ i ] && '\\' != p[ i ]; i++ );
+    } else {
+        for( char c; i < n && '"' != ( c = p[ i ] ) && '{' != ( c | 0x20 ) && '}' != ( c | 0x20 ); i++ );
+    }
+    return i;
+}
+
+static __inline bool isDocSeparator( char c ) { return ( ' ' == c || '\t' == c || '\n' == c || '\r' == c || ',' == c || '\0' == c ); }
+
+COStreamReader::COStreamReader( int f, bool cls )
+{
+    fd = f;
+    closeFd = cls;
+    cap = STREAM_BLOCK_SIZE * 4;
+    if( !( buf = (char *) malloc( cap + 1 ) ) )
+    {
+        perror( "malloc Memory allocation error" );
+        cap = 0;
+    }
+    start = end = pos = 0;
+    atEof = ( NULL == buf );
+    mode = 0;
+    inString = escape = false;
+    depth = 0;
+    docs = errs = 0;
+}
+
+COStreamReader::COStreamReader( FILE *fp ) : COStreamReader( ( fp ) ? fileno( fp ) : -1, false )
+{
+}
+
+COStreamReader::~COStreamReader()
+{
+    if( closeFd && 0 <= fd )
+    {
+        close( fd );
+    }
+    free( buf );
+}
+
 /*
- * Add an element to the map
- * But first check to see if the key is a path,
- * If not then
- *    just add it.
- * else
- *    check to see if it references an existing object in the map
- *    if not then
- *       append a map by that name
- *
- *    check to see if the object is a map
- *    if so then
- *       append the object to it with the remainder of the key
- *    if not is it an array?
- *       if so then we will append it without the key
- *    otherwise
- *       we can't do anything because we can't append an object to something that isn't a map or and array
- *
- *
+ * Make sure there is at least a block of free space at the end of the buffer.  Consumed data is moved out
+ * of the way first and the buffer only grows when a single document is larger than what is already allocated.
+ */
+void COStreamReader::makeRoom()
+{
+    if( start == end )
+    {
+        start = end = pos = 0;
+    }
+    if( STREAM_BLOCK_SIZE > cap - end && start )
+    {
+        memmove( buf, &buf[ start ], end - start );
+        end -= start;
+        pos -= start;
+        start = 0;
+    }
+    if( STREAM_BLOCK_SIZE > cap - end )
+    {
+        size_t  nCap    = cap * 2;
+        char    *nBuf   = (char *) realloc( buf, nCap + 1 );
+
+        if( nBuf )
+        {
+            buf = nBuf;
+            cap = nCap;
+        } else {
+            perror( "realloc Memory allocation error" );
+        }
+    }
+}
+
+/*
+ * Read whatever is available, up to the free space in the buffer.  Returns the number of bytes read, 0 at the
+ * end of the stream or -1 on error with errno set.
  */
-
-int COMap::append( std::string key, CppON *n )
+ssize_t COStreamReader::fill()
 {
-    size_t pos = key.find( '/' );
-    int rtn = 0;
+    ssize_t     rd;
 
-    if( string::npos == pos )
+    makeRoom();
+    if( cap == end )
     {
-        std::map <std::string, CppON *> *m = ( std::map <std::string, CppON*> *) data;
-        std::map <std::string, CppON *>::iterator it = m->find( key );                                    // If there is already an object by this name delete it and and the new one.
-        if( m->end() != it )
+        errno = ENOMEM;
+        return -1;
+    }
+    while( 0 > ( rd = read( fd, &buf[ end ], cap - end ) ) && EINTR == errno );
+    if( 0 < rd )
+    {
+        end += rd;
+    }
+    return rd;
+}
+
+/*
+ * Continue scanning the buffered data from where the last call stopped.  When a complete document has been found
+ * it is NUL terminated in place, parsed and the terminator restored.  Returns NULL when more data is needed.
+ */
+CppON *COStreamReader::extract()
+{
+    while( start < end || ( atEof && mode ) )
+    {
+        size_t  docEnd  = 0;
+        bool    done    = false;
+
+        if( ! mode )
         {
-            delete it->second;
-            m->erase( it );
-            std::vector< std::string>::iterator its = std::find( order.begin(), order.end(), key );
-            if( order.end() != its )
+            for( ; start < end && isDocSeparator( buf[ start ] ); start++ );
+            if( start == end )
             {
-                order.erase( its );
+                break;
+            }
+            pos = start + 1;
+            depth = 0;
+            escape = false;
+            inString = false;
+            switch( buf[ start ] )
+            {
+                case '{':
+                case '[':
+                    mode = 1;
+                    depth = 1;
+                    break;
+                case '"':
+                    mode = 2;
+                    inString = true;
+                    break;
+                default:
+                    mode = 3;
+                    break;
             }
         }
-        m->insert( m->end(), std::pair < std::string, CppON* >( key, n ) );
-        order.push_back(std::string( key ) );
-    } else {
-        string s = key.substr( 0, pos );
-        key = key.substr( pos + 1 );
-        COMap *mp = (COMap *) findElement( s );
-        if(! mp )
+        if( 3 == mode )
         {
-            append( s, mp = new COMap() );
+            char    c;
+
+            for( ; pos < end && ! isDocSeparator( c = buf[ pos ] ) && '{' != ( c | 0x20 ) && '"' != c; pos++ );
+            if( pos < end || atEof )
+            {
+                docEnd = pos;
+                done = true;
+            }
+        } else {
+            while( ! done && pos < end )
+            {
+                if( escape )
+                {
+                    escape = false;
+                    pos++;
+                    continue;
+                }
+                pos += nextStructural( &buf[ pos ], end - pos, inString );
+                if( pos == end )
+                {
+                    break;
+                }
+                char c = buf[ pos++ ];
+                if( inString )
+                {
+                    if( '\\' == c )
+                    {
+                        escape = true;
+                    } else {
+                        inString = false;
+                        done = ( 0 == depth );
+                    }
+                } else if( '"' == c ) {
+                    inString = true;
+                } else if( '{' == ( c | 0x20 ) ) {
+                    depth++;
+                } else if( !( --depth ) ) {
+                    done = true;
+                }
+            }
+            docEnd = pos;
+            if( ! done && atEof )
+            {
+                fprintf( stderr, "%s[%d]: Stream ended inside a document\n", __FILE__, __LINE__ );
+                errs++;
+                start = pos = end;
+                mode = 0;
+                break;
+            }
         }
-        if( CppON::isMap( mp ) )
+        if( ! done )
         {
-            rtn = mp->append( key, n );
-        } else if( CppON::isArray( mp ) ) {
-            ((COArray *)mp )->append( n );
-        } else {
-            rtn = -1;
+            break;
         }
-    }
-    return rtn;
-};
 
-// cppcheck-suppress unusedFunction
-std::vector<CppON *> *COMap::getValues()
-{
-    std::vector<CppON *> *rtn = new std::vector<CppON *>;
+        char        save    = buf[ docEnd ];
+        const char  *str    = &buf[ start ];
+        CppON       *rtn;
 
-    // cppcheck-suppress postfixOperator
-    for(std::map< std::string, CppON *>::iterator it = (( std::map<std::string, CppON *> *) data )->begin();(( std::map<std::string, CppON *> *) data )->end() != it; it++)
-    {
-        rtn->push_back( it->second );
+        buf[ docEnd ] = '\0';
+        rtn = CppON::GetObj( &str );
+        buf[ docEnd ] = save;
+        start = pos = docEnd;
+        mode = 0;
+        if( rtn )
+        {
+            docs++;
+            return rtn;
+        }
+        errs++;
     }
-    return rtn;
-};
+    return NULL;
+}
 
-// cppcheck-suppress unusedFunction
-CppON *COMap::extract( const char *name )
+CppON *COStreamReader::next()
 {
-    CppON *rtn = NULL;
-    std::map< std::string, CppON *>::iterator it = (( std::map<std::string, CppON *> *) data )->find( name );
+    CppON       *rtn;
 
-    if( it != ((std::map< std::string, CppON *> *) data )->end() )
+    while( !( rtn = extract() ) && ! atEof )
     {
-        rtn = it->second;
-        for( std::vector<std::string>::iterator iter = order.begin(); order.end() != iter; ++iter )
+        ssize_t rd = fill();
+        if( 0 > rd && ( EAGAIN == errno || EWOULDBLOCK == errno ) )
         {
-            if( ! iter->compare( it->first ) )
+            break;                                                                          // Non-blocking descriptor with nothing left to read
+        } else if( 0 >= rd ) {
+            if( rd )
             {
-                order.erase( iter );
-                break;
+                perror( "COStreamReader read" );
             }
+            atEof = true;
         }
-        (( std::map<std::string, CppON *> *) data )->erase( it );
     }
     return rtn;
 }
 
-COMap *COMap::operator=( COMap &val )
+/****************************************************************************************/
+/*                                                                                      */
+/*                                      COSocketReader                                  */
+/*                                                                                      */
+/****************************************************************************************/
+
+COSocketReader::COSocketReader( int f, bool cls ) : COStreamReader( f, cls )
 {
-    map< string, CppON*> *ptr;
+    int     flags;
 
-    if( data )
+    if( 0 <= fd && ( 0 > ( flags = fcntl( fd, F_GETFL ) ) || 0 > fcntl( fd, F_SETFL, flags | O_NONBLOCK ) ) )
     {
-        map <string, CppON*> *m = ( map <string, CppON *> * ) data;
-        map<string, CppON *>::iterator it;
+        perror( "COSocketReader fcntl" );
+    }
+}
 
-        // cppcheck-suppress postfixOperator
-        for( it = m->begin(); m->end() != it; it++ )
+int COSocketReader::drain( std::vector<CppON *> &msgs )
+{
+    size_t      cnt     = msgs.size();
+    CppON       *obj;
+
+    while( ( obj = next() ) )
+    {
+        msgs.push_back( obj );
+    }
+    cnt = msgs.size() - cnt;
+    return ( ! cnt && eof() ) ? -1 : (int) cnt;
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                    COTNetStreamReader                                */
+/*                                                                                      */
+/****************************************************************************************/
+
+COTNetStreamReader::COTNetStreamReader( int f, bool cls ) : COStreamReader( f, cls )
+{
+    struct stat st;
+
+    map = NULL;
+    mapLen = 0;
+    need = 0;
+    if( 0 <= fd && 0 == fstat( fd, &st ) && S_ISREG( st.st_mode ) && 0 < st.st_size )
+    {
+        off_t   off     = lseek( fd, 0, SEEK_CUR );
+        size_t  page    = (size_t) sysconf( _SC_PAGESIZE );
+        size_t  len     = ( (size_t) st.st_size / page + 1 ) * page;                        // A zero page after the file, as
+        void    *m      = mmap( NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ); // mapFileRegion() leaves
+
+        if( MAP_FAILED != m && 0 <= off && off <= st.st_size && MAP_FAILED != mmap( m, st.st_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0 ) )
         {
-            delete( it->second);
+            madvise( m, st.st_size, MADV_SEQUENTIAL );
+            map = (char *) m;
+            mapLen = len;
+            start = pos = off;
+            end = st.st_size;
+            atEof = true;
+            free( buf );                                                                    // Nothing is read into it
+            buf = NULL;
+            cap = 0;
+        } else if( MAP_FAILED != m ) {
+            munmap( m, len );
         }
-        m->clear();
-    } else {
-        data = new map<string, CppON*>();
     }
-    order.clear();
-    siz = val.size();
-    map<string, CppON*> *th = (map<string, CppON*> *) data;
+}
 
-    if( ( ptr = val.value() ) )
+COTNetStreamReader::COTNetStreamReader( FILE *fp ) : COTNetStreamReader( ( fp ) ? fileno( fp ) : -1, false )
+{
+}
+
+COTNetStreamReader::~COTNetStreamReader()
+{
+    if( map )
     {
-        // cppcheck-suppress postfixOperator
-        for( std::map< string, CppON* >::iterator it = ptr->begin(); it != ptr->end(); it++ )
+        munmap( map, mapLen );
+    }
+}
+
+ssize_t COTNetStreamReader::fill()
+{
+    return ( map ) ? 0 : COStreamReader::fill();
+}
+
+/*
+ * Besides the block the base class keeps free, make sure the whole of the current message fits so its
+ * remainder arrives in a single read() regardless of its size.
+ */
+void COTNetStreamReader::makeRoom()
+{
+    COStreamReader::makeRoom();
+    if( need > end - start && need - ( end - start ) > cap - end )
+    {
+        if( start )
         {
-            switch( it->second->type() )
+            memmove( buf, &buf[ start ], end - start );
+            end -= start;
+            pos -= start;
+            start = 0;
+        }
+        if( need > cap )
+        {
+            char    *nBuf   = (char *) realloc( buf, need + STREAM_BLOCK_SIZE + 1 );
+
+            if( nBuf )
             {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    th->insert( th->end(), pair< string, CppON* >( it->first, new COInteger( *((COInteger *)it->second ) ) ) );
-                    order.push_back( string( it->first ) );
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    th->insert( th->end(), pair< string, CppON* >( it->first, new CODouble( *( (CODouble *)it->second ) ) ) );
-                    order.push_back( string( it->first ) );
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    th->insert( th->end(), pair< string, CppON* >( it->first, new COString( *( (COString *)it->second ) ) ) );
-                    order.push_back( string( it->first ) );
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    th->insert( th->end(), pair< string, CppON* >( it->first, new CONull( *( (CONull *)it->second ) ) ) );
-                    order.push_back( string( it->first ) );
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    th->insert( th->end(), pair< string, CppON* >( it->first, new COBoolean( *( (COBoolean *)it->second ) ) ) );
-                    order.push_back( string( it->first ) );
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    th->insert( th->end(), pair< string, CppON* >( it->first, new COMap( *( (COMap *)it->second ) ) ) );
-                    order.push_back( string( it->first ) );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    th->insert( th->end(), pair< string, CppON* >( it->first, new COArray( *( (COArray *)it->second ) ) ) );
-                    order.push_back( string( it->first ) );
-                    break;
-                default:
-                    break;
+                buf = nBuf;
+                cap = need + STREAM_BLOCK_SIZE;
+            } else {
+                perror( "realloc Memory allocation error" );
             }
         }
     }
-    return this;
 }
 
-bool COMap::operator == ( COMap &val )
+CppON *COTNetStreamReader::extract()
 {
-    map<string, CppON*> *th = (map<string, CppON*> *) data;
+    char        *b      = ( map ) ? map : buf;
 
-    // cppcheck-suppress postfixOperator
-    for( std::map< string, CppON* >::iterator itr = th->begin(); itr != th->end(); itr++ )
+    while( start < end )
     {
-        CppON               *t;
+        size_t  len     = 0;
+        size_t  i;
+        char    c       = '\0';
 
-        if( !(t = val.findElement( itr->first.c_str() ) ) )
+        for( ; start < end && ( ' ' == ( c = b[ start ] ) || '\t' == c || '\r' == c || '\n' == c ); start++ );
+        for( i = start; i < end && '0' <= ( c = b[ i ] ) && '9' >= c && 20 > i - start; i++ )
         {
-            return false;
+            len = len * 10 + ( c - '0' );
         }
-        if( !isObj( t ) || !isObj( itr->second ) )
+        if( i == end )
         {
-            return false;
+            if( atEof && start < end )
+            {
+                fprintf( stderr, "%s[%d]: Stream ended inside a TNetString length\n", __FILE__, __LINE__ );
+                errs++;
+                start = end;
+            }
+            need = 0;
+            break;
         }
-        if( t->type() != (itr->second)->type() )
+        if( ':' != c || i == start || len > ( (size_t) -1 ) / 2 )
         {
-            return false;
+            fprintf( stderr, "%s[%d]: Invalid TNetString length prefix\n", __FILE__, __LINE__ );
+            errs++;
+            start = pos = end;
+            atEof = true;
+            break;
         }
-        if( *t != *itr->second )
+        need = ( i - start ) + 2 + len;                                                     // prefix, ':', data and type
+        if( end - start < need )
+        {
+            if( atEof )
+            {
+                fprintf( stderr, "%s[%d]: Stream ended inside a TNetString\n", __FILE__, __LINE__ );
+                errs++;
+                start = end;
+            }
+            break;
+        }
+
+        size_t      mEnd    = start + need;
+        const char  *str    = &b[ start ];
+        char        save    = '\0';
+        CppON       *rtn;
+
+        if( ! map )
+        {
+            save = buf[ mEnd ];                                                             // Protect any JSON embedded in the message
+            buf[ mEnd ] = '\0';
+        }
+        rtn = CppON::parseJson( str, need, opts );                                          // Lengths inside it are checked against need
+        if( ! map )
+        {
+            buf[ mEnd ] = save;
+        }
+        start = pos = mEnd;
+        need = 0;
+        if( rtn )
+        {
+            docs++;
+            return rtn;
+        }
+        errs++;
+    }
+    return NULL;
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                   COUnixTransport                                    */
+/*                                                                                      */
+/****************************************************************************************/
+
+COUnixTransport::COUnixTransport( int f, bool cf ) : it( NULL, false )
+{
+    int         type    = SOCK_STREAM;
+    socklen_t   len     = sizeof( type );
+
+    fd = f;
+    closeFd = cf;
+    reader = NULL;
+    if( getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &len ) )
+    {
+        perror( "getsockopt SO_TYPE" );
+    }
+    seqpacket = ( SOCK_SEQPACKET == type );
+}
+
+COUnixTransport::~COUnixTransport()
+{
+    if( reader )
+    {
+        delete reader;
+    }
+    if( closeFd && 0 <= fd )
+    {
+        close( fd );
+    }
+}
+
+static __inline int unixSocket( const char *path, bool seqpacket, struct sockaddr_un &addr )
+{
+    int fd;
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    if( sizeof( addr.sun_path ) <= strlen( path ) )
+    {
+        fprintf( stderr, "%s[%d]: Socket path too long: \"%s\"\n", __FILE__, __LINE__, path );
+        return -1;
+    }
+    strcpy( addr.sun_path, path );
+    if( 0 > ( fd = socket( AF_UNIX, ( seqpacket ) ? SOCK_SEQPACKET : SOCK_STREAM, 0 ) ) )
+    {
+        perror( "socket" );
+    }
+    return fd;
+}
+
+int COUnixTransport::connectTo( const char *path, bool seqpacket )
+{
+    struct sockaddr_un  addr;
+    int                 fd = unixSocket( path, seqpacket, addr );
+
+    if( 0 <= fd && connect( fd, (struct sockaddr *) &addr, sizeof( addr ) ) )
+    {
+        perror( "connect" );
+        close( fd );
+        fd = -1;
+    }
+    return fd;
+}
+
+int COUnixTransport::listenOn( const char *path, bool seqpacket, int backlog )
+{
+    struct sockaddr_un  addr;
+    int                 fd = unixSocket( path, seqpacket, addr );
+
+    if( 0 <= fd )
+    {
+        unlink( path );
+        if( bind( fd, (struct sockaddr *) &addr, sizeof( addr ) ) || listen( fd, backlog ) )
         {
-            return false;
+            perror( "bind/listen" );
+            close( fd );
+            fd = -1;
         }
     }
-    return true;
+    return fd;
 }
 
-/****************************************************************************************/
-/*                                                                                        */
-/*                                        COArray                                            */
-/*                                                                                        */
-/****************************************************************************************/
-
-COArray::COArray( COArray *at ) : CppON( ARRAY_CPPON_OBJ_TYPE )
+/*
+ * Account for bytes just appended to the framing buffer, growing the last segment when it already ends there.
+ */
+void COUnixTransport::addFrame( size_t from )
 {
-    siz = at->size();
-    data = new vector<CppON *>();
-    for( int i = 0; at->size() > i; i++ )
+    size_t      len = frame.size() - from;
+    Message     &m  = msgs.back();
+
+    if( ! len )
     {
-        CppON *jt = at->at( i );
-        switch( jt->type() )
-        {
-            case INTEGER_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COInteger( *((COInteger *)jt ) ) );
-                break;
-            case DOUBLE_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new CODouble( *( (CODouble *)jt ) ) );
-                break;
-            case STRING_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COString( *( (COString *)jt ) ) );
-                break;
-            case NULL_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new CONull( *( (CONull *)jt ) ) );
-                break;
-            case BOOLEAN_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COBoolean( *( (COBoolean *)jt ) ) );
-                break;
-            case MAP_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COMap( *( (COMap *)jt ) ) );
-                break;
-            case ARRAY_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COArray( *( (COArray *)jt ) ) );
-                break;
-            default:
-                break;
-        }
+        return;
     }
+    if( m.count && ! segs.back().ptr && segs.back().len && segs.back().off + segs.back().len == from )
+    {
+        segs.back().len += len;
+    } else {
+        segs.push_back( Segment{ NULL, from, len } );
+        m.count++;
+    }
+    m.bytes += len;
 }
 
-COArray::COArray( COArray & at ) : CppON( ARRAY_CPPON_OBJ_TYPE )
+/*
+ * Frame one tree.  A container's length is only known when it closes, so a placeholder segment is left where
+ * its prefix goes and the prefix, written to the end of the framing buffer, is pointed at from there.
+ */
+void COUnixTransport::queue( CppON *obj )
 {
-    siz = at.size();
-    data = new vector<CppON *>();
-    for( int i = 0; at.size() > i; i++ )
+    if( ! obj )
     {
-        CppON *jt = at.at( i );
-        switch( jt->type() )
+        return;
+    }
+    msgs.push_back( Message{ segs.size(), 0, 0 } );
+    it.reset( obj );
+    opens.clear();
+    openBytes.clear();
+    while( it.next() )
+    {
+        CppON   *n      = it.node();
+        size_t  from    = frame.size();
+        Message &m      = msgs.back();
+
+        if( it.leaving() )
         {
-            case INTEGER_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COInteger( *((COInteger *)jt ) ) );
-                break;
-            case DOUBLE_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new CODouble( *( (CODouble *)jt ) ) );
+            char    buf[ 24 ];
+            size_t  at      = opens.back();
+            int     len     = snprintf( buf, sizeof( buf ), "%zu:", m.bytes - openBytes.back() );
+
+            opens.pop_back();
+            openBytes.pop_back();
+            frame.append( buf, len );
+            segs[ at ] = Segment{ NULL, from, (size_t) len };
+            m.bytes += len;
+            from = frame.size();
+            frame.push_back( ( MAP_CPPON_OBJ_TYPE == n->type() ) ? '}' : ']' );
+            addFrame( from );
+            continue;
+        }
+        if( it.key() )
+        {
+            CppON::appendNetString( frame, it.key()->data(), it.key()->length(), ',' );
+        }
+        switch( n->type() )
+        {
+            case MAP_CPPON_OBJ_TYPE:
+            case ARRAY_CPPON_OBJ_TYPE:
+                addFrame( from );
+                segs.push_back( Segment{ NULL, 0, 0 } );                                    // Filled in when it closes
+                m.count++;
+                opens.push_back( segs.size() - 1 );
+                openBytes.push_back( m.bytes );
                 break;
             case STRING_CPPON_OBJ_TYPE:
+            {
                 // cppcheck-suppress cstyleCast
-                append( new COString( *( (COString *)jt ) ) );
-                break;
-            case NULL_CPPON_OBJ_TYPE:
+                COString    *cs     = (COString *) n;
                 // cppcheck-suppress cstyleCast
-                append( new CONull( *( (CONull *)jt ) ) );
+                const char  *p      = ( cs->inFile() ) ? ( (COFileString *) cs )->bytes() : ( ( cs->value() ) ? cs->value()->data() : NULL );
+                size_t      plen    = ( p ) ? cs->size() : 0;                               // A COFileString is sent from its mapping
+
+                if( p && UNIX_ZERO_COPY_MIN <= plen && ( ! seqpacket || UNIX_MAX_SEGMENTS > m.count ) )
+                {
+                    char    buf[ 24 ];
+                    int     len = snprintf( buf, sizeof( buf ), "%zu:", plen );
+
+                    frame.append( buf, len );
+                    addFrame( from );
+                    segs.push_back( Segment{ p, 0, plen } );
+                    m.count++;
+                    m.bytes += plen;
+                    from = frame.size();
+                    frame.push_back( ',' );
+                } else {
+                    // cppcheck-suppress cstyleCast
+                    ( (COString *) n )->appendNetString( frame );
+                }
+                addFrame( from );
                 break;
-            case BOOLEAN_CPPON_OBJ_TYPE:
+            }
+            case INTEGER_CPPON_OBJ_TYPE:
                 // cppcheck-suppress cstyleCast
-                append( new COBoolean( *( (COBoolean *)jt ) ) );
+                ( (COInteger *) n )->appendNetString( frame );
+                addFrame( from );
                 break;
-            case MAP_CPPON_OBJ_TYPE:
+            case DOUBLE_CPPON_OBJ_TYPE:
                 // cppcheck-suppress cstyleCast
-                append( new COMap( *( (COMap *)jt ) ) );
+                ( (CODouble *) n )->appendNetString( frame );
+                addFrame( from );
                 break;
-            case ARRAY_CPPON_OBJ_TYPE:
+            case BOOLEAN_CPPON_OBJ_TYPE:
                 // cppcheck-suppress cstyleCast
-                append( new COArray( *( (COArray *)jt ) ) );
+                frame.append( ( ( (COBoolean *) n )->value() ) ? "4:true!" : "5:false!" );
+                addFrame( from );
                 break;
             default:
+                frame.append( "0:~" );
+                addFrame( from );
                 break;
         }
     }
 }
 
-void COArray::parseData( const char *str )
+ssize_t COUnixTransport::flush()
 {
-    if( str )
+    ssize_t rtn = ( seqpacket ) ? flushPackets() : flushStream();
+
+    frame.clear();
+    segs.clear();
+    msgs.clear();
+    return rtn;
+}
+
+static __inline bool waitWritable( int fd )
+{
+    struct pollfd   pfd = { fd, POLLOUT, 0 };
+
+    return 0 < poll( &pfd, 1, -1 );
+}
+
+ssize_t COUnixTransport::flushStream()
+{
+    struct iovec    iov[ UNIX_MAX_SEGMENTS ];
+    size_t          seg     = 0;
+    size_t          skip    = 0;                                                            // Bytes of segs[ seg ] already sent
+    ssize_t         total   = 0;
+
+    while( segs.size() > seg )
     {
-        DumpWhiteSpace( str );
-        const char    *sav = str;
-        unsigned     i;
-        if( '[' == *str )
+        int     cnt = 0;
+        ssize_t n;
+
+        for( size_t i = seg; segs.size() > i && UNIX_MAX_SEGMENTS > cnt; i++ )
         {
-            char        ch;
-            CppON        *obj = NULL;
-            ++str;
-            DumpWhiteSpace( ch, str );
-            while( ch )
+            const char  *p = ( segs[ i ].ptr ) ? segs[ i ].ptr : frame.data() + segs[ i ].off;
+            size_t      o = ( i == seg ) ? skip : 0;
+
+            iov[ cnt ].iov_base = (void *) ( p + o );
+            iov[ cnt++ ].iov_len = segs[ i ].len - o;
+        }
+        if( 0 > ( n = writev( fd, iov, cnt ) ) )
+        {
+            if( EINTR == errno || ( ( EAGAIN == errno || EWOULDBLOCK == errno ) && waitWritable( fd ) ) )
             {
-                sav = str;
-                while( 0 != (ch = *str ) && ( ' ' == ch || '\t' == ch || '\n' == ch || '\r' == ch ) ) { ++str; }
-                if( '0' <= ch && '9' >= ch )
-                {
-                    obj = GetTNetstring( &str );
-                } else if( ch ) {
-                    obj =  GetObj( &str );
-                }
-                if( obj )
-                {
-                    append( obj );
-                    obj = NULL;
-                    DumpWhiteSpace( ch, str );
-                    if( ch )
-                    {
-                        if( ',' == *str )
-                        {
-                            str++;
-                            DumpWhiteSpace( ch, str );
-                        } else if( ']' == ch ) {
-                            break;
-                        } else {
-                            fprintf( stderr, "%s[%d]: Unexpected character: '%c'\n", __FILE__,__LINE__, *str );
-                            break;
-                        }
-                    }
-                } else {
-                    std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
-                    fprintf( stderr, "%s[%d]: Failed to get object: '%s'\n", __FILE__,__LINE__, s.c_str() );
-                }
+                continue;
+            }
+            perror( "writev" );
+            return -1;
+        }
+        total += n;
+        while( 0 < n )                                                                      // Step over what was written
+        {
+            size_t left = segs[ seg ].len - skip;
+
+            if( (size_t) n >= left )
+            {
+                n -= left;
+                seg++;
+                skip = 0;
+            } else {
+                skip += n;
+                n = 0;
             }
-        } else {
-            std::string s( sav, (( i = strlen( sav ) ) > 24 )?24:i );
-            fprintf( stderr, "%s[%d]: Parse ERROR: Expected '[' got '%s'\n", __FILE__, __LINE__, sav );
         }
     }
+    return total;
 }
 
-COArray::COArray( const char *path, const char *file ): CppON( ARRAY_CPPON_OBJ_TYPE )
+ssize_t COUnixTransport::flushPackets()
 {
-    struct stat     _stat;
-    std::string p( path );
-    FILE    *fp;
-
-    data = new vector<CppON *>();
-    siz = 0;
-    if( '/' != p.back() )
-    {
-        p += '/';
-    }
-    p.append( file );
+    std::vector<struct iovec>   iov;
+    struct mmsghdr              hdrs[ UNIX_PACKET_BATCH ];
+    std::vector<std::string>    joined;                                                     // Messages with too many segments for one iovec
+    ssize_t                     total = 0;
 
-    if( ! stat( p.c_str(), &_stat ) && ! ( _stat.st_mode & DIRECTORY_BIT ) && (fp = fopen( p.c_str(), "r" ) ) )
+    for( size_t done = 0; msgs.size() > done; )
     {
-        int     sz = 1024;
-        char    *buf,*bSave;
-        int     rd = 0;
-        int     c;
+        size_t  cnt = ( UNIX_PACKET_BATCH < msgs.size() - done ) ? UNIX_PACKET_BATCH : msgs.size() - done;
+        size_t  segTotal = 0;
+        int     sent;
 
-        if( !( buf = (char *) malloc( sz ) ) )
+        for( size_t i = 0; cnt > i; i++ )
         {
-            fclose( fp );
-            fprintf( stderr, "%s[%.4u]: Failed to allocate memory",__FILE__, __LINE__ );
+            segTotal += ( UNIX_MAX_SEGMENTS < msgs[ done + i ].count ) ? 1 : msgs[ done + i ].count;
         }
-        while( EOF != ( c = fgetc( fp ) ) )
+        iov.resize( segTotal );
+        joined.clear();
+        joined.reserve( cnt );
+        memset( hdrs, 0, sizeof( hdrs ) );
+        segTotal = 0;
+        for( size_t i = 0; cnt > i; i++ )
         {
-            buf[ rd++ ] = ( char ) c;
-            if( rd == sz )
+            Message &m = msgs[ done + i ];
+
+            hdrs[ i ].msg_hdr.msg_iov = &iov[ segTotal ];
+            if( UNIX_MAX_SEGMENTS < m.count )
             {
-                if( !( buf = (char *) realloc( (void *) (bSave = buf ), sz += 512 ) ) )
+                joined.push_back( std::string() );
+                joined.back().reserve( m.bytes );
+                for( size_t s = m.first; m.first + m.count > s; s++ )
+                {
+                    joined.back().append( ( segs[ s ].ptr ) ? segs[ s ].ptr : frame.data() + segs[ s ].off, segs[ s ].len );
+                }
+                iov[ segTotal ].iov_base = (void *) joined.back().data();
+                iov[ segTotal++ ].iov_len = m.bytes;
+                hdrs[ i ].msg_hdr.msg_iovlen = 1;
+            } else {
+                for( size_t s = m.first; m.first + m.count > s; s++ )
                 {
-                    fprintf( stderr, "%s[%.4u]: Failed to reallocate memory: %d bytes!",__FILE__, __LINE__, sz );
-                    free( bSave );
+                    iov[ segTotal ].iov_base = (void *) ( ( segs[ s ].ptr ) ? segs[ s ].ptr : frame.data() + segs[ s ].off );
+                    iov[ segTotal++ ].iov_len = segs[ s ].len;
                 }
+                hdrs[ i ].msg_hdr.msg_iovlen = m.count;
             }
         }
-        buf[ rd ] = '\0';
-        fclose( fp );
-        parseData( buf );
-        free(buf );
-    } else {
-        fprintf( stderr, "%s[%.4u]: Failed to open JSON FILE \"%s\"",__FILE__, __LINE__, p.c_str() );
+        if( 0 > ( sent = sendmmsg( fd, hdrs, cnt, 0 ) ) )
+        {
+            if( EINTR == errno || ( ( EAGAIN == errno || EWOULDBLOCK == errno ) && waitWritable( fd ) ) )
+            {
+                continue;
+            }
+            perror( "sendmmsg" );
+            return -1;
+        }
+        for( int i = 0; sent > i; i++ )
+        {
+            total += msgs[ done + i ].bytes;
+        }
+        done += sent;
     }
+    return total;
 }
 
-COArray::COArray( const char *str ): CppON( ARRAY_CPPON_OBJ_TYPE )
-{
-    data = new vector<CppON *>();
-    siz = 0;
-
-    parseData( str );
-}
-
-void COArray::clear( )
+CppON *COUnixTransport::receive( CppONParseOptions &opts )
 {
-    vector <CppON *> *v = ( vector<CppON *> * ) data;
-
-    for(unsigned int i = 0; v->size() > i; i++ )
+    if( ! seqpacket )
     {
-        delete( v->at( i ) );
-    }
-}
+        CppON *rtn;
 
-CppON *COArray::remove( size_t idx )
-{
-    vector< CppON *>  *v = ( vector<CppON *> *) data;
-    CppON *rtn = NULL;
-
-    if( v->size() > idx )
-    {
-        rtn = v->at( idx );
-        v->erase( v->begin() + idx );
+        if( ! reader )
+        {
+            reader = new COTNetStreamReader( fd, false );
+        }
+        reader->options() = opts;
+        rtn = reader->next();
+        opts.error = reader->options().error;
+        return rtn;
     }
-    return rtn;
-}
-
-string *COArray::toCompactJsonString( )
-{
-    std::string *rtn = new string( "[" );
-
-    if( data )
+    for( ;; )
     {
-        vector <CppON *> *v = ( vector <CppON *> * ) data;
-        unsigned       int i;
-        bool         first = true;
+        ssize_t     n = recv( fd, NULL, 0, MSG_PEEK | MSG_TRUNC );                          // Size of the next packet
+        CppON       *rtn;
 
-        for( i = 0; v->size() > i; i++ )
+        if( 0 > n && EINTR == errno )
         {
-            if( first )
-            {
-                first = false;
-            } else {
-                rtn->append( "," );
-            }
-            CppON       *n = v->at( i );
-            std::string *sptr = NULL;
-
-            switch ( n->type() )
-            {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COInteger *) n )->toJsonString();
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (CODouble *) n )->toJsonString();
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COString *) n )->toJsonString();
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COBoolean *) n )->toJsonString();
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COMap *) n )->toCompactJsonString();
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COArray *) n )->toCompactJsonString( );
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    fprintf( stderr, "COArray: toJsonString -> Dropping NULL\n" );
-                    break;
-                default:
-                    break;
-            }
-            if( sptr )
+            continue;
+        } else if( 0 >= n ) {
+            if( 0 > n )
             {
-                *rtn += *sptr;
-                delete sptr;
+                perror( "recv" );
             }
+            return NULL;
+        }
+        packet.resize( n );
+        if( 0 > ( n = recv( fd, &packet[ 0 ], n, 0 ) ) )
+        {
+            perror( "recv" );
+            return NULL;
+        }
+        packet.resize( n );                                                                 // Keeps a NUL after the message
+        if( ( rtn = CppON::parseJson( packet.c_str(), packet.size(), opts ) ) )             // Lengths inside it are checked against n
+        {
+            return rtn;
         }
+        fprintf( stderr, "%s[%d]: Dropping a malformed %zd byte packet\n", __FILE__, __LINE__, n );
     }
-    *rtn += ']';
-    return rtn;
 }
 
-string *COArray::toJsonString( std::string &indent )
+/****************************************************************************************/
+/*                                                                                      */
+/*                                       COSchema                                       */
+/*                                                                                      */
+/****************************************************************************************/
+
+#define SCHEMA_INTEGRAL         ( 1u << ( ARRAY_CPPON_OBJ_TYPE + 1 ) )                     // A Double with no fraction passes "integer"
+
+/*
+ * Where in the tree the node being checked is.  They are chained on the stack so a path is only built for an error.
+ */
+struct COSchema::Where
 {
-    std::string                                            *rtn         = new string( indent.c_str() );
+    const Where                 *up;
+    const std::string           *key;                                                       // Key in the parent Map or NULL
+    size_t                      index;                                                      // Position in the parent Array
 
-    rtn->append( "[\n" );
-    if( data )
+    static std::string path( const Where *w, const std::string *child = NULL )
     {
-        vector <CppON *> *v = ( vector <CppON *> * )    data;
-        unsigned                                        int i;
-        bool                                            first        = true;
-        std::string                                        newIndent    = indent;
+        std::string rtn;
 
-        newIndent.append( "  " );
-        for( i = 0; v->size() > i; i++ )
+        if( w )
         {
-            if( first )
+            rtn = path( w->up );
+            if( rtn.length() )
             {
-                first = false;
-            } else {
-                rtn->append( ",\n");
+                rtn.push_back( '/' );
             }
-            rtn->append( newIndent.c_str() );
-
-            CppON                                        *n             = v->at( i );
-            std::string                                 *sptr        = NULL;
-
-            switch ( n->type() )
+            if( w->key )
             {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COInteger *) n )->toJsonString();
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (CODouble *) n )->toJsonString();
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COString *) n )->toJsonString();
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COBoolean *) n )->toJsonString();
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COMap *) n )->toJsonString( newIndent );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COArray *) n )->toJsonString( newIndent );
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    fprintf( stderr, "COArray: toJsonString -> Dropping NULL\n" );
-                    break;
-                default:
-                    break;
+                rtn.append( *w->key );
+            } else {
+                rtn.append( std::to_string( w->index ) );
             }
-            if( sptr )
+        }
+        if( child )
+        {
+            if( rtn.length() )
             {
-                *rtn += *sptr;
-                delete sptr;
+                rtn.push_back( '/' );
             }
+            rtn.append( *child );
         }
+        return rtn;
     }
-    *rtn += '\n';
-    rtn->append( indent.c_str() );
-    *rtn += ']';
-    return rtn;
+};
+
+COSchema::COSchema( CppON *schema )
+{
+    compiled = true;
+    compile( schema, "" );
 }
 
-string *COArray::toNetString()
+COSchema::COSchema( const char *json )
 {
-    if( data )
+    CppON   *schema = CppON::parseJson( json );
+
+    compiled = true;
+    if( schema )
     {
-        vector <CppON *>    *v = ( vector <CppON *> * ) data;
-        unsigned            int i;
-        std::string            rt;
+        compile( schema, "" );
+        delete schema;
+    } else {
+        compiled = false;
+        error = "Schema is not valid JSON";
+    }
+}
 
-        for( i = 0; v->size() > i; i++ )
-        {
-            CppON * n = v->at( i );
-            std::string *sptr = NULL;
-            switch ( n->type() )
-            {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COInteger *) n )->toNetString();
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (CODouble *) n )->toNetString();
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COString *) n )->toNetString();
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( ( COBoolean *) n )->toNetString();
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COMap *) n )->toNetString();
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    sptr = ( (COArray *) n )->toNetString();
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    fprintf( stderr, "COArray: toNetString -> Dropping NULL\n" );
-                    break;
-                default:
-                    break;
-            }
-            if( sptr )
-            {
-                rt += *sptr;
-                delete sptr;
-            }
-        }
-        return CppON::toNetString( rt.c_str(), ']' );
+COSchema::~COSchema()
+{
+    for( size_t i = 0; enums.size() > i; i++ )
+    {
+        delete enums[ i ];
     }
+}
 
-    return NULL;
+static __inline unsigned schemaType( const std::string &name )
+{
+    if( "object" == name )
+    {
+        return 1u << MAP_CPPON_OBJ_TYPE;
+    } else if( "array" == name ) {
+        return 1u << ARRAY_CPPON_OBJ_TYPE;
+    } else if( "string" == name ) {
+        return 1u << STRING_CPPON_OBJ_TYPE;
+    } else if( "number" == name ) {
+        return ( 1u << INTEGER_CPPON_OBJ_TYPE ) | ( 1u << DOUBLE_CPPON_OBJ_TYPE );
+    } else if( "integer" == name ) {
+        return ( 1u << INTEGER_CPPON_OBJ_TYPE ) | SCHEMA_INTEGRAL;
+    } else if( "boolean" == name ) {
+        return 1u << BOOLEAN_CPPON_OBJ_TYPE;
+    } else if( "null" == name ) {
+        return 1u << NULL_CPPON_OBJ_TYPE;
+    }
+    return 0;
 }
 
-const char  *COArray::c_str( std::string &idnt )
+/*
+ * Compile one (sub)schema into rules[], returning its index or -1.  "at" is the schema's own path, for errors.
+ */
+int COSchema::compile( CppON *schema, const std::string &at )
 {
-    str = "[";
-    if( data )
+    int                 idx     = (int) rules.size();
+    std::vector<Prop>   local;
+    CppON               *v;
+    COMap               *m;
+    Rule                r;
+    auto                fail    = [ this, &at ]( const char *key, const char *msg )
+    {
+        if( compiled )
+        {
+            error = ( ( at.length() ) ? at + "/" : at ) + key + ": " + msg;
+            compiled = false;
+        }
+        return -1;
+    };
+
+    r.types = 0;
+    r.minimum = -HUGE_VAL;
+    r.maximum = HUGE_VAL;
+    r.minLength = r.minItems = 0;
+    r.maxLength = r.maxItems = ( size_t ) -1;
+    r.propFirst = r.propCount = r.enumFirst = r.enumCount = 0;
+    r.items = -1;
+    r.exclusiveMin = r.exclusiveMax = r.closed = false;
+    rules.push_back( r );                                                                   // Children are compiled after their parent
+
+    // cppcheck-suppress cstyleCast
+    if( CppON::isBoolean( schema ) && ( (COBoolean *) schema )->value() )
     {
-        vector <CppON *> *v = ( vector <CppON *> * )    data;
-        unsigned                                        i;
-        const char                                        *comma = "\n";
-        std::string                                        indent = idnt;
+        return idx;                                                                         // true: anything goes
+    } else if( ! CppON::isMap( schema ) ) {
+        return fail( "", "A schema must be an object" );
+    }
+    // cppcheck-suppress cstyleCast
+    m = (COMap *) schema;
 
-        for( i = 0; v->size() > i; i++ )
+    if( ( v = m->findElement( "type" ) ) )
+    {
+        if( CppON::isString( v ) )
         {
-            CppON *n = v->at( i );
+            // cppcheck-suppress cstyleCast
+            r.types = schemaType( *( (COString *) v )->value() );
+        } else if( CppON::isArray( v ) ) {
+            // cppcheck-suppress cstyleCast
+            COArray *a = (COArray *) v;
 
-            str.append( comma );
-            comma = ",\n";
-            str.append( indent );
-            switch ( n->type() )
+            for( size_t i = 0; a->size() > i; i++ )
             {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( (COInteger *) n )->c_str();
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( (CODouble *) n )->c_str();
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    str += '"';
-                    // cppcheck-suppress cstyleCast
-                    str += ( ( COString *) n )->c_str();
-                    str += '"';
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( ( COBoolean *) n )->c_str();
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( ( CONull *) n )->c_str();
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( (COMap *) n )->c_str( indent );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    str += ( (COArray *) n )->c_str( indent );
-                    break;
-                default:
-                    break;
+                unsigned t = ( CppON::isString( a->at( i ) ) ) ? schemaType( *( (COString *) a->at( i ) )->value() ) : 0;
+
+                if( ! t )
+                {
+                    return fail( "type", "Unknown type" );
+                }
+                r.types |= t;
             }
         }
-        str += '\n';
+        if( ! r.types )
+        {
+            return fail( "type", "Unknown type" );
+        }
     }
-    str += ']';
-    return str.c_str();
-}
 
-void COArray::dump( string &indent, FILE *fp )
-{
-    if( data )
+    if( ( v = m->findElement( "minimum" ) ) && CppON::isNumber( v ) )
     {
-        vector <CppON *> *v = ( vector <CppON *> * )    data;
-        unsigned                                        i;
-        string                                            newIndent    = indent;
-        bool                                            first        = true;
+        r.minimum = v->toDouble();
+    }
+    if( ( v = m->findElement( "maximum" ) ) && CppON::isNumber( v ) )
+    {
+        r.maximum = v->toDouble();
+    }
+    if( ( v = m->findElement( "exclusiveMinimum" ) ) && CppON::isNumber( v ) && ! CppON::isBoolean( v ) && v->toDouble() >= r.minimum )
+    {
+        r.minimum = v->toDouble();
+        r.exclusiveMin = true;
+    }
+    if( ( v = m->findElement( "exclusiveMaximum" ) ) && CppON::isNumber( v ) && ! CppON::isBoolean( v ) && v->toDouble() <= r.maximum )
+    {
+        r.maximum = v->toDouble();
+        r.exclusiveMax = true;
+    }
+    if( ( v = m->findElement( "minLength" ) ) && CppON::isInteger( v ) )
+    {
+        r.minLength = v->toLongInt();
+    }
+    if( ( v = m->findElement( "maxLength" ) ) && CppON::isInteger( v ) )
+    {
+        r.maxLength = v->toLongInt();
+    }
+    if( ( v = m->findElement( "minItems" ) ) && CppON::isInteger( v ) )
+    {
+        r.minItems = v->toLongInt();
+    }
+    if( ( v = m->findElement( "maxItems" ) ) && CppON::isInteger( v ) )
+    {
+        r.maxItems = v->toLongInt();
+    }
 
-        newIndent += "\t";
-        fprintf( fp, "%s[",indent.c_str() );
-        for( i = 0; v->size() > i; i++ )
+    r.enumFirst = enums.size();
+    if( ( v = m->findElement( "enum" ) ) )
+    {
+        if( ! CppON::isArray( v ) )
         {
-            CppON *n = v->at( i );
-            if( first )
-            {
-                fprintf( fp,"\n%s", newIndent.c_str() );
-                first = false;
-            } else {
-                fprintf( fp, ",\n%s", newIndent.c_str() );
-            }
-            switch ( n->type() )
-            {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (COInteger *) n )->dump( fp );
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (CODouble *) n )->dump( fp );
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (COString *) n )->dump( fp );
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( ( COBoolean *) n )->dump( fp );
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    fprintf( fp, "\n");
-                    // cppcheck-suppress cstyleCast
-                    ( (COMap *) n )->dump( newIndent, fp );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    fprintf( fp, "\n");
-                    // cppcheck-suppress cstyleCast
-                    ( (COArray *) n )->dump( newIndent, fp );
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    fprintf( stderr, "COArray: dump -> Dropping NULL\n" );
-                    break;
-                default:
-                    break;
-            }
+            return fail( "enum", "Must be an array" );
+        }
+        for( size_t i = 0; v->size() > i; i++ )
+        {
+            // cppcheck-suppress cstyleCast
+            CppON *e = ( (COArray *) v )->at( i );
+
+            enums.push_back( ( e ) ? CppON::factory( e ) : new CONull() );
         }
-        fprintf( fp, "\n%s]",indent.c_str() );
-    } else {
-        fprintf( fp, "NULL" );
     }
-}
-void COArray::cdump( FILE *fp )
-{
-    if( data )
+    if( ( v = m->findElement( "const" ) ) )
     {
-        vector <CppON *> *v = ( vector <CppON *> * )    data;
-        unsigned                                        i;
-        bool                                            first = true;
+        enums.push_back( CppON::factory( v ) );
+    }
+    r.enumCount = enums.size() - r.enumFirst;
 
-        fprintf( fp, "[");
-        for( i = 0; v->size() > i; i++ )
+    if( ( v = m->findElement( "additionalProperties" ) ) && CppON::isBoolean( v ) )
+    {
+        // cppcheck-suppress cstyleCast
+        r.closed = ! ( (COBoolean *) v )->value();
+    }
+    if( ( v = m->findElement( "properties" ) ) )
+    {
+        if( ! CppON::isMap( v ) )
         {
-            CppON *n = v->at( i );
-            if( first )
+            return fail( "properties", "Must be an object" );
+        }
+        // cppcheck-suppress cstyleCast
+        std::map<std::string, CppON *> *pm = ( (COMap *) v )->value();
+
+        for( std::map<std::string, CppON *>::iterator it = pm->begin(); pm->end() != it; ++it )
+        {
+            int child = compile( it->second, ( ( at.length() ) ? at + "/" : at ) + "properties/" + it->first );
+
+            if( 0 > child )
             {
-                first = false;
-            } else {
-                fprintf( fp, "," );
+                return -1;
+            }
+            local.push_back( Prop{ it->first, child, false } );                              // Already in key order
+        }
+    }
+    if( ( v = m->findElement( "required" ) ) )
+    {
+        if( ! CppON::isArray( v ) )
+        {
+            return fail( "required", "Must be an array" );
+        }
+        for( size_t i = 0; v->size() > i; i++ )
+        {
+            // cppcheck-suppress cstyleCast
+            CppON   *k = ( (COArray *) v )->at( i );
+            size_t  j;
+
+            if( ! CppON::isString( k ) )
+            {
+                return fail( "required", "Must be an array of strings" );
             }
-            switch ( n->type() )
+            // cppcheck-suppress cstyleCast
+            const std::string &key = *( (COString *) k )->value();
+
+            for( j = 0; local.size() > j && local[ j ].key != key; j++ );
+            if( local.size() > j )
             {
-                case INTEGER_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (COInteger *) n )->cdump( fp );
-                    break;
-                case DOUBLE_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (CODouble *) n )->cdump( fp );
-                    break;
-                case STRING_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( (COString *) n )->cdump( fp );
-                    break;
-                case BOOLEAN_CPPON_OBJ_TYPE:
-                    // cppcheck-suppress cstyleCast
-                    ( ( COBoolean *) n )->cdump( fp );
-                    break;
-                case MAP_CPPON_OBJ_TYPE:
-                    fprintf( fp, "\"\n\"");
-                    // cppcheck-suppress cstyleCast
-                    ( (COMap *) n )->cdump( fp );
-                    break;
-                case ARRAY_CPPON_OBJ_TYPE:
-                    fprintf( fp, "\"\n\"");
-                    // cppcheck-suppress cstyleCast
-                    ( (COArray *) n )->cdump( fp );
-                    break;
-                case NULL_CPPON_OBJ_TYPE:
-                    fprintf( stderr, "COArray: cdump -> Dropping NULL\n" );
-                    break;
-                default:
-                    break;
+                local[ j ].required = true;
+            } else {
+                local.push_back( Prop{ key, -1, true } );
             }
         }
-        fprintf( fp, "]" );
-    } else {
-        fprintf( fp, "[]" );
+        std::sort( local.begin(), local.end(), []( const Prop &a, const Prop &b ) { return a.key < b.key; } );
+    }
+    r.propFirst = props.size();
+    r.propCount = local.size();
+    props.insert( props.end(), local.begin(), local.end() );
+
+    if( ( v = m->findElement( "items" ) ) )
+    {
+        if( 0 > ( r.items = compile( v, ( ( at.length() ) ? at + "/" : at ) + "items" ) ) )
+        {
+            return -1;
+        }
     }
+    rules[ idx ] = r;
+    return idx;
 }
 
-COArray  *COArray::diff( COArray &newObj, const char *name )
+/*
+ * Check obj against one rule and, for Maps and Arrays, its children.  Stops at the first failure unless errors is
+ * collecting them, and then once maxErrors (if not 0) have been found.
+ */
+bool COSchema::check( int rule, CppON *obj, const Where *where, std::vector<COSchemaError> *errors, size_t maxErrors ) const
 {
-    COArray                            *rtn    = new COArray();
-    COMap                            *nv;
-    COString                        *vS;
-    COArray                            *na;
-    vector< CppON *>::iterator        it;
-    vector< CppON *>::iterator        nt;
-    vector< CppON *>                *v        = ( vector <CppON *> * ) data;
-    vector< CppON *>                *u        = ( vector <CppON *> * ) newObj.data;
+    const Rule  &r      = rules[ rule ];
+    CppONType   t       = ( obj ) ? obj->type() : NULL_CPPON_OBJ_TYPE;
+    bool        rtn     = true;
+    auto        fail    = [ & ]( const std::string *key, std::string msg )
+    {
+        rtn = false;
+        if( errors )
+        {
+            errors->push_back( COSchemaError{ Where::path( where, key ), msg } );
+        }
+        return ! errors || ( maxErrors && maxErrors <= errors->size() );                    // true: stop here
+    };
 
-    it = v->begin();
-    // cppcheck-suppress postfixOperator
-    for( nt = u->begin(); u->end() != nt; nt++ )
+    if( r.types && ! ( r.types & ( 1u << t ) ) )
     {
-        CppON                        *n;
-        CppON                        *obj    = NULL;
-        COString                    *uS;
+        double d;
 
-        // cppcheck-suppress cstyleCast
-        if( CppON::isMap( obj = (CppON *) *nt ) && name && CppON::isString( uS = (COString *)( ( COMap * ) obj)->findElement( name ) ) )   // If array of maps look for name
+        if( ! ( r.types & SCHEMA_INTEGRAL ) || DOUBLE_CPPON_OBJ_TYPE != t || ( d = obj->toDouble(), floor( d ) != d ) )
         {
-            // cppcheck-suppress postfixOperator
-            for( it = v->begin(); v->end() != it; it++ )
+            fail( NULL, "Wrong type" );
+            return false;                                                                   // Nothing else about it is worth checking
+        }
+    }
+    if( r.enumCount )
+    {
+        size_t  i;
+
+        for( i = r.enumFirst; r.enumFirst + r.enumCount > i; i++ )
+        {
+            CppON *e = enums[ i ];
+
+            if( ( CppON::isNumber( e ) && CppON::isNumber( obj ) && ! CppON::isBoolean( e ) && ! CppON::isBoolean( obj ) ) ?
+                    e->toDouble() == obj->toDouble() : ( obj && *e == *obj ) || ( ! obj && NULL_CPPON_OBJ_TYPE == e->type() ) )
+            {
+                break;
+            }
+        }
+        if( r.enumFirst + r.enumCount <= i && fail( NULL, "Not one of the allowed values" ) )
+        {
+            return false;
+        }
+    }
+    switch( t )
+    {
+        case INTEGER_CPPON_OBJ_TYPE:
+        case DOUBLE_CPPON_OBJ_TYPE:
+        {
+            double d = obj->toDouble();
+
+            if( ( r.exclusiveMin ) ? d <= r.minimum : d < r.minimum )
+            {
+                fail( NULL, "Below the minimum" );
+            } else if( ( r.exclusiveMax ) ? d >= r.maximum : d > r.maximum ) {
+                fail( NULL, "Above the maximum" );
+            }
+            break;
+        }
+        case STRING_CPPON_OBJ_TYPE:
+            if( r.minLength || ( size_t ) -1 != r.maxLength )
             {
                 // cppcheck-suppress cstyleCast
-                if( CppON::isMap( n = (CppON *) *it ) && CppON::isString( vS = (COString *) ( ( COMap * ) n )->findElement( name ) ) && !strcmp( uS->c_str(), vS->c_str( ) ) )
+                COString            *cs = (COString *) obj;
+                // cppcheck-suppress cstyleCast
+                const char          *s  = ( cs->inFile() ) ? ( (COFileString *) cs )->bytes() : ( ( cs->value() ) ? cs->value()->data() : NULL );
+                size_t              n   = ( s ) ? cs->size() : 0;                               // A COFileString is counted in its file
+                size_t              len = 0;
+
+                for( size_t i = 0; n > i; i++ )
+                {
+                    len += ( 0x80 != ( (unsigned char) s[ i ] & 0xC0 ) );                       // Count UTF-8 lead bytes
+                }
+                if( r.minLength > len )
+                {
+                    fail( NULL, "Too short" );
+                } else if( r.maxLength < len ) {
+                    fail( NULL, "Too long" );
+                }
+            }
+            break;
+        case ARRAY_CPPON_OBJ_TYPE:
+        {
+            size_t  n   = obj->size();
+
+            if( r.minItems > n )
+            {
+                if( fail( NULL, "Too few elements" ) )
+                {
+                    return false;
+                }
+            } else if( r.maxItems < n ) {
+                if( fail( NULL, "Too many elements" ) )
                 {
+                    return false;
+                }
+            }
+            if( 0 <= r.items )
+            {
+                for( size_t i = 0; n > i; i++ )
+                {
+                    Where w = { where, NULL, i };
+
                     // cppcheck-suppress cstyleCast
-                    if( (nv = ((COMap *) n )->diff( *((COMap *) obj ), name ) ) )
+                    if( ! check( r.items, ( (COArray *) obj )->at( i ), &w, errors, maxErrors ) )
                     {
-                        delete( nv );      // send whole map
-                        // cppcheck-suppress cstyleCast
-                        rtn->append( new COMap( *( ( COMap * ) obj ) ) );
-                        break;
+                        rtn = false;
+                        if( ! errors || ( maxErrors && maxErrors <= errors->size() ) )
+                        {
+                            return false;
+                        }
                     }
                 }
             }
-        } else if( it != v->end() ) {
-            obj    = ( CppON * ) *nt;
-            n = ( CppON * ) *it;
-            if( obj->type() == n->type() )
+            break;
+        }
+        case MAP_CPPON_OBJ_TYPE:
+            if( r.propCount || r.closed )
             {
-                switch ( obj->type() )
+                // cppcheck-suppress cstyleCast
+                std::map<std::string, CppON *>              *m  = ( (COMap *) obj )->value();
+                std::map<std::string, CppON *>::iterator    it  = m->begin();
+                size_t                                      p   = r.propFirst;
+                size_t                                      pe  = r.propFirst + r.propCount;
+
+                while( m->end() != it || pe > p )                                           // Merge the Map's keys with the properties
                 {
-                    case INTEGER_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( *((COInteger *) n ) != *((COInteger *) obj ) )
-                        {
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( new COInteger( *((COInteger *) obj) ) );
-                        }
-                        break;
-                    case DOUBLE_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( *((CODouble *) n ) != *((CODouble *) obj ) )
-                        {
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( new CODouble( *((CODouble *) obj) ) );
-                        }
-                        break;
-                    case STRING_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( *((COString *) n ) != *((COString *) obj ) )
-                        {
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( new COString( *((COString *) obj) ) );
-                        }
-                        break;
-                    case BOOLEAN_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( *((COBoolean *) n ) != *((COBoolean *) obj ) )
+                    int c = ( m->end() == it ) ? 1 : ( pe == p ) ? -1 : it->first.compare( props[ p ].key );
+
+                    if( 0 > c )
+                    {
+                        if( r.closed && fail( &it->first, "Unexpected key" ) )
                         {
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( new COBoolean( *((COBoolean *) obj) ) );
+                            return false;
                         }
-                        break;
-                    case NULL_CPPON_OBJ_TYPE:
-                        fprintf( stderr, "COArray: diff - Dropping NULL\n" );
-                        break;
-                    case MAP_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( (nv = ((COMap *) n )->diff( *((COMap *) obj ) ) ) )
+                        ++it;
+                    } else if( 0 < c ) {
+                        if( props[ p ].required && fail( &props[ p ].key, "Missing required key" ) )
                         {
-                            delete (nv);                                                  // send whole map
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( new COMap(  *((COMap *) obj ) ) );
+                            return false;
                         }
-                        break;
-                    case ARRAY_CPPON_OBJ_TYPE:
-                        // cppcheck-suppress cstyleCast
-                        if( (na = ( (COArray *) n )->diff( *( ( COArray *) obj ) ) ) )
+                        p++;
+                    } else {
+                        Where w = { where, &it->first, 0 };
+
+                        if( 0 <= props[ p ].rule && ! check( props[ p ].rule, it->second, &w, errors, maxErrors ) )
                         {
-                            delete (na);                                                  // send whole map
-                            // cppcheck-suppress cstyleCast
-                            rtn->append( new COArray(  *((COArray *) obj ) ) );
+                            rtn = false;
+                            if( ! errors || ( maxErrors && maxErrors <= errors->size() ) )
+                            {
+                                return false;
+                            }
                         }
-                        break;
-                    default:
-                        break;
+                        ++it;
+                        p++;
+                    }
                 }
             }
-            // cppcheck-suppress postfixOperator
-            it++;
-        }
-    }
-    if(!rtn->size() )
-    {
-        delete rtn;
-        rtn = NULL;
+            break;
+        default:
+            break;
     }
     return rtn;
 }
 
-COArray *COArray::operator=( COArray &val )
-{
-    if( data )
-    {
-        vector <CppON *> *v = ( vector<CppON *> * ) data;
-
-        for(unsigned int i = 0; v->size() > i; i++ )
-        {
-            delete( v->at( i ) );
-        }
-        v->clear();
-    } else {
-        data = new vector<CppON *>();
-    }
-    siz = val.size();
-
-    for( int i = 0; val.size() > i; i++ )
-    {
-        CppON *jt = val.at( i );
-
-        switch( jt->type() )
-        {
-            case INTEGER_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COInteger( *((COInteger *)jt ) ) );
-                break;
-            case DOUBLE_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new CODouble( *( (CODouble *)jt ) ) );
-                break;
-            case STRING_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COString( *( (COString *)jt ) ) );
-                break;
-            case NULL_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new CONull( *( (CONull *)jt ) ) );
-                break;
-            case BOOLEAN_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COBoolean( *( (COBoolean *)jt ) ) );
-                break;
-            case MAP_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COMap( *( (COMap *)jt ) ) );
-                break;
-            case ARRAY_CPPON_OBJ_TYPE:
-                // cppcheck-suppress cstyleCast
-                append( new COArray( *( (COArray *)jt ) ) );
-                break;
-            default:
-                break;
-        }
-    }
-    return this;
-}
-
-bool COArray::operator == ( COArray &val )
-{
-    // cppcheck-suppress cstyleCast
-    if( val.size() != ((COArray*)this)->size() )
-    {
-        return false;
-    }
-    for( int i = 0; val.size() > i; i++ )
+/*
+ * Check a tree against the schema.  Returns true if it passes.  With errors every failure is appended to it (up to
+ * maxErrors of them if that is not 0), otherwise the check stops at the first one.
+ */
+bool COSchema::validate( CppON *obj, std::vector<COSchemaError> *errors, size_t maxErrors ) const
+{
+    if( ! compiled )
     {
-        // cppcheck-suppress cstyleCast
-        if( ! ( val.at( i ) == ((COArray*)this)->at( i ) ) )
+        if( errors )
         {
-            return false;
+            errors->push_back( COSchemaError{ "", "Schema did not compile: " + error } );
         }
+        return false;
     }
-    return true;
+    return check( 0, obj, NULL, errors, maxErrors );
 }
 
 /****************************************************************************************/
 /*                                                                                      */
-/*                                 COString                                             */
+/*                                        COStore                                       */
 /*                                                                                      */
 /****************************************************************************************/
 
-COString::COString( COString *st ) : CppON( STRING_CPPON_OBJ_TYPE )
+#define STORE_MAGIC             "CPPONIX1"
+#define STORE_DELETE            "0:#"                                                       // An empty integer, which no document writes
+#define SLOT_EMPTY              0                                                           // Slot hashes below 2 are markers
+#define SLOT_DELETED            1
+
+struct COStore::Header
 {
-    data = ( st->data ) ? new std::string( ( ( std::string *) st->data )->c_str() ): NULL;
+    char                        magic[ 8 ];
+    uint64_t                    capacity;                                                   // Slots, a power of two
+    uint64_t                    used;                                                       // Live and deleted slots
+    uint64_t                    live;
+    uint64_t                    liveBytes;                                                  // Log bytes of the live records
+    uint64_t                    logEnd;                                                     // Log size the index describes
+    uint64_t                    logInode;
+    uint64_t                    clean;                                                      // Set only while the store is closed
+};
+
+struct COStore::Slot
+{
+    uint64_t                    hash;
+    uint64_t                    off;                                                        // Record in the log
+    uint64_t                    len;
+};
+
+static thread_local std::string storeScratch;                                               // put() encodes outside the lock into this
+
+static __inline uint64_t storeHash( const std::string &key )
+{
+    uint64_t h = fnvHash( FNV_OFFSET_BASIS, key.data(), key.length() );
+
+    return ( SLOT_DELETED >= h ) ? h + 2 : h;
 }
 
-COString::COString( COString &st ) : CppON( STRING_CPPON_OBJ_TYPE )
+/*
+ * Size of the TNetString at p, or 0 if there isn't a whole one in the avail bytes.  The type character is put in typ.
+ */
+static size_t tnetSize( const char *p, size_t avail, char *typ )
 {
-    data = ( st.data ) ? new std::string( ( ( std::string *) st.data )->c_str() ): NULL;
+    size_t  len = 0;
+    size_t  i;
+
+    for( i = 0; avail > i && '0' <= p[ i ] && '9' >= p[ i ] && 10 > i; i++ )
+    {
+        len = len * 10 + ( p[ i ] - '0' );
+    }
+    if( ! i || avail <= i || ':' != p[ i ] || avail - i - 1 <= len )
+    {
+        return 0;
+    }
+    *typ = p[ i + 1 + len ];
+    return i + len + 2;
 }
 
-COString::COString( std::string st ) : CppON( STRING_CPPON_OBJ_TYPE )
+static __inline size_t keyPrefix( const std::string &key )
 {
-    std::string rst;
+    return std::to_string( key.length() ).length() + key.length() + 2;                      // "len:key,"
+}
 
-    for( unsigned int i = 0; st.length() > i; i++ )
+static bool preadAll( int fd, char *buf, size_t len, uint64_t off )
+{
+    while( len )
     {
-        char ch = st[ i ];
-        switch( ch )
+        ssize_t n = pread( fd, buf, len, off );
+
+        if( 0 >= n )
         {
-            case '"':
-                rst.append( "%22" );
-                break;
-            case '%':
-                rst.append( "%25" );
-                break;
-            case '\0':
-                rst.append( "%00" );
-                break;
-            default:
-                rst.push_back( ch );
-                break;
+            if( 0 > n && EINTR == errno )
+            {
+                continue;
+            }
+            return false;
         }
+        buf += n;
+        len -= n;
+        off += n;
     }
-    data = new std::string( rst.c_str() );
+    return true;
 }
 
-COString::COString( std::string st, bool base64 ) : CppON( STRING_CPPON_OBJ_TYPE )
+static bool pwriteAll( int fd, const char *buf, size_t len, uint64_t off )
 {
-    if( ! base64 )
+    while( len )
     {
-        std::string rst;
+        ssize_t n = pwrite( fd, buf, len, off );
 
-        for( unsigned int i = 0; st.length() > i; i++ )
+        if( 0 > n )
         {
-            char ch = st[ i ];
-            switch( ch )
+            if( EINTR == errno )
             {
-                case '"':
-                    rst.append( "%22" );
-                    break;
-                case '%':
-                    rst.append( "%25" );
-                    break;
-                case '\0':
-                    rst.append( "%00" );
-                    break;
-                default:
-                    rst.push_back( ch );
-                    break;
+                continue;
             }
+            return false;
         }
-        data = new std::string( rst.c_str() );
-    } else {
-        unsigned int    len;
-        char             out[ st.length() + 3 ];
-        if( base64Decode( st.c_str(), st.length(), len, out ) )
+        buf += n;
+        len -= n;
+        off += n;
+    }
+    return true;
+}
+
+/*
+ * fsync() the directory a file is in, which makes a rename() into it durable.
+ */
+static void syncDir( const std::string &file )
+{
+    size_t  slash   = file.find_last_of( '/' );
+    int     dfd     = open( ( std::string::npos == slash ) ? "." : ( slash ) ? file.substr( 0, slash ).c_str() : "/", O_RDONLY | O_CLOEXEC );
+
+    if( 0 <= dfd )
+    {
+        fsync( dfd );
+        close( dfd );
+    }
+}
+
+COStore::COStore( const char *p, bool s ) : path( p )
+{
+    header = NULL;
+    slots = NULL;
+    mapLen = 0;
+    logEnd = 0;
+    idxFd = -1;
+    sync = s;
+    compacting = false;
+    if( 0 > ( fd = open( p, O_RDWR | O_CREAT | O_CLOEXEC, 0644 ) ) )
+    {
+        fprintf( stderr, "%s[%d]: Can't open \"%s\": %s\n", __FILE__, __LINE__, p, strerror( errno ) );
+        return;
+    }
+    if( 0 > ( idxFd = open( ( path + ".idx" ).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644 ) ) )
+    {
+        fprintf( stderr, "%s[%d]: Can't open \"%s.idx\": %s\n", __FILE__, __LINE__, p, strerror( errno ) );
+        close( fd );
+        fd = -1;
+        return;
+    }
+    openIndex( false );
+}
+
+COStore::~COStore()
+{
+    backgroundCompact( false );
+    if( 0 > commit() )
+    {
+        fprintf( stderr, "%s[%d]: Records queued for \"%s\" were lost\n", __FILE__, __LINE__, path.c_str() );
+    }
+    if( header )
+    {
+        header->logEnd = logEnd;
+        msync( header, mapLen, MS_SYNC );                                                   // The slots reach the disk before the flag
+        header->clean = 1;
+        msync( header, sizeof( Header ), MS_SYNC );
+        munmap( header, mapLen );
+    }
+    if( 0 <= idxFd )
+    {
+        close( idxFd );
+    }
+    if( 0 <= fd )
+    {
+        close( fd );
+    }
+}
+
+/*
+ * (Re)size the index file for capacity slots and map it.  The new file is zeroed, so any old contents are lost.
+ */
+bool COStore::mapIndex( uint64_t capacity )
+{
+    size_t  len = sizeof( Header ) + capacity * sizeof( Slot );
+    void    *m;
+
+    if( header )
+    {
+        munmap( header, mapLen );
+        header = NULL;
+        slots = NULL;
+    }
+    if( ftruncate( idxFd, 0 ) || ftruncate( idxFd, len ) )
+    {
+        perror( "ftruncate" );
+        return false;
+    }
+    if( MAP_FAILED == ( m = mmap( NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, idxFd, 0 ) ) )
+    {
+        perror( "mmap" );
+        return false;
+    }
+    mapLen = len;
+    header = (Header *) m;
+    slots = (Slot *) ( header + 1 );
+    memcpy( header->magic, STORE_MAGIC, sizeof( header->magic ) );
+    header->capacity = capacity;
+    return true;
+}
+
+/*
+ * Use the index file if it was closed cleanly and describes the log as it is now, otherwise rebuild it.
+ */
+bool COStore::openIndex( bool rebuild )
+{
+    struct stat st;
+    struct stat ist;
+    void        *m;
+
+    if( fstat( fd, &st ) || fstat( idxFd, &ist ) )
+    {
+        perror( "fstat" );
+        return false;
+    }
+    logEnd = st.st_size;
+    if( ! rebuild && sizeof( Header ) <= (size_t) ist.st_size &&
+        MAP_FAILED != ( m = mmap( NULL, ist.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, idxFd, 0 ) ) )
+    {
+        Header *h = (Header *) m;
+
+        if( ! memcmp( h->magic, STORE_MAGIC, sizeof( h->magic ) ) && h->clean && h->logEnd == logEnd &&
+            h->logInode == (uint64_t) st.st_ino && h->capacity && ! ( h->capacity & ( h->capacity - 1 ) ) &&
+            sizeof( Header ) + h->capacity * sizeof( Slot ) == (size_t) ist.st_size )
         {
-            std::string *s = new std::string( );
-            s->reserve( len );
-            for( unsigned i = 0; i < len; i++ )
-            {
-                s[ i ] = out[ i ];
-            }
-        } else {
-            data = NULL;
+            header = h;
+            slots = (Slot *) ( header + 1 );
+            mapLen = ist.st_size;
+            header->clean = 0;                                                              // Until it is closed again
+            return true;
         }
+        munmap( m, ist.st_size );
     }
-};
+    return rebuildIndex();
+}
 
-COString::COString( const char *st, bool base64) : CppON( STRING_CPPON_OBJ_TYPE )
+/*
+ * Build the index by reading the whole log.  A torn record at the end (from a crash during a commit) is cut off.
+ */
+bool COStore::rebuildIndex()
 {
-    if( ! base64 )
+    struct stat st;
+    const char  *log    = NULL;
+    uint64_t    off     = 0;
+
+    if( ! mapIndex( STORE_MIN_SLOTS ) || fstat( fd, &st ) )
     {
-        data = new std::string( st );
-    } else {
-        unsigned int    len;
-        unsigned int    sz = strlen( st );
-        char             out[ sz + 3 ];
+        return false;
+    }
+    header->logInode = st.st_ino;
+    if( logEnd && MAP_FAILED == ( log = (const char *) mmap( NULL, logEnd, PROT_READ, MAP_PRIVATE, fd, 0 ) ) )
+    {
+        perror( "mmap" );
+        return false;
+    }
+    while( logEnd > off )
+    {
+        char    kt;
+        char    vt;
+        size_t  kl  = tnetSize( log + off, logEnd - off, &kt );
+        size_t  vl  = ( kl && ',' == kt ) ? tnetSize( log + off + kl, logEnd - off - kl, &vt ) : 0;
+        size_t  p;
 
-        if( base64Decode( st, sz, len, out ) )
+        if( ! vl )
         {
-            std::string *s = new std::string( );
-            s->reserve( len );
-            data = s;
-            for( unsigned i = 0; i < len; i++ )
-            {
-                s->push_back( out[ i ] );
-            }
+            break;
+        }
+        for( p = 0; ':' != log[ off + p ]; p++ );
+        std::string key( log + off + p + 1, kl - p - 2 );
+        if( sizeof( STORE_DELETE ) - 1 == vl && ! memcmp( log + off + kl, STORE_DELETE, vl ) )
+        {
+            indexRemove( key );
         } else {
-            data = NULL;
+            indexPut( key, off, kl + vl );
+        }
+        off += kl + vl;
+    }
+    if( log )
+    {
+        munmap( (void *) log, logEnd );
+    }
+    if( logEnd > off )
+    {
+        fprintf( stderr, "%s[%d]: Dropping %llu bytes of torn records at the end of \"%s\"\n", __FILE__, __LINE__,
+                 (unsigned long long) ( logEnd - off ), path.c_str() );
+        if( ftruncate( fd, off ) )
+        {
+            perror( "ftruncate" );
         }
+        logEnd = off;
     }
+    header->logEnd = logEnd;
+    return true;
 }
 
-COString::COString( uint64_t val, bool hex ) : CppON( STRING_CPPON_OBJ_TYPE )
+/*
+ * Check that the record at off is stored under key.  Called with lock held.
+ */
+bool COStore::keyAt( uint64_t off, uint64_t len, const std::string &key )
 {
-    char buf[ 32 ];
+    size_t  n = keyPrefix( key );
 
-#if SIXTY_FOUR_BIT
-    if( hex )
+    if( len < n )
     {
-        snprintf( buf, 31, "0x%.16lX", val );
-    } else {
-        snprintf( buf, 31, "%lu", val );
+        return false;
     }
-#else
-    if( hex )
+    scratch.resize( n );
+    if( ! preadAll( fd, &scratch[ 0 ], n, off ) )
     {
-        snprintf( buf, 31, "0x%.16llX", val );
-    } else {
-        snprintf( buf, 31, "%llu", val );
+        return false;
     }
-#endif
-    data = new std::string( buf );
+    return ! scratch.compare( n - key.length() - 1, key.length(), key ) && ',' == scratch[ n - 1 ] &&
+           ! scratch.compare( 0, n - key.length() - 2, std::to_string( key.length() ) );
 }
-COString::COString( uint32_t val, bool hex ) : CppON( STRING_CPPON_OBJ_TYPE )
+
+/*
+ * The slot holding key, or NULL.  With insert the slot it should go in is returned instead of NULL; tell the two
+ * apart by the slot's hash.
+ */
+COStore::Slot *COStore::findSlot( const std::string &key, uint64_t h, bool insert )
 {
-    char buf[ 24 ];
+    uint64_t    mask    = header->capacity - 1;
+    Slot        *tomb   = NULL;
 
-    if( hex )
+    for( uint64_t i = h & mask; ; i = ( i + 1 ) & mask )
     {
-        snprintf( buf, 23, "0x%.8X", val );
-    } else {
-        snprintf( buf, 23, "%u", val );
+        Slot *s = &slots[ i ];
+
+        if( SLOT_EMPTY == s->hash )
+        {
+            return ( insert ) ? ( ( tomb ) ? tomb : s ) : NULL;
+        } else if( SLOT_DELETED == s->hash ) {
+            if( ! tomb )
+            {
+                tomb = s;
+            }
+        } else if( h == s->hash && keyAt( s->off, s->len, key ) ) {
+            return s;
+        }
     }
-    data = new std::string( buf );
 }
-COString *COString::operator = ( uint64_t val )
+
+void COStore::indexPut( const std::string &key, uint64_t off, uint64_t len )
 {
-    char buf[ 32 ];
+    uint64_t    h   = storeHash( key );
+    Slot        *s;
 
-#if SIXTY_FOUR_BIT
-    if( data && '0' == ((std::string *) data)->at( 0 )  )
+    if( ! header )
     {
-        snprintf( buf, 31, "0x%.16lX", val );
-    } else {
-        snprintf( buf, 31, "%lu", val );
+        return;                                                                             // The index could not be grown
+    } else if( ( header->used + 1 ) * 4 > header->capacity * 3 )                                   // Grow (or just clear out deleted slots)
+    {
+        std::vector<Slot>   keep;
+        Header              saved   = *header;
+        uint64_t            cap     = saved.capacity;
+
+        for( uint64_t i = 0; saved.capacity > i; i++ )
+        {
+            if( SLOT_DELETED < slots[ i ].hash )
+            {
+                keep.push_back( slots[ i ] );
+            }
+        }
+        while( ( keep.size() + 1 ) * 2 > cap )
+        {
+            cap *= 2;
+        }
+        if( ! mapIndex( cap ) )
+        {
+            return;
+        }
+        *header = saved;
+        header->capacity = cap;
+        header->used = keep.size();
+        for( size_t i = 0; keep.size() > i; i++ )
+        {
+            uint64_t j;
+
+            for( j = keep[ i ].hash & ( cap - 1 ); SLOT_EMPTY != slots[ j ].hash; j = ( j + 1 ) & ( cap - 1 ) );
+            slots[ j ] = keep[ i ];
+        }
     }
-#else
-    if( data && '0' == ((std::string *) data)->at( 0 )  )
+    s = findSlot( key, h, true );
+    if( h == s->hash )
     {
-        snprintf( buf, 31, "0x%.16llX", val );
+        header->liveBytes -= s->len;
     } else {
-        snprintf( buf, 31, "%llu", val );
+        header->used += ( SLOT_EMPTY == s->hash );
+        header->live++;
     }
-#endif
-    if( data )
+    s->hash = h;
+    s->off = off;
+    s->len = len;
+    header->liveBytes += len;
+}
+
+void COStore::indexRemove( const std::string &key )
+{
+    Slot *s = ( header ) ? findSlot( key, storeHash( key ), false ) : NULL;
+
+    if( s )
     {
-        *( ( std::string *) data) = buf;
-    } else {
-        data = new std::string( buf );
+        s->hash = SLOT_DELETED;
+        header->live--;
+        header->liveBytes -= s->len;
     }
-    return this;
 }
-COString *COString::operator = ( uint32_t val )
+
+/*
+ * Append a record to the queue.  obj NULL queues a delete.  Commits the queue once it is big enough.
+ */
+bool COStore::queue( const std::string &key, CppON *obj )
 {
-    char buf[ 24 ];
+    bool full;
 
-    if( data && '0' == ((std::string *) data)->at( 0 ) )
+    storeScratch.clear();
+    CppON::appendNetString( storeScratch, key.data(), key.length(), ',' );
+    if( obj )
     {
-        snprintf( buf, 23, "0x%.16X", val );
+        std::string value;
+
+        obj->writeNetString( value );
+        storeScratch.append( value );
     } else {
-        snprintf( buf, 23, "%u", val );
+        storeScratch.append( STORE_DELETE );
     }
-    if( data )
     {
-        *( ( std::string *) data) = buf;
-    } else {
-        data = new std::string( buf );
+        std::lock_guard<std::mutex> lk( lock );
+
+        if( ! ok() )
+        {
+            return false;
+        }
+        pendingKeys[ key ] = Queued{ pending.size(), storeScratch.size(), ! obj };
+        pending.append( storeScratch );
+        full = STORE_COMMIT_BYTES <= pending.size();
     }
-    return this;
+    return ! full || 0 <= commit();
 }
-COString *COString::operator = ( int val )
+
+bool COStore::put( const std::string &key, CppON *obj )
 {
-    char buf[ 24 ];
+    return obj && queue( key, obj );
+}
 
-    snprintf( buf, 23, "%d", val );
+bool COStore::remove( const std::string &key )
+{
+    return queue( key, NULL );
+}
 
-    if( data )
+/*
+ * Copy key's record into rec, from the queues or the log.  valueAt is where the document starts in it.
+ */
+bool COStore::readRecord( const std::string &key, std::string &rec, size_t &valueAt )
+{
+    std::lock_guard<std::mutex>                         lk( lock );
+    std::unordered_map<std::string, Queued>::iterator   it;
+    Slot                                                *s;
+
+    if( ! ok() )
+    {
+        return false;
+    }
+    valueAt = keyPrefix( key );
+    if( pendingKeys.end() != ( it = pendingKeys.find( key ) ) )
+    {
+        rec.assign( pending, it->second.off, it->second.len );
+        return ! it->second.removed;
+    } else if( writingKeys.end() != ( it = writingKeys.find( key ) ) ) {
+        rec.assign( writing, it->second.off, it->second.len );
+        return ! it->second.removed;
+    } else if( ! ( s = findSlot( key, storeHash( key ), false ) ) ) {
+        return false;
+    }
+    rec.resize( s->len );
+    if( ! preadAll( fd, &rec[ 0 ], s->len, s->off ) )
     {
-        *( ( std::string *) data) = buf;
-    } else {
-        data = new std::string( buf );
+        fprintf( stderr, "%s[%d]: Can't read \"%s\" from \"%s\"\n", __FILE__, __LINE__, key.c_str(), path.c_str() );
+        return false;
     }
-    return this;
+    return true;
 }
-// cppcheck-suppress unusedFunction
-std::string *COString::toString()
+
+CppON *COStore::get( const std::string &key )
 {
-    char            *cPtr = (char *) data;
-    char            ch;
-    std::string        *rtn = new string();
+    std::string rec;
+    size_t      at;
+    const char  *p;
 
-    while( 0 != (ch = *cPtr++ ) )
+    if( ! readRecord( key, rec, at ) )
     {
-        if( '%' == ch )
-        {
-            ch = ( ( *cPtr++ - '0' ) << 4 );
-            ch += (*cPtr++ - '0' );
-        }
-        rtn->push_back( ch );
+        return NULL;
     }
-    rtn->push_back( '\0' );
-    return rtn;
-};
+    p = rec.c_str() + at;
+    return CppON::GetTNetstring( &p );
+}
 
-string *COString::toNetString()
+bool COStore::contains( const std::string &key )
 {
-    return CppON::toNetString( ( ( std::string *) data )->c_str(), ',' );
+    std::lock_guard<std::mutex>                         lk( lock );
+    std::unordered_map<std::string, Queued>::iterator   it;
+
+    if( ! ok() )
+    {
+        return false;
+    } else if( pendingKeys.end() != ( it = pendingKeys.find( key ) ) ) {
+        return ! it->second.removed;
+    } else if( writingKeys.end() != ( it = writingKeys.find( key ) ) ) {
+        return ! it->second.removed;
+    }
+    return NULL != findSlot( key, storeHash( key ), false );
 }
 
-static unsigned char dtab[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x0A, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3E, 0x80, 0x80, 0x80, 0x3F,
-                                0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x80, 0x80, 0x80, 0x00, 0x80, 0x80,
-                                0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
-                                0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
-                                0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-                                0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+size_t COStore::size()
+{
+    std::lock_guard<std::mutex> lk( lock );
 
-static unsigned char etable[] ={0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,0x50,
-                                0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x61,0x62,0x63,0x64,0x65,0x66,
-                                0x67,0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,0x70,0x71,0x72,0x73,0x74,0x75,0x76,
-                                0x77,0x78,0x79,0x7A,0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x2B,0x2F};
+    return ( header ) ? header->live : 0;
+}
 
 /*
- * Decode Base64 encoded strings
- * Some files insert newlines in the strings to brake them up.  Allow those
+ * Write the queue to the log.  The write and the sync are done without holding lock, so put() and get() carry on
+ * meanwhile; a thread that commits during that time waits on commitLock and then writes everything queued since.
  */
-char *COString::base64Decode( const char *tmp, unsigned int sz, unsigned int &len, char    *out )
+int COStore::commit()
 {
-    int             i;
-    int             ch;
-    unsigned char    a[ 4 ],b[ 4 ];
+    std::lock_guard<std::mutex>     cl( commitLock );
+    std::unique_lock<std::mutex>    lk( lock );
+    uint64_t                        base    = logEnd;
+    int                             rtn;
 
-    len = 0;
-    if( ! tmp || 1 > sz )
+    if( ! ok() || pending.empty() )
     {
-        return NULL;
+        return 0;
     }
-    if( ! out )
+    writing.swap( pending );
+    writingKeys.swap( pendingKeys );
+    lk.unlock();
+
+    if( ! pwriteAll( fd, writing.data(), writing.size(), base ) || ( sync && fdatasync( fd ) ) )
     {
-        out = new char[ sz + 3 ];
+        fprintf( stderr, "%s[%d]: Commit to \"%s\" failed: %s\n", __FILE__, __LINE__, path.c_str(), strerror( errno ) );
+        if( ftruncate( fd, base ) )
+        {
+            perror( "ftruncate" );
+        }
+        lk.lock();
+        for( std::unordered_map<std::string, Queued>::iterator it = pendingKeys.begin(); pendingKeys.end() != it; ++it )
+        {
+            it->second.off += writing.size();                                               // Newer records go after the failed ones
+            writingKeys[ it->first ] = it->second;
+        }
+        writing.append( pending );
+        writing.swap( pending );
+        writingKeys.swap( pendingKeys );
+        writing.clear();
+        writingKeys.clear();
+        return -1;
     }
-    while( *tmp != 0 )
+
+    lk.lock();
+    for( std::unordered_map<std::string, Queued>::iterator it = writingKeys.begin(); writingKeys.end() != it; ++it )
     {
-        if( 0x0A == *tmp )
+        if( it->second.removed )
         {
-            tmp++;
+            indexRemove( it->first );
         } else {
-            for( i = 0; 4 > i ;  )
-            {
-                ch = *tmp++;
-                if( ch == 0 || 0x80 == dtab[ ch ] )          // Got an illegal character so die.
-                {
-                    fprintf( stderr, "Character = 0x%.2X => dtab: 0x%.2X\n", ch, dtab[ ch ] );
-                    return NULL;
-                } else if( 0x0A != ch ) {
-                    a[ i ] = (unsigned char) ch;
-                    b[ i++ ] = (unsigned char) dtab[ ch ];
-                }
-            }
-            out[ len++ ] = ( b[ 0 ] << 2 ) | ( b[ 1 ] >> 4 );
-            if(a[ 2 ] != '=')
-            {
-                out[ len++ ] = ( b[ 1 ] << 4 ) | ( b[ 2 ] >> 2 );
-                if(a[ 3 ] != '=')
-                {
-                    out[ len++ ] = ( b[ 2 ] << 6 ) | b[ 3 ];
-                }
-            }
+            indexPut( it->first, base + it->second.off, it->second.len );
         }
     }
-    out[ len ] = 0;
-    return out;
+    logEnd = base + writing.size();
+    rtn = (int) writingKeys.size();
+    writing.clear();
+    writingKeys.clear();
+    if( ! header )
+    {
+        return -1;
+    }
+    header->logEnd = logEnd;
+    if( compacting && STORE_COMPACT_MIN <= logEnd - header->liveBytes && logEnd - header->liveBytes > header->liveBytes )
+    {
+        compactWake.notify_one();
+    }
+    return rtn;
 }
 
-std::string *COString::toBase64JsonString( const char *cPtr, unsigned int len )
+/*
+ * Rewrite the log with just the live records, in the order they are in now.  Records are copied without holding
+ * lock; nothing else changes the log or the index meanwhile because commit() waits on commitLock.
+ */
+bool COStore::compact()
 {
-    unsigned char    o[ ( ( len * 4 ) / 3 ) + 4 ];                                      // Make sure it is big enough to hold the output data
-    unsigned char    ig[ 3 ];
-    unsigned char    c;
-    int             n;
-    unsigned char    *ot                             =     o;
-    bool             done                            =    false;
+    std::lock_guard<std::mutex>     cl( commitLock );
+    std::unique_lock<std::mutex>    lk( lock );
+    std::vector<uint64_t>           live;                                                   // Slot numbers in log order
+    std::vector<uint64_t>           offs;
+    std::string                     buf;
+    std::string                     tmp     = path + ".compact";
+    uint64_t                        out     = 0;
+    struct stat                     st;
+    int                             nfd;
+
+    if( ! ok() )
+    {
+        return false;
+    }
+    for( uint64_t i = 0; header->capacity > i; i++ )
+    {
+        if( SLOT_DELETED < slots[ i ].hash )
+        {
+            live.push_back( i );
+        }
+    }
+    std::sort( live.begin(), live.end(), [ this ]( uint64_t a, uint64_t b ) { return slots[ a ].off < slots[ b ].off; } );
+    offs.reserve( live.size() );
+    for( size_t i = 0; live.size() > i; i++ )
+    {
+        offs.push_back( slots[ live[ i ] ].off );
+    }
+    lk.unlock();
 
-    while( !done )
+    if( 0 > ( nfd = open( tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 ) ) )
+    {
+        fprintf( stderr, "%s[%d]: Can't open \"%s\": %s\n", __FILE__, __LINE__, tmp.c_str(), strerror( errno ) );
+        return false;
+    }
+    buf.reserve( STORE_COPY_BYTES );
+    for( size_t i = 0; live.size() > i; i++ )
     {
-        ig[ 0 ] = ig[ 1 ] = ig[ 2 ] = 0;
-        for( n = 0; 3 > n; n++ )
+        size_t  len = slots[ live[ i ] ].len;                                               // Only commit() changes slots
+        size_t  at  = buf.size();
+
+        buf.resize( at + len );
+        if( ! preadAll( fd, &buf[ at ], len, offs[ i ] ) )
         {
-            if((c = (unsigned char)*cPtr++) == 0)  // end of input string so we are done....
-            {
-                done = true;
-                break;
-            }
-            ig[ n ] = c;
+            perror( "pread" );
+            close( nfd );
+            unlink( tmp.c_str() );
+            return false;
         }
-        if( 0 < n )
+        offs[ i ] = out + at;
+        if( STORE_COPY_BYTES <= buf.size() || live.size() == i + 1 )
         {
-            *ot++ = etable[ ig[ 0 ] >> 2 ];
-            *ot++ = etable[ ( ( ig[ 0 ] & 3) << 4 ) | ig[ 1 ] >> 4 ];
-            *ot++ = etable[ ( ( ig[ 1 ] &0x0f ) << 2 ) | ( ig[ 2 ] >> 6 ) ];
-            *ot++ = etable[ ig[ 2 ] & 0x3f ];
-            if( 3 > n )                 // If we kicked out before getting all 3 input bytes then replace with '='
+            if( ! pwriteAll( nfd, buf.data(), buf.size(), out ) )
             {
-                ot[ -1 ] = '=';
-                if(2 > n )
-                {
-                    ot[ -2 ] = '=';
-                }
+                perror( "pwrite" );
+                close( nfd );
+                unlink( tmp.c_str() );
+                return false;
             }
+            out += buf.size();
+            buf.clear();
         }
     }
-    *ot = '\0';
-    return new std::string( (char *) o );
-}
+    if( ( sync && fdatasync( nfd ) ) || fstat( nfd, &st ) )
+    {
+        perror( "fdatasync" );
+        close( nfd );
+        unlink( tmp.c_str() );
+        return false;
+    }
 
-string *COString::toJsonString()
-{
-    if( ! data )
+    lk.lock();
+    if( rename( tmp.c_str(), path.c_str() ) )
     {
-        return NULL;
+        perror( "rename" );
+        close( nfd );
+        unlink( tmp.c_str() );
+        return false;
+    }
+    if( sync )
+    {
+        syncDir( path );
+    }
+    close( fd );
+    fd = nfd;
+    for( size_t i = 0; live.size() > i; i++ )
+    {
+        slots[ live[ i ] ].off = offs[ i ];
     }
-    unsigned int    len     = ( ( std::string *) data)->length();
-    const char        *cPtr    =  ( ( std::string *) data)->c_str();
-    string            *rtn    = new string( "\"" );
+    logEnd = out;
+    header->logEnd = logEnd;
+    header->logInode = st.st_ino;
+    return true;
+}
+
+void COStore::compactLoop()
+{
+    std::unique_lock<std::mutex> lk( lock );
 
-    for(unsigned int i = 0; len > i; i++)
+    while( compacting )
     {
-        char ch = cPtr[ i ];
-        switch( ch )
+        uint64_t dead = ( header ) ? logEnd - header->liveBytes : 0;
+
+        if( STORE_COMPACT_MIN <= dead && dead > header->liveBytes )
         {
-            case '"':
-                rtn->append( "%22");
-                break;
-            case '{':
-                rtn->append( "%7B" );
-                break;
-            case '}':
-                rtn->append( "%7D" );
-                break;
-            case '<':
-                rtn->append( "%3C" );
-                break;
-            case '>':
-                rtn->append( "%3E" );
-                break;
-            case '\\':
-                rtn->append( "%5C" );
-                break;
-            case '\'':
-                rtn->append( "%60" );
-                break;
-            case '^':
-                rtn->append( "%5E" );
-                break;
-            case '&':
-                rtn->append( "%26" );
-                break;
-            case '\r':
-                rtn->append( "%0D" );
-                break;
-            case '\n':
-            case '\a':
-                rtn->append( "%0A" );
-                break;
-            case '\t':
-                rtn->push_back( ' ' );
-                break;
-            default:
-                rtn->push_back( ch );
-                break;
+            bool done;
+
+            lk.unlock();
+            done = compact();
+            lk.lock();
+            if( ! done && compacting )
+            {
+                compactWake.wait_for( lk, std::chrono::seconds( 1 ) );                      // Don't spin on a failing disk
+            }
+        } else {
+            compactWake.wait( lk );
         }
     }
-    rtn->push_back( '"');
-    return rtn;
 }
 
-void COString::dump( FILE *fp)
-{
-    fprintf( fp, "\"%s\"", ( data ) ? ((std::string *) data)->c_str() : "\"\"" );
-}
-void COString::cdump( FILE *fp )
+void COStore::backgroundCompact( bool on )
 {
-    fprintf( fp, "\\\"%s\\\"", ( data ) ? ((std::string *) data)->c_str() : "\"\"" );
+    std::unique_lock<std::mutex> lk( lock );
+
+    if( on && ! compacting && ok() )
+    {
+        compacting = true;
+        compactor = std::thread( &COStore::compactLoop, this );
+    } else if( ! on && compacting ) {
+        compacting = false;
+        compactWake.notify_one();
+        lk.unlock();
+        compactor.join();
+    }
 }
 
 /****************************************************************************************/
 /*                                                                                      */
-/*                                        CODouble                                      */
+/*                                       COJournal                                      */
 /*                                                                                      */
 /****************************************************************************************/
 
-CODouble::CODouble( CODouble *dt ) : CppON( DOUBLE_CPPON_OBJ_TYPE )
+/*
+ * Apply one operation to root, moving its value (if any) out of op.  An empty path replaces root itself.
+ */
+static bool journalApply( COMap *&root, COArray *op )
 {
-    if( ! data )
+    COArray *p;
+    COMap   *m  = root;
+    size_t  n;
+
+    // cppcheck-suppress cstyleCast
+    if( ! CppON::isArray( op ) || 1 > op->size() || 2 < op->size() || ! CppON::isArray( p = (COArray *) op->at( 0 ) ) )
     {
-        data = new ( double );
+        return false;
     }
-    *((double *) data) = dt->doubleValue();
-    precision = dt->Precision();
+    if( ! ( n = p->size() ) )
+    {
+        if( 2 != op->size() || ! CppON::isMap( op->at( 1 ) ) )
+        {
+            return false;
+        }
+        delete root;
+        // cppcheck-suppress cstyleCast
+        root = (COMap *) op->pop();
+        return true;
+    }
+    for( size_t i = 0; n > i; i++ )
+    {
+        if( ! CppON::isString( p->at( i ) ) )
+        {
+            return false;
+        }
+    }
+    for( size_t i = 0; n - 1 > i; i++ )
+    {
+        // cppcheck-suppress cstyleCast
+        const std::string                           &key    = *( (COString *) p->at( i ) )->value();
+        std::map<std::string, CppON *>::iterator    it      = m->value()->find( key );
+
+        if( m->value()->end() == it || ! CppON::isMap( it->second ) )
+        {
+            COMap *c = new COMap();
+
+            mapSetKey( m, key, c );
+            m = c;
+        } else {
+            // cppcheck-suppress cstyleCast
+            m = (COMap *) it->second;
+        }
+    }
+    // cppcheck-suppress cstyleCast
+    const std::string &key = *( (COString *) p->at( n - 1 ) )->value();
+    if( 2 == op->size() )
+    {
+        CppON *v = op->pop();
+
+        mapSetKey( m, key, ( v ) ? v : new CONull() );
+    } else {
+        mapRemoveKey( m, key );
+    }
+    return true;
 }
 
-CODouble::CODouble( CODouble &dt ) : CppON( DOUBLE_CPPON_OBJ_TYPE )
+static COArray *journalPath( const std::vector<const std::string *> &stack, const std::string *key )
 {
-    if( ! data )
+    COArray *p = new COArray();
+
+    for( size_t i = 0; stack.size() > i; i++ )
     {
-        data = new ( double );
+        p->append( new COString( *stack[ i ] ) );
     }
-    *((double *) data) = dt.doubleValue();
+    if( key )
+    {
+        p->append( new COString( *key ) );
+    }
+    return p;
 }
 
-string *CODouble::toNetString()
+/*
+ * Add the operations that turn "from" into "to" to ops.  Both Maps keep their keys sorted so they are walked
+ * side by side; a Map found on both sides is compared key by key and anything else is replaced if it changed.
+ * Replaying keeps the keys "from" still has where they are and adds the new ones in "to"'s order after them, so
+ * when that isn't "to"'s key order (a key moved or was added between others) the whole Map is replaced instead.
+ */
+static void journalDiff( COMap *from, COMap *to, std::vector<const std::string *> &stack, COArray &ops )
 {
-    char buf[ 48 ];
-    buf[ 47 ] = buf[ 0 ] = '\0';
-    if( data )
+    std::map<std::string, CppON *>              *a      = from->value();
+    std::map<std::string, CppON *>              *b      = to->value();
+    std::vector<std::string>                    *order  = to->getKeys();
+    std::map<std::string, CppON *>::iterator    ia      = a->begin();
+    std::map<std::string, CppON *>::iterator    ib      = b->begin();
+    size_t                                      k       = 0;
+
+    for( size_t i = 0; from->getKeys()->size() > i; i++ )
     {
-    snprintf( buf, 47, "%.10lf", *(( double *) data ));
+        if( b->count( ( *from->getKeys() )[ i ] ) && ( order->size() <= k || ( *order )[ k++ ] != ( *from->getKeys() )[ i ] ) )
+        {
+            k = order->size() + 1;                                                          // A kept key moved
+            break;
+        }
     }
-    return CppON::toNetString( buf, '^' );
-};
+    for( ; order->size() > k; k++ )
+    {
+        if( a->count( ( *order )[ k ] ) )
+        {
+            break;                                                                          // A new key before a kept one
+        }
+    }
+    if( order->size() != k )
+    {
+        COArray *op = new COArray();
 
-string *CODouble::toJsonString()
-{
-    char buf[ 128 ];
-    buf[127] = buf[ 0 ] = '\0';
-    if( data )
+        op->append( journalPath( stack, NULL ) );
+        op->append( CppON::factory( to ) );
+        ops.append( op );
+        return;
+    }
+    while( a->end() != ia || b->end() != ib )
     {
-        if( 0 > precision || 16 < precision )
+        int c = ( a->end() == ia ) ? 1 : ( b->end() == ib ) ? -1 : ia->first.compare( ib->first );
+
+        if( 0 > c )
         {
-            snprintf( buf, 127, "%.10lf", *(double *)data );
-        } else {
-            char prebuf[ 8 ];
-            prebuf[ 7 ] = buf[ 23 ] = '\0';
-            snprintf( prebuf, 7, "%c.%dlf", '%', (int)precision );
-            snprintf( buf, 23, prebuf, *(double *) data );
+            COArray *op = new COArray();
+
+            op->append( journalPath( stack, &ia->first ) );
+            ops.append( op );
+            ++ia;
+            continue;
+        } else if( 0 == c && CppON::isMap( ia->second ) && CppON::isMap( ib->second ) ) {
+            stack.push_back( &ia->first );
+            // cppcheck-suppress cstyleCast
+            journalDiff( (COMap *) ia->second, (COMap *) ib->second, stack, ops );
+            stack.pop_back();
+        } else if( 0 == c && ( ! ia->second || ! ib->second || ! ia->second->identical( ib->second ) ) ) {
+            COArray *op = new COArray();
+
+            op->append( journalPath( stack, &ib->first ) );
+            op->append( ( ib->second ) ? CppON::factory( ib->second ) : new CONull() );
+            ops.append( op );
+        }
+        if( 0 == c )
+        {
+            ++ia;
+        }
+        ++ib;
+    }
+    for( size_t i = 0; order->size() > i; i++ )                                             // New keys, in their order
+    {
+        std::map<std::string, CppON *>::iterator it = b->find( ( *order )[ i ] );
+
+        if( b->end() != it && ! a->count( it->first ) )
+        {
+            COArray *op = new COArray();
+
+            op->append( journalPath( stack, &it->first ) );
+            op->append( ( it->second ) ? CppON::factory( it->second ) : new CONull() );
+            ops.append( op );
         }
     }
-    return new string( buf );
 }
 
-const char *CODouble::c_str()
+COJournal::COJournal( const char *p, bool s ) : path( p )
 {
-    char buf[ 32 ];
-    buf[ 31 ] = '\0';
-    if( data )
-    {
-        if( 0 > precision || 16 < precision )
+    last = new COMap();
+    generation = 0;
+    journalBytes = snapshotBytes = 0;
+    sync = s;
+    fd = -1;
+    if( readSnapshot() )
+    {
+        if( 0 > ( fd = open( ( path + ".journal" ).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644 ) ) )
         {
-            snprintf( buf, 31, "%.10lf", *(double *) data );
-        } else{
-            char prebuf[ 8 ];
-            prebuf[ 7 ] = buf[ 23 ] = '\0';
-            snprintf( prebuf, 7, "%c.%dlf", '%', (int)precision );
-            snprintf( buf, 23, prebuf, *(double *) data );
+            fprintf( stderr, "%s[%d]: Can't open \"%s.journal\": %s\n", __FILE__, __LINE__, p, strerror( errno ) );
+        } else if( ! replay() ) {
+            close( fd );
+            fd = -1;
         }
-    } else {
-        strcpy( buf, "NULL" );
     }
-    str = buf;
-    return str.c_str();
 }
 
-void CODouble::dump( FILE *fp)
+COJournal::~COJournal()
 {
-    if( data )
+    if( 0 <= fd )
     {
-        fprintf( fp, "%.10lf", *(double *) data );
-    } else {
-        fprintf( fp, "NULL" );
+        close( fd );
     }
+    delete last;
 }
 
-void CODouble::cdump( FILE *fp )
+/*
+ * Read the snapshot: a TNetString generation number followed by the Map.  No snapshot is an empty Map.
+ */
+bool COJournal::readSnapshot()
 {
-    if( data )
+    int         sfd     = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+    struct stat st;
+    const char  *p;
+    char        typ;
+    CppON       *gen;
+    CppON       *map;
+
+    if( 0 > sfd )
     {
-        fprintf( fp, "%.16lf", *(double *) data );
-    } else {
-        fprintf( fp, "0.0" );
+        if( ENOENT == errno )
+        {
+            return true;
+        }
+        fprintf( stderr, "%s[%d]: Can't open \"%s\": %s\n", __FILE__, __LINE__, path.c_str(), strerror( errno ) );
+        return false;
+    }
+    if( fstat( sfd, &st ) )
+    {
+        perror( "fstat" );
+        close( sfd );
+        return false;
+    }
+    buf.resize( st.st_size );
+    if( st.st_size && ! preadAll( sfd, &buf[ 0 ], st.st_size, 0 ) )
+    {
+        perror( "pread" );
+        close( sfd );
+        return false;
+    }
+    close( sfd );
+    snapshotBytes = buf.size();
+    p = buf.c_str();
+    if( ! tnetSize( p, buf.size(), &typ ) || '#' != typ || ! ( gen = CppON::GetTNetstring( &p ) ) )
+    {
+        fprintf( stderr, "%s[%d]: \"%s\" is not a journal snapshot\n", __FILE__, __LINE__, path.c_str() );
+        return false;
+    }
+    generation = gen->toLongInt();
+    delete gen;
+    if( ! tnetSize( p, buf.size() - ( p - buf.c_str() ), &typ ) || '}' != typ || ! ( map = CppON::GetTNetstring( &p ) ) )
+    {
+        fprintf( stderr, "%s[%d]: The snapshot in \"%s\" is damaged\n", __FILE__, __LINE__, path.c_str() );
+        return false;
     }
+    delete last;
+    // cppcheck-suppress cstyleCast
+    last = (COMap *) map;
+    return true;
 }
 
-double CODouble::operator = (const double& val)
+/*
+ * Apply the journal to the snapshot.  A journal for another generation is left over from before the last
+ * checkpoint and is started over; the journal is cut short at the first record that is not whole.
+ */
+bool COJournal::replay()
 {
-    if( !data )
+    struct stat st;
+    const char  *p;
+    const char  *end;
+    char        typ;
+    CppON       *gen    = NULL;
+    size_t      len;
+
+    if( fstat( fd, &st ) )
     {
-        data = new double;
-        *((double*) (*this).data) = val;
-    } else {
-        if( 0 > precision  || 16 < precision )
+        perror( "fstat" );
+        return false;
+    }
+    buf.resize( st.st_size );
+    if( st.st_size && ! preadAll( fd, &buf[ 0 ], st.st_size, 0 ) )
+    {
+        perror( "pread" );
+        return false;
+    }
+    p = buf.c_str();
+    end = p + buf.size();
+    if( ! tnetSize( p, end - p, &typ ) || '#' != typ || ! ( gen = CppON::GetTNetstring( &p ) ) || generation != gen->toLongInt() )
+    {
+        delete gen;
+        return resetJournal();
+    }
+    delete gen;
+    while( end > p && ( len = tnetSize( p, end - p, &typ ) ) && ']' == typ )
+    {
+        const char  *q      = p;
+        CppON       *rec    = CppON::GetTNetstring( &q );
+
+        if( ! rec )
         {
-            *((double*) (*this).data) = val;
-        } else {
-            double pow_10 = pow( 10.0, precision);
-            double n = pow_10 * *((double*) (*this).data);
-            double d = pow_10 * val;
-            double t = n - d;
-            if( 0.75 < t || -0.75 > t )
+            break;
+        }
+        for( size_t i = 0; rec->size() > i; i++ )
+        {
+            // cppcheck-suppress cstyleCast
+            if( ! journalApply( last, (COArray *) ( (COArray *) rec )->at( i ) ) )
             {
-                *((double*) (*this).data) = round( d )/ pow_10;
+                fprintf( stderr, "%s[%d]: Skipping a bad operation in \"%s.journal\"\n", __FILE__, __LINE__, path.c_str() );
             }
         }
+        delete rec;
+        p += len;
     }
-    return *((double*) (*this).data);
-}
-
-CODouble *CODouble::operator = ( CODouble &val)
-{
-    if( ! data )
+    journalBytes = p - buf.c_str();
+    if( end > p )
     {
-        data = new double;
-        precision = val.precision;
-        *((double*)data ) = val.doubleValue();
-    } else {
-        if( 0 <= precision && 16 >= precision )
+        fprintf( stderr, "%s[%d]: Dropping %zu bytes of torn records at the end of \"%s.journal\"\n", __FILE__, __LINE__,
+                 (size_t) ( end - p ), path.c_str() );
+        if( ftruncate( fd, journalBytes ) )
         {
-            double pow_10 = pow( 10.0, precision);
-            double n = pow_10 * *((double*) (*this).data);
-            double d = pow_10 * val.doubleValue();
-            double t = n - d;
-
-            if( 0.75 < t || -0.75 > t )
-            {
-                *((double*)data ) = round( d )/ pow_10;
-            }
-        } else {
-            *((double*)data ) = val.doubleValue();
+            perror( "ftruncate" );
+            return false;
         }
     }
-    return this;
-};
-
-/****************************************************************************************/
-/*                                                                                        */
-/*                                        COInteger                                        */
-/*                                                                                        */
-/****************************************************************************************/
+    return true;
+}
 
-string *COInteger::toJsonString()
+/*
+ * Empty the journal and start it with the current generation.
+ */
+bool COJournal::resetJournal()
 {
-    char buf[ 32 ];
+    COInteger   gen( generation );
 
-    buf[ 31 ] = buf[ 0 ] = '\0';
-    if( data )
+    gen.writeNetString( buf );
+    if( ftruncate( fd, 0 ) || ! pwriteAll( fd, buf.data(), buf.size(), 0 ) || ( sync && fdatasync( fd ) ) )
     {
-        switch ( siz )
+        fprintf( stderr, "%s[%d]: Can't reset \"%s.journal\": %s\n", __FILE__, __LINE__, path.c_str(), strerror( errno ) );
+        return false;
+    }
+    journalBytes = buf.size();
+    return true;
+}
+
+/*
+ * Append one record and apply it to the state, checkpointing if the journal has grown big enough.
+ */
+bool COJournal::write( COArray &ops )
+{
+    ops.writeNetString( buf );
+    if( ! pwriteAll( fd, buf.data(), buf.size(), journalBytes ) || ( sync && fdatasync( fd ) ) )
+    {
+        fprintf( stderr, "%s[%d]: Can't write to \"%s.journal\": %s\n", __FILE__, __LINE__, path.c_str(), strerror( errno ) );
+        if( ftruncate( fd, journalBytes ) )
         {
-            case sizeof( char ):
-                snprintf( buf, 31,"%c", *( char *) data );
-                break;
-            case sizeof( short ):
-                snprintf( buf, 31, "%d", ( int ) *(( short *) data ));
-                break;
-            case sizeof( int ):
-                snprintf( buf, 31, "%d", *(( int *) data ));
-                break;
-            case sizeof( long long):
-#if SIXTY_FOUR_BIT
-                snprintf( buf, 31, "%ld", *(( uint64_t *) data ));
-#else
-                snprintf( buf, 31, "%lld", *(( uint64_t *) data ));
-#endif
-                break;
+            perror( "ftruncate" );
         }
+        return false;
+    }
+    journalBytes += buf.size();
+    for( size_t i = 0; ops.size() > i; i++ )
+    {
+        // cppcheck-suppress cstyleCast
+        journalApply( last, (COArray *) ops.at( i ) );
+    }
+    if( JOURNAL_MIN_CHECKPOINT <= journalBytes && snapshotBytes < journalBytes )
+    {
+        checkpoint();
     }
-    return new string( buf );
+    return true;
 }
 
-COInteger::COInteger( COInteger *it ) : CppON( INTEGER_CPPON_OBJ_TYPE )
+int COJournal::record( COMap *config )
 {
-    switch( siz = it->size() )
+    std::vector<const std::string *>    stack;
+    COArray                             ops;
+
+    if( ! ok() || ! config )
     {
-        case sizeof( char ):
-            data = new ( char );
-            *((char*) data) = it->charValue();
-            break;
-        case sizeof( short ):
-            data = new ( short );
-            *((short*) data) = it->shortValue();
-            break;
-        case sizeof( int ):
-            data = new ( int );
-            *((int*) data) = it->intValue();
-            break;
-        default:
-            data = new ( long long );
-            *((long long*) data) = it->longValue();
-            break;
+        return -1;
     }
+    journalDiff( last, config, stack, ops );
+    if( ! ops.size() )
+    {
+        return 0;
+    }
+    return ( write( ops ) ) ? (int) ops.size() : -1;
 }
 
-COInteger::COInteger( COInteger &it ) : CppON( INTEGER_CPPON_OBJ_TYPE )
+bool COJournal::set( const std::vector<std::string> &keys, CppON *value )
 {
-    switch( siz = it.size() )
+    COArray ops;
+    COArray *op     = new COArray();
+    COArray *p      = new COArray();
+
+    for( size_t i = 0; keys.size() > i; i++ )
     {
-        case sizeof( char ):
-            data = new ( char );
-            *((char*) data) = it.charValue();
-            break;
-        case sizeof( short ):
-            data = new ( short );
-            *((short*) data) = it.shortValue();
-            break;
-        case sizeof( int ):
-            data = new ( int );
-            *((int*) data) = it.intValue();
-            break;
-        default:
-            data = new ( long long );
-            *((long long*) data) = it.longValue();
-            break;
+        p->append( new COString( keys[ i ] ) );
     }
+    op->append( p );
+    op->append( ( value ) ? CppON::factory( value ) : new CONull() );
+    ops.append( op );
+    return ok() && write( ops );
 }
 
-int64_t COInteger::longValue()
+bool COJournal::remove( const std::vector<std::string> &keys )
 {
-    int64_t rtn = 0;
-    if( data )
+    COArray ops;
+    COArray *op     = new COArray();
+    COArray *p      = new COArray();
+
+    for( size_t i = 0; keys.size() > i; i++ )
     {
-        switch ( siz )
-        {
-            case sizeof( int8_t ):
-                rtn = (int64_t ) *( (int8_t *) data );
-                break;
-            case sizeof( int16_t ):
-                rtn = (int64_t) *( ( int16_t *) data );
-                break;
-            case sizeof( int32_t ):
-                rtn = (int64_t) *( (int32_t *) data );
-                break;
-            case sizeof( int64_t ):
-                rtn = *( (int64_t *) data );
-                break;
-        }
+        p->append( new COString( keys[ i ] ) );
     }
-    return rtn;
+    op->append( p );
+    ops.append( op );
+    return ok() && keys.size() && write( ops );
 }
 
-string *COInteger::toNetString()
+/*
+ * Write the state as a new snapshot (next generation) with a rename, then empty the journal.  A crash before the
+ * rename keeps the old snapshot and journal; after it the journal's generation no longer matches and is dropped.
+ */
+bool COJournal::checkpoint()
 {
-    char buf[ 32 ];
+    std::string tmp     = path + ".tmp";
+    COInteger   gen( generation + 1 );
+    std::string body;
+    int         sfd;
 
-    buf[ 31 ] = buf[ 0 ] = '\0';
-    if( data )
+    if( ! ok() )
     {
-        switch ( siz )
-        {
-            case 1:
-                snprintf( buf, 31, "%c", *( char *) data );
-                break;
-            case 2:
-                snprintf( buf, 31, "%d", ( int ) *(( short *) data ));
-                break;
-            case 4:
-                snprintf( buf, 31, "%d", *(( int *) data ));
-                break;
-            case 8:
-#if SIXTY_FOUR_BIT
-                snprintf( buf, 31, "%ld", *(( uint64_t *) data ));
-#else
-                snprintf( buf, 31, "%lld", *(( uint64_t *) data ));
-#endif
-                break;
-        }
+        return false;
+    }
+    gen.writeNetString( buf );
+    last->writeNetString( body );
+    buf.append( body );
+    if( 0 > ( sfd = open( tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 ) ) )
+    {
+        fprintf( stderr, "%s[%d]: Can't open \"%s\": %s\n", __FILE__, __LINE__, tmp.c_str(), strerror( errno ) );
+        return false;
+    }
+    if( ! pwriteAll( sfd, buf.data(), buf.size(), 0 ) || ( sync && fdatasync( sfd ) ) || close( sfd ) )
+    {
+        fprintf( stderr, "%s[%d]: Can't write \"%s\": %s\n", __FILE__, __LINE__, tmp.c_str(), strerror( errno ) );
+        unlink( tmp.c_str() );
+        return false;
+    }
+    if( rename( tmp.c_str(), path.c_str() ) )
+    {
+        perror( "rename" );
+        unlink( tmp.c_str() );
+        return false;
     }
-    return CppON::toNetString( buf, '#' );
+    if( sync )
+    {
+        syncDir( path );
+    }
+    generation++;
+    snapshotBytes = buf.size();
+    return resetJournal();
 }
 
-const char *COInteger::c_str()
+/****************************************************************************************/
+/*                                                                                      */
+/*                                      COHotReload                                     */
+/*                                                                                      */
+/****************************************************************************************/
+
+COHotReload::COHotReload()
 {
-    char buf[ 32 ];
+    nextId = 1;
+    events.resize( RELOAD_EVENT_BYTES );
+    if( 0 > ( fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) ) )
+    {
+        perror( "inotify_init1" );
+    }
+}
 
-    buf[ 31 ] = '\0';
-    if( data )
+COHotReload::~COHotReload()
+{
+    for( size_t i = 0; files.size() > i; i++ )
+    {
+        delete files[ i ].tree;
+    }
+    if( 0 <= fd )
     {
-        switch ( siz )
-        {
-            case sizeof( char ):
-                snprintf( buf, 31, "%c", *(char *) data );
-                break;
-            case sizeof( short ):
-                snprintf( buf, 31, "%d", ( int ) *(short *) data );
-                break;
-            case sizeof( int ):
-                snprintf( buf, 31, "%d", *(int *) data );
-                break;
-            default:
-#if SIXTY_FOUR_BIT
-                snprintf( buf, 31, "%ld", *(uint64_t *) data );
-#else
-                snprintf( buf, 31, "%lld", *(uint64_t *) data );
-#endif
-                break;
-        }
+        close( fd );
     }
-    str = buf;
-    return str.c_str();
 }
 
-void COInteger::dump( FILE *fp)
+/*
+ * Load a file and start watching it.  Its directory is what is watched, for the writes and renames that end an edit.
+ */
+COMap *COHotReload::watch( const char *file )
 {
-    if( data )
+    std::string f( file );
+    size_t      slash   = f.find_last_of( '/' );
+    std::string dir     = ( std::string::npos == slash ) ? "." : ( slash ) ? f.substr( 0, slash ) : "/";
+    CppON       *obj;
+    int         wd;
+
+    if( 0 > fd )
     {
-        switch ( siz )
-        {
-            case sizeof( char ):
-                fprintf( fp, "%c", *(char *) data );
-                break;
-            case sizeof( short ):
-                fprintf( fp, "%d", ( int ) *(short *) data );
-                break;
-            case sizeof( int ):
-                fprintf( fp, "%d", *(int *) data );
-                break;
-            default:
-#if SIXTY_FOUR_BIT
-                fprintf( fp, "%ld", *(uint64_t *) data );
-#else
-                fprintf( fp, "%lld", *(uint64_t *) data );
-#endif
-                break;
-        }
-    } else {
-        fprintf( fp, "NULL" );
+        return NULL;
+    } else if( ! CppON::isMap( obj = CppON::parseJsonFile( file ) ) ) {
+        fprintf( stderr, "%s[%d]: \"%s\" does not hold a JSON object\n", __FILE__, __LINE__, file );
+        delete obj;
+        return NULL;
+    } else if( 0 > ( wd = inotify_add_watch( fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO ) ) ) {
+        fprintf( stderr, "%s[%d]: Can't watch \"%s\": %s\n", __FILE__, __LINE__, dir.c_str(), strerror( errno ) );
+        delete obj;
+        return NULL;
     }
+    // cppcheck-suppress cstyleCast
+    files.push_back( Watched{ f, f.substr( ( std::string::npos == slash ) ? 0 : slash + 1 ), wd, (COMap *) obj } );
+    return files.back().tree;
 }
 
-void COInteger::cdump( FILE *fp )
+unsigned COHotReload::subscribe( const std::string &prefix, Listener fn )
 {
-    if( data )
+    subscribers.push_back( Subscriber{ nextId, prefix, fn } );
+    return nextId++;
+}
+
+void COHotReload::unsubscribe( unsigned id )
+{
+    for( std::vector<Subscriber>::iterator it = subscribers.begin(); subscribers.end() != it; ++it )
     {
-        switch ( siz )
+        if( id == it->id )
         {
-            case sizeof( char ):
-                fprintf( fp, "%c", *(char *) data );
-                break;
-            case sizeof( short ):
-                fprintf( fp, "%d", ( int ) *(short *) data );
-                break;
-            case sizeof( int ):
-                fprintf( fp, "%d", *(int *) data );
-                break;
-            default:
-#if SIXTY_FOUR_BIT
-                fprintf( fp, "%ld", *(uint64_t *) data );
-#else
-                fprintf( fp, "%lld", *(uint64_t *) data );
-#endif
-                break;
+            subscribers.erase( it );
+            break;
         }
-    } else {
-        fprintf( fp, "0" );
     }
 }
 
+void COHotReload::changed( const std::string &path, CppON *value )
+{
+    changes.push_back( std::pair<std::string, CppON *>( path, value ) );
+}
 
-uint64_t COInteger::doOperation( unsigned sz, uint64_t val, CppONOperator op )
+/*
+ * Bring live up to date with fresh, walking their (sorted) keys side by side.  What is moved into live is taken
+ * out of fresh and what is replaced is put into fresh, so deleting fresh afterwards frees exactly the old values.
+ * Live then takes fresh's key order, so added keys sit where the file has them and a reordered file is followed.
+ */
+void COHotReload::apply( COMap *live, COMap *fresh, std::string &path )
 {
-    int64_t rtn = 0;
+    std::map<std::string, CppON *>              *a      = live->value();
+    std::map<std::string, CppON *>              *b      = fresh->value();
+    std::map<std::string, CppON *>::iterator    ia      = a->begin();
+    std::map<std::string, CppON *>::iterator    ib      = b->begin();
+    size_t                                      len     = path.length();
 
-    switch( siz )
+    while( a->end() != ia || b->end() != ib )
     {
-        case 1:
-            switch( op )
-            {
-                case CPPON_ADD:
-                    if( unSigned )
-                    {
-                        *((uint8_t*) data ) += (uint8_t) val;
-                        rtn = (int64_t) *((uint8_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int8_t*) data ) + (int64_t) val;
-                        rtn = (-128>rtn )?-128:((127<rtn)?127:rtn);
-                        *((uint8_t *) data) = (uint8_t) rtn;
-                    }
-                    break;
-                case CPPON_SUBTRACT:
-                    if( unSigned )
-                    {
-                        *((uint8_t*) data ) -= (uint8_t) val;
-                        rtn = (int64_t) *((uint8_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int8_t*) data ) - (int64_t) val;
-                        rtn = (-128>rtn )?-128:((127<rtn)?127:rtn);
-                        *((uint8_t *) data) = (uint8_t) rtn;
-                    }
-                    break;
-                case CPPON_MULTIPLY:
-                    if( unSigned )
-                    {
-                        *((uint8_t*) data ) *= (uint8_t) val;
-                        rtn = (int64_t) *((uint8_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int8_t*) data ) * (int64_t) val;
-                        rtn = (-128>rtn )?-128:((127<rtn)?127:rtn);
-                        *((uint8_t *) data) = (uint8_t) rtn;
-                    }
-                    break;
-                case CPPON_DIVIDE:
-                    if( unSigned )
-                    {
-                        *((uint8_t*) data ) /= (uint8_t) val;
-                        rtn = (int64_t) *((uint8_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int8_t*) data ) / (int64_t) val;
-                        rtn = (-128>rtn )?-128:((127<rtn)?127:rtn);
-                        *((uint8_t *) data) = (uint8_t) rtn;
-                    }
-                    break;
-            }
-            break;
-        case 2:
-            switch( op )
-            {
-                case CPPON_ADD:
-                    if( unSigned )
-                    {
-                        *((uint16_t*) data ) += (uint16_t) val;
-                        rtn = (int64_t) *((uint16_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int16_t*) data ) + (int64_t) val;
-                        rtn = (-32768>rtn )?-32768:((32767<rtn)?32767:rtn);
-                        *((uint16_t *) data) = (uint16_t) rtn;
-                    }
-                    break;
-                case CPPON_SUBTRACT:
-                    if( unSigned )
-                    {
-                        *((uint16_t*) data ) -= (uint16_t) val;
-                        rtn = (int64_t) *((uint16_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int16_t*) data ) - (int64_t) val;
-                        rtn = (-32768>rtn )?-32768:((32767<rtn)?32767:rtn);
-                        *((uint16_t *) data) = (uint16_t) rtn;
-                    }
-                    break;
-                case CPPON_MULTIPLY:
-                    if( unSigned )
-                    {
-                        *((uint16_t*) data ) *= (uint16_t) val;
-                        rtn = (int64_t) *((uint16_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int16_t*) data ) * (int64_t) val;
-                        rtn = (-32768>rtn )?-32768:((32767<rtn)?32767:rtn);
-                        *((uint16_t *) data) = (uint16_t) rtn;
-                    }
-                    break;
-                case CPPON_DIVIDE:
-                    if( unSigned )
-                    {
-                        *((uint16_t*) data ) /= (uint16_t) val;
-                        rtn = (int64_t) *((uint16_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int16_t*) data ) / (int64_t) val;
-                        rtn = (-32768>rtn )?-32768:((32767<rtn)?32767:rtn);
-                        *((uint16_t *) data) = (uint16_t) rtn;
-                    }
-                    break;
-            }
-            break;
-        case 4:
-            switch( op )
-            {
-                case CPPON_ADD:
-                    if( unSigned )
-                    {
-                        *((uint32_t*) data ) += (uint32_t) val;
-                        rtn = (int64_t) *((uint32_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int32_t*) data ) + (int64_t) val;
-                        rtn = (-2147483648>rtn )?-2147483648:((0x7FFFFFFF<rtn)?0x7FFFFFFF:rtn);
-                        *((uint32_t *) data) = (uint32_t) rtn;
-                    }
-                    break;
-                case CPPON_SUBTRACT:
-                    if( unSigned )
-                    {
-                        *((uint32_t*) data ) -= (uint32_t) val;
-                        rtn = (int64_t) *((uint32_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int32_t*) data ) - (int64_t) val;
-                        rtn = (-2147483648>rtn )?-2147483648:((0x7FFFFFFF<rtn)?0x7FFFFFFF:rtn);
-                        *((uint32_t *) data) = (uint32_t) rtn;
-                    }
-                    break;
-                case CPPON_MULTIPLY:
-                    if( unSigned )
-                    {
-                        *((uint32_t*) data ) *= (uint32_t) val;
-                        rtn = (int64_t) *((uint32_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int32_t*) data ) * (int64_t) val;
-                        rtn = (-2147483648>rtn )?-2147483648:((0x7FFFFFFF<rtn)?0x7FFFFFFF:rtn);
-                        *((uint32_t *) data) = (uint32_t) rtn;
-                    }
-                    break;
-                case CPPON_DIVIDE:
-                    if( unSigned )
-                    {
-                        *((uint32_t*) data ) /= (uint32_t) val;
-                        rtn = (int64_t) *((uint32_t *) data );
-                    } else {
-                        rtn = (int64_t)*((int32_t*) data ) / (int64_t) val;
-                        rtn = (-2147483648>rtn )?-2147483648:((0x7FFFFFFF<rtn)?0x7FFFFFFF:rtn);
-                        *((uint32_t *) data) = (uint32_t) rtn;
-                    }
-                    break;
+        int     c   = ( a->end() == ia ) ? 1 : ( b->end() == ib ) ? -1 : ia->first.compare( ib->first );
+
+        path.resize( len );
+        if( len )
+        {
+            path.push_back( '/' );
+        }
+        if( 0 > c )                                                                         // Removed
+        {
+            std::string key = ia->first;
+
+            path.append( key );
+            ++ia;
+            mapRemoveKey( live, key );
+            changed( path, NULL );
+            continue;
+        } else if( 0 < c ) {                                                                // Added
+            CppON *v = ib->second;
+
+            path.append( ib->first );
+            ib->second = NULL;
+            mapSetKey( live, ib->first, v );
+            changed( path, v );
+            ++ib;
+            continue;
+        }
+
+        CppON       *x  = ia->second;
+        CppON       *y  = ib->second;
+        CppONType   t   = ( x && y && x->type() == y->type() ) ? x->type() : UNKNOWN_CPPON_OBJ_TYPE;
+
+        path.append( ia->first );
+        switch( t )
+        {
+            case MAP_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                apply( (COMap *) x, (COMap *) y, path );
+                break;
+            case INTEGER_CPPON_OBJ_TYPE:
+                if( x->toLongInt() != y->toLongInt() )
+                {
+                    // cppcheck-suppress cstyleCast
+                    *( (COInteger *) x ) = (long long) y->toLongInt();
+                    changed( path, x );
+                }
+                break;
+            case DOUBLE_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                if( ( (CODouble *) x )->doubleValue() != ( (CODouble *) y )->doubleValue() || ( (CODouble *) x )->Precision() != ( (CODouble *) y )->Precision() )
+                {
+                    // cppcheck-suppress cstyleCast
+                    ( (CODouble *) x )->set( ( (CODouble *) y )->doubleValue() );
+                    // cppcheck-suppress cstyleCast
+                    ( (CODouble *) x )->Precision( ( (CODouble *) y )->Precision() );
+                    changed( path, x );
+                }
+                break;
+            case STRING_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                if( *( (COString *) x )->value() != *( (COString *) y )->value() )
+                {
+                    // cppcheck-suppress cstyleCast
+                    ( (COString *) x )->value()->assign( *( (COString *) y )->value() );
+                    changed( path, x );
+                }
+                break;
+            case BOOLEAN_CPPON_OBJ_TYPE:
+                // cppcheck-suppress cstyleCast
+                if( ( (COBoolean *) x )->value() != ( (COBoolean *) y )->value() )
+                {
+                    // cppcheck-suppress cstyleCast
+                    *( (COBoolean *) x ) = ( (COBoolean *) y )->value();
+                    changed( path, x );
+                }
+                break;
+            case NULL_CPPON_OBJ_TYPE:
+                break;
+            default:                                                                        // Arrays and changed types are replaced
+                if( ! x || ! y || ! x->identical( y ) )
+                {
+                    ia->second = y;
+                    ib->second = x;
+                    changed( path, y );
+                }
+                break;
+        }
+        ++ia;
+        ++ib;
+    }
+    if( *live->getKeys() != *fresh->getKeys() )
+    {
+        *live->getKeys() = *fresh->getKeys();                                               // Same keys now, in the file's order
+    }
+    path.resize( len );
+}
+
+/*
+ * Re-read the file root was loaded from and apply it, then tell the subscribers what changed.
+ */
+int COHotReload::reload( COMap *root )
+{
+    std::vector<Subscriber> subs;
+    std::string             path;
+    CppON                   *fresh;
+    size_t                  i;
+
+    for( i = 0; files.size() > i && root != files[ i ].tree; i++ );
+    if( files.size() <= i )
+    {
+        return -1;
+    } else if( ! CppON::isMap( fresh = CppON::parseJsonFile( files[ i ].file.c_str() ) ) ) {
+        fprintf( stderr, "%s[%d]: Keeping the old \"%s\", the new one does not parse\n", __FILE__, __LINE__, files[ i ].file.c_str() );
+        delete fresh;
+        return -1;
+    }
+    changes.clear();
+    // cppcheck-suppress cstyleCast
+    apply( root, (COMap *) fresh, path );
+    delete fresh;
+
+    subs = subscribers;                                                                     // A listener may (un)subscribe
+    for( size_t c = 0; changes.size() > c; c++ )
+    {
+        const std::string &p = changes[ c ].first;
+
+        for( size_t s = 0; subs.size() > s; s++ )
+        {
+            const std::string &pre = subs[ s ].prefix;
+            size_t            n    = ( pre.length() < p.length() ) ? pre.length() : p.length();
+
+            if( ! p.compare( 0, n, pre, 0, n ) && ( pre.length() == p.length() || ! n || '/' == ( ( pre.length() < p.length() ) ? p[ n ] : pre[ n ] ) ) )
+            {
+                subs[ s ].fn( root, p, changes[ c ].second );
             }
-            break;
-        case 8:
-            switch( op )
+        }
+    }
+    return (int) changes.size();
+}
+
+/*
+ * Wait up to timeoutMs for edits, then reload every file that was written, each once however many events it had.
+ */
+int COHotReload::poll( int timeoutMs )
+{
+    struct pollfd       pfd     = { fd, POLLIN, 0 };
+    std::vector<size_t> hit;
+    int                 rtn     = 0;
+    ssize_t             len;
+
+    if( 0 > fd )
+    {
+        return -1;
+    } else if( 0 >= ::poll( &pfd, 1, timeoutMs ) ) {
+        return 0;
+    }
+    while( 0 < ( len = read( fd, &events[ 0 ], events.size() ) ) )
+    {
+        for( char *p = &events[ 0 ]; &events[ 0 ] + len > p; )
+        {
+            struct inotify_event *ev = (struct inotify_event *) p;
+
+            for( size_t i = 0; files.size() > i; i++ )
             {
-                case CPPON_ADD:
-                    if( unSigned )
-                    {
-                        *((uint64_t *) data ) += (uint64_t) val;
-                        rtn = *((uint64_t *) data );
-                    } else {
-                        *((int64_t *) data ) += (int64_t) val;
-                        rtn = *((int64_t *) data );
-                    }
-                    break;
-                case CPPON_SUBTRACT:
-                    if( unSigned )
-                    {
-                        *((uint64_t*) data ) -= (uint64_t) val;
-                        rtn = *((uint64_t*) data );
-                    } else {
-                        *((int64_t*) data ) -= (int64_t) val;
-                        rtn = *((int64_t*) data );
-                    }
-                    break;
-                case CPPON_MULTIPLY:
-                    if( unSigned )
-                    {
-                        *((uint64_t*) data ) *= (uint64_t) val;
-                        rtn = *((uint64_t*) data );
-                    } else {
-                        *((int64_t*) data ) *= (int64_t) val;
-                        rtn = *((int64_t*) data );
-                    }
-                    break;
-                case CPPON_DIVIDE:
-                    if( unSigned )
+                if( ( ev->mask & IN_Q_OVERFLOW ) || ( ev->len && ev->wd == files[ i ].wd && ! strcmp( ev->name, files[ i ].name.c_str() ) ) )
+                {
+                    if( hit.end() == std::find( hit.begin(), hit.end(), i ) )
                     {
-                        *((uint64_t*) data ) /= (uint64_t) val;
-                        rtn = *((uint64_t*) data );
-                    } else {
-                        *((int64_t*) data ) /= (int64_t) val;
-                        rtn = (int64_t) *((int64_t*) data );
+                        hit.push_back( i );
                     }
-                    break;
+                }
             }
-            break;
+            p += sizeof( struct inotify_event ) + ev->len;
+        }
     }
-    switch( sz )
+    for( size_t i = 0; hit.size() > i; i++ )
     {
-        case 1:
-            if( unSigned )
-            {
-                rtn = ( (uint64_t) rtn > 256 ) ? 256 : rtn;
-            } else {
-                rtn = ( rtn > 127 ) ? 127 : ( ( rtn < -128 ) ? -128 : rtn );
-            }
-            break;
-        case 2:
-            if( unSigned )
+        rtn += ( 0 <= reload( files[ hit[ i ] ].tree ) );
+    }
+    return rtn;
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*                                      COLayeredMap                                    */
+/*                                                                                      */
+/****************************************************************************************/
+
+COMap *COLayeredMap::pop()
+{
+    COMap   *rtn = NULL;
+
+    if( maps.size() )
+    {
+        rtn = maps.back();
+        maps.pop_back();
+    }
+    return rtn;
+}
+
+COMap *COLayeredMap::setLayer( size_t i, COMap *layer )
+{
+    COMap   *rtn = NULL;
+
+    if( maps.size() > i )
+    {
+        rtn = maps[ i ];
+        maps[ i ] = layer;
+    }
+    return rtn;
+}
+
+/*
+ * The effective value of one key.  If it is a merged Map the top one is returned and, when sub is given, every Map
+ * that shows through is put in it, bottom first.
+ */
+CppON *COLayeredMap::resolve( const std::string &key, std::vector<COMap *> *sub )
+{
+    CppON   *top    = NULL;
+
+    if( sub )
+    {
+        sub->clear();
+    }
+    for( size_t i = maps.size(); i--; )
+    {
+        std::map<std::string, CppON *>              *m  = ( maps[ i ] ) ? maps[ i ]->value() : NULL;
+        std::map<std::string, CppON *>::iterator    it;
+
+        if( ! m || m->end() == ( it = m->find( key ) ) || ! it->second )
+        {
+            continue;
+        } else if( ! CppON::isMap( it->second ) ) {
+            if( ! top )
             {
-                rtn = ( (uint64_t) rtn > 0xFFFF ) ? 0xFFFF : rtn;
-            } else {
-                rtn = ( rtn > 0x7FFF ) ? 0x7FFF : ( ( rtn < -0x8000 ) ? -0x8000 : rtn );
+                top = it->second;                                                           // A value that is not a Map hides everything below
             }
             break;
-        case 4:
-            if( unSigned )
+        }
+        if( ! top )
+        {
+            top = it->second;
+        }
+        if( sub )
+        {
+            // cppcheck-suppress cstyleCast
+            sub->push_back( (COMap *) it->second );
+        }
+    }
+    if( sub )
+    {
+        std::reverse( sub->begin(), sub->end() );
+    }
+    return top;
+}
+
+CppON *COLayeredMap::findElement( const char *path )
+{
+    const char  *slash  = ( path ) ? strchr( path, '/' ) : NULL;
+
+    if( ! path || ! *path )
+    {
+        return NULL;
+    } else if( ! slash ) {
+        return resolve( path, NULL );
+    }
+    return view( std::string( path, slash - path ).c_str() ).findElement( slash + 1 );
+}
+
+COLayeredMap COLayeredMap::view( const char *path )
+{
+    COLayeredMap    rtn;
+    const char      *p      = path;
+
+    rtn.maps = maps;
+    while( p && *p )
+    {
+        const char      *slash  = strchr( p, '/' );
+        std::string     key     = ( slash ) ? std::string( p, slash - p ) : std::string( p );
+        std::vector<COMap *> sub;
+
+        if( ! CppON::isMap( rtn.resolve( key, &sub ) ) )
+        {
+            sub.clear();                                                                    // Not a Map: nothing to see
+        }
+        rtn.maps.swap( sub );
+        p = ( slash ) ? slash + 1 : NULL;
+    }
+    return rtn;
+}
+
+std::vector<std::string> COLayeredMap::keys()
+{
+    std::vector<std::string>        rtn;
+    std::unordered_set<std::string> seen;
+
+    for( size_t i = 0; maps.size() > i; i++ )
+    {
+        std::vector<std::string>    *order  = ( maps[ i ] ) ? maps[ i ]->getKeys() : NULL;
+
+        for( size_t k = 0; order && order->size() > k; k++ )
+        {
+            if( seen.insert( ( *order )[ k ] ).second )
             {
-                rtn = ( (uint64_t) rtn > 0xFFFFFFFF ) ? 0xFFFFFFFF : rtn;
-            } else {
-                rtn = ( rtn > 0x7FFFFFFF ) ? 0x7FFFFFFF : ( ( rtn < -80000000 ) ? -0x80000000 : rtn );
+                rtn.push_back( ( *order )[ k ] );
             }
-            break;
-        default:
-            break;
+        }
     }
     return rtn;
 }
 
+COMap *COLayeredMap::flatten()
+{
+    COMap                       *rtn    = new COMap();
+    std::vector<std::string>    k       = keys();
+    std::vector<COMap *>        sub;
 
-bool COInteger::operator == ( COInteger &newObj ) {
-    /*
-     * If the sizes are equal then just compare them
-     */
-    if( siz == newObj.siz )
+    for( size_t i = 0; k.size() > i; i++ )
     {
-        return (
-                ( siz == sizeof( long long) ) ? *( (long long *) newObj.data ) == *( (long long *)data ) :
-                ( siz == sizeof( int ) )      ? *( (int *)       newObj.data ) == *( (int *)      data ) :
-                ( siz == sizeof( short ) )    ? *( (short *)     newObj.data ) == *( (short *)    data ) :
-                *( (char * )     newObj.data ) == *( (char *)     data ) );
-        /*
-         * Else convert them both to "long long" and compare them.
-         */
-    } else {
-        return     ( (siz == sizeof( long long ) ) ?                 *( (long long *)         data ) :
-                ( (siz == sizeof( int       ) ) ? ( long long )      *( (int *)               data ) :
-                ( (siz == sizeof( short     ) ) ? ( long long )      *( (short *)             data ) :
-                ( long long ) *( (char *)              data ) ) ) ) ==
-                ( (newObj.siz == sizeof( long long ) ) ?               *( (long long *)  newObj.data ) :
-                ( (newObj.siz == sizeof( int       ) ) ? ( long long ) *( (int *)        newObj.data ) :
-                ( (newObj.siz == sizeof( short     ) ) ? ( long long ) *( (short *)      newObj.data ) :
-                ( long long ) *( (char *)       newObj.data ) ) ) );
+        CppON   *v  = resolve( k[ i ], &sub );
+
+        if( 1 < sub.size() )
+        {
+            COLayeredMap    inner;
+
+            inner.maps.swap( sub );
+            mapSetKey( rtn, k[ i ], inner.flatten() );
+        } else if( v ) {
+            mapSetKey( rtn, k[ i ], CppON::factory( v ) );
+        }
     }
+    return rtn;
 }
 
-COInteger *COInteger::operator=(COInteger &val )
+/*
+ * Append the merged result to out.  A value that comes from one layer only, even a whole Map, is written by the
+ * ordinary writer straight from that layer.
+ */
+void COLayeredMap::write( std::string &out, bool net )
 {
-    if( siz != val.siz )
+    std::vector<std::string>    k       = keys();
+    std::vector<COMap *>        sub;
+    size_t                      mark    = out.size();
+    bool                        first   = true;
+
+    if( ! net )
     {
-        switch(siz)
+        out.push_back( '{' );
+    }
+    for( size_t i = 0; k.size() > i; i++ )
+    {
+        CppON   *v  = resolve( k[ i ], &sub );
+
+        if( ! v )
         {
-            case sizeof(int): delete (int*)data; break;
-            case sizeof(long long): delete (long long*)data; break;
-            case sizeof(short): delete (short*)data; break;
-            case sizeof(char): delete (char*)data; break;
+            continue;
         }
-        switch(siz=val.siz)
+        if( net )
         {
-            case sizeof(int): data=new int;break;
-            case sizeof(long long): data=new (long long); break;
-            case sizeof(short): data=new(short); break;
-            case sizeof(char): data=new(char); break;
+            CppON::appendNetString( out, k[ i ].data(), k[ i ].length(), ',' );
+        } else {
+            if( ! first )
+            {
+                out.push_back( ',' );
+            }
+            out.push_back( '"' );
+            out.append( k[ i ] );
+            out.append( "\":" );
+        }
+        first = false;
+        if( 1 < sub.size() )
+        {
+            COLayeredMap    inner;
+
+            inner.maps.swap( sub );
+            inner.write( out, net );
+        } else {
+            CppONWriter w( v, ( net ) ? CppONWriter::NET : CppONWriter::COMPACT, out, "" );
+
+            w.run();
         }
     }
-    switch(siz)
+    if( net )
     {
-        case sizeof(int): *((int*)data )=val.intValue(); break;
-        case sizeof(long long): *((long long*)data )=val.longValue(); break;
-        case sizeof(short): *((short*)data )=val.shortValue(); break;
-        case sizeof(char): *((char*)data )=val.charValue(); break;
+        char    buf[ 24 ];
+
+        out.insert( mark, buf, snprintf( buf, sizeof( buf ), "%zu:", out.size() - mark ) );
     }
-    return this;
+    out.push_back( '}' );
 }
 
-/****************************************************************************************/
-/*                                                                                        */
-/*                                        CONull                                            */
-/*                                                                                        */
-/****************************************************************************************/
-
-void CONull::dump( FILE *fp)
+void COLayeredMap::writeCompactJson( std::string &out )
 {
-    fprintf( fp, "NULL" );
+    out.clear();
+    write( out, false );
 }
-void CONull::cdump( FILE *fp )
+
+void COLayeredMap::writeNetString( std::string &out )
 {
-    fprintf( fp, "null" );
+    out.clear();
+    write( out, true );
 }
-string *CONull::toJsonString()
+
+std::string *COLayeredMap::toCompactJsonString()
 {
-    return new string("null");
+    std::string *rtn = new std::string();
+
+    write( *rtn, false );
+    return rtn;
 }
@@ -186,15 +186,26 @@
 
 #define HAS_XML 0
 #define SIXTY_FOUR_BIT 1
+#ifndef CPPON_RT_CHECK
+#define CPPON_RT_CHECK 0                                                                    // 1 to count/abort on allocations inside CppONRealTime sections
+#endif
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/types.h>
 #include <map>
 #include <iostream>
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <memory>
 #include <semaphore.h>
 
 #if HAS_XML
@@ -231,6 +242,104 @@ enum CppONOperator
     CPPON_DIVIDE
 };
 
+/*
+ * Results of a dedupe() pass.  "nodes" and "bytes" are the number of tree nodes and the approximate heap bytes
+ * that were freed because an identical copy of the subtree they belonged to is now shared.
+ */
+struct CppONDedupeStats
+{
+    size_t                                          subtrees;                                       // Duplicate subtrees replaced by a shared copy
+    size_t                                          nodes;                                          // Nodes freed
+    size_t                                          bytes;                                          // Approximate heap bytes freed
+                                                    CppONDedupeStats(){ subtrees = nodes = bytes = 0; }
+};
+
+/*
+ * Why a parse with CppONParseOptions failed.  offset is the position in the input where the problem was found.
+ */
+enum CppONParseErrorCode
+{
+    CPPON_PARSE_OK,
+    CPPON_PARSE_SYNTAX,                                                                             // Malformed input
+    CPPON_PARSE_TOO_MANY_BYTES,                                                                     // maxBytes exceeded
+    CPPON_PARSE_TOO_MANY_NODES,                                                                     // maxNodes exceeded
+    CPPON_PARSE_STRING_TOO_LONG,                                                                    // maxStringLength exceeded
+    CPPON_PARSE_CONTAINER_TOO_LARGE,                                                                // maxContainerSize exceeded
+    CPPON_PARSE_TOO_DEEP,                                                                           // maxDepth exceeded
+    CPPON_PARSE_SCHEMA                                                                              // The document does not match schema
+};
+
+struct CppONParseError
+{
+    CppONParseErrorCode                             code;
+    size_t                                          offset;
+    std::string                                     message;
+                                                    CppONParseError(){ code = CPPON_PARSE_OK; offset = 0; }
+};
+
+/*
+ * Options that can be handed to parseJson() and parseJsonFile() to change how a document is built.
+ *   dedupe           - After parsing share identical Map and Array subtrees (see CppON::dedupe()). The statistics
+ *                      are returned in dedupeStats.
+ *   maxBytes         - Limit on the (approximate) heap bytes the parsed tree may use.
+ *   maxNodes         - Limit on the number of objects created.
+ *   maxStringLength  - Limit on the length of any one string value or key.
+ *   maxContainerSize - Limit on the number of elements in any one Map or Array.
+ *   maxDepth         - Limit on how deeply Maps and Arrays may be nested.
+ *   lazyNumbers      - Keep JSON numbers as their source text and only convert them the first time their value is
+ *                      used.  Numbers whose value is never changed are written back out exactly as they were read.
+ *   schema           - Reject documents that do not pass this COSchema.  error.message names the first failure.
+ *   fileStrings      - parseJsonFile() only: string values of at least this many bytes that have no escapes are not
+ *                      read into memory but left in the mmap'd file as COFileStrings (see there).
+ * A limit of 0 means no limit.  The limits are checked as the tree is built, so a parse that exceeds one stops
+ * right there, frees everything built so far and returns NULL.  After every parse "error" tells what went wrong.
+ */
+class COSchema;
+struct COFileRegion;
+
+struct CppONParseOptions
+{
+    bool                                            dedupe;
+    CppONDedupeStats                                dedupeStats;
+    size_t                                          maxBytes;
+    size_t                                          maxNodes;
+    size_t                                          maxStringLength;
+    size_t                                          maxContainerSize;
+    unsigned                                        maxDepth;
+    bool                                            lazyNumbers;
+    const COSchema                                  *schema;
+    size_t                                          fileStrings;
+    CppONParseError                                 error;
+                                                    CppONParseOptions(){ dedupe = lazyNumbers = false; maxBytes = maxNodes = maxStringLength = maxContainerSize = fileStrings = 0; maxDepth = 0; schema = NULL; }
+};
+
+/*
+ * One message of a batch for CppON::parseBatch().  The bytes don't need to be NUL terminated.
+ */
+struct CppONSpan
+{
+    const char                                      *data;
+    size_t                                          len;
+                                                    CppONSpan( const char *d = NULL, size_t l = 0 ){ data = d; len = l; }
+};
+
+/*
+ * Marks the parts of a control loop that must not allocate.  After a warm-up cycle (strings reserved, output strings
+ * sized, one serialization done) assigning CODouble/COInteger/COBoolean values, assigning a COString within its
+ * capacity and writeCompactJson()/writeNetString() into a reused string do not allocate.  When the library is built
+ * with CPPON_RT_CHECK set it replaces the global operator new to count (or abort on) every allocation made on a
+ * thread while it is between enter() and leave().  Otherwise enter()/leave() cost next to nothing and nothing is counted.
+ */
+class CppONRealTime
+{
+public:
+    static  void                                    enter();                                        // Start a section that must not allocate
+    static  void                                    leave();
+    static  size_t                                  allocations();                                  // Allocations made in sections on this thread
+    static  void                                    resetAllocations();
+    static  void                                    abortOnAllocation( bool a );                    // abort() instead of counting
+};
+
 /*
  * This is the base class.  It is not meant to be instantiated directly.
  * However you can use the "factory" to create a copy of it if you don't know its derived class
@@ -259,6 +368,12 @@ enum CppONOperator
  * toNetString( const char *str, char styp );  can be used to create a TNet String from the data
  * dump( FILE *fp); can be used to write the whole contents to a file
  *
+ * dedupe() walks a tree and replaces Maps and Arrays that are structurally identical to one seen earlier with a
+ * reference to that first copy.  Shared nodes are reference counted so the tree can still be deleted normally,
+ * but they MUST be treated as read only: changing one changes every place it appears.  Use factory() to get a
+ * private copy of a shared node before modifying it, and never delete or extract a node for which isShared()
+ * returns true.
+ *
  * Other methods are available on the individual container classes and object classes to access and manipulate the data
  * As stated the root class is just there for accessing and moving the objects in a generic sense.
  *
@@ -267,18 +382,22 @@ class CppON
 {
 public:
                                                     CppON( CppON &jt );
-                                                    CppON(){ data = NULL; typ=UNKNOWN_CPPON_OBJ_TYPE; siz = 0; precision=-1; }
+                                                    CppON(){ data = NULL; typ=UNKNOWN_CPPON_OBJ_TYPE; siz = 0; precision=-1; refs = 0; lazy = raw = false; }
                                                     CppON( CppONType typ=UNKNOWN_CPPON_OBJ_TYPE );
                                                     CppON( CppON *jt = NULL );
     virtual                                         ~CppON();
     static  CppON                                   *factory( CppON &jt );
     static  CppON                                   *factory( CppON *jt ) { return factory( *jt ); }
             CppONType                               type(){ return typ;}
-    virtual int                                     size(){ return siz;}
+    virtual size_t                                  size(){ return siz;}
     virtual void                                    dump( FILE *fp = stderr );
     virtual void                                    cdump( FILE *fp = stderr );
     virtual std::string                             *toCompactJsonString();
-            void                                    *getData(){ return data; }
+            void                                    writeCompactJson( std::string &out );          // Replace out with compact JSON, reusing its capacity
+            void                                    writeNetString( std::string &out );            // Replace out with a TNetString, reusing its capacity
+            ssize_t                                 writeCompactJson( int fd );                     // Write compact JSON to fd, bytes written or -1
+            ssize_t                                 writeNetString( int fd );                       // Write a TNetString to fd, bytes written or -1
+            void                                    *getData(){ materialize(); raw = false; return data; }
             double                                  toDouble(void);
             long long                               toLongInt(void);
             int                                     toInt(void);
@@ -309,10 +428,26 @@ public:
     static  bool                                    isInteger( CppON *val ) { return ( val && INTEGER_CPPON_OBJ_TYPE == val->typ ); }
     static  bool                                    isDouble( CppON *val ) { return ( val && DOUBLE_CPPON_OBJ_TYPE == val->typ ); }
     static  bool                                    isObj( CppON *val ){ return ( val && INTEGER_CPPON_OBJ_TYPE <= val->typ && ARRAY_CPPON_OBJ_TYPE >= val->typ ); }
+    static  void                                    release( CppON *obj );                          // Drop one owner of a node, deleting it when it was the last
+    static  void                                    deleteAsync( CppON *obj );                      // release() in O(1), the freeing is done by reclaim()
+    static  size_t                                  reclaim( size_t maxNodes = 0 );                 // Free up to maxNodes (0: all) nodes queued by deleteAsync()
+    static  void                                    backgroundReclaim( bool on );                   // Run reclaim() on a thread of its own
+    static  size_t                                  reclaimPending();                               // Trees queued and not yet started on
+            bool                                    isShared() { return 0 < refs; }
+            bool                                    identical( CppON *obj );                        // Structural equality including key order and number sizes
+            uint64_t                                hash() { return hashTree( NULL, NULL ); }       // Structural hash, equal for identical() trees
+            size_t                                  memSize( size_t *nodes = NULL );                // Approximate heap bytes (and nodes) used by the tree
+            CppONDedupeStats                        dedupe();
+
+            template<typename F> void               visit( F &&f );                                 // Call f( path, node ) for every node, depth first
 
     static  CppON                                   *readObj( FILE *fp );
     static  CppON                                   *parse( const char *str, char **rstr );         // Create a CppON object from a net string
     static  CppON                                   *parseJson( const char *str );                  // Create a CppON object form a json string
+    static  CppON                                   *parseJson( const char *str, CppONParseOptions &opts );
+    static  CppON                                   *parseJson( const char *str, size_t len, CppONParseOptions &opts );   // TNetString lengths are kept within len
+    static  size_t                                  parseBatch( const std::vector<CppONSpan> &spans, std::vector<CppON *> &results, CppONParseOptions &opts, unsigned threads = 1 );
+    static  size_t                                  parseBatch( const std::vector<CppONSpan> &spans, std::vector<CppON *> &results ) { CppONParseOptions opts; return parseBatch( spans, results, opts ); }
     static  CppON                                   *GetTNetstring( const char **str );
     static  CppON                                   *GetObj( const char **str );
 
@@ -322,20 +457,29 @@ public:
     static  CppON                                   *parseCSV(const char *str );                    // parse a CSV file into  and array of arrays;
     static  CppON                                   *parseTSV(const char *str );                    // parse a TSV file into  and array of arrays;
     static  CppON                                   *parseJsonFile( const char *path );             // Read a file and create a CppON from it.
+    static  CppON                                   *parseJsonFile( const char *path, CppONParseOptions &opts );
     static  CppON                                   *guessDataType( const char *str );
+    static  void                                    appendNetString( std::string &out, const char *str, size_t len, char styp );   // Append "len:str" + styp to out
     static  unsigned char                           *findTNetStringArg( const char *arg, int argSize, const char *str, const char **next = NULL, int *cnt = NULL );
 private:
+    static  CppON                                   *parseJson( const char *str, const char *end, const std::shared_ptr<COFileRegion> *region, CppONParseOptions &opts );
             void                                    deleteData();
+            uint64_t                                hashTree( std::unordered_multimap< uint64_t, CppON *> *table, CppONDedupeStats *stats );
 protected:
     static    std::string                           *toNetString( const char *str, char styp );
+            void                                    materialize() { if( lazy ) parseRaw(); }       // Convert a lazy number's text or read a COFileString before using data
+            void                                    parseRaw();
 
             void                                    *data;                                            // This is an allocated pointer to the data
             CppONType                               typ;                                            // This is used to indicate the object type
-            int                                     siz;                                            // Either the size of the object as in 1,2 4, 8 bytes
+            size_t                                  siz;                                            // Either the size of the object as in 1,2 4, 8 bytes
             std::string                             str;                                            // Used when c_str called;
                                                                                             // or the number of elements in the list.
             std::vector<std::string>                order;                                            // only used for Map.  Order in which keys appear
             char                                    precision;                                        // precision to be used for double numbers
+            unsigned                                refs;                                             // Extra owners of a shared node (see dedupe())
+            bool                                    lazy;                                             // Number whose text in str has not been converted yet, or COFileString not read
+            bool                                    raw;                                              // str holds the number's unchanged source text
 };
 
 /*
@@ -363,18 +507,20 @@ public:
             bool                                    operator != ( COInteger &newObj ) { return( ! ( *this == newObj ) );}
                                                     // cppcheck-suppress constParameter
             bool                                    operator != ( COInteger *newObj ){ return( ! ( *this == *newObj ) );}
-            template<typename T> T                  operator = (const T t ) { if( data ) delete( ( T* ) data ); data = new ( T ); *(( T *) data ) = t; siz = sizeof( T ); return t; }
+            template<typename T> T                  operator = (const T t ) { if( !data || sizeof( T ) != siz ) { if( data ) delete( ( T* ) data ); data = new ( T ); siz = sizeof( T ); } *(( T *) data ) = t; lazy = raw = false; return t; }
             template<typename T> T                  operator += ( const T t){ return ( T ) doOperation( sizeof( T ), (uint64_t) t, CPPON_ADD ); }
             template<typename T> T                  operator -= ( const T t){ return ( T ) doOperation( sizeof( T ), (uint64_t) t, CPPON_SUBTRACT ); }
             template<typename T> T                  operator *= ( const T t){ return ( T ) doOperation( sizeof( T ), (uint64_t) t, CPPON_MULTIPLY ); }
             template<typename T> T                  operator /= ( const T t){ return ( T ) doOperation( sizeof( T ), (uint64_t) t, CPPON_DIVIDE ); }
-            int                                     size() override { return ( data ) ? siz : 0;}                                                                                        // return the 1 if it is defined
+            size_t                                  size() override { return ( data ) ? siz : 0;}                                                                                        // return the 1 if it is defined
             int64_t                                 longValue();                                                                                                                        // get the long long value of the object
             int8_t                                  charValue(){int64_t l=longValue();if(l<-128){return -128;}else if(l>127){return 127;}return(int8_t)l;}                                 // get the long long value of the object
             int16_t                                 shortValue(){int64_t l=longValue();if(l<-32768){return -32768;}else if(l>32767){return 32767;}return(int16_t)l;}                       // get the long long value of the object
             int32_t                                 intValue(){int64_t l=longValue();if(l<-2147483648){return -2147483648;}else if(l>0x7FFFFFFF){return 0x7FFFFFFF;}return(int32_t)l;}    // get the long long value of the object
             std::string                             *toNetString();                                                                                                                     // convert to net string format
             std::string                             *toJsonString();                                                                                                                    // convert to json string format
+            void                                    appendJson( std::string &out );                                                                                                     // append the json text to out
+            void                                    appendNetString( std::string &out );                                                                                                // append the net string to out
             void                                    dump( FILE *fp = stderr ) override ;
             void                                    cdump( FILE *fp = stderr ) override ;
             const char                              *c_str();
@@ -404,8 +550,8 @@ public:
                                                     CODouble( CODouble *dt = NULL );
                                                     CODouble( double d = 0.0 ) : CppON( DOUBLE_CPPON_OBJ_TYPE ) { precision=10; data = new (double); *((double*) data) = d; siz = sizeof(double);}
             unsigned char                           Precision() { return precision; }
-            unsigned char                           Precision( unsigned char p ){ precision = p; return precision;}
-            bool                                    operator == ( CODouble &newObj ) { return(  *( (double *)newObj.data) == *( (double *) data) ); }
+            unsigned char                           Precision( unsigned char p ){ if( p != precision ) { materialize(); raw = false; } precision = p; return precision;}
+            bool                                    operator == ( CODouble &newObj ) { materialize(); newObj.materialize(); return(  *( (double *)newObj.data) == *( (double *) data) ); }
                                                     // cppcheck-suppress constParameter
             bool                                    operator == ( CODouble *newObj ) { return(   ( *this == *newObj ) ); }
                                                     // cppcheck-suppress constParameter
@@ -416,18 +562,20 @@ public:
             CODouble                                *operator = ( CODouble &val );
                                                     // cppcheck-suppress constParameter
             CODouble                                *operator = ( CODouble *val ) { return( *this = *val ); }
-            template<typename T> double             operator += ( T val ) { if( data ) { *( ( double *) data ) += (double) val; return *((double *) data );} return UD_DOUBLE; }
-            template<typename T> double             operator -= ( T val ) { if( data ) { *( ( double *) data ) -= (double) val; return *((double *) data );} return UD_DOUBLE; }
-            template<typename T> double             operator *= ( T val ) { if( data ) { *( ( double *) data ) *= (double) val; return *((double *) data );} return UD_DOUBLE; }
-            template<typename T> double             operator /= ( T val ) { if( data ) { *( ( double *) data ) /= (double) val; return *((double *) data );} return UD_DOUBLE; }
-
-            int                                     size() override { return ( data ) ? siz : 0; }
-            double                                  value(){ return ( data ) ? *( double *) data : 0.0; }
-            double                                  doubleValue() { return ( data ) ? *( double *) data : 0.0; }
-            void                                    set( const double &d ){ *((double*) data) = d; }
-            float                                   floatValue(){ if( data ) return ( float ) *( ( double *) data ); return 0.0; }
+            template<typename T> double             operator += ( T val ) { if( data ) { materialize(); raw = false; *( ( double *) data ) += (double) val; return *((double *) data );} return UD_DOUBLE; }
+            template<typename T> double             operator -= ( T val ) { if( data ) { materialize(); raw = false; *( ( double *) data ) -= (double) val; return *((double *) data );} return UD_DOUBLE; }
+            template<typename T> double             operator *= ( T val ) { if( data ) { materialize(); raw = false; *( ( double *) data ) *= (double) val; return *((double *) data );} return UD_DOUBLE; }
+            template<typename T> double             operator /= ( T val ) { if( data ) { materialize(); raw = false; *( ( double *) data ) /= (double) val; return *((double *) data );} return UD_DOUBLE; }
+
+            size_t                                  size() override { return ( data ) ? siz : 0; }
+            double                                  value(){ materialize(); return ( data ) ? *( double *) data : 0.0; }
+            double                                  doubleValue() { materialize(); return ( data ) ? *( double *) data : 0.0; }
+            void                                    set( const double &d ){ *((double*) data) = d; lazy = raw = false; }
+            float                                   floatValue(){ materialize(); if( data ) return ( float ) *( ( double *) data ); return 0.0; }
             std::string                             *toNetString();                      // convert to net string format
             std::string                             *toJsonString();                     // convert to json string format
+            void                                    appendJson( std::string &out );      // append the json text to out
+            void                                    appendNetString( std::string &out ); // append the net string to out
             const char                              *c_str();
             void                                    dump( FILE *fp = stderr ) override ;
             void                                    cdump( FILE *fp = stderr ) override ;
@@ -442,7 +590,7 @@ public:
                                                     CONull( CONull *nt ) : CppON( NULL_CPPON_OBJ_TYPE ){}
                                                     CONull( ) : CppON( NULL_CPPON_OBJ_TYPE ){}
 
-            int                                     size() override { return 0; }
+            size_t                                  size() override { return 0; }
             void                                    *value(){ return NULL; }
             std::string                             *toNetString() { return new std::string( "0:~" ); }
             std::string                             *toJsonString();
@@ -463,7 +611,7 @@ public:
                                                     COBoolean( COBoolean &bt ): CppON( BOOLEAN_CPPON_OBJ_TYPE ){ if( !data ) { data = new( bool ); } *( ( bool *) data) = bt.value(); siz = sizeof( bool ); }
                                                     COBoolean( COBoolean *bt = NULL ): CppON( BOOLEAN_CPPON_OBJ_TYPE ){ if( !data ) { data = new( bool ); } *( ( bool *) data) = bt->value(); siz = sizeof( bool ); }
                                                     COBoolean( bool v = false ) : CppON( BOOLEAN_CPPON_OBJ_TYPE ){ if( !data ) { data = new( bool ); } *( ( bool *) data) = v; siz = sizeof( bool ); }
-            int                                     size() override { return ( data ) ? sizeof( bool ) : 0; }
+            size_t                                  size() override { return ( data ) ? sizeof( bool ) : 0; }
             bool                                    value(){ return ( ( data ) ? ( ( *( ( bool *) data ) ) ? true : false ) : false ); }
             std::string                             *toNetString();                      // convert to net string format
             std::string                             *toJsonString();                      // convert to json string format
@@ -493,37 +641,65 @@ public:
                                                     COString( std::string st = std::string("") );
                                                     COString( uint64_t val, bool hex = true );
                                                     COString( uint32_t val, bool hex = true );
-    static  char                                    *base64Decode( const char *tmp, unsigned int sz, unsigned int &len, char *out = NULL );
-            COString                                *append( std::string &val ) { if( data ) ( ( std::string *) data)->append( val ); else data = new std::string( val );  return this; }
-            COString                                *append( const char *val ) { if( data ) ( ( std::string *) data)->append( val ); else data = new std::string( val );  return this; }
-            COString                                *operator += ( const char *val ) { if( data ) ((std::string *) data)->append( val ); else data = new std::string( val );  return this; }
-            COString                                *operator += ( std::string &val ) { if( data ) ((std::string *) data)->append( val ); else data = new std::string( val ); return this; }
-            COString                                *operator = ( const char *val ) { if( data ) delete((std::string*) data ); data = new std::string( val ); return this; }
-            COString                                *operator = ( std::string &val) { if( data ) delete((std::string*) data ); data = new std::string( val.c_str() ); return this; }
-            COString                                *operator = ( COString &val) { if( data ) delete((std::string*) data ); data = new std::string( val.c_str() ); return this; }
+    static  char                                    *base64Decode( const char *tmp, size_t sz, size_t &len, char *out = NULL );
+            COString                                *append( std::string &val ) { materialize(); if( data ) ( ( std::string *) data)->append( val ); else data = new std::string( val );  return this; }
+            COString                                *append( const char *val ) { materialize(); if( data ) ( ( std::string *) data)->append( val ); else data = new std::string( val );  return this; }
+            COString                                *operator += ( const char *val ) { materialize(); if( data ) ((std::string *) data)->append( val ); else data = new std::string( val );  return this; }
+            COString                                *operator += ( std::string &val ) { materialize(); if( data ) ((std::string *) data)->append( val ); else data = new std::string( val ); return this; }
+            COString                                *operator = ( const char *val ) { materialize(); if( data ) ((std::string*) data )->assign( val ); else data = new std::string( val ); return this; }
+            COString                                *operator = ( std::string &val) { materialize(); if( data ) ((std::string*) data )->assign( val.c_str() ); else data = new std::string( val.c_str() ); return this; }
+            COString                                *operator = ( COString &val) { if( this != &val ) *this = val.c_str(); return this; }
                                                     // cppcheck-suppress constParameter
             COString                                *operator = ( COString *val) { return( *this = *val ); }
             COString                                *operator = ( uint64_t val );
             COString                                *operator = ( uint32_t val );
             COString                                *operator = ( int val );
-            bool                                    operator == ( COString &newObj ) { return ( ! ( ( std::string *) data )->compare( ( ( std::string *)newObj.data)->c_str( ) ) ); }
+            bool                                    operator == ( COString &newObj ) { materialize(); newObj.materialize(); return ( ! ( ( std::string *) data )->compare( ( ( std::string *)newObj.data)->c_str( ) ) ); }
                                                     // cppcheck-suppress constParameter
             bool                                    operator == ( COString *newObj ) { return ( *this == *newObj ); }
-            bool                                    operator != ( COString &newObj ) { return (   ( ( std::string *) data )->compare( ( ( std::string *)newObj.data)->c_str( ) ) ); }
+            bool                                    operator != ( COString &newObj ) { materialize(); newObj.materialize(); return (   ( ( std::string *) data )->compare( ( ( std::string *)newObj.data)->c_str( ) ) ); }
                                                     // cppcheck-suppress constParameter
             bool                                    operator != ( COString *newObj ) { return ( *this != *newObj ); }
 
-            int                                     size() override { return ( ( data != NULL ) ? ( ( std::string * ) data )->length() : 0 ); }
+            size_t                                  size() override { return ( lazy ) ? siz : ( ( data != NULL ) ? ( ( std::string * ) data )->length() : 0 ); }
+            void                                    reserve( size_t n ) { materialize(); if( !data ) data = new std::string(); ((std::string *) data )->reserve( n ); }     // So later assignments up to n bytes don't allocate
 
-            const char                              *c_str(){ return ( (std::string *) data )->c_str(); }
-            std::string                             *value(){ return ( data != NULL )? ( std::string * ) data : NULL; }
+            const char                              *c_str(){ materialize(); return ( (std::string *) data )->c_str(); }
+            std::string                             *value(){ materialize(); return ( data != NULL )? ( std::string * ) data : NULL; }
+            bool                                    inFile() { return lazy; }                       // A COFileString not read yet
             std::string                             *toString();
             std::string                             *toNetString();                                                              // convert to net string format
             std::string                             *toJsonString();                                                            // convert to JSON string format
-    static  std::string                             *toBase64JsonString( const char *cPtr, unsigned int len );                    // convert to base64 encoded JSON string
-            std::string                             *toBase64JsonString(){ return toBase64JsonString( ( ( std::string *) data )->c_str(), ( ( std::string *) data )->length() ); }
+            void                                    appendJson( std::string &out );                                             // append the JSON text to out
+            void                                    appendNetString( std::string &out );                                        // append the net string to out
+    static  std::string                             *toBase64JsonString( const char *cPtr, size_t len );                          // convert to base64 encoded JSON string
+            std::string                             *toBase64JsonString(){ materialize(); return toBase64JsonString( ( ( std::string *) data )->c_str(), ( ( std::string *) data )->length() ); }
             void                                    dump( FILE *fp = stderr ) override ;
             void                                    cdump( FILE *fp = stderr ) override ;
+protected:
+                                                    explicit COString( CppONType t ) : CppON( t ) {}   // No value yet
+};
+
+/*
+ * A string value left in the file it was parsed from (see CppONParseOptions::fileStrings).  It is a COString whose
+ * bytes are read into the usual std::string only the first time something asks for them.  Until then size() does
+ * not read them, the writers take them straight from the mapping and writeCompactJson( fd )/writeNetString( fd )
+ * copy them from file to file with copy_file_range() or sendfile(), so a large blob never has to be in the heap.
+ * Copies made by factory() or by copying the Map or Array it is in share the file.  The mapping stays open for as
+ * long as any COFileString refers to it, and the file must not be changed while one does.
+ */
+class COFileString : public COString
+{
+public:
+                                                    COFileString( const std::shared_ptr<COFileRegion> &r, size_t off, size_t len );
+                                                    COFileString( COFileString &fs );
+            const char                              *bytes();                                       // Where the value is in the mapping, NULL once read
+            int                                     fileDescriptor();                               // The open source file, -1 once read
+            size_t                                  fileOffset() { return offset; }
+            void                                    load();                                         // Read the value in and let go of the file
+private:
+            std::shared_ptr<COFileRegion>           region;
+            size_t                                  offset;                                         // Of the value in the file
 };
 
 
@@ -539,7 +715,7 @@ public:
                                                     COMap( ) : CppON(  MAP_CPPON_OBJ_TYPE ) { data = new std::map<std::string, CppON*>(); }
                                                     // cppcheck-suppress noExplicitConstructor
                                                     COMap( std::map < std::string, CppON *> &m ) : CppON( MAP_CPPON_OBJ_TYPE ){ data = new std::map<std::string, CppON *>( m ); }
-            int                                     size() override { return ( data ) ? ((std::map< std::string, CppON*> *) data)->size() : 0; }
+            size_t                                  size() override { return ( data ) ? ((std::map< std::string, CppON*> *) data)->size() : 0; }
 
             std::map<std::string,CppON*>::iterator  begin() { return ((std::map< std::string, CppON*> *) data)->begin(); }
             std::map<std::string,CppON*>::iterator  end() { return ((std::map< std::string, CppON*> *) data)->end(); }
@@ -592,11 +768,18 @@ public:
             COMap                                   *diff( COMap &newObj, const char *name = NULL);
             void                                    upDate( COMap *map, const char *name );
             void                                    merge( COMap *map, const char *name );
+    static  COMap                                   *mergeAll( std::vector<COMap *> &docs, const char *keyField = NULL, unsigned threads = 0 );
 private:
             void                                    doParse( const char *str );
             void                                    parseData( const char *str );
 };
 
+/*
+ * The Array keeps its elements in a std::vector.  So it can also be used as a FIFO queue, pop_front() does not
+ * erase from the front of the vector; it clears the slot and moves a head index forward.  The dead slots are
+ * dropped all at once when they make up half the vector, when the queue empties or when value() hands out the
+ * vector, which keeps push()/pop_front() O(1) amortized.  Indexing, iteration and serialization all start at the head.
+ */
 class COArray : public CppON
 {
 public:
@@ -608,16 +791,16 @@ public:
                                                     // cppcheck-suppress noExplicitConstructor
                                                     COArray( const char *path, const char *file );
                                                     // cppcheck-suppress noExplicitConstructor
-                                                    COArray( ) : CppON( ARRAY_CPPON_OBJ_TYPE ) { data = new std::vector<CppON *>(); }
+                                                    COArray( ) : CppON( ARRAY_CPPON_OBJ_TYPE ) { data = new std::vector<CppON *>(); head = 0; }
                                                     // cppcheck-suppress noExplicitConstructor
-                                                    COArray( std::vector<CppON *> &v ) : CppON( ARRAY_CPPON_OBJ_TYPE ){ data = new std::vector<CppON *>( v ); }
-            int                                     size() override { return ( data ) ? (( std::vector<CppON *> *) data)->size() : 0; }
-            std::vector< CppON *>                   *value() { return ( data ) ? ( std::vector< CppON *> *) data : NULL; }
-            std::vector< CppON* >::iterator         begin() { return ((std::vector< CppON*> *) data)->begin(); }
+                                                    COArray( std::vector<CppON *> &v ) : CppON( ARRAY_CPPON_OBJ_TYPE ){ data = new std::vector<CppON *>( v ); head = 0; }
+            size_t                                  size() override { return ( data ) ? (( std::vector<CppON *> *) data)->size() - head : 0; }
+            std::vector< CppON *>                   *value() { compact(); return ( data ) ? ( std::vector< CppON *> *) data : NULL; }
+            std::vector< CppON* >::iterator         begin() { return ((std::vector< CppON*> *) data)->begin() + head; }
             std::vector< CppON* >::iterator         end() { return ((std::vector< CppON*> *) data)->end(); }
 
             std::string                             *toNetString();
-            bool                                    replace( size_t i, CppON *n){ std::vector<CppON *> *v = (std::vector< CppON *> *) data; if( v->size() > i ) { delete( (*v)[ i ] ); (*v)[ i ] = n; return true;} return false; }
+            bool                                    replace( size_t i, CppON *n){ std::vector<CppON *> *v = (std::vector< CppON *> *) data; if( v->size() - head > i ) { release( (*v)[ head + i ] ); (*v)[ head + i ] = n; return true;} return false; }
             bool                                    operator == ( COArray &val );
                                                     // cppcheck-suppress constParameter
             bool                                    operator == ( COArray *val ){ return( *this == *val ); }
@@ -628,6 +811,7 @@ public:
             COArray                                 *operator = ( COArray &val );
                                                     // cppcheck-suppress constParameter
             COArray                                 *operator = ( COArray *val ){ return( *this = *val ); }
+            CppON                                   *operator = ( CppON &val ) override { head = 0; return CppON::operator = ( val ); }
             CppON                                   *remove( size_t idx );
             void                                    append( CppON *n ) { ( (std::vector < CppON *> *) data)->push_back( n ); }
             void                                    append( std::string value ){ append( new COString( value ) ); }
@@ -636,17 +820,18 @@ public:
             void                                    append( int value ){ append( new COInteger( value ) ); }
             void                                    append( bool value ) { append( new COBoolean( value ) ); }
             void                                    push_back( CppON *n ){ ( (std::vector < CppON *> *) data)->push_back( n ); }
-            CppON                                   *pop( ){ return remove( size() - 1 ); }
-            CppON                                   *pop_front(){ return remove( 0 ); }
+            CppON                                   *pop( ){ return ( size() ) ? remove( size() - 1 ) : NULL; }
+            CppON                                   *pop_front();                                   // O(1), see above
+            void                                    push_front( CppON *n );                         // O(1) after a pop_front()
             void                                    push( CppON *n) { append( n ); }
             void                                    clear();
-            CppON                                   *at( unsigned int i )
+            CppON                                   *at( size_t i )
                                                     {
-                                                        if( ! data || ((std::vector < CppON *> *) data)->size() <= i )
+                                                        if( ! data || ((std::vector < CppON *> *) data)->size() - head <= i )
                                                         {
                                                             return NULL;
                                                         }
-                                                        return ((std::vector < CppON *> *) data)->at( i );
+                                                        return ((std::vector < CppON *> *) data)->at( head + i );
                                                     }
             std::string                             *toJsonString( std::string &indent );
             std::string                             *toJsonString(){ std::string indent(""); return toJsonString( indent ); }
@@ -657,8 +842,673 @@ public:
             void                                    dump( FILE *fp = stderr ) override { std::string indent; dump( indent, fp ); }
             void                                    cdump( FILE *fp = stderr ) override ;
             COArray                                 *diff( COArray &newObj, const char *name = NULL);
+            COArray                                 *diffEdits( COArray &newObj );                  // Shortest edit script to newObj, NULL if identical
+            int                                     applyEdits( COArray &edits );                   // Apply a diffEdits() script in place
 private:
             void                                    parseData( const char *str );
+            void                                    compact();
+            size_t                                  head;                                           // Index of the first element in the vector
 };
 
+#define COCMAP_SHARDS 64
+
+/*
+ * A map that many threads can write at once.  Keys are spread over COCMAP_SHARDS shards, each with its own lock,
+ * so threads only wait for each other when they use keys in the same shard.  add() changes a COInteger or
+ * CODouble counter under that lock, creating it at 0 when it is missing.  A counter keeps its type: a double delta
+ * added to a COInteger is truncated toward zero first, so count fractions in a CODouble.  Keys are taken as they
+ * are ("a/b" is one key, not a path).  The values belong to the map: a pointer from findElement() stays valid until
+ * the key is replaced or removed, but to read or change a value other threads may be writing use update(), which
+ * runs a function under the key's lock, or findCopy().  snapshot() holds every shard lock at once and copies the
+ * whole map, in the order the keys were added, into a plain COMap that can be serialized.
+ */
+class COConcurrentMap
+{
+public:
+                                                    COConcurrentMap() : seq( 0 ), count( 0 ) {}
+                                                    COConcurrentMap( const COConcurrentMap & ) = delete;
+                                                    ~COConcurrentMap();
+            size_t                                  size() { return count.load( std::memory_order_relaxed ); }
+            int                                     append( const std::string &key, CppON *n );      // Replace or add; the map owns n
+            int                                     append( const std::string &key, std::string value ){ return append( key, new COString( value ) ); }
+            int                                     append( const std::string &key, const char *value ){ return append( key, new COString( value ) ); }
+            int                                     append( const std::string &key, double value ){ return append( key, new CODouble( value ) ); }
+            int                                     append( const std::string &key, int64_t value ){ return append( key, new COInteger( value ) ); }
+            int                                     append( const std::string &key, int value ){ return append( key, new COInteger( value ) ); }
+            int                                     append( const std::string &key, bool value ){ return append( key, new COBoolean( value ) ); }
+            int64_t                                 add( const std::string &key, int64_t delta );
+            int64_t                                 add( const std::string &key, int delta ){ return add( key, (int64_t) delta ); }
+            int64_t                                 add( const std::string &key, unsigned delta ){ return add( key, (int64_t) delta ); }
+            int64_t                                 add( const std::string &key, uint64_t delta ){ return add( key, (int64_t) delta ); }
+            double                                  add( const std::string &key, double delta );      // Truncated toward 0 on a COInteger
+            CppON                                   *findElement( const std::string &key );
+            CppON                                   *findElement( const char *key ) { return findElement( std::string( key ) ); }
+            CppON                                   *findCopy( const std::string &key );              // A copy the caller deletes, or NULL
+            template<typename F> bool               update( const std::string &key, F &&f );        // f( CppON * ) under the key's lock
+            void                                    removeVal( const std::string &key );            // Remove and free the value
+            COMap                                   *snapshot();
+            std::string                             *toCompactJsonString();
+            std::string                             *toJsonString();
+private:
+    struct Entry
+    {
+        CppON                                       *obj;
+        uint64_t                                    seq;                                            // When the key was added, for snapshot order
+    };
+    struct alignas( 64 ) Shard
+    {
+        std::mutex                                  lock;
+        std::unordered_map<std::string, Entry>      map;
+    };
+            Shard                                   &shard( const std::string &key ) { return shards[ std::hash<std::string>()( key ) % COCMAP_SHARDS ]; }
+
+            Shard                                   shards[ COCMAP_SHARDS ];
+            std::atomic<uint64_t>                   seq;
+            std::atomic<size_t>                     count;
+};
+
+template<typename F> bool COConcurrentMap::update( const std::string &key, F &&f )
+{
+    Shard                       &s = shard( key );
+    std::lock_guard<std::mutex> lock( s.lock );
+    auto                        it = s.map.find( key );
+
+    if( s.map.end() == it )
+    {
+        return false;
+    }
+    f( it->second.obj );
+    return true;
+}
+
+/*
+ * A bounded queue that hands whole trees from one thread to another without serializing them.  Any number of
+ * threads may push and pop (it is the bounded MPMC ring by Dmitry Vyukov: one compare-and-swap per message and no
+ * locks).  The try* calls never wait.  push()/pop() wait while the channel is full/empty for at most timeoutMs
+ * milliseconds (-1: no limit), which is what gives a fast producer backpressure; waiting threads sleep on a
+ * semaphore that is only posted when someone waits.  A pushed tree belongs to the channel until it is popped;
+ * a push that fails leaves it with the caller.  close() wakes everybody: pushes then fail and pops return what
+ * is left and then NULL.  Trees still queued when the channel is destroyed are released.
+ */
+class COChannel
+{
+public:
+    explicit                                        COChannel( size_t capacity );                   // Rounded up to a power of 2
+                                                    COChannel( const COChannel & ) = delete;
+                                                    ~COChannel();
+            bool                                    tryPush( CppON *obj );
+            CppON                                   *tryPop();
+            size_t                                  tryPushBatch( CppON **objs, size_t n );         // Pushes objs[ 0 .. rtn - 1 ]
+            size_t                                  tryPopBatch( CppON **objs, size_t max );
+            bool                                    push( CppON *obj, int timeoutMs = -1 );
+            CppON                                   *pop( int timeoutMs = -1 );
+            size_t                                  pushBatch( CppON **objs, size_t n, int timeoutMs = -1 );   // All n unless closed or timed out
+            size_t                                  popBatch( CppON **objs, size_t max, int timeoutMs = -1 );  // Waits for at least one
+            void                                    close();
+            bool                                    closed() { return isClosed.load(); }
+            size_t                                  capacity() { return mask + 1; }
+            size_t                                  size();                                         // Approximate while others are busy
+private:
+    struct Cell
+    {
+        std::atomic<size_t>                         seq;
+        CppON                                       *obj;
+    };
+            bool                                    wait( sem_t *sem, std::atomic<int> &waiters, int timeoutMs, bool forPush );
+            void                                    wake( sem_t *sem, std::atomic<int> &waiters );
+
+            Cell                                    *cells;
+            size_t                                  mask;
+    alignas( 64 ) std::atomic<size_t>               head;                                           // Next slot to push into
+    alignas( 64 ) std::atomic<size_t>               tail;                                           // Next slot to pop from
+    alignas( 64 ) std::atomic<bool>                 isClosed;
+            std::atomic<int>                        popWaiters;
+            std::atomic<int>                        pushWaiters;
+            sem_t                                   notEmpty;
+            sem_t                                   notFull;
+};
+
+/*
+ * Non-recursive depth first walk of a tree.  Each call to next() moves to the next event: every node is entered
+ * once and every Map or Array is also left once, after all of its children.  Along with the node the iterator
+ * tells its path from the root ("a/b/3/c", "" for the root), its key in its parent Map (or NULL), its index in its
+ * parent and its depth.  The path and the stack are reused from step to step, so walking does not allocate once
+ * they have grown to the depth of the tree.  Maps are walked in key order.  The tree must not change during a walk.
+ *
+ *     CppONIterator it( root );
+ *     while( it.next() ) { if( ! it.leaving() ) printf( "%s\n", it.path().c_str() ); }
+ */
+class CppONIterator
+{
+public:
+                                                    CppONIterator( CppON *root = NULL, bool paths = true ) { trackPath = paths; reset( root ); }
+            void                                    reset( CppON *root );
+            bool                                    next();                                         // false once the walk is done
+            CppON                                   *node() { return cur; }
+            bool                                    leaving() { return isLeaving; }                 // This event closes a Map or Array
+            const std::string                       &path() { return curPath; }                      // Empty if built with paths false
+            const std::string                       *key() { return curKey; }                       // Key in the parent Map or NULL
+            size_t                                  index() { return curIndex; }                    // Position in the parent
+            unsigned                                depth() { return curDepth; }
+            void                                    skip() { descend = false; }                     // Don't walk the children of the node just entered
+private:
+    struct Frame
+    {
+        CppON                                       *node;
+        const std::string                           *key;
+        size_t                                      index;
+        size_t                                      next;                                           // Next child to visit
+        size_t                                      pathLen;                                        // Length of the node's own path
+    };
+            std::vector<Frame>                      stack;
+            std::string                             curPath;
+            CppON                                   *root;
+            CppON                                   *cur;
+            const std::string                       *curKey;
+            size_t                                  curIndex;
+            unsigned                                curDepth;
+            bool                                    isLeaving;
+            bool                                    descend;
+            bool                                    started;
+            bool                                    trackPath;
+};
+
+template<typename F> void CppON::visit( F &&f )
+{
+    CppONIterator   it( this );
+
+    while( it.next() )
+    {
+        if( ! it.leaving() )
+        {
+            f( it.path(), it.node() );
+        }
+    }
+}
+
+class CppONWriter;
+
+/*
+ * Writes a tree as compact or indented JSON a piece at a time so a large document can be sent from an event loop
+ * without blocking it.  Each step() appends at most maxBytes bytes and returns after about maxMicros microseconds;
+ * the serializer remembers where it is in the tree and carries on from there on the next call.  The pieces put
+ * together are the same text toCompactJsonString() / toJsonString() would give, as long as the tree does not
+ * change until done() - pass snapshot true to serialize a private copy taken by the constructor instead.
+ *
+ *     COSerializer ser( map );
+ *     bool last;
+ *     do {
+ *         last = ser.step( buf, 64 * 1024, 500 );                                  // The last piece comes with true
+ *         send( buf ); buf.clear();
+ *         if( ! last ) waitForNextTick();
+ *     } while( ! last );
+ */
+class COSerializer
+{
+public:
+    enum Style { COMPACT, PRETTY };
+                                                    COSerializer( CppON *root, Style style = COMPACT, const std::string &indent = "", bool snapshot = false );
+                                                    COSerializer( const COSerializer & ) = delete;
+                                                    ~COSerializer();
+            bool                                    step( std::string &out, size_t maxBytes, unsigned maxMicros = 0 );
+            bool                                    done() { return finished && pendingPos >= pending.size(); }
+            size_t                                  written() { return total; }                     // Bytes handed out so far
+private:
+            CppONIterator                           it;
+            std::vector<size_t>                     marks;
+            std::string                             pending;                                        // Text of the last node not yet handed out
+            size_t                                  pendingPos;
+            size_t                                  total;
+            CppON                                   *owned;                                         // The snapshot, if one was taken
+            CppONWriter                             *writer;                                        // Does the formatting
+            bool                                    finished;
+};
+
+/*
+ * Read a stream of concatenated JSON documents from a file descriptor or FILE *.
+ *
+ * Data is read in large blocks and document boundaries are found with a resumable scanner that only tracks
+ * nesting depth and string/escape state.  Where SSE2 is available the scanner skips 16 bytes at a time to the
+ * next structural character.  Each complete document is parsed once, in place, out of the block buffer.
+ *
+ * Top level documents may be Maps, Arrays, strings, numbers or booleans and may be separated by white space,
+ * commas or NUL characters.  A document that fails to parse is counted in errors() and skipped.
+ *
+ *     COStreamReader rdr( fd );
+ *     CppON *obj;
+ *     while( ( obj = rdr.next() ) ) { ...; delete obj; }
+ *
+ * When constructed from a FILE * the underlying descriptor is read directly, so no data should have been read from
+ * the FILE through stdio before.  readObj() remains for reading a single object without reading past it.
+ */
+class COStreamReader
+{
+public:
+                                                    COStreamReader( int fd, bool closeFd = false );
+                                                    COStreamReader( FILE *fp );
+    virtual                                         ~COStreamReader();
+            CppON                                   *next();                                        // Next document or NULL at the end of the stream
+            bool                                    eof() { return atEof && start == end; }
+            size_t                                  documents() { return docs; }
+            size_t                                  errors() { return errs; }
+            int                                     getFd() { return fd; }
+protected:
+    virtual ssize_t                                 fill();                                         // Read more data into the buffer
+    virtual CppON                                   *extract();                                     // Parse the next complete document in the buffer
+    virtual void                                    makeRoom();
+            char                                    *buf;
+            size_t                                  cap;                                            // Allocated size of buf less one for a NUL
+            size_t                                  start;                                          // Start of the current (or next) document
+            size_t                                  end;                                            // End of the data in buf
+            size_t                                  pos;                                            // Scanner position
+            int                                     fd;
+            bool                                    closeFd;
+            bool                                    atEof;
+            char                                    mode;                                           // 0 between documents, 1 container, 2 string, 3 scalar
+            bool                                    inString;
+            bool                                    escape;
+            unsigned                                depth;
+            size_t                                  docs;
+            size_t                                  errs;
+};
+
+/*
+ * A COStreamReader for sockets and pipes driven by epoll (or poll/select).  The descriptor is switched to
+ * non-blocking mode and drain() is called whenever it is readable.  drain() reads until the descriptor
+ * would block, which also makes it safe for edge triggered epoll, and appends every message completed so far.
+ * Partial messages stay in the reader's buffer until the rest arrives.
+ *
+ *     std::vector<CppON *> msgs;
+ *     if( 0 > rdr->drain( msgs ) ) { the peer closed the connection }
+ */
+class COSocketReader : public COStreamReader
+{
+public:
+                                                    COSocketReader( int fd, bool closeFd = true );
+            int                                     drain( std::vector<CppON *> &msgs );            // Number of messages appended, -1 once closed
+            bool                                    closed() { return atEof; }
+};
+
+/*
+ * Read a stream of TNetStrings.  Because every message carries its own length no scanning is needed: once the
+ * length prefix has been seen the rest of the message is read with as few read() calls as possible (normally one)
+ * into a buffer sized for it, and parsed in place.  Regular files are mmap'd and parsed straight from the mapping
+ * without any read() calls at all.  Messages may be separated by white space.
+ *
+ * Every message is parsed with options() (a default CppONParseOptions unless changed), so the lengths inside it
+ * are checked against the message and the limits set there apply to each message on its own; after a message
+ * fails options().error tells why.  A malformed length prefix can not be recovered from, so it ends the stream and
+ * is counted in errors().
+ */
+class COTNetStreamReader : public COStreamReader
+{
+public:
+                                                    COTNetStreamReader( int fd, bool closeFd = false );
+                                                    COTNetStreamReader( FILE *fp );
+                                                    ~COTNetStreamReader();
+            CppONParseOptions                       &options() { return opts; }                     // Limits applied to each message
+protected:
+            ssize_t                                 fill() override;
+            CppON                                   *extract() override;
+            void                                    makeRoom() override;
+            char                                    *map;                                           // Mapping of a regular file or NULL
+            size_t                                  mapLen;
+            size_t                                  need;                                           // Size of the message being read, 0 if unknown
+            CppONParseOptions                       opts;
+};
+
+/*
+ * Sends and receives trees as TNetStrings over a connected AF_UNIX socket, stream or seqpacket.  queue() frames a
+ * tree without building a string for it: the length prefixes, keys and small values go into one framing buffer and
+ * strings of UNIX_ZERO_COPY_MIN bytes or more are pointed at where they are, so flush() hands the kernel an iovec
+ * list straight out of the trees.  A stream socket gets the whole batch with writev(); a seqpacket socket gets one
+ * packet per tree with sendmmsg().  Because of this the queued trees must stay alive and unchanged until flush().
+ * A stream is read with COTNetStreamReader; each seqpacket is parsed on its own.  Either way the lengths inside a
+ * message are checked against it and the limits in the options given to receive() apply to each message.
+ */
+class COUnixTransport
+{
+public:
+                                                    COUnixTransport( int fd, bool closeFd = false );
+                                                    COUnixTransport( const COUnixTransport & ) = delete;
+                                                    ~COUnixTransport();
+    static  int                                     connectTo( const char *path, bool seqpacket = false );
+    static  int                                     listenOn( const char *path, bool seqpacket = false, int backlog = 16 );
+            void                                    queue( CppON *obj );                            // Frame obj into the pending batch
+            ssize_t                                 flush();                                        // Send the batch, bytes sent or -1
+            ssize_t                                 send( CppON *obj ) { queue( obj ); return flush(); }
+            CppON                                   *receive( CppONParseOptions &opts );           // Next tree or NULL when the peer closed
+            CppON                                   *receive() { CppONParseOptions opts; return receive( opts ); }
+            size_t                                  pending() { return msgs.size(); }
+            int                                     getFd() { return fd; }
+private:
+    struct Segment
+    {
+        const char                                  *ptr;                                           // Outside data, or NULL for frame[ off ]
+        size_t                                      off;
+        size_t                                      len;
+    };
+    struct Message
+    {
+        size_t                                      first;                                          // First segment
+        size_t                                      count;
+        size_t                                      bytes;
+    };
+            void                                    addFrame( size_t from );                        // frame[ from .. ] was just appended
+            ssize_t                                 flushStream();
+            ssize_t                                 flushPackets();
+
+            std::string                             frame;
+            std::vector<Segment>                    segs;
+            std::vector<Message>                    msgs;
+            std::vector<size_t>                     opens;                                          // Placeholder segment of each open container
+            std::vector<size_t>                     openBytes;                                      // Message bytes when it was opened
+            CppONIterator                           it;
+            COTNetStreamReader                      *reader;
+            std::string                             packet;
+            int                                     fd;
+            bool                                    closeFd;
+            bool                                    seqpacket;
+};
+
+/*
+ * One failure found by COSchema::validate().  path has the form CppONIterator::path() gives ("a/b/3", "" for the root).
+ */
+struct COSchemaError
+{
+    std::string                                     path;
+    std::string                                     message;
+};
+
+/*
+ * A validator for a subset of JSON Schema.  The schema document is compiled once into a flat table of rules so
+ * validate() checks a tree in a single pass without looking anything up by path.  The properties of each object
+ * rule are kept sorted, the same order a Map keeps its keys in, so a Map is checked by one merge of the two lists
+ * that finds unexpected keys, missing required keys and the children to descend into.
+ *
+ * Keywords understood: type (a name or a list of names), properties, required, additionalProperties (true or false),
+ * items (one schema for every element), enum, const, minimum, maximum, exclusiveMinimum, exclusiveMaximum (as
+ * numbers), minLength, maxLength (in characters), minItems and maxItems.  Other keywords are ignored.
+ *
+ * A compiled schema is not changed by validate(), so one may be shared by any number of threads.  Set
+ * CppONParseOptions::schema to have parseJson() reject documents that don't pass.
+ *
+ *     COSchema schema( "{\"type\":\"object\",\"required\":[\"id\"],\"properties\":{\"id\":{\"type\":\"integer\"}}}" );
+ *     std::vector<COSchemaError> errors;
+ *     if( ! schema.validate( msg, &errors ) ) { for( auto &e : errors ) printf( "%s: %s\n", e.path.c_str(), e.message.c_str() ); }
+ */
+class COSchema
+{
+public:
+                                                    COSchema( CppON *schema );
+                                                    COSchema( const char *json );
+                                                    COSchema( const COSchema & ) = delete;
+                                                    ~COSchema();
+            bool                                    ok() { return compiled; }                       // false if the schema could not be compiled
+            const std::string                       &compileError() { return error; }
+            bool                                    validate( CppON *obj, std::vector<COSchemaError> *errors = NULL, size_t maxErrors = 0 ) const;
+private:
+    struct Rule
+    {
+            unsigned                                types;                                          // Bit per CppONType allowed, 0 for any
+            double                                  minimum;
+            double                                  maximum;
+            size_t                                  minLength;                                      // Characters of a String
+            size_t                                  maxLength;
+            size_t                                  minItems;                                       // Elements of an Array
+            size_t                                  maxItems;
+            size_t                                  propFirst;                                      // Properties, sorted by key
+            size_t                                  propCount;
+            size_t                                  enumFirst;
+            size_t                                  enumCount;
+            int                                     items;                                          // Rule for Array elements or -1
+            bool                                    exclusiveMin;
+            bool                                    exclusiveMax;
+            bool                                    closed;                                         // additionalProperties false
+    };
+    struct Prop
+    {
+            std::string                             key;
+            int                                     rule;                                           // -1 if only named in required
+            bool                                    required;
+    };
+    struct Where;
+            int                                     compile( CppON *schema, const std::string &at );
+            bool                                    check( int rule, CppON *obj, const Where *where, std::vector<COSchemaError> *errors, size_t maxErrors ) const;
+
+            std::vector<Rule>                       rules;                                          // rules[ 0 ] is the root
+            std::vector<Prop>                       props;
+            std::vector<CppON *>                    enums;                                          // Copies of the enum values
+            std::string                             error;
+            bool                                    compiled;
+};
+
+/*
+ * An embedded key to document store.  Records are appended to a log file ("path") as two TNetStrings, the key and
+ * the document ("0:#", an empty integer no document is written as, marks a delete), so the log can also be read
+ * with COTNetStreamReader.  An open addressing hash table in a second, mmap'd file ("path.idx") maps each live key
+ * to its record, and get() reads and parses just that record with one pread().
+ *
+ * put() and remove() only queue records.  commit() writes everything queued by every thread with one write() and,
+ * if sync is set, one fdatasync(); records queued while a commit is syncing go out together with the next one.
+ * Queued records are seen by get() straight away.  The queue is committed by itself once it holds
+ * STORE_COMMIT_BYTES.
+ *
+ * The log is the only thing that has to survive a crash.  An index that was not closed cleanly or does not match
+ * the log is rebuilt from it when the store is opened, and a torn record at the end of the log is cut off.
+ * compact() rewrites the log with only the live records; backgroundCompact() runs it on a thread of its own
+ * whenever more than half of the log is dead.  A store may be used from any number of threads.
+ *
+ *     COStore db( "/var/lib/app/records" );
+ *     db.put( "user/17", map ); db.commit();
+ *     CppON *rec = db.get( "user/17" );
+ */
+class COStore
+{
+public:
+                                                    COStore( const char *path, bool sync = true );
+                                                    COStore( const COStore & ) = delete;
+                                                    ~COStore();
+            bool                                    ok() { return 0 <= fd && header; }              // false if the files could not be opened
+            bool                                    put( const std::string &key, CppON *obj );      // Queue obj (written as a TNetString) under key
+            bool                                    remove( const std::string &key );
+            CppON                                   *get( const std::string &key );                 // A new tree the caller deletes, or NULL
+            bool                                    contains( const std::string &key );
+            int                                     commit();                                       // Records written or -1
+            size_t                                  size();                                         // Committed live keys
+            bool                                    compact();
+            void                                    backgroundCompact( bool on );
+private:
+    struct Header;
+    struct Slot;
+    struct Queued
+    {
+            size_t                                  off;                                            // Record in the queue buffer
+            size_t                                  len;
+            bool                                    removed;
+    };
+            bool                                    openIndex( bool rebuild );
+            bool                                    rebuildIndex();
+            bool                                    mapIndex( uint64_t capacity );
+            Slot                                    *findSlot( const std::string &key, uint64_t h, bool insert );
+            bool                                    keyAt( uint64_t off, uint64_t len, const std::string &key );
+            void                                    indexPut( const std::string &key, uint64_t off, uint64_t len );
+            void                                    indexRemove( const std::string &key );
+            bool                                    queue( const std::string &key, CppON *obj );
+            bool                                    readRecord( const std::string &key, std::string &rec, size_t &valueAt );
+            void                                    compactLoop();
+
+            std::string                             path;
+            std::string                             pending;                                        // Records queued for the next commit
+            std::unordered_map<std::string, Queued> pendingKeys;
+            std::string                             writing;                                        // Records being committed
+            std::unordered_map<std::string, Queued> writingKeys;
+            std::string                             scratch;
+            std::mutex                              lock;                                           // Everything but the commit's write() and fdatasync()
+            std::mutex                              commitLock;                                     // One commit or compaction at a time
+            std::condition_variable                 compactWake;
+            std::thread                             compactor;
+            Header                                  *header;                                        // The mmap'd index
+            Slot                                    *slots;
+            size_t                                  mapLen;
+            uint64_t                                logEnd;                                         // Bytes of committed records
+            int                                     fd;                                             // The log
+            int                                     idxFd;
+            bool                                    sync;
+            bool                                    compacting;                                     // backgroundCompact() is on
+};
+
+/*
+ * Keeps a configuration Map on disk as a snapshot ("path") plus a journal of changes ("path.journal"), so a small
+ * change costs a write the size of the change instead of a rewrite of the whole file.  Both are TNetStrings.
+ *
+ * The journal holds the current state.  record() compares a config with it (one merge per Map, identical() below
+ * that) and journals what differs as one record of operations: [ [ key, key, ... ], value ] sets a value and
+ * [ [ key, key, ... ] ] removes one.  Arrays and other values are replaced whole, and so is a Map whose keys were
+ * reordered or had one added between two it already had, so that replaying keeps the key order.  Code that knows
+ * what it changed can skip the comparison and call set() / remove() with the path itself.  Once the journal is
+ * bigger than the snapshot (and at least JOURNAL_MIN_CHECKPOINT bytes) a checkpoint writes a new snapshot to a
+ * temporary file, renames it into place and empties the journal.
+ *
+ * Opening reads the snapshot and replays the journal over it.  The snapshot and the journal both start with a
+ * generation number and a journal left over from an older snapshot is ignored, so a crash at any point loses at
+ * most the record being written; a torn record at the end of the journal is cut off.  Not thread safe.
+ *
+ *     COJournal jnl( "/etc/app/config" );
+ *     COMap *config = jnl.load();
+ *     config->append( "level", 3 ); jnl.record( config );
+ */
+class COJournal
+{
+public:
+                                                    COJournal( const char *path, bool sync = true );
+                                                    COJournal( const COJournal & ) = delete;
+                                                    ~COJournal();
+            bool                                    ok() { return 0 <= fd; }
+            COMap                                   *load() { return new COMap( *last ); }          // A copy of the state for the caller
+            COMap                                   *state() { return last; }                       // The journal's own copy, don't change it
+            int                                     record( COMap *config );                        // Operations journaled or -1
+            bool                                    set( const std::vector<std::string> &path, CppON *value );
+            bool                                    remove( const std::vector<std::string> &path );
+            bool                                    checkpoint();
+            size_t                                  journalSize() { return journalBytes; }
+private:
+            bool                                    readSnapshot();
+            bool                                    replay();
+            bool                                    resetJournal();
+            bool                                    write( COArray &ops );
+
+            std::string                             path;
+            std::string                             buf;
+            COMap                                   *last;                                          // The state as journaled
+            long long                               generation;                                     // Of the snapshot the journal applies to
+            size_t                                  journalBytes;
+            size_t                                  snapshotBytes;
+            int                                     fd;                                             // The journal
+            bool                                    sync;
+};
+
+/*
+ * Keeps Maps loaded from JSON files up to date as the files are edited.  Each file's directory is watched with
+ * inotify (so editors that save by renaming a new file over the old one are seen too), and poll() re-parses just
+ * the files that were written.  The new tree is not swapped in: it is compared with the live one and only what
+ * changed is applied.  Values that keep their type are assigned in place, so pointers into the live tree stay
+ * good; added, removed and retyped values and changed Arrays are replaced.  A file that fails to parse leaves its
+ * tree as it was.
+ *
+ * After a file has been applied every subscriber whose prefix is on a changed path - the changed path itself, above
+ * it or below it - is called with the root, the path ("a/b", as CppONIterator::path() gives) and the new value, or
+ * NULL if it was removed.  The live trees are changed only by poll(), on the thread that calls it.
+ *
+ *     COHotReload reload;
+ *     COMap *cfg = reload.watch( "/etc/app/config.json" );
+ *     reload.subscribe( "db", []( COMap *, const std::string &path, CppON *v ) { reconnect(); } );
+ *     for( ;; ) { reload.poll( 1000 ); ... }
+ */
+class COHotReload
+{
+public:
+    typedef std::function<void( COMap *root, const std::string &path, CppON *value )> Listener;
+                                                    COHotReload();
+                                                    COHotReload( const COHotReload & ) = delete;
+                                                    ~COHotReload();
+            COMap                                   *watch( const char *file );                     // The live tree, owned by the reloader
+            unsigned                                subscribe( const std::string &prefix, Listener fn );
+            void                                    unsubscribe( unsigned id );
+            int                                     poll( int timeoutMs = 0 );                      // Files reloaded, or -1
+            int                                     reload( COMap *root );                          // Re-read one file now; paths changed or -1
+            int                                     getFd() { return fd; }                          // For epoll; call poll( 0 ) when readable
+private:
+    struct Watched
+    {
+            std::string                             file;
+            std::string                             name;                                           // Within its directory
+            int                                     wd;
+            COMap                                   *tree;
+    };
+    struct Subscriber
+    {
+            unsigned                                id;
+            std::string                             prefix;
+            Listener                                fn;
+    };
+            void                                    apply( COMap *live, COMap *fresh, std::string &path );
+            void                                    changed( const std::string &path, CppON *value );
+
+            std::vector<Watched>                    files;
+            std::vector<Subscriber>                 subscribers;
+            std::vector<std::pair<std::string, CppON *> > changes;                               // Found by the apply() running now
+            std::vector<char>                       events;
+            unsigned                                nextId;
+            int                                     fd;
+};
+
+/*
+ * A read only view of a stack of COMaps as one Map, as if they had been merge()d into an empty Map from the bottom
+ * layer up, but without copying anything.  A key is looked up from the top layer down and the first layer that has
+ * it decides, unless its value is a Map: then the Maps under that key in the layers below it (down to the first
+ * layer where it is not a Map) show through as one merged Map, which view() returns as a COLayeredMap of its own.
+ * Keys come in the order merge() would have given them: the bottom layer's first, then those new in each layer
+ * above.  The layers stay their owners'.  Pushing, popping or replacing a layer is O(1) and a NULL layer is
+ * skipped, so one can be switched off; layers changed in place are seen at once since nothing is cached.  A lookup
+ * costs a probe per layer per path element.
+ *
+ *     COLayeredMap cfg;
+ *     cfg.push( defaults ); cfg.push( site ); cfg.push( device ); cfg.push( overrides );
+ *     CppON *port = cfg.findElement( "db/port" );
+ *     cfg.setLayer( 3, newOverrides );
+ */
+class COLayeredMap
+{
+public:
+            size_t                                  push( COMap *layer ) { maps.push_back( layer ); return maps.size() - 1; }   // On top, returns its index
+            COMap                                   *pop();                                         // Take off the top layer
+            COMap                                   *setLayer( size_t i, COMap *layer );            // Replace layer i, returns the old one
+            COMap                                   *layer( size_t i ) { return ( maps.size() > i ) ? maps[ i ] : NULL; }
+            size_t                                  layers() { return maps.size(); }
+            CppON                                   *findElement( const char *path );               // Effective value at "a/b"; for a merged Map its top Map
+            COLayeredMap                            view( const char *path );                       // The merged Map at path, empty if it is not a Map
+            std::vector<std::string>                keys();                                         // Effective keys in merge order
+            template<typename F> void               forEach( F &&f );                               // f( key, value ) as findElement() gives them
+            COMap                                   *flatten();                                     // A merged copy the caller owns
+            void                                    writeCompactJson( std::string &out );          // Replace out with the merged result
+            void                                    writeNetString( std::string &out );
+            std::string                             *toCompactJsonString();
+private:
+            CppON                                   *resolve( const std::string &key, std::vector<COMap *> *sub );
+            void                                    write( std::string &out, bool net );
+
+            std::vector<COMap *>                    maps;                                           // Bottom (the defaults) first
+};
+
+template<typename F> void COLayeredMap::forEach( F &&f )
+{
+    std::vector<std::string>    k   = keys();
+
+    for( size_t i = 0; k.size() > i; i++ )
+    {
+        f( k[ i ], resolve( k[ i ], NULL ) );
+    }
+}
+
 #endif /* CPPON_HPP_ */